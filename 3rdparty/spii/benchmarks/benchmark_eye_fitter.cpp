@@ -0,0 +1,265 @@
+// Benchmark of the eye model refinement of singleeyefitter
+// (refine_with_region_contrast): one region contrast term per
+// observation, all sharing the eye centre.
+//
+// The terms mimic the cost profile of singleeyefitter's
+// PupilContrastTerm without its OpenCV dependency: the pupil
+// circle on the eye sphere is projected to an ellipse, whose
+// inner and outer band are sampled from the observation's image.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <spii/auto_diff_term.h>
+#include <spii/function.h>
+#include <spii/solver.h>
+using namespace spii;
+
+#include "hastighet.h"
+
+namespace
+{
+	const double pi = 3.14159265358979323846;
+
+	const int image_width  = 160;
+	const int image_height = 120;
+	const double focal_length = 150.0;
+	const double eye_radius = 12.0;
+
+	// Number of samples on each of the inner and outer band.
+	const int band_samples = 128;
+
+	int default_number_of_threads()
+	{
+		#ifdef USE_OPENMP
+			return omp_get_max_threads();
+		#else
+			return 1;
+		#endif
+	}
+}
+
+// Projected pupil ellipse of the pupil (theta, psi, radius) on the
+// eye sphere centred at eye. The ellipse is given by its centre and
+// its semi-axes as vectors.
+template<typename R>
+void project_pupil(const R* const eye, const R* const pupil,
+                   R* centre, R* major, R* minor)
+{
+	using std::sin;
+	using std::cos;
+	using std::sqrt;
+
+	// Pupil normal on the sphere, pointing towards the camera for
+	// theta in (0, pi) and psi in (-pi, 0).
+	R normal[3] = {sin(pupil[0]) * cos(pupil[1]),
+	               cos(pupil[0]),
+	               sin(pupil[0]) * sin(pupil[1])};
+	R position[3];
+	for (int i = 0; i < 3; ++i) {
+		position[i] = eye[i] + eye_radius * normal[i];
+	}
+
+	centre[0] = focal_length * position[0] / position[2] + image_width / 2.0;
+	centre[1] = focal_length * position[1] / position[2] + image_height / 2.0;
+
+	// Weak perspective: the minor axis is foreshortened along the
+	// projected normal.
+	R length = focal_length * pupil[2] / position[2];
+	R projected_normal = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + 1e-12);
+	R nx = normal[0] / projected_normal;
+	R ny = normal[1] / projected_normal;
+	R foreshortening = -normal[2];
+	minor[0] = length * foreshortening * nx;
+	minor[1] = length * foreshortening * ny;
+	major[0] = -length * ny;
+	major[1] =  length * nx;
+}
+
+struct EyeImage
+{
+	std::vector<unsigned char> pixels;
+
+	double operator()(int x, int y) const
+	{
+		return pixels[y * image_width + x];
+	}
+
+	// Bilinear interpolation, differentiable in x and y.
+	template<typename R>
+	R sample(R x, R y) const
+	{
+		int x0 = std::min(std::max(int(std::floor(to_double(x))), 0), image_width - 2);
+		int y0 = std::min(std::max(int(std::floor(to_double(y))), 0), image_height - 2);
+		R fx = x - double(x0);
+		R fy = y - double(y0);
+		return (1.0 - fx) * (1.0 - fy) * (*this)(x0, y0)
+		     + fx * (1.0 - fy) * (*this)(x0 + 1, y0)
+		     + (1.0 - fx) * fy * (*this)(x0, y0 + 1)
+		     + fx * fy * (*this)(x0 + 1, y0 + 1);
+	}
+};
+
+// Negative contrast between the outer and the inner band of the
+// projected pupil.
+struct RegionContrastTerm
+{
+	const EyeImage* image;
+
+	RegionContrastTerm(const EyeImage* image)
+		: image(image)
+	{ }
+
+	template<typename R>
+	R operator()(const R* const eye, const R* const pupil) const
+	{
+		R centre[2], major[2], minor[2];
+		project_pupil(eye, pupil, centre, major, minor);
+
+		R inner = 0.0;
+		R outer = 0.0;
+		for (int k = 0; k < band_samples; ++k) {
+			double phi = 2.0 * pi * k / band_samples;
+			R dx = std::cos(phi) * major[0] + std::sin(phi) * minor[0];
+			R dy = std::cos(phi) * major[1] + std::sin(phi) * minor[1];
+			inner += image->sample(centre[0] + 0.8 * dx, centre[1] + 0.8 * dy);
+			outer += image->sample(centre[0] + 1.25 * dx, centre[1] + 1.25 * dy);
+		}
+		return (inner - outer) / double(band_samples);
+	}
+};
+
+class EyeFitterBenchmark :
+	public hastighet::Test
+{
+public:
+	Function f;
+	double eye[3];
+	std::vector<double> pupils;
+	std::vector<EyeImage> images;
+	Eigen::VectorXd x, g;
+	LBFGSSolver solver;
+	SolverResults results;
+
+	EyeFitterBenchmark(int number_of_threads, int number_of_observations = 300) :
+		pupils(3 * number_of_observations),
+		images(number_of_observations)
+	{
+		std::mt19937 prng(unsigned(1));
+		std::normal_distribution<double> normal;
+		auto randn = std::bind(normal, prng);
+
+		const double true_eye[3] = {1.0, -0.5, 50.0};
+
+		for (int i = 0; i < number_of_observations; ++i) {
+			double true_pupil[3] = {pi / 2.0 + 0.3 * randn(),
+			                        -pi / 2.0 + 0.3 * randn(),
+			                        3.0 + 0.5 * randn()};
+			render(true_eye, true_pupil, &images[i], prng);
+
+			for (int j = 0; j < 3; ++j) {
+				pupils[3 * i + j] = true_pupil[j] + 0.05 * randn();
+			}
+		}
+		for (int j = 0; j < 3; ++j) {
+			eye[j] = true_eye[j] + 0.5 * randn();
+		}
+
+		f.add_variable(eye, 3);
+		for (int i = 0; i < number_of_observations; ++i) {
+			f.add_variable(&pupils[3 * i], 3);
+			f.add_term(std::make_shared<AutoDiffTerm<RegionContrastTerm, 3, 3>>(&images[i]),
+			           eye, &pupils[3 * i]);
+		}
+
+		x.resize(f.get_number_of_scalars());
+		f.copy_user_to_global(&x);
+		f.set_number_of_threads(number_of_threads);
+
+		solver.log_function = [](const std::string&) { };
+		solver.maximum_iterations = 10;
+	}
+
+private:
+
+	// Dark pupil ellipse on a bright iris, with noise.
+	static void render(const double* eye, const double* pupil, EyeImage* image, std::mt19937& prng)
+	{
+		std::normal_distribution<double> noise(0.0, 5.0);
+
+		double centre[2], major[2], minor[2];
+		project_pupil(eye, pupil, centre, major, minor);
+		double major_length2 = major[0] * major[0] + major[1] * major[1];
+		double minor_length2 = minor[0] * minor[0] + minor[1] * minor[1];
+
+		image->pixels.resize(image_width * image_height);
+		for (int y = 0; y < image_height; ++y) {
+			for (int x = 0; x < image_width; ++x) {
+				double dx = x - centre[0];
+				double dy = y - centre[1];
+				double u = (dx * major[0] + dy * major[1]) / major_length2;
+				double v = (dx * minor[0] + dy * minor[1]) / minor_length2;
+				double rho = std::sqrt(u * u + v * v);
+				double edge = std::min(std::max((rho - 0.9) / 0.2, 0.0), 1.0);
+				double intensity = 40.0 + 140.0 * edge + noise(prng);
+				image->pixels[y * image_width + x] =
+					static_cast<unsigned char>(std::min(std::max(intensity, 0.0), 255.0));
+			}
+		}
+	}
+};
+
+class EyeFitterBenchmarkOneThread :
+	public EyeFitterBenchmark
+{
+public:
+	EyeFitterBenchmarkOneThread() : EyeFitterBenchmark(1) { }
+};
+
+class EyeFitterBenchmarkAllThreads :
+	public EyeFitterBenchmark
+{
+public:
+	EyeFitterBenchmarkAllThreads() : EyeFitterBenchmark(default_number_of_threads()) { }
+};
+
+BENCHMARK_F(EyeFitterBenchmarkOneThread, evaluate_x)
+{
+	f.evaluate(x);
+}
+
+BENCHMARK_F(EyeFitterBenchmarkOneThread, evaluate_x_g)
+{
+	f.evaluate(x, &g);
+}
+
+BENCHMARK_F(EyeFitterBenchmarkOneThread, solver_10_lbfgs_iter)
+{
+	f.copy_global_to_user(x);
+	solver.solve(f, &results);
+}
+
+BENCHMARK_F(EyeFitterBenchmarkAllThreads, evaluate_x)
+{
+	f.evaluate(x);
+}
+
+BENCHMARK_F(EyeFitterBenchmarkAllThreads, evaluate_x_g)
+{
+	f.evaluate(x, &g);
+}
+
+BENCHMARK_F(EyeFitterBenchmarkAllThreads, solver_10_lbfgs_iter)
+{
+	f.copy_global_to_user(x);
+	solver.solve(f, &results);
+}
+
+int main(int argc, char** argv)
+{
+	hastighet::Benchmarker::RunAllTests(argc, argv);
+}
@@ -10,6 +10,15 @@ using namespace spii;
 
 #include "hastighet.h"
 
+int default_number_of_threads()
+{
+	#ifdef USE_OPENMP
+		return omp_get_max_threads();
+	#else
+		return 1;
+	#endif
+}
+
 // One term in the negative log-likelihood function for
 // a one-dimensional Gaussian distribution.
 struct NegLogLikelihood
@@ -83,6 +92,26 @@ BENCHMARK_F(LikelihoodBenchmark, evaluate_x_g_H)
 	f.evaluate(x, &g, &H);
 }
 
+class LikelihoodBenchmarkAllThreads :
+	public LikelihoodBenchmark
+{
+public:
+	LikelihoodBenchmarkAllThreads()
+	{
+		f.set_number_of_threads(default_number_of_threads());
+	}
+};
+
+BENCHMARK_F(LikelihoodBenchmarkAllThreads, evaluate_x)
+{
+	f.evaluate(x);
+}
+
+BENCHMARK_F(LikelihoodBenchmarkAllThreads, evaluate_x_g)
+{
+	f.evaluate(x, &g);
+}
+
 struct LennardJonesTerm
 {
 	template<typename R>
@@ -168,6 +197,26 @@ BENCHMARK_F(LennardJonesBenchmark, evaluate_x_g_H)
 	potential.evaluate(x, &g, &H);
 }
 
+class LennardJonesBenchmarkAllThreads :
+	public LennardJonesBenchmark
+{
+public:
+	LennardJonesBenchmarkAllThreads()
+	{
+		potential.set_number_of_threads(default_number_of_threads());
+	}
+};
+
+BENCHMARK_F(LennardJonesBenchmarkAllThreads, evaluate_x)
+{
+	potential.evaluate(x);
+}
+
+BENCHMARK_F(LennardJonesBenchmarkAllThreads, evaluate_x_g)
+{
+	potential.evaluate(x, &g);
+}
+
 int main(int argc, char** argv)
 {
 	hastighet::Benchmarker::RunAllTests(argc, argv);
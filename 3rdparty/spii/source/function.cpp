@@ -119,6 +119,16 @@ public:
 	// Number of threads used for evaluation.
 	int number_of_threads;
 
+	// The terms are evaluated in one contiguous block per thread. Each
+	// block accumulates its value and gradient in term order into its
+	// own storage, and the blocks are summed in block order. The result
+	// therefore only depends on the number of threads, not on the
+	// scheduling of the blocks.
+	int first_term_of_block(int block) const
+	{
+		return static_cast<int>(terms.size() * block / this->number_of_threads);
+	}
+
 	// Allocates temporary storage for gradient evaluations.
 	// Should be called automatically at first evaluate()
 	void allocate_local_storage() const;
@@ -578,27 +588,29 @@ double Function::Implementation::evaluate_from_local_storage() const
 	interface->evaluations_without_gradient++;
 	double start_time = wall_time();
 
-	double value = this->constant;
-	// Go through and evaluate each term.
+	// Go through and evaluate each block of terms.
 	// OpenMP requires a signed data type as the loop variable.
+	std::vector<double> block_values(this->number_of_threads, 0.0);
 	#ifdef USE_OPENMP
-		// Each thread needs to store a specific error.
+		// Each block needs to store a specific error.
 		std::vector<std::exception_ptr> evaluation_errors(this->number_of_threads);
 
-		#pragma omp parallel for reduction(+ : value) num_threads(this->number_of_threads) if (terms.size() > 1)
+		#pragma omp parallel for schedule(static, 1) num_threads(this->number_of_threads) if (terms.size() > 1)
 	#endif
 	// For loop has to be int for OpenMP.
-	for (int i = 0; i < terms.size(); ++i) {
+	for (int t = 0; t < this->number_of_threads; ++t) {
 		#ifdef USE_OPENMP
-			// The thread number calling this iteration.
-			int t = omp_get_thread_num();
 			// We need to catch all exceptions before leaving
 			// the loop body.
 			try {
 		#endif
 
-		// Evaluate the term .
-		value += terms[i].term->evaluate(&terms[i].temp_variables[0]);
+		// Evaluate the terms of the block.
+		double block_value = 0;
+		for (int i = first_term_of_block(t); i < first_term_of_block(t + 1); ++i) {
+			block_value += terms[i].term->evaluate(&terms[i].temp_variables[0]);
+		}
+		block_values[t] = block_value;
 
 		#ifdef USE_OPENMP
 			// We need to catch all exceptions before leaving
@@ -622,6 +634,11 @@ double Function::Implementation::evaluate_from_local_storage() const
 		}
 	#endif
 
+	double value = this->constant;
+	for (double block_value: block_values) {
+		value += block_value;
+	}
+
 	interface->evaluate_time += wall_time() - start_time;
 	return value;
 }
@@ -884,98 +901,98 @@ double Function::Implementation::evaluate(const Eigen::VectorXd& x,
 		this->thread_gradient_storage[t].setZero();
 	}
 
-	double value = this->constant;
-
-	// Go through and evaluate each term.
+	// Go through and evaluate each block of terms.
 	// OpenMP requires a signed data type as the loop variable.
+	std::vector<double> block_values(this->number_of_threads, 0.0);
 	#ifdef USE_OPENMP
-		// Each thread needs to store a specific error.
+		// Each block needs to store a specific error.
 		std::vector<std::exception_ptr> evaluation_errors(this->number_of_threads);
 
-		#pragma omp parallel for reduction(+ : value) num_threads(this->number_of_threads)
+		#pragma omp parallel for schedule(static, 1) num_threads(this->number_of_threads)
 	#endif
-	for (int i = 0; i < terms.size(); ++i) {
+	for (int t = 0; t < this->number_of_threads; ++t) {
 		#ifdef USE_OPENMP
-			// The thread number calling this iteration.
-			int t = omp_get_thread_num();
 			// We need to catch all exceptions before leaving
 			// the loop body.
 			try {
-		#else
-			int t = 0;
 		#endif
 
-		if (hessian) {
-			// Evaluate the term and put its gradient and hessian
-			// into local storage.
-			value += terms[i].term->evaluate(&terms[i].temp_variables[0],
-											 &this->thread_gradient_scratch[t],
-											 &this->thread_hessian_scratch[t]);
+		double block_value = 0;
+		for (int i = first_term_of_block(t); i < first_term_of_block(t + 1); ++i) {
 
+			if (hessian) {
+				// Evaluate the term and put its gradient and hessian
+				// into local storage.
+				block_value += terms[i].term->evaluate(&terms[i].temp_variables[0],
+												 &this->thread_gradient_scratch[t],
+												 &this->thread_hessian_scratch[t]);
 
-			const auto& term = terms[i].term;
-			const auto& indices = terms[i].added_variables_indices;
-			// Put the hessian into the global hessian.
-			for (int var0 = 0; var0 < term->number_of_variables(); ++var0) {
 
-				if ( ! variables[indices[var0]].is_constant) {
-					spii_assert(!variables[indices[var0]].change_of_variables,
-					            "Change of variables not supported for Hessians");
+				const auto& term = terms[i].term;
+				const auto& indices = terms[i].added_variables_indices;
+				// Put the hessian into the global hessian.
+				for (int var0 = 0; var0 < term->number_of_variables(); ++var0) {
 
-					size_t global_offset0 = variables[indices[var0]].global_index;
-					for (int var1 = 0; var1 < term->number_of_variables(); ++var1) {
-						size_t global_offset1 = variables[indices[var1]].global_index;
+					if ( ! variables[indices[var0]].is_constant) {
+						spii_assert(!variables[indices[var0]].change_of_variables,
+						            "Change of variables not supported for Hessians");
 
-						if ( ! variables[indices[var1]].is_constant) {
+						size_t global_offset0 = variables[indices[var0]].global_index;
+						for (int var1 = 0; var1 < term->number_of_variables(); ++var1) {
+							size_t global_offset1 = variables[indices[var1]].global_index;
 
-							const Eigen::MatrixXd& part_hessian = this->thread_hessian_scratch[t][var0][var1];
-							for (int i = 0; i < term->variable_dimension(var0); ++i) {
-								for (int j = 0; j < term->variable_dimension(var1); ++j) {
-									thread_dense_hessian_storage[t]
-										.coeffRef(i + global_offset0, j + global_offset1)
-									+= part_hessian(i, j);
+							if ( ! variables[indices[var1]].is_constant) {
+
+								const Eigen::MatrixXd& part_hessian = this->thread_hessian_scratch[t][var0][var1];
+								for (int i = 0; i < term->variable_dimension(var0); ++i) {
+									for (int j = 0; j < term->variable_dimension(var1); ++j) {
+										thread_dense_hessian_storage[t]
+											.coeffRef(i + global_offset0, j + global_offset1)
+										+= part_hessian(i, j);
+									}
 								}
-							}
 
+							}
 						}
 					}
 				}
-			}
-
 
-		}
-		else {
-			// Evaluate the term and put its gradient into local
-			// storage.
-			value += terms[i].term->evaluate(&terms[i].temp_variables[0],
-											 &this->thread_gradient_scratch[t]);
-		}
 
-		// Put the gradient from the term into the thread's global gradient.
-		const auto& indices = terms[i].added_variables_indices;
-		for (int var = 0; var < indices.size(); ++var) {
+			}
+			else {
+				// Evaluate the term and put its gradient into local
+				// storage.
+				block_value += terms[i].term->evaluate(&terms[i].temp_variables[0],
+												 &this->thread_gradient_scratch[t]);
+			}
 
-			if ( ! variables[indices[var]].is_constant) {
-				if (variables[indices[var]].change_of_variables == nullptr) {
-					// No change of variables, just copy the gradient.
-					size_t global_offset = variables[indices[var]].global_index;
-					for (int i = 0; i < variables[indices[var]].user_dimension; ++i) {
-						this->thread_gradient_storage[t][global_offset + i] +=
-							this->thread_gradient_scratch[t][var][i];
+			// Put the gradient from the term into the thread's global gradient.
+			const auto& indices = terms[i].added_variables_indices;
+			for (int var = 0; var < indices.size(); ++var) {
+
+				if ( ! variables[indices[var]].is_constant) {
+					if (variables[indices[var]].change_of_variables == nullptr) {
+						// No change of variables, just copy the gradient.
+						size_t global_offset = variables[indices[var]].global_index;
+						for (int i = 0; i < variables[indices[var]].user_dimension; ++i) {
+							this->thread_gradient_storage[t][global_offset + i] +=
+								this->thread_gradient_scratch[t][var][i];
+						}
 					}
-				}
-				else {
-					// Transform the gradient from user space to solver space.
-					size_t global_offset = variables[indices[var]].global_index;
-					if (global_offset < this->number_of_scalars) {
-						variables[indices[var]].change_of_variables->update_gradient(
-							&this->thread_gradient_storage[t][global_offset],
-							&x[global_offset],
-							&this->thread_gradient_scratch[t][var][0]);
+					else {
+						// Transform the gradient from user space to solver space.
+						size_t global_offset = variables[indices[var]].global_index;
+						if (global_offset < this->number_of_scalars) {
+							variables[indices[var]].change_of_variables->update_gradient(
+								&this->thread_gradient_storage[t][global_offset],
+								&x[global_offset],
+								&this->thread_gradient_scratch[t][var][0]);
+						}
 					}
 				}
 			}
 		}
+		block_values[t] = block_value;
 
 		#ifdef USE_OPENMP
 			// We need to catch all exceptions before leaving
@@ -999,6 +1016,11 @@ double Function::Implementation::evaluate(const Eigen::VectorXd& x,
 		}
 	#endif
 
+	double value = this->constant;
+	for (double block_value: block_values) {
+		value += block_value;
+	}
+
 	interface->evaluate_with_hessian_time += wall_time() - start_time;
 	start_time = wall_time();
 
@@ -1007,7 +1029,7 @@ double Function::Implementation::evaluate(const Eigen::VectorXd& x,
 		gradient->resize(this->number_of_scalars);
 	}
 	gradient->setZero();
-	// Sum the gradients from all different terms.
+	// Sum the gradients of the blocks in block order.
 	for (int t = 0; t < this->number_of_threads; ++t) {
 		(*gradient) += this->thread_gradient_storage[t].segment(0, this->number_of_scalars);
 	}
@@ -1076,74 +1098,75 @@ double Function::Implementation::evaluate(const Eigen::VectorXd& x,
 		this->thread_gradient_storage[t].setZero();
 	}
 
-	double value = this->constant;
-	// Go through and evaluate each term.
+	// Go through and evaluate each block of terms.
 	// OpenMP requires a signed data type as the loop variable.
+	std::vector<double> block_values(this->number_of_threads, 0.0);
 	#ifdef USE_OPENMP
-		// Each thread needs to store a specific error.
+		// Each block needs to store a specific error.
 		std::vector<std::exception_ptr> evaluation_errors(this->number_of_threads);
 
-		#pragma omp parallel for reduction(+ : value) num_threads(this->number_of_threads)
+		#pragma omp parallel for schedule(static, 1) num_threads(this->number_of_threads)
 	#endif
-	for (int i = 0; i < terms.size(); ++i) {
+	for (int t = 0; t < this->number_of_threads; ++t) {
 		#ifdef USE_OPENMP
-			// The thread number calling this iteration.
-			int t = omp_get_thread_num();
 			// We need to catch all exceptions before leaving
 			// the loop body.
 			try {
-		#else
-			int t = 0;
 		#endif
 
-		// Evaluate the term and put its gradient and hessian
-		// into local storage.
-		value += terms[i].term->evaluate(&terms[i].temp_variables[0],
-		                                 &this->thread_gradient_scratch[t],
-		                                 &this->thread_hessian_scratch[t]);
+		double block_value = 0;
+		for (int i = first_term_of_block(t); i < first_term_of_block(t + 1); ++i) {
 
-		// Put the gradient from the term into the thread's global gradient.
-		const auto& indices = terms[i].added_variables_indices;
-		for (int var = 0; var < indices.size(); ++var) {
+			// Evaluate the term and put its gradient and hessian
+			// into local storage.
+			block_value += terms[i].term->evaluate(&terms[i].temp_variables[0],
+			                                       &this->thread_gradient_scratch[t],
+			                                       &this->thread_hessian_scratch[t]);
 
-			if ( ! variables[indices[var]].is_constant) {
-				spii_assert(!variables[indices[var]].change_of_variables,
-				            "Change of variables not supported for sparse Hessian");
+			// Put the gradient from the term into the thread's global gradient.
+			const auto& indices = terms[i].added_variables_indices;
+			for (int var = 0; var < indices.size(); ++var) {
+
+				if ( ! variables[indices[var]].is_constant) {
+					spii_assert(!variables[indices[var]].change_of_variables,
+					            "Change of variables not supported for sparse Hessian");
 
-				size_t global_offset = variables[indices[var]].global_index;
-				for (int i = 0; i < variables[indices[var]].user_dimension; ++i) {
-					this->thread_gradient_storage[t][global_offset + i] +=
-						this->thread_gradient_scratch[t][var][i];
+					size_t global_offset = variables[indices[var]].global_index;
+					for (int i = 0; i < variables[indices[var]].user_dimension; ++i) {
+						this->thread_gradient_storage[t][global_offset + i] +=
+							this->thread_gradient_scratch[t][var][i];
+					}
 				}
 			}
-		}
 
-		// Put the hessian from the term into the thread's global hessian.
-		const auto& term = terms[i].term;
-		for (int var0 = 0; var0 < term->number_of_variables(); ++var0) {
-			if ( ! variables[indices[var0]].is_constant) {
+			// Put the hessian from the term into the thread's global hessian.
+			const auto& term = terms[i].term;
+			for (int var0 = 0; var0 < term->number_of_variables(); ++var0) {
+				if ( ! variables[indices[var0]].is_constant) {
 
-				size_t global_offset0 = variables[indices[var0]].global_index;
-				for (int var1 = 0; var1 < term->number_of_variables(); ++var1) {
-					if ( ! variables[indices[var1]].is_constant) {
+					size_t global_offset0 = variables[indices[var0]].global_index;
+					for (int var1 = 0; var1 < term->number_of_variables(); ++var1) {
+						if ( ! variables[indices[var1]].is_constant) {
 
-						size_t global_offset1 = variables[indices[var1]].global_index;
-						const Eigen::MatrixXd& part_hessian = this->thread_hessian_scratch[t][var0][var1];
-						for (int i = 0; i < term->variable_dimension(var0); ++i) {
-							for (int j = 0; j < term->variable_dimension(var1); ++j) {
+							size_t global_offset1 = variables[indices[var1]].global_index;
+							const Eigen::MatrixXd& part_hessian = this->thread_hessian_scratch[t][var0][var1];
+							for (int i = 0; i < term->variable_dimension(var0); ++i) {
+								for (int j = 0; j < term->variable_dimension(var1); ++j) {
 
-								int global_i = static_cast<int>(i + global_offset0);
-								int global_j = static_cast<int>(j + global_offset1);
-								thread_sparse_hessian_storage[t].push_back(Eigen::Triplet<double>(global_i,
-								                                                                  global_j,
-								                                                                  part_hessian(i, j)));
+									int global_i = static_cast<int>(i + global_offset0);
+									int global_j = static_cast<int>(j + global_offset1);
+									thread_sparse_hessian_storage[t].push_back(Eigen::Triplet<double>(global_i,
+									                                                                  global_j,
+									                                                                  part_hessian(i, j)));
+								}
 							}
 						}
-					}
 
+					}
 				}
 			}
 		}
+		block_values[t] = block_value;
 
 		#ifdef USE_OPENMP
 			// We need to catch all exceptions before leaving
@@ -1167,6 +1190,11 @@ double Function::Implementation::evaluate(const Eigen::VectorXd& x,
 		}
 	#endif
 
+	double value = this->constant;
+	for (double block_value: block_values) {
+		value += block_value;
+	}
+
 	interface->evaluate_with_hessian_time += wall_time() - start_time;
 	start_time = wall_time();
 
@@ -1175,7 +1203,7 @@ double Function::Implementation::evaluate(const Eigen::VectorXd& x,
 		gradient->resize(this->number_of_scalars);
 	}
 	gradient->setZero();
-	// Sum the gradients from all different terms.
+	// Sum the gradients of the blocks in block order.
 	for (int t = 0; t < this->number_of_threads; ++t) {
 		(*gradient) += this->thread_gradient_storage[t].segment(0, this->number_of_scalars);
 	}
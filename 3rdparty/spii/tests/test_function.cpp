@@ -131,6 +131,42 @@ TEST(Function, calls_term_destructor)
 	EXPECT_EQ(counter2, 1);
 }
 
+TEST(Function, evaluate_multiple_threads_is_deterministic)
+{
+	Function f;
+	double x[2] = {0.3, 2.0};
+	std::vector<double> y(1000);
+	f.add_variable(x, 2);
+	for (int i = 0; i < y.size(); ++i) {
+		y[i] = 1.0 + 0.001 * i;
+		f.add_variable(&y[i], 1);
+		// All terms share x, so every block adds to its gradient.
+		f.add_term<AutoDiffTerm<Term2, 2, 1>>(x, &y[i]);
+		f.add_term<AutoDiffTerm<Term1, 2>>(x);
+	}
+
+	Eigen::VectorXd point(f.get_number_of_scalars());
+	f.copy_user_to_global(&point);
+
+	f.set_number_of_threads(1);
+	Eigen::VectorXd serial_gradient;
+	double serial_value = f.evaluate(point, &serial_gradient);
+
+	f.set_number_of_threads(3);
+	Eigen::VectorXd gradient1, gradient2;
+	double value1 = f.evaluate(point, &gradient1);
+	double value2 = f.evaluate(point, &gradient2);
+
+	// The same number of threads gives bitwise identical results.
+	EXPECT_EQ(value1, value2);
+	EXPECT_EQ(f.evaluate(point), f.evaluate(point));
+	CHECK((gradient1.array() == gradient2.array()).all());
+
+	// Other numbers of threads only differ by the summation order.
+	EXPECT_LT(std::abs(value1 - serial_value), 1e-9 * std::abs(serial_value));
+	EXPECT_LT((gradient1 - serial_gradient).norm(), 1e-9 * serial_gradient.norm());
+}
+
 TEST(Function, copy_constructor)
 {
 	Function* function = new Function;
@@ -300,8 +300,8 @@ Ellipse2D<T> scaledMajorRadius(const Ellipse2D<T>& ellipse, const T& target_radi
 };
 
 namespace internal {
-    template<class T> T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, T band_width, T step_epsilon, scalar_tag);
-    template<class T> T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, typename ad_traits<T>::scalar band_width, typename ad_traits<T>::scalar step_epsilon, ceres_jet_tag);
+    template<class T> T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, const cv::Point& centre, T band_width, T step_epsilon, scalar_tag);
+    template<class T> T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, const cv::Point& centre, typename ad_traits<T>::scalar band_width, typename ad_traits<T>::scalar step_epsilon, ceres_jet_tag);
 }
 
 // Calculates the "goodness" of an ellipse.
@@ -332,11 +332,12 @@ namespace internal {
 // r * (1 - ||A(p - t)||)  scales this to major radius of ellipse, for (roughly) pixel distance
 //
 template<class T>
-inline T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, typename ad_traits<T>::scalar band_width, typename ad_traits<T>::scalar step_epsilon) {
+inline T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, const cv::Point& centre, typename ad_traits<T>::scalar band_width, typename ad_traits<T>::scalar step_epsilon) {
+    // centre         Pixel position of the image centre (the origin of the ellipse coordinates) in eye, which may be a crop of the camera image
     // band_width     The width of each band (inner and outer)
     // step_epsilon   The epsilon of the soft step function
 
-    return internal::ellipseGoodness<T>(ellipse, eye, band_width, step_epsilon, typename ad_traits<T>::ad_tag());
+    return internal::ellipseGoodness<T>(ellipse, eye, centre, band_width, step_epsilon, typename ad_traits<T>::ad_tag());
 }
 
 //#define DEBUG_ELLIPSE_GOODNESS
@@ -351,7 +352,7 @@ inline T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& e
 namespace internal {
 // Non autodiff version of ellipse goodness calculation
 template<class T>
-T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, T band_width, T step_epsilon, scalar_tag) {
+T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, const cv::Point& centre, T band_width, T step_epsilon, scalar_tag) {
     using std::max;
     using std::min;
     using std::ceil;
@@ -370,7 +371,7 @@ T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, T b
 
     // Only iterate over pixels within the outer ellipse's bounding box
     cv::Rect bb = bounding_box(outerEllipse);
-    bb &= cv::Rect(-eye.cols/2,-eye.rows/2,eye.cols,eye.rows);
+    bb &= cv::Rect(-centre.x,-centre.y,eye.cols,eye.rows);
 
 
 #ifndef USE_INLINED_ELLIPSE_DIST
@@ -401,8 +402,8 @@ T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, T b
 #endif
 
     for (int i = bb.y; i < bb.y + bb.height; ++i IF_INLINED_ELLIPSE_DIST(, rA0yrAt += rA01)) {
-        // Image row pointer -- (0,0) is centre of image, so shift accordingly
-        const uint8_t* eye_i = eye[i + eye.rows/2];
+        // Image row pointer -- (0,0) is the image centre, so shift accordingly
+        const uint8_t* eye_i = eye[i + centre.y];
 
         // Only iterate over pixels between the inner and outer ellipse
         T ox1, ox2;
@@ -428,7 +429,7 @@ T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, T b
         // Go over x pairs (that is, outer-->outer or outer-->inner,inner-->outer)
         for (const auto& xpair : xpairs) {
             // Pixel pointer, shifted accordingly
-            const uint8_t* eye_ij = eye_i + xpair.first + eye.cols/2;
+            const uint8_t* eye_ij = eye_i + xpair.first + centre.x;
 
 #ifdef USE_INLINED_ELLIPSE_DIST
             // rA(0,y) + rA(x,0) - rAt, with x_0 = xpair.first
@@ -485,7 +486,7 @@ T ellipseGoodness(const Ellipse2D<T>& ellipse, const cv::Mat_<uint8_t>& eye, T b
 
 // Autodiff version of ellipse goodness calculation
 template<class Jet>
-Jet ellipseGoodness(const Ellipse2D<Jet>& ellipse, const cv::Mat_<uint8_t>& eye, typename ad_traits<Jet>::scalar band_width, typename ad_traits<Jet>::scalar step_epsilon, ceres_jet_tag) {
+Jet ellipseGoodness(const Ellipse2D<Jet>& ellipse, const cv::Mat_<uint8_t>& eye, const cv::Point& centre, typename ad_traits<Jet>::scalar band_width, typename ad_traits<Jet>::scalar step_epsilon, ceres_jet_tag) {
     using std::max;
     using std::min;
     using std::ceil;
@@ -513,7 +514,7 @@ Jet ellipseGoodness(const Ellipse2D<Jet>& ellipse, const cv::Mat_<uint8_t>& eye,
 
     // Only iterate over pixels within the outer ellipse's bounding box
     cv::Rect bb = bounding_box(constOuterEllipse);
-    bb &= cv::Rect(-eye.cols/2,-eye.rows/2,eye.cols,eye.rows);
+    bb &= cv::Rect(-centre.x,-centre.y,eye.cols,eye.rows);
 
 
 #ifndef USE_INLINED_ELLIPSE_DIST
@@ -552,8 +553,8 @@ Jet ellipseGoodness(const Ellipse2D<Jet>& ellipse, const cv::Mat_<uint8_t>& eye,
 #endif
 
     for (int i = bb.y; i < bb.y + bb.height; ++i IF_INLINED_ELLIPSE_DIST(, rA0yrAt += rA01)) {
-        // Image row pointer -- (0,0) is centre of image, so shift accordingly
-        const uint8_t* eye_i = eye[i + eye.rows/2];
+        // Image row pointer -- (0,0) is the image centre, so shift accordingly
+        const uint8_t* eye_i = eye[i + centre.y];
 
         // Only iterate over pixels between the inner and outer ellipse
         T ox1, ox2;
@@ -587,7 +588,7 @@ Jet ellipseGoodness(const Ellipse2D<Jet>& ellipse, const cv::Mat_<uint8_t>& eye,
         for (const auto& xpair : xpairs) {
 
             // Pixel pointer, shifted accordingly
-            const uint8_t* eye_ij = eye_i + xpair.first + eye.cols/2;
+            const uint8_t* eye_ij = eye_i + xpair.first + centre.x;
 
 #ifdef USE_INLINED_ELLIPSE_DIST
             // rA(0,y) + rA(x,0) - rAt, with x_0 = xpair.first
@@ -650,13 +651,13 @@ Jet ellipseGoodness(const Ellipse2D<Jet>& ellipse, const cv::Mat_<uint8_t>& eye,
                     count_inner.v.noalias() += inner_weight.v;
 
                     #ifdef DEBUG_ELLIPSE_GOODNESS
-                        eye_H(i + eye.rows/2,j + eye.cols/2)[2] = outer_weight.a*255;
-                        eye_H(i + eye.rows/2,j + eye.cols/2)[1] = inner_weight.a*255;
-                        eye_H(i + eye.rows/2,j + eye.cols/2)[0] = 255;
+                        eye_H(i + centre.y,j + centre.x)[2] = outer_weight.a*255;
+                        eye_H(i + centre.y,j + centre.x)[1] = inner_weight.a*255;
+                        eye_H(i + centre.y,j + centre.x)[0] = 255;
 
-                        eye_proc(i + eye.rows/2,j + eye.cols/2)[2] = outer_weight.a * eye_ij_val;
-                        eye_proc(i + eye.rows/2,j + eye.cols/2)[1] = inner_weight.a * eye_ij_val;
-                        eye_proc(i + eye.rows/2,j + eye.cols/2)[0] = 255;
+                        eye_proc(i + centre.y,j + centre.x)[2] = outer_weight.a * eye_ij_val;
+                        eye_proc(i + centre.y,j + centre.x)[1] = inner_weight.a * eye_ij_val;
+                        eye_proc(i + centre.y,j + centre.x)[0] = 255;
                     #endif
 
                 } else {
@@ -675,13 +676,13 @@ Jet ellipseGoodness(const Ellipse2D<Jet>& ellipse, const cv::Mat_<uint8_t>& eye,
                     count_inner.a += inner_weight;
 
                     #ifdef DEBUG_ELLIPSE_GOODNESS
-                    eye_H(i + eye.rows/2,j + eye.cols/2)[2] = outer_weight*255;
-                    eye_H(i + eye.rows/2,j + eye.cols/2)[1] = inner_weight*255;
-                    eye_H(i + eye.rows/2,j + eye.cols/2)[0] = 0;
+                    eye_H(i + centre.y,j + centre.x)[2] = outer_weight*255;
+                    eye_H(i + centre.y,j + centre.x)[1] = inner_weight*255;
+                    eye_H(i + centre.y,j + centre.x)[0] = 0;
 
-                    eye_proc(i + eye.rows/2,j + eye.cols/2)[2] = outer_weight * eye_ij_val;
-                    eye_proc(i + eye.rows/2,j + eye.cols/2)[1] = inner_weight * eye_ij_val;
-                    eye_proc(i + eye.rows/2,j + eye.cols/2)[0] = 255;
+                    eye_proc(i + centre.y,j + centre.x)[2] = outer_weight * eye_ij_val;
+                    eye_proc(i + centre.y,j + centre.x)[1] = inner_weight * eye_ij_val;
+                    eye_proc(i + centre.y,j + centre.x)[0] = 255;
                     #endif
                 }
             }
@@ -745,7 +746,7 @@ Circle3D<T> circleOnSphere(const Sphere<T>& sphere, T theta, T psi, T circle_rad
 
 template<typename T>
 struct EllipseGoodnessFunction {
-    T operator()(const Sphere<T>& eye, T theta, T psi, T pupil_radius, T focal_length, typename ad_traits<T>::scalar band_width, typename ad_traits<T>::scalar step_epsilon, const cv::Mat& mEye) {
+    T operator()(const Sphere<T>& eye, T theta, T psi, T pupil_radius, T focal_length, typename ad_traits<T>::scalar band_width, typename ad_traits<T>::scalar step_epsilon, const cv::Mat& mEye, const cv::Point& mEyeCentre) {
         typedef Eigen::Matrix<T,3,1> Vector3;
         typedef typename ad_traits<T>::scalar Const;
 
@@ -800,7 +801,7 @@ struct EllipseGoodnessFunction {
 
         Ellipse2D<T> pupil_ellipse(project(pupil_circle, focal_length));
 
-        return ellipseGoodness<T>(pupil_ellipse, mEye, band_width, step_epsilon);
+        return ellipseGoodness<T>(pupil_ellipse, mEye, mEyeCentre, band_width, step_epsilon);
     }
 };
 
@@ -865,16 +866,18 @@ struct PupilContrastTerm : public spii::Term {
     const Sphere<double>& init_eye;
     double focal_length;
     const cv::Mat eye_image;
+    const cv::Point eye_image_centre;
     double band_width;
     double step_epsilon;
 
     int eye_var_idx() const { return has_eye_var ? 0 : -1; }
     int pupil_var_idx() const { return has_eye_var ? 1 : 0; }
 
-    PupilContrastTerm(const Sphere<double>& eye, double focal_length, cv::Mat eye_image, double band_width, double step_epsilon) :
+    PupilContrastTerm(const Sphere<double>& eye, double focal_length, cv::Mat eye_image, cv::Point eye_image_centre, double band_width, double step_epsilon) :
         init_eye(eye),
         focal_length(focal_length),
         eye_image(eye_image),
+        eye_image_centre(eye_image_centre),
         band_width(band_width),
         step_epsilon(step_epsilon)
     {}
@@ -911,7 +914,7 @@ struct PupilContrastTerm : public spii::Term {
             theta, psi, r,
             focal_length,
             band_width, step_epsilon,
-            eye_image);
+            eye_image, eye_image_centre);
 
         return -goodness;
     }
@@ -942,7 +945,7 @@ struct PupilContrastTerm : public spii::Term {
                     theta, psi, r,
                     EyePupilJet(focal_length),
                     band_width, step_epsilon,
-                    eye_image);
+                    eye_image, eye_image_centre);
             }
 
             contrast_goodness_a = contrast_goodness.a;
@@ -965,7 +968,7 @@ struct PupilContrastTerm : public spii::Term {
                     theta, psi, r,
                     PupilJet(focal_length),
                     band_width, step_epsilon,
-                    eye_image);
+                    eye_image, eye_image_centre);
             }
 
             contrast_goodness_a = contrast_goodness.a;
@@ -1053,6 +1056,12 @@ struct PupilAnthroTerm : public spii::Term {
 
 };
 
+// Position of the image centre in an observation's image resized by scale, for contrast terms on the resized image
+static cv::Point scaledImageCentre(const EyeModelFitter::Observation& observation, double scale)
+{
+    return cv::Point(cvRound(observation.image_centre.x * scale), cvRound(observation.image_centre.y * scale));
+}
+
 const EyeModelFitter::Vector3 EyeModelFitter::camera_centre = EyeModelFitter::Vector3::Zero();
 
 
@@ -1079,6 +1088,11 @@ EyeModelFitter::PupilParams::PupilParams() : theta(0), psi(0), radius(0)
 
 
 EyeModelFitter::Observation::Observation(cv::Mat image, Ellipse ellipse, std::vector<cv::Point2f> inliers) : image(std::move(image)), ellipse(std::move(ellipse)), inliers(std::move(inliers))
+{
+    image_centre = cv::Point(this->image.cols/2, this->image.rows/2);
+}
+
+EyeModelFitter::Observation::Observation(cv::Mat image, cv::Point image_centre, Ellipse ellipse, std::vector<cv::Point2f> inliers) : image(std::move(image)), image_centre(image_centre), ellipse(std::move(ellipse)), inliers(std::move(inliers))
 {
 
 }
@@ -1091,11 +1105,11 @@ EyeModelFitter::Observation::Observation()
 }
 
 
-singleeyefitter::EyeModelFitter::EyeModelFitter() : region_band_width(5), region_step_epsilon(0.5), region_scale(1)
+singleeyefitter::EyeModelFitter::EyeModelFitter() : region_band_width(5), region_step_epsilon(0.5), region_scale(1), region_threads(0)
 {
 
 }
-singleeyefitter::EyeModelFitter::EyeModelFitter(double focal_length, double region_band_width, double region_step_epsilon) : focal_length(focal_length), region_band_width(region_band_width), region_step_epsilon(region_step_epsilon), region_scale(1)
+singleeyefitter::EyeModelFitter::EyeModelFitter(double focal_length, double region_band_width, double region_step_epsilon) : focal_length(focal_length), region_band_width(region_band_width), region_step_epsilon(region_step_epsilon), region_scale(1), region_threads(0)
 {
 
 }
@@ -1114,11 +1128,16 @@ singleeyefitter::EyeModelFitter::Index singleeyefitter::EyeModelFitter::add_obse
 {
     assert(image.channels() == 1 && image.depth() == CV_8U);
 
+    return add_observation(Observation(std::move(image), std::move(pupil), std::move(pupil_inliers)));
+}
+
+singleeyefitter::EyeModelFitter::Index singleeyefitter::EyeModelFitter::add_observation(Observation observation)
+{
+    assert(observation.image.channels() == 1 && observation.image.depth() == CV_8U);
+
     std::lock_guard<std::mutex> lock_model(model_mutex);
 
-    pupils.emplace_back(
-        Observation(std::move(image), std::move(pupil), std::move(pupil_inliers))
-        );
+    pupils.emplace_back(std::move(observation));
     return pupils.size() - 1;
 }
 
@@ -1167,6 +1186,7 @@ void singleeyefitter::EyeModelFitter::print_single_contrast_metric(const Pupil&
         eye,
         focal_length * region_scale,
         cvx::resize(pupil.observation.image, region_scale),
+        scaledImageCentre(pupil.observation, region_scale),
         region_band_width,
         region_step_epsilon);
 
@@ -1199,6 +1219,7 @@ double singleeyefitter::EyeModelFitter::single_contrast_metric(const Pupil& pupi
         eye,
         focal_length * region_scale,
         cvx::resize(pupil.observation.image, region_scale),
+        scaledImageCentre(pupil.observation, region_scale),
         region_band_width,
         region_step_epsilon);
 
@@ -1228,6 +1249,7 @@ const singleeyefitter::EyeModelFitter::Circle& singleeyefitter::EyeModelFitter::
         eye,
         focal_length * region_scale,
         cvx::resize(pupil.observation.image, region_scale),
+        scaledImageCentre(pupil.observation, region_scale),
         region_band_width,
         region_step_epsilon), &params[0]);
 
@@ -1413,7 +1435,6 @@ void singleeyefitter::EyeModelFitter::refine_with_inliers(const CallbackFunction
     }
     ceres::Solver::Summary summary;
     ceres::Solve(options, &problem, &summary);
-    std::cout << summary.BriefReport() << "\n";
 
     {
         std::lock_guard<std::mutex> lock_model(model_mutex);
@@ -1462,6 +1483,7 @@ void singleeyefitter::EyeModelFitter::refine_with_region_contrast(const Callback
                     eye,
                     focal_length * region_scale,
                     cvx::resize(pupils[i].observation.image, region_scale),
+                    scaledImageCentre(pupils[i].observation, region_scale),
                     region_band_width,
                     region_step_epsilon),
                     &x0[0], &x0[3 + 3 * i]);
@@ -1476,6 +1498,10 @@ void singleeyefitter::EyeModelFitter::refine_with_region_contrast(const Callback
         }
     }
 
+    // The contrast terms of the observations are independent and evaluated in parallel
+    if (region_threads > 0)
+        f.set_number_of_threads(region_threads);
+
     spii::LBFGSSolver solver;
     solver.maximum_iterations = 1000;
     solver.function_improvement_tolerance = 1e-5;
@@ -1502,7 +1528,6 @@ void singleeyefitter::EyeModelFitter::refine_with_region_contrast(const Callback
     }
 #endif
     solver.solve(f, &results);
-    std::cout << results << std::endl;
 
     {
         std::lock_guard<std::mutex> lock_model(model_mutex);
@@ -1604,6 +1629,52 @@ void singleeyefitter::EyeModelFitter::initialise_model()
     }*/
 }
 
+bool singleeyefitter::EyeModelFitter::update_model(std::vector<Observation> observations, double pupil_radius /*= 1*/, double inlier_distance /*= 10*/)
+{
+    {
+        std::lock_guard<std::mutex> lock_model(model_mutex);
+
+        if (eye == Sphere::Null) {
+            return false;
+        }
+
+        // Warm start: instead of searching the eye centre with RANSAC as in unproject_observations, keep the current one and
+        // use it to disambiguate the pupil circles and to reject stray gaze lines
+        Vector2 eye_centre_proj = project(eye.centre, focal_length);
+
+        std::vector<Pupil> updated_pupils;
+        updated_pupils.reserve(observations.size());
+        size_t inlier_count = 0;
+
+        for (auto& observation : observations) {
+            updated_pupils.emplace_back(std::move(observation));
+            Pupil& pupil = updated_pupils.back();
+
+            unproject_single_observation(pupil, pupil_radius);
+
+            Vector2 c_proj = project(pupil.circle.centre, focal_length);
+            Vector2 v_proj = project(pupil.circle.normal + pupil.circle.centre, focal_length) - c_proj;
+            v_proj.normalize();
+
+            pupil.init_valid = euclidean_distance(eye_centre_proj, Line(c_proj, v_proj)) < inlier_distance;
+            if (pupil.init_valid) {
+                ++inlier_count;
+            }
+        }
+
+        // The eye moved too far (e.g. the camera was adjusted), the current model no longer explains the observations
+        if (inlier_count < 2) {
+            return false;
+        }
+
+        pupils = std::move(updated_pupils);
+    }
+
+    // Re-estimates the eye radius and the pupils against the kept eye centre, and invalidates running refinements
+    initialise_model();
+    return true;
+}
+
 void singleeyefitter::EyeModelFitter::unproject_observations(double pupil_radius /*= 1*/, double eye_z /*= 20*/, bool use_ransac /*= true*/)
 {
     using math::sq;
@@ -1717,11 +1788,6 @@ void singleeyefitter::EyeModelFitter::unproject_observations(double pupil_radius
             }
         }
 
-        std::cout << "Inliers: " << best_inlier_indices.size()
-            << " (" << (100.0*best_inlier_indices.size() / pupil_gazelines_proj.size()) << "%)"
-            << " = " << best_line_distance_error
-            << std::endl;
-
         for (auto& pupil : pupils) {
             pupil.init_valid = false;
         }
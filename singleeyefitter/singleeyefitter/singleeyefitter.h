@@ -61,6 +61,7 @@ namespace singleeyefitter {
         double region_band_width;
         double region_step_epsilon;
         double region_scale;
+        int region_threads; // Threads evaluating the region contrast terms, 0 uses spii's default (all cores)
 
         // Constructors
         EyeModelFitter();
@@ -89,11 +90,13 @@ namespace singleeyefitter {
 
         struct Observation {
             cv::Mat image;
+            cv::Point image_centre; // Pixel position of the camera image centre (the origin of ellipse and inliers) in image, which may be a crop
             Ellipse ellipse;
             std::vector<cv::Point2f> inliers;
 
             Observation();
             Observation(cv::Mat image, Ellipse ellipse, std::vector<cv::Point2f> inliers);
+            Observation(cv::Mat image, cv::Point image_centre, Ellipse ellipse, std::vector<cv::Point2f> inliers);
         };
         struct PupilParams {
             double theta, psi, radius;
@@ -110,6 +113,14 @@ namespace singleeyefitter {
             Pupil(Observation observation);
         };
 
+        // Observations with their own image_centre, e.g. crops around the pupil
+        Index add_observation(Observation observation);
+
+        // Replaces the observations and re-initialises the model warm-started from the current eye centre, without the RANSAC
+        // search of unproject_observations(). Returns false (leaving the model to a full refit) if there is no eye yet or fewer
+        // than two gaze lines pass within inlier_distance pixels of the projected eye centre
+        bool update_model(std::vector<Observation> observations, double pupil_radius = 1, double inlier_distance = 10);
+
         //
         // Local (single pupil) calculations
         //
@@ -173,6 +173,22 @@ void MainWindow::PRGopenSingleWebcam(int deviceID) {
     singleWebcamSelected(action);
 }
 
+void MainWindow::PRGopenSyntheticCamera(const QString &mode) {
+    if(selectedCamera && selectedCamera->isOpen())
+        return;
+
+    QAction *action = new QAction();
+    action->setData(mode == "stereo");
+    syntheticCameraSelected(action);
+}
+
+void MainWindow::PRGsetSyntheticCameraParams(const QString &spec) {
+    SyntheticCameraParams params;
+    SyntheticCamera::parseParams(applicationSettings->value("syntheticCamera.params", "").toString(), params);
+    if(SyntheticCamera::parseParams(spec, params))
+        applicationSettings->setValue("syntheticCamera.params", SyntheticCamera::paramsToString(params));
+}
+
 /*void MainWindow::PRGincrementTrial() {
     if(dataStreamer)
         dataStreamer->incrementTrial();
@@ -212,7 +228,7 @@ void MainWindow::PRGsetImageOutputFormat(QString format) {
 }
 
 void MainWindow::PRGsetPupilDetectionAlgorithm(const QString &alg) {
-    if( alg == "else" || alg == "excuse" || alg == "pure" || alg == "purest" || alg == "starburst" || alg == "swirski2d" ) {
+    if( alg == "else" || alg == "excuse" || alg == "pure" || alg == "purest" || alg == "starburst" || alg == "swirski2d" || alg == "swirski3d" ) {
         pupilDetectionWorker->setAlgorithm(alg);
         applicationSettings->setValue("PupilDetectionSettingsDialog.algorithm", alg);
     }
@@ -47,6 +47,8 @@ void CameraCalibration::reset() {
     cameraMatrix.at<double>(0,0) = 1.0;
 
     distCoeffs = cv::Mat::zeros(8, 1, CV_64F);
+    undistRemapper.clear();
+    undistLUT.clear();
     emit unavailableCalibration();
 }
 
@@ -208,6 +210,8 @@ void CameraCalibration::onNewImage(const CameraImage &cimg) {
             // Initials the maps for image mapping for undistortion using cv::remap
             newCameraMatrix = getOptimalNewCameraMatrix(cameraMatrix, distCoeffs, imageSize, 1, imageSize, 0);
             initUndistortRectifyMap(cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix, imageSize, CV_32F, undistMap1, undistMap2);
+            undistRemapper.setMaps(undistMap1, undistMap2);
+            undistLUT.build(cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix, imageSize);
 
             emit finishedCalibration();
         } else if(calibrationSuccess.isFinished() && !calibrationSuccess.result()) {
@@ -221,9 +225,8 @@ void CameraCalibration::onNewImage(const CameraImage &cimg) {
         if(timer.elapsed() > drawDelay && !img.empty()) {
             timer.restart();
 
-            cv::Mat undist = img.clone();
             //cv::undistort(img, undist, cameraMatrix, distCoeffs); // replaced with remap, should be faster
-            cv::remap(img, undist, undistMap1, undistMap2, cv::INTER_LINEAR);
+            cv::Mat undist = undistRemapper.remap(img);
 
             cv::putText(undist, "UNDISTORTED", cv::Point(static_cast<int>(static_cast<int>(0.1 * undist.cols)), static_cast<int>(static_cast<int>(
                     0.1 * undist.rows))), cv::FONT_HERSHEY_PLAIN, 4, cv::Scalar(255, 0, 0), 3);
@@ -514,6 +517,8 @@ void CameraCalibration::loadFromFile(QString filename) {
         initUndistortRectifyMap(cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix, imageSize, CV_32F, undistMap1, undistMap2);
 
         if(cv::checkRange(undistMap1) && cv::checkRange(undistMap2)) {
+            undistRemapper.setMaps(undistMap1, undistMap2);
+            undistLUT.build(cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix, imageSize);
             mode = CALIBRATED;
             emit finishedCalibration();
         }
@@ -527,33 +532,51 @@ cv::Mat CameraCalibration::undistortImage(const cv::Mat &img) {
     if(mode!=CALIBRATED)
         return img;
 
-    cv::Mat undist;
-    cv::remap(img, undist, undistMap1, undistMap2, cv::INTER_LINEAR);
-    return undist;
+    return undistRemapper.remap(img);
+}
+
+// Undistorts only the region roi of the undistorted image, which is much faster than undistorting the whole image for small ROIs
+// The result has the size of the roi (clipped to the image), if no calibration is load, the unchanged image region is returned
+cv::Mat CameraCalibration::undistortImage(const cv::Mat &img, const cv::Rect &roi) {
+    if(mode!=CALIBRATED)
+        return img(roi & cv::Rect(0, 0, img.cols, img.rows));
+
+    return undistRemapper.remap(img, roi);
 }
 
 // Undistorts only the pupil size of a given pupil detection, rather then the complete image (faster)
 // This is done by undistorting only contour points of the pupil and calculating the new pupil size using the undistorted points
 double CameraCalibration::undistortPupilDiameter(const Pupil &pupil) {
-    // Undistorting using remap should be faster than using the undistort function
-    if(mode!=CALIBRATED || !pupil.valid(-2))
-        return pupil.diameter();
+    return undistortPupilDiameters(std::vector<Pupil>{pupil}).front();
+}
 
-    Pupil rotPupil(pupil);
-    rotPupil.angle += 360-rotPupil.angle;
+// Undistorts the sizes of several pupil detections in one batch
+// Points of the whole fitted pupil ellipse are undistorted through the cached lookup table, and the major axis of the
+// ellipse fitted to the undistorted points is the undistorted diameter
+std::vector<double> CameraCalibration::undistortPupilDiameters(const std::vector<Pupil> &pupils) {
 
-    // Select the top left and top right corner of the bounding rects of the pupils as the points we undistort
-    cv::Point2f mainPointsArr[4]; // rotatedRect points in order: bottomLeft, topLeft, topRight, bottomRight
-    rotPupil.points(mainPointsArr);
-    int secondPoint = rotPupil.size.width > rotPupil.size.height ? 2 : 0; // if the pupil major axis is horizontal use topLeft and topRight, else topLeft and bottomLeft
+    std::vector<double> diameters(pupils.size());
+    std::vector<size_t> measured;
+    std::vector<cv::Point2f> contours;
 
-    std::vector<cv::Point2f> mainPoints{mainPointsArr[1], mainPointsArr[secondPoint]};
+    for(size_t i=0; i<pupils.size(); i++) {
+        diameters[i] = pupils[i].diameter();
+        if(mode==CALIBRATED && pupils[i].valid(-2) && pupils[i].size.area() > 0) {
+            PupilGeometry::sampleContour(pupils[i], PupilGeometry::contourSamples, contours);
+            measured.push_back(i);
+        }
+    }
+    if(measured.empty())
+        return diameters;
 
-    std::vector<cv::Point2f> undistCornerPointsBuf;
+    std::vector<cv::Point2f> undistContours;
+    if(!undistLUT.undistortPoints(contours, undistContours))
+        cv::undistortPoints(contours, undistContours, cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix);
 
-    cv::undistortPoints(cv::Mat(mainPoints), undistCornerPointsBuf, cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix);
+    for(size_t k=0; k<measured.size(); k++)
+        diameters[measured[k]] = PupilGeometry::majorAxis(&undistContours[k * PupilGeometry::contourSamples], PupilGeometry::contourSamples);
 
-    return cv::norm(undistCornerPointsBuf[0] - undistCornerPointsBuf[1]);
+    return diameters;
 }
 
 // Helper function to persist error values to csv file
@@ -10,6 +10,8 @@
 #include <QtCore/QMutex>
 #include "devices/camera.h"
 #include "pupil-detection-methods/Pupil.h"
+#include "roiRemapper.h"
+#include "pupilGeometry.h"
 #include <QtConcurrent/QtConcurrent>
 
 enum CalibrationPattern {CHESSBOARD = 0, CIRCLES_GRID = 1, ASYMMETRIC_CIRCLES_GRID = 2};
@@ -146,6 +148,7 @@ public:
     }
 
     cv::Mat undistortImage(const cv::Mat &img);
+    cv::Mat undistortImage(const cv::Mat &img, const cv::Rect &roi);
 
     void setVerifyOutputPath(QString path) {
         verifyOutputPath = path;
@@ -156,6 +159,7 @@ public:
     }
 
     double undistortPupilDiameter(const Pupil &pupil);
+    std::vector<double> undistortPupilDiameters(const std::vector<Pupil> &pupils);
 
 private:
 
@@ -172,6 +176,8 @@ private:
     QFuture<bool> calibrationSuccess;
 
     cv::Mat undistMap1, undistMap2;
+    ROIRemapper undistRemapper;
+    UndistortionLUT undistLUT;
 
     double intrinsicRMSE;
     double avgMAE;
@@ -7,6 +7,7 @@
 #include <QtCore/QObject>
 #include <QByteArray>
 #include "connPool.h"
+#include "udpReceiverThread.h"
 #include <QUdpSocket>
 
 /**
@@ -19,49 +20,61 @@ struct ConnPoolUDPInstanceSettings {
 
 /**
     This class is necessary for the UDP pool to work. Each of these instances can start a separate listener.
+
+    Listening is done by a UDPReceiverThread reading the socket, so incoming commands (e.g. trial increments) are timestamped
+    upon arrival, not when the GUI thread gets to process them. Messages are still delivered to subscribers in the thread of this instance.
 */
 class ConnPoolUDPInstance : public QObject {
     Q_OBJECT
 
     public:
         explicit ConnPoolUDPInstance(QUdpSocket *UDPsocket, ConnPoolPurposeFlag purposeFlag, QObject *parent) : QObject(parent), UDPSocket(UDPsocket), purposeFlags((uint8_t)purposeFlag) {};
-        ~ConnPoolUDPInstance() override {};
+        ~ConnPoolUDPInstance() override {
+            stopListening();
+        };
 
         bool startListening() {
-            bool isOpen = UDPSocket->isOpen();
-            bool handleReadyReadWorking = connect(UDPSocket, SIGNAL(readyRead()), this, SLOT(handleReadyRead()), Qt::QueuedConnection);
+            if(!UDPSocket->isOpen())
+                return false;
+            if(receiverThread)
+                return true;
+            receiverThread = new UDPReceiverThread(UDPSocket->socketDescriptor(), this);
             // NOTE: No errorOccured() or similar signal exists for the UDP socket instances, as it was the case for COM instances
-            return isOpen && handleReadyReadWorking;
+            bool handleDatagramsWorking = connect(receiverThread, SIGNAL(datagramsAvailable()), this, SLOT(handleDatagrams()), Qt::QueuedConnection);
+            receiverThread->start(QThread::TimeCriticalPriority);
+            return handleDatagramsWorking;
+        };
+
+        // Must be called before the socket is closed
+        void stopListening() {
+            if(!receiverThread)
+                return;
+            receiverThread->stop();
+            receiverThread->wait();
+            delete receiverThread;
+            receiverThread = nullptr;
         };
 
     QUdpSocket *UDPSocket;
     uint8_t purposeFlags;
         
+    private:
+        UDPReceiverThread *receiverThread = nullptr;
+        std::vector<ReceivedDatagram> datagrams;
+
     private slots:
-        void handleReadyRead() {
-
-            QHostAddress sender;
-            quint16 port;
-            QByteArray datagram;
-            while(UDPSocket->hasPendingDatagrams())
-            {
-                quint64 timestamp  = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-                //qDebug() << "Got message at unix time: " << QString::number(timestamp);
-
-                datagram.resize(UDPSocket->pendingDatagramSize());
-                // NOTE: the (target/sender filter) IP address of the connection is also kept in UDPSocket->objectName()
-                // but we dont read and convert it here, because it should be the same as ipAddress anyway. The objectName()
-                // is only for the ConnPoolUDP to know what IP we are targeting/filtering, although writing to the port
-                // is not (yet) handled by the ConnPoolUDPInstance
-                UDPSocket->readDatagram(datagram.data(), datagram.size(), &sender, &port);
-                emit messageReceived(QString::fromStdString(datagram.toStdString()), timestamp);
-            }
+        void handleDatagrams() {
+            if(!receiverThread)
+                return;
 
-            // NOTE: Somehow there is always one more "dummy" readDatagram call to make,
-            // otherwise no new readyRead() will be emitted, and this function would never be called again.
-            // Is this a Qt bug? Seen in Qt 5.15
-            datagram.resize(UDPSocket->pendingDatagramSize());
-            UDPSocket->readDatagram(datagram.data(), datagram.size(), &sender, &port);
+            // NOTE: the (target/sender filter) IP address of the connection is also kept in UDPSocket->objectName()
+            // but we dont read and check the sender here, because it should be the same as ipAddress anyway. The objectName()
+            // is only for the ConnPoolUDP to know what IP we are targeting/filtering, although writing to the port
+            // is not (yet) handled by the ConnPoolUDPInstance
+            datagrams.clear();
+            receiverThread->takeDatagrams(datagrams);
+            for(const ReceivedDatagram &datagram : datagrams)
+                emit messageReceived(QString::fromUtf8(datagram.data), (quint64)(datagram.timestampUs / 1000));
         };
 
 //        void handleError() {
@@ -200,6 +213,7 @@ public:
 
                 // Try to send the last message before closing, though not sure it this succeeds
                 // See: https://forum.qt.io/topic/112651/send-a-serial-message-before-closing-the-serial-port-in-qt/15
+                instancePool[idx]->stopListening();
                 instancePool[idx]->UDPSocket->waitForBytesWritten(1000); //
                 instancePool[idx]->UDPSocket->flush(); //
                 instancePool[idx]->UDPSocket->close();
@@ -47,6 +47,19 @@ void DataStreamer::stopCOMStreamer() {
 }
 
 // On new pupil data, stream it
+void DataStreamer::setResultSource(PupilResultBroadcaster *broadcaster) {
+    resultReader.setSource(broadcaster);
+}
+
+// Reads all results published since the last call, several frames are handled at once if this thread was busy
+void DataStreamer::newPupilResults(quint64 sequence) {
+    const quint64 lost = resultReader.readUpTo(sequence, [this](quint64 timestamp, int procMode, const std::vector<Pupil> &Pupils, const QString &filename) {
+        newPupilData(timestamp, procMode, Pupils, filename);
+    });
+    if(lost > 0)
+        std::cerr << "DataStreamer: " << lost << " pupil detection results were overwritten before they could be streamed" << std::endl;
+}
+
 void DataStreamer::newPupilData(quint64 timestamp, int procMode, const std::vector<Pupil> &Pupils, const QString &filename) {
 
     _trialNumber = recEventTracker->getTrialIncrement(timestamp).trialNumber;
@@ -35,6 +35,9 @@
     I introduced to manage different pupil detection processing modes (procModes).
     Also it uses EyeDataSerializer class to process every pupil detection output.
 
+    setResultSource(): sets the broadcaster to read the pupil detection results from, newPupilResults() then reads every result
+                       not read yet and passes it to newPupilData()
+
 */
 class DataStreamer : public QObject {
     Q_OBJECT
@@ -61,6 +64,8 @@ public:
 
     int getNumActiveStreamers();
 
+    void setResultSource(PupilResultBroadcaster *broadcaster);
+
 private:
 
     ConnPoolCOM *connPoolCOM;
@@ -85,8 +90,11 @@ private:
     QString _message = "";
     std::vector<double> _d = {-1.0,-1.0};
 
+    PupilResultReader resultReader;
+
 public slots:
 
+    void newPupilResults(quint64 sequence);
     void newPupilData(quint64 timestamp, int procMode, const std::vector<Pupil> &Pupils, const QString &filename);
 
 signals:
@@ -22,6 +22,8 @@ DataWriter::DataWriter(
     QString dataStyleStr = applicationSettings->value("dataWriterDataStyle", "PupilEXT-0-1-2").toString();
     if(dataStyleStr == "PupilEXT-0-1-1")
         dataStyle = PUPILEXT_V0_1_1;
+    else if(dataStyleStr == "PupilEXT-0-1-3")
+        dataStyle = PUPILEXT_V0_1_3;
     else // if(dataStyleStr == "PupilEXT-0-1-2")
         dataStyle = PUPILEXT_V0_1_2;
 
@@ -96,6 +98,19 @@ void DataWriter::close() {
 // GB: replacing previous methods for single pupil detection from single or stereo cameras, 
 // as well as adding new capability to write data of other processing modes
 // On new pupil data, write the pupil detection to file in a new row
+void DataWriter::setResultSource(PupilResultBroadcaster *broadcaster) {
+    resultReader.setSource(broadcaster);
+}
+
+// Reads all results published since the last call, several frames are handled at once if this thread was busy
+void DataWriter::newPupilResults(quint64 sequence) {
+    const quint64 lost = resultReader.readUpTo(sequence, [this](quint64 timestamp, int procMode, const std::vector<Pupil> &Pupils, const QString &filename) {
+        newPupilData(timestamp, procMode, Pupils, filename);
+    });
+    if(lost > 0)
+        std::cerr << "DataWriter: " << lost << " pupil detection results were overwritten before they could be written" << std::endl;
+}
+
 void DataWriter::newPupilData(quint64 timestamp, int procMode, const std::vector<Pupil> &Pupils, const QString &filename) {
     if (!textStream)
         return;
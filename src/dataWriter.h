@@ -18,7 +18,8 @@
 // BG NOTE: must come here due to eyeDataSerializer.h and this dataWriter.h including each other. Compiler has to know the enum before looking at the other one
 enum DataWriterDataStyle {
     PUPILEXT_V0_1_1 = 1,
-    PUPILEXT_V0_1_2 = 2
+    PUPILEXT_V0_1_2 = 2,
+    PUPILEXT_V0_1_3 = 3 // v0.1.2 plus the blink flag columns
 };
 
 #include "eyeDataSerializer.h"
@@ -32,6 +33,9 @@ enum DataWriterDataStyle {
     newPupilData(): called for each new pupil data, writes the pupil data to the file stream (which is flushes its content to disk occasionally)
 
     writePupilData(): given a vector of pupil data, write all its entries to file
+
+    setResultSource(): sets the broadcaster to read the pupil detection results from, newPupilResults() then reads every result
+                       not read yet and passes it to newPupilData()
 */
 
 class DataWriter : public QObject {
@@ -47,6 +51,7 @@ public:
         );
     ~DataWriter() override;
     void close();
+    void setResultSource(PupilResultBroadcaster *broadcaster);
 
     // GB: found these unreferenced functions. I updated the functionality, now available in a new function under the name writePupilData()
     //void writePupilData(const std::vector<Pupil>& pupilData);
@@ -79,8 +84,11 @@ private:
 
     bool writerReady;
 
+    PupilResultReader resultReader;
+
 public slots:
 
+    void newPupilResults(quint64 sequence);
     // GB: changed to work with vector of pupils due to different procModes
     void newPupilData(quint64 timestamp, int procMode, const std::vector<Pupil> &Pupils, const QString &filename);
 };
@@ -0,0 +1,60 @@
+
+#include "detectionTaskGroup.h"
+
+#include <iostream>
+
+DetectionTaskGroup::DetectionTaskGroup(DetectFunction detect, QThreadPool *pool) :
+    detect(std::move(detect)),
+    pool(pool),
+    failed(false) {
+
+    for(Task &task : tasks)
+        task.group = this;
+}
+
+bool DetectionTaskGroup::run(std::initializer_list<View> views) {
+    return run(views.begin(), views.size());
+}
+
+bool DetectionTaskGroup::run(const std::vector<View> &views) {
+    return run(views.data(), views.size());
+}
+
+bool DetectionTaskGroup::run(const View *views, size_t numViews) {
+
+    if(numViews == 0)
+        return true;
+    if(numViews > static_cast<size_t>(maxViews)) {
+        std::cerr << "DetectionTaskGroup: " << numViews << " views exceed the maximum of " << maxViews << std::endl;
+        return false;
+    }
+
+    const int count = static_cast<int>(numViews);
+    failed = false;
+
+    int i;
+    for(i=0; i<count; i++)
+        tasks[i].view = views[i];
+
+    for(i=1; i<count; i++)
+        pool->start(&tasks[i]);
+    tasks[0].run();
+
+    finished.acquire(count);
+
+    // Drop the frame references, so the images of the frame are not kept alive until the next one
+    for(i=0; i<count; i++)
+        tasks[i].view.frame.release();
+
+    return !failed;
+}
+
+// Unhandled exceptions of a detection must not escape into the thread pool, they are reported to run() instead
+void DetectionTaskGroup::Task::run() {
+    try {
+        *view.pupil = group->detect(view);
+    } catch (...) {
+        group->failed = true;
+    }
+    group->finished.release();
+}
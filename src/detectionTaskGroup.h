@@ -0,0 +1,81 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "pupil-detection-methods/Pupil.h"
+#include "pupil-detection-methods/PupilDetectionMethod.h"
+
+/**
+    Fan-out/fan-in of the per-view pupil detections of one frame, as done in the two pupil and stereo processing modes
+
+    The tasks are created once and resubmitted to the detection thread pool every frame, instead of creating and synchronizing futures
+    per frame. The first view is detected on the calling thread, which would otherwise just wait, the other views on the pool. The
+    frames are only passed as cv::Mat headers, i.e. views into the preprocessed images of the frame, no pixels are copied.
+
+    A view may restrict the search to a window of its frame, with the expected pupil diameter range, as passed to the ROI variant of
+    PupilDetectionMethod::run(). The pupil is then still in frame coordinates.
+
+    run(): detects the pupils of the views concurrently and returns once all are done, returns false if a detection threw an exception,
+        the pupils are undefined then
+*/
+class DetectionTaskGroup {
+
+public:
+
+    static const int maxViews = 4;
+
+    struct View {
+        PupilDetectionMethod *method;
+        cv::Mat frame;
+        Pupil *pupil;
+        // Empty to search the whole frame
+        cv::Rect window;
+        float minPupilDiameterPx;
+        float maxPupilDiameterPx;
+
+        View() : method(nullptr), pupil(nullptr), minPupilDiameterPx(-1), maxPupilDiameterPx(-1) {}
+        View(PupilDetectionMethod *method, const cv::Mat &frame, Pupil *pupil, const cv::Rect &window=cv::Rect(), float minPupilDiameterPx=-1, float maxPupilDiameterPx=-1) :
+            method(method), frame(frame), pupil(pupil), window(window), minPupilDiameterPx(minPupilDiameterPx), maxPupilDiameterPx(maxPupilDiameterPx) {}
+    };
+
+    typedef std::function<Pupil(const View&)> DetectFunction;
+
+    DetectionTaskGroup(DetectFunction detect, QThreadPool *pool);
+
+    bool run(std::initializer_list<View> views);
+    bool run(const std::vector<View> &views);
+
+private:
+
+    // Not deleted by the pool, the pool only reads autoDelete() before running it, so the task can be resubmitted once it released the semaphore
+    class Task : public QRunnable {
+    public:
+        Task() : group(nullptr) { setAutoDelete(false); }
+        void run() override;
+
+        DetectionTaskGroup *group;
+        View view;
+    };
+
+    DetectFunction detect;
+    QThreadPool *pool;
+
+    bool run(const View *views, size_t count);
+
+    Task tasks[maxViews];
+    QSemaphore finished;
+    std::atomic<bool> failed;
+};
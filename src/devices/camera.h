@@ -13,8 +13,9 @@
 
 
     GB: added LIVE_SINGLE_WEBCAM 
+    SYNTHETIC_SINGLE_CAMERA and SYNTHETIC_STEREO_CAMERA are procedurally rendered eye images (SyntheticCamera)
 */
-enum CameraImageType { LIVE_SINGLE_CAMERA=0, LIVE_STEREO_CAMERA=1, SINGLE_IMAGE_FILE=2, STEREO_IMAGE_FILE=3, LIVE_SINGLE_WEBCAM = 4 };
+enum CameraImageType { LIVE_SINGLE_CAMERA=0, LIVE_STEREO_CAMERA=1, SINGLE_IMAGE_FILE=2, STEREO_IMAGE_FILE=3, LIVE_SINGLE_WEBCAM = 4, SYNTHETIC_SINGLE_CAMERA = 5, SYNTHETIC_STEREO_CAMERA = 6 };
 
 /**
     Struct representing a camera image returned from a camera and its respective meta-data
@@ -74,6 +74,9 @@ public:
     QString getImageDirectoryName() {
         return imageReader->getImageDirectoryName();
     }
+    const std::vector<std::string> &getFilenames() {
+        return imageReader->getFilenames();
+    }
     QString getImageWidth() {
         return QString::number(imageReader->getImageWidth());
     }
@@ -87,6 +90,12 @@ public:
     std::vector<cv::Mat> getStillImageStereo(int frameNumber) {
         return imageReader->getStillImageStereo(frameNumber);
     }
+    cv::Mat getPreviewImageSingle(int frameNumber) {
+        return imageReader->getPreviewImageSingle(frameNumber);
+    }
+    std::vector<cv::Mat> getPreviewImageStereo(int frameNumber) {
+        return imageReader->getPreviewImageStereo(frameNumber);
+    }
     int getFrameNumberForTimestamp(uint64_t timestamp) {
         return imageReader->getFrameNumberForTimestamp(timestamp);
     }
@@ -1,10 +1,30 @@
 
 #include "singleWebcam.h"
 
-
-GrabberDummy::GrabberDummy(int deviceID) : deviceID(deviceID), m_camera(new cv::VideoCapture()) {
+#include <chrono>
+#include <thread>
+
+
+GrabberDummy::GrabberDummy(int deviceID) :
+    m_running(false),
+    resizeFactor(1.0),
+    queryFPS(30),
+    deviceID(deviceID),
+    m_camera(new cv::VideoCapture()),
+    imageWidth(0),
+    imageHeight(0),
+    deliveredFrames(0),
+    droppedFrames(0),
+    deliveredFPS(0.0),
+    grabPending(false),
+    decoderStopped(false),
+    pendingTimestamp(0) {
     //std::cout << "GrabberDummy::GrabberDummy(cv::VideoCapture* camera)" << std::endl;
 }
+
+GrabberDummy::GrabberDummy(const QString &videoFile) : GrabberDummy(-1) {
+    this->videoFile = videoFile;
+}
  
 bool GrabberDummy::running() const {
     //std::cout << "GrabberDummy::running()" << std::endl;
@@ -12,7 +32,19 @@ bool GrabberDummy::running() const {
 }
 
 cv::Size GrabberDummy::getImageSize() const {
-    return image.size();
+    return cv::Size(imageWidth, imageHeight);
+}
+
+double GrabberDummy::getDeliveredFPS() const {
+    return deliveredFPS;
+}
+
+quint64 GrabberDummy::getDeliveredFrames() const {
+    return deliveredFrames;
+}
+
+quint64 GrabberDummy::getDroppedFrames() const {
+    return droppedFrames;
 }
 
 std::string uint64_to_string( uint64 value ) {
@@ -21,6 +53,8 @@ std::string uint64_to_string( uint64 value ) {
     return os.str();
 }
 
+// Grabs at absolute deadlines: if a grab took longer than a frame period, the missed deadlines are counted as dropped and skipped,
+// so the capture neither drifts nor tries to catch up with a burst of frames
 void GrabberDummy::run() {
     //std::cout << "GrabberDummy::run() started" << std::endl;
     m_running = true;
@@ -29,33 +63,163 @@ void GrabberDummy::run() {
         m_camera->release();
 
     emit startedToOpenCamera();
-    if(!m_camera->open(deviceID)) {
+    const bool opened = videoFile.isEmpty() ? m_camera->open(deviceID) : m_camera->open(videoFile.toStdString());
+    if(!opened) {
+        m_running = false;
         emit couldNotOpenCamera();
         emit finished();
         return;
     }
     emit successfullyOpenedCamera();
 
+    deliveredFrames = 0;
+    droppedFrames = 0;
+    deliveredFPS = 0.0;
+    grabPending = false;
+    decoderStopped = false;
+    std::thread decodingThread(&GrabberDummy::decode, this);
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now();
     while(m_running) {
-    //while(true) {
-        *m_camera >> image;
-        if (image.channels() > 1)
-            cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
-        if(image.cols > 0 && image.rows > 0 && resizeFactor<1.0 && resizeFactor >0.0) 
-            cv::resize(image, image, cv::Size(), resizeFactor, resizeFactor);
-        emit GrabberDummyEvent(image);
-
-        QThread::msleep((int)round(1000/queryFPS));
+        const std::chrono::steady_clock::duration period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(1.0 / std::max(1.0, queryFPS.load())));
+        deadline += period;
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now > deadline + period) {
+            const auto missed = (now - deadline) / period;
+            droppedFrames += missed;
+            deadline += missed * period;
+        }
+        std::this_thread::sleep_until(deadline);
+
+        decodeMutex.lock();
+        while(grabPending && m_running)
+            decodeCondition.wait(&decodeMutex);
+        decodeMutex.unlock();
+        if(!m_running)
+            break;
+
+        if(!m_camera->grab()) {
+            // End of a video file, a camera may recover from a failed grab
+            if(!videoFile.isEmpty())
+                m_running = false;
+            else
+                droppedFrames++;
+            continue;
+        }
+        const quint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+
+        decodeMutex.lock();
+        pendingTimestamp = timestamp;
+        grabPending = true;
+        decodeCondition.wakeAll();
+        decodeMutex.unlock();
     }
 
+    decodeMutex.lock();
+    decoderStopped = true;
+    decodeCondition.wakeAll();
+    decodeMutex.unlock();
+    decodingThread.join();
+
     m_camera->release();
 
+    std::cout << "Webcam capture finished: " << deliveredFrames << " frames delivered, " << droppedFrames << " dropped" << std::endl;
+
     //std::cout << "GrabberDummy::run() finishing" << std::endl;
     emit finished();
 }
 
+// Retrieves (decodes) the grabbed frames in the decoding thread and emits them, the frame rate is measured over windows of about one second
+void GrabberDummy::decode() {
+    std::chrono::steady_clock::time_point windowStart = std::chrono::steady_clock::now();
+    int windowFrames = 0;
+
+    while(true) {
+        decodeMutex.lock();
+        while(!grabPending && !decoderStopped)
+            decodeCondition.wait(&decodeMutex);
+        if(!grabPending) {
+            decodeMutex.unlock();
+            break;
+        }
+        const quint64 timestamp = pendingTimestamp;
+        decodeMutex.unlock();
+
+        cv::Mat image;
+        const bool retrieved = m_camera->retrieve(image);
+
+        decodeMutex.lock();
+        grabPending = false;
+        decodeCondition.wakeAll();
+        decodeMutex.unlock();
+
+        if(!retrieved || image.empty()) {
+            droppedFrames++;
+            continue;
+        }
+
+        const double factor = resizeFactor;
+        if(factor < 1.0 && factor > 0.0)
+            cv::resize(image, image, cv::Size(), factor, factor, cv::INTER_AREA);
+        imageWidth = image.cols;
+        imageHeight = image.rows;
+
+        deliveredFrames++;
+        windowFrames++;
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - windowStart).count();
+        if(elapsed >= 1.0) {
+            deliveredFPS = windowFrames / elapsed;
+            windowFrames = 0;
+            windowStart = std::chrono::steady_clock::now();
+        }
+
+        emit GrabberDummyEvent(image, timestamp);
+    }
+}
+
+// The source is a device id, or a video file path if it is not a number
+int GrabberDummy::measureCapture(const QString &source, double fps, int seconds) {
+
+    if(fps <= 0.0 || seconds <= 0) {
+        std::cerr << "Framerate and duration must be positive" << std::endl;
+        return -1;
+    }
+
+    bool isDeviceID = false;
+    const int id = source.toInt(&isDeviceID);
+    GrabberDummy grabber(isDeviceID ? id : -1);
+    if(!isDeviceID)
+        grabber.videoFile = source;
+    grabber.queryFPS = fps;
+
+    std::vector<quint64> timestamps;
+    QMutex timestampMutex;
+    connect(&grabber, &GrabberDummy::GrabberDummyEvent, [&](cv::Mat, quint64 timestamp) {
+        const QMutexLocker locker(&timestampMutex);
+        timestamps.push_back(timestamp);
+    });
+
+    std::thread capture(&GrabberDummy::run, &grabber);
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while(std::chrono::steady_clock::now() < end && (grabber.running() || grabber.getDeliveredFrames() == 0))
+        QThread::msleep(10);
+    grabber.stop();
+    capture.join();
+
+    const QMutexLocker locker(&timestampMutex);
+    std::cout << "Target framerate: " << fps << ", delivered " << timestamps.size() << " frames, dropped " << grabber.getDroppedFrames() << std::endl;
+    if(timestamps.size() < 2)
+        return 1;
+
+    const double duration = (timestamps.back() - timestamps.front()) / 1000.0;
+    std::cout << "Delivered framerate: " << (duration > 0.0 ? (timestamps.size() - 1) / duration : 0.0) << " (over " << duration << " s)" << std::endl;
+    return 0;
+}
+
 bool GrabberDummy::registerEventHandler(SingleWebcamImageEventHandler *handler, const char *method) {
-    return connect(this, SIGNAL(GrabberDummyEvent(cv::Mat)), handler, method );
+    return connect(this, SIGNAL(GrabberDummyEvent(cv::Mat, quint64)), handler, method );
 }
  
 void GrabberDummy::stop() {
@@ -177,7 +341,7 @@ SingleWebcam::SingleWebcam(int deviceID, QString friendlyName, QObject* parent)
         grabbingThread = new QThread();
         grabberDummy = new GrabberDummy(deviceID);
 
-        grabberDummy->registerEventHandler(cameraImageEventHandler, SLOT(OnImageGrabbed(cv::Mat)));
+        grabberDummy->registerEventHandler(cameraImageEventHandler, SLOT(OnImageGrabbed(cv::Mat, quint64)));
         connect(grabbingThread, &QThread::started, grabberDummy, &GrabberDummy::run);
         grabberDummy->moveToThread(grabbingThread);
 
@@ -283,6 +447,14 @@ double SingleWebcam::getResizeFactor() {
     return grabberDummy->getResizeFactor();
 }
 
+double SingleWebcam::getDeliveredFPS() {
+    return grabberDummy->getDeliveredFPS();
+}
+
+quint64 SingleWebcam::getDroppedFrames() {
+    return grabberDummy->getDroppedFrames();
+}
+
 int SingleWebcam::getImageROIwidth(){
     return grabberDummy->getImageSize().width;
 }
@@ -17,31 +17,69 @@
 #include <fstream>
 #include <opencv2/videoio/videoio_c.h>
 #include <QDebug>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
 
 
 /**
     
     This class runs in a thread to simulate framegrabbing process, using OpenCV input
 
+    Frames are grabbed at absolute deadlines of the query framerate (steady clock), so the time needed for grabbing does not
+    add up to the frame period, and missed deadlines are skipped (and counted as dropped) instead of shifting all later frames.
+    Grabbing only latches the frame and its timestamp, retrieving/decoding it and the optional resize happen in a separate
+    decoding thread, which emits the frame. Frames are emitted in their original color, the detection converts only its ROI.
+    Besides a camera device, a video file can be opened, e.g. for checking the capture rate with measureCapture().
+
+    getDeliveredFPS(): frames emitted per second, averaged over about one second
+    getDeliveredFrames(): number of frames emitted since the capture was started
+    getDroppedFrames(): number of deadlines missed and frames that could not be grabbed or decoded
+    measureCapture(): captures from a device id or video file for the given seconds at the given framerate and prints the
+                      delivered framerate and dropped frames, returns 0 if frames were delivered
+
 */
 class GrabberDummy : public QObject {
     Q_OBJECT
  
-    bool m_running;
-    double resizeFactor = 1.0;
-    double queryFPS = 30;
+    std::atomic<bool> m_running;
+    std::atomic<double> resizeFactor;
+    std::atomic<double> queryFPS;
 
     int deviceID;
+    QString videoFile;
     cv::VideoCapture* m_camera;
 
-    cv::Mat image;
+    std::atomic<int> imageWidth;
+    std::atomic<int> imageHeight;
+
+    std::atomic<quint64> deliveredFrames;
+    std::atomic<quint64> droppedFrames;
+    std::atomic<double> deliveredFPS;
+
+    // Handover of a grabbed frame to the decoding thread, the next frame is grabbed only after it was retrieved
+    QMutex decodeMutex;
+    QWaitCondition decodeCondition;
+    bool grabPending;
+    bool decoderStopped;
+    quint64 pendingTimestamp;
+
+    void decode();
  
 public:
     explicit GrabberDummy(int deviceID);
+    explicit GrabberDummy(const QString &videoFile);
 
     bool running() const;
 
     cv::Size getImageSize() const;
+
+    double getDeliveredFPS() const;
+    quint64 getDeliveredFrames() const;
+    quint64 getDroppedFrames() const;
+
+    static int measureCapture(const QString &source, double fps, int seconds);
  
 signals:
     void startedToOpenCamera();
@@ -49,7 +87,7 @@ signals:
     void successfullyOpenedCamera();
     void finished();
 
-    void GrabberDummyEvent(cv::Mat image);
+    void GrabberDummyEvent(cv::Mat image, quint64 timestamp);
  
 public slots:
     void run();
@@ -141,6 +179,8 @@ public slots:
     double getGainValue();
     double getExposureValue();
     double getResizeFactor();
+    double getDeliveredFPS();
+    quint64 getDroppedFrames();
 
     bool setFPSValue(int value);
     bool setBrightnessValue(double value);
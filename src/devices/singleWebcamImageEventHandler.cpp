@@ -6,17 +6,13 @@ SingleWebcamImageEventHandler::SingleWebcamImageEventHandler(QObject* parent) :
 
 SingleWebcamImageEventHandler::~SingleWebcamImageEventHandler() {}
 
-void SingleWebcamImageEventHandler::OnImageGrabbed(const cv::Mat &image) {
-
-    uint64 timeStamp = QDateTime::currentMSecsSinceEpoch(); // std::chrono::duration_cast<std::chrono::milliseconds> (); //0; //ptrGrabResult->GetTimeStamp();
-    
-    // cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+// The image is newly retrieved for each frame and the timestamp taken right after grabbing it, so neither needs to be renewed here
+void SingleWebcamImageEventHandler::OnImageGrabbed(const cv::Mat &image, quint64 timestamp) {
 
     CameraImage result;
     result.type = CameraImageType::LIVE_SINGLE_WEBCAM;
-    result.img = image.clone();
-    result.timestamp = timeStamp;
+    result.img = image;
+    result.timestamp = timestamp;
 
     emit onNewGrabResult(result);
 }
-
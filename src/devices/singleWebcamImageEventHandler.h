@@ -28,7 +28,7 @@ signals:
     void onNewGrabResult(CameraImage grabResult);
 
 public slots:
-    void OnImageGrabbed(const cv::Mat &image);
+    void OnImageGrabbed(const cv::Mat &image, quint64 timestamp);
 
 };
 
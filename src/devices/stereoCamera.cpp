@@ -92,6 +92,12 @@ void StereoCamera::attachCameras(const CDeviceInfo &diMain, const CDeviceInfo &d
     std::cout<<"Attached Camera1:" << cameras[1].GetDeviceInfo().GetFriendlyName() << std::endl << std::endl;
 }
 
+// Applies to the next open(), the window is in frames, the timeout in ms (0 disables it)
+void StereoCamera::setFramePairing(unsigned int window, uint64_t timeoutMs) {
+    pairingWindow = window;
+    pairingTimeoutMs = timeoutMs;
+}
+
 // Opens the stereo camera through its corresponding camera array
 // If the stereo camera is already open, it is first closed and then reopened again
 // CAUTION: Its important for the stereo cameras to be in sync, that the stereo camera is first opened, and only then the hardware trigger source is started
@@ -134,7 +140,7 @@ void StereoCamera::open(bool enableHardwareTrigger) {
 //            cameras[1].TriggerMode.SetValue(TriggerMode_On);
         }
 
-        cameraImageEventHandler = new StereoCameraImageEventHandler(this->parent());
+        cameraImageEventHandler = new StereoCameraImageEventHandler(pairingWindow, pairingTimeoutMs, this->parent());
         connect(cameraImageEventHandler, SIGNAL(onNewGrabResult(CameraImage)), this, SIGNAL(onNewGrabResult(CameraImage)));
         connect(cameraImageEventHandler, SIGNAL(onNewGrabResult(CameraImage)), frameCounter, SLOT(count(CameraImage)));
         //connect(cameraImageEventHandler, SIGNAL(needsTimeSynchronization()), this, SLOT(resynchronizeTime()));
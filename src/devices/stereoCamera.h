@@ -82,6 +82,7 @@ public:
 
     void attachCameras(const CDeviceInfo &diMain, const CDeviceInfo &diSecondary);
     void open(bool enableHardwareTrigger);
+    void setFramePairing(unsigned int window, uint64_t timeoutMs);
 
     String_t getLineSource();
 
@@ -117,6 +118,9 @@ private:
 
     CBaslerUniversalInstantCameraArray cameras;
     StereoCameraImageEventHandler *cameraImageEventHandler = nullptr;
+    // Frame pairing of the image event handler created in open(), see StereoFramePairer
+    unsigned int pairingWindow = 16;
+    uint64_t pairingTimeoutMs = 0;
     CameraConfigurationEventHandler *cameraConfigurationEventHandler0 = nullptr;
     CameraConfigurationEventHandler *cameraConfigurationEventHandler1 = nullptr;
     HardwareTriggerConfiguration* hardwareTriggerConfiguration0 = nullptr;
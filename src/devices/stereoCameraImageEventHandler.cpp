@@ -3,16 +3,21 @@
 #include "stereoCameraImageEventHandler.h"
 
 // Creates a new stereo image event handler for a StereoCamera
-StereoCameraImageEventHandler::StereoCameraImageEventHandler(QObject* parent) : QObject(parent), systemTime(0), stereoImage() {
+StereoCameraImageEventHandler::StereoCameraImageEventHandler(unsigned int pairingWindow, uint64_t pairingTimeoutMs, QObject* parent) :
+        QObject(parent), systemTime(0), framePairer(pairingWindow, pairingTimeoutMs) {
 
-    formatConverter.OutputPixelFormat = Pylon::PixelType_Mono8;
-
-    stereoImage.timestamp = 0;
-    stereoImage.type = CameraImageType::LIVE_STEREO_CAMERA;
+    formatConverter[0].OutputPixelFormat = Pylon::PixelType_Mono8;
+    formatConverter[1].OutputPixelFormat = Pylon::PixelType_Mono8;
 }
 
 StereoCameraImageEventHandler::~StereoCameraImageEventHandler() {
 
+    framePairer.flush();
+    if(framePairer.getOrphanedFrames(0) > 0 || framePairer.getOrphanedFrames(1) > 0 || framePairer.getDuplicateFrames() > 0) {
+        std::cout << "Stereo frame pairing: " << framePairer.getPairedFrames() << " paired, orphaned frames main camera "
+                  << framePairer.getOrphanedFrames(0) << ", secondary camera " << framePairer.getOrphanedFrames(1)
+                  << ", duplicate frames " << framePairer.getDuplicateFrames() << std::endl;
+    }
 }
 
 // Event handler that is executed if for any of the two cameras in the stereo camera images were skipped
@@ -29,19 +34,18 @@ void StereoCameraImageEventHandler::OnImagesSkipped(CInstantCamera& camera, size
 }
 
 // Event handler that is executed for EACH image acquisition of EACH camera
-// This means that for each hardware trigger signal to the two cameras in a StereoCamera, this handler is called two times
-// In order to produce a single stereo camera image, combining the two camera acquisitions , OnImageGrabbed synchronized the
-// image grab results based on their framenumber. For two consecutive(!) images with the same framenumber, a single new stereo
-// camera image is produced and emitted through onNewGrabResult (containing both images).
-// In case only a single image was acquired and its consecutive image is of a different framenumber, the first image is dropped.
+// This means that for each hardware trigger signal to the two cameras in a StereoCamera, this handler is called two times, from
+// the grab thread of the respective camera. In order to produce a single stereo camera image, combining the two camera acquisitions,
+// the images are paired by their framenumber in the StereoFramePairer, in any order within its window. The completed stereo camera
+// image is emitted through onNewGrabResult (containing both images) by the thread that delivered the second image.
+// Images whose counterpart does not arrive in time are dropped and counted as orphaned.
 void StereoCameraImageEventHandler::OnImageGrabbed(CInstantCamera& camera, const CGrabResultPtr& ptrGrabResult) {
     //std::cout << "OnImageGrabbed event for device " << ptrGrabResult->GetCameraContext() << std::endl;
 
     if (ptrGrabResult->GrabSucceeded()) {
-        // As we modify the stereoImage in potentially different threads (Pylon image event handler) lock the mutex for the update
-        mutex.lock();
-
         intptr_t cameraContextValue = ptrGrabResult->GetCameraContext();
+        if(cameraContextValue != 0 && cameraContextValue != 1)
+            return;
         int64_t frameNumber = ptrGrabResult->GetImageNumber();
 
         uint64_t timeStamp = ptrGrabResult->GetTimeStamp();
@@ -49,49 +53,24 @@ void StereoCameraImageEventHandler::OnImageGrabbed(CInstantCamera& camera, const
 
         //std::cout<< "Grabresult from camera" << cameraContextValue << ": frameNumber:  " << frameNumber << ", timestamp: " << timeStamp <<std::endl;
 
-        formatConverter.Convert(pylonImage, ptrGrabResult);
-        cv::Mat img(ptrGrabResult->GetHeight(), ptrGrabResult->GetWidth(), CV_8UC1, (uint8_t *) pylonImage.GetBuffer());
+        // Converted directly into a new image, which is shared with the emitted stereo image without any further copy
+        cv::Mat img(ptrGrabResult->GetHeight(), ptrGrabResult->GetWidth(), CV_8UC1);
+        formatConverter[cameraContextValue].Convert(img.data, img.total() * img.elemSize(), ptrGrabResult);
 
-        // If the current image and its framenumber are part of the existing stereoImage, then the stereoImage is complete and gets emitted
         // To make sure stereo image consists of two images at the same time from both cameras, their framenumber is checked
         // We assume that when both cameras are started grabbing at the same time, the framenumbers should match (at each camera acquisition start, the framenumber is reset)
         // Combining images based on timestamps showed to be error prone as the time difference between the two images started to drift for unknown reasons
 
-//        int diff = std::abs((int)(timeStamp - stereoImage.timestamp));
-//        std::cout<<"Grabresult timestamp diff: "<<diff<<std::endl;
-
-//        int diff2 = std::abs((int)(frameNumber - stereoImage.frameNumber));
-//        std::cout<<"Grabresult frameNumber diff: "<<diff2<<std::endl;
-
+        // Emulated cameras deliver no usable timestamps
         if (camera.GetDeviceInfo().GetModelName().find("Emu") != String_t::npos){
-            stereoImage.timestamp += frameNumber;
+            timeStamp += frameNumber;
         }
 
-        //std::cout << "Image frameNumber: " << stereoImage.frameNumber << std::endl;
-        //std::cout << "Received frameNumber: " << frameNumber << " Device id: " << camera.GetDeviceInfo().GetDeviceGUID() <<  std::endl;
-        if(stereoImage.frameNumber == frameNumber) {
-            // If framenumber matches the already contained image in the stereo image this means the missing second images is now found
-            // Cameracontextvalue describes the index of the camera in a basler camera array (main or secondary)
-            if(cameraContextValue == 0) {
-                stereoImage.img = img.clone();
-            } else if(cameraContextValue == 1) {
-                stereoImage.imgSecondary = img.clone();
-            }
+        CameraImage stereoImage;
+        if(framePairer.push(static_cast<int>(cameraContextValue), static_cast<uint64_t>(frameNumber), timeStamp, img, stereoImage)) {
             //std::cout<< "Stereoimage complete: " << stereoImage.frameNumber << " " << stereoImage.timestamp <<std::endl;
-            //std::cout<< "-------------------------------" <<std::endl;
             emit onNewGrabResult(stereoImage);
-//            std::cout << "STEREO GRAB RESULT: " << stereoImage.frameNumber << " AT TIME: " << stereoImage.timestamp << std::endl;
-        } else {
-            // Else, we have a "new" stereo image, set the timestamp, image and wait for the second missing one, then emit
-            stereoImage.timestamp = timeStamp;
-            stereoImage.frameNumber = frameNumber;
-            if(cameraContextValue == 0) {
-                stereoImage.img = img.clone();
-            } else if(cameraContextValue == 1) {
-                stereoImage.imgSecondary = img.clone();
-            }
         }
-        mutex.unlock();
     } else {
         std::cout << "Error: " << ptrGrabResult->GetErrorCode() << " " << ptrGrabResult->GetErrorDescription() << std::endl;
 
@@ -105,6 +84,10 @@ void StereoCameraImageEventHandler::OnImageGrabbed(CInstantCamera& camera, const
 
 }
 
+const StereoFramePairer &StereoCameraImageEventHandler::getFramePairer() const {
+    return framePairer;
+}
+
 // Set the timestamps of both cameras and the system time for a given point in time, used for converting between from cameratime to systemtime
 void StereoCameraImageEventHandler::setTimeSynchronization(uint64_t m_mainCameraTime, uint64_t m_secondaryCameraTime, uint64_t m_systemTime) {
 
@@ -10,8 +10,8 @@
 #include <pylon/PylonImage.h>
 #include <pylon/ImageEventHandler.h>
 #include <pylon/PylonIncludes.h>
-#include <QtCore/QMutex>
 #include "camera.h"
+#include "stereoFramePairer.h"
 
 using namespace Pylon;
 
@@ -22,7 +22,12 @@ using namespace Pylon;
     To sync the images, the camera provided framecount is used and it is assumed that the framecount of both cameras matches due to sync acquisition start (See StereoCamera)
     Its important for stereo synchronization, that only after opening of the stereo camera (acquisition start) the hardware triggers are started
 
+    The two images of a stereo image are paired by a StereoFramePairer, without a lock between the grab threads of the two cameras.
+    Its window (in frames) and timeout (in ms, the camera timestamps are converted from ns to ms before pairing) are given upon construction.
+    Each camera has its own format converter, converting directly into a newly allocated image.
+
     setTimeSynchronization(): set the camera and system times which are used to sync the camera timestamps, usually only a single time at camera initialisation
+    getFramePairer(): pairing statistics, i.e. the number of paired and orphaned frames
 
     onNewGrabResult(): signal send at each new stereo image, distributing the new stereo images of both cameras
 */
@@ -31,7 +36,7 @@ Q_OBJECT
 
 public:
 
-    explicit StereoCameraImageEventHandler(QObject* parent=0);
+    explicit StereoCameraImageEventHandler(unsigned int pairingWindow=16, uint64_t pairingTimeoutMs=0, QObject* parent=0);
 
     ~StereoCameraImageEventHandler() override;
 
@@ -40,17 +45,17 @@ public:
     void OnImagesSkipped( CInstantCamera& camera, size_t countOfSkippedImages) override;
     void OnImageGrabbed( CInstantCamera& camera, const CGrabResultPtr& ptrGrabResult) override;
 
-private:
+    const StereoFramePairer &getFramePairer() const;
 
-    QMutex mutex;
+private:
 
     uint64_t cameraTime[2] = {0, 0};
     uint64_t systemTime;
 
-    CImageFormatConverter formatConverter;
-    CPylonImage pylonImage;
+    // One per camera, as OnImageGrabbed is called concurrently from the grab threads of both cameras
+    CImageFormatConverter formatConverter[2];
 
-    CameraImage stereoImage;
+    StereoFramePairer framePairer;
 
 signals:
 
@@ -0,0 +1,234 @@
+
+#include "stereoFramePairer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+StereoFramePairer::StereoFramePairer(unsigned int window, uint64_t timeout) :
+    window(std::max(2u, window)),
+    timeout(timeout),
+    slots(new Slot[std::max(2u, window)]),
+    paired(0),
+    duplicates(0) {
+
+    for(unsigned int i=0; i<this->window; i++) {
+        slots[i].state.store(0, std::memory_order_relaxed);
+        slots[i].claimTime.store(0, std::memory_order_relaxed);
+    }
+    orphaned[0].store(0, std::memory_order_relaxed);
+    orphaned[1].store(0, std::memory_order_relaxed);
+}
+
+// A camera only writes its own half of a slot, and only while the slot is free (never used, or completed by an older frame) or holds
+// its frame number without its presence bit. The thread setting the second presence bit marks the slot busy until the pair is taken
+// out, so neither half changes while it is read. The other camera waits for that (a few reference count updates) if it needs the slot.
+bool StereoFramePairer::push(int camera, uint64_t frameNumber, uint64_t timestamp, const cv::Mat &img, CameraImage &stereoImage) {
+
+    if(camera != 0 && camera != 1)
+        return false;
+
+    if(timeout > 0)
+        evictTimedOut(timestamp);
+
+    Slot &slot = slots[frameNumber % window];
+    const uint64_t tag = frameNumber + 1;
+    const uint64_t cameraBit = 1ull << camera;
+
+    while(true) {
+        uint64_t state = slot.state.load(std::memory_order_acquire);
+        const uint64_t stateTag = state >> tagShift;
+
+        if(stateTag == tag) {
+            if(state & cameraBit) {
+                duplicates++;
+                return false;
+            }
+            slot.half[camera].img = img;
+            slot.half[camera].timestamp = timestamp;
+            if(!slot.state.compare_exchange_strong(state, state | cameraBit | busyBit, std::memory_order_acq_rel))
+                continue;
+
+            stereoImage.type = CameraImageType::LIVE_STEREO_CAMERA;
+            stereoImage.frameNumber = frameNumber;
+            stereoImage.timestamp = std::min(slot.half[0].timestamp, slot.half[1].timestamp);
+            stereoImage.img = slot.half[0].img;
+            stereoImage.imgSecondary = slot.half[1].img;
+            stereoImage.filename.clear();
+            slot.half[0].img.release();
+            slot.half[1].img.release();
+
+            slot.state.store((tag << tagShift) | presentBits, std::memory_order_release);
+            paired++;
+            return true;
+        }
+
+        if(stateTag > tag) {
+            // Slot already holds a newer frame number, the counterpart of this image is out of the window
+            orphaned[camera]++;
+            return false;
+        }
+
+        // Slot holds an older frame: free if its pair was completed, otherwise the half-pair is out of the window now
+        if(state & busyBit) {
+            std::this_thread::yield();
+            continue;
+        }
+        if(isWaiting(state)) {
+            evict(slot, state);
+            continue;
+        }
+
+        slot.half[camera].img = img;
+        slot.half[camera].timestamp = timestamp;
+        slot.claimTime.store(timestamp, std::memory_order_relaxed);
+        if(slot.state.compare_exchange_strong(state, (tag << tagShift) | cameraBit, std::memory_order_acq_rel))
+            return false;
+    }
+}
+
+// Only the state is reset, the images stay in the slot until overwritten, as the other camera may be writing its half right now
+bool StereoFramePairer::evict(Slot &slot, uint64_t state) {
+    if(!slot.state.compare_exchange_strong(state, 0, std::memory_order_acq_rel))
+        return false;
+    for(int i=0; i<2; i++) {
+        if(state & (1ull << i))
+            orphaned[i]++;
+    }
+    return true;
+}
+
+// A half-pair waits in the slot for the image of the other camera
+bool StereoFramePairer::isWaiting(uint64_t state) {
+    return state != 0 && (state & presentBits) != presentBits;
+}
+
+void StereoFramePairer::evictTimedOut(uint64_t now) {
+    for(unsigned int i=0; i<window; i++) {
+        const uint64_t state = slots[i].state.load(std::memory_order_acquire);
+        if(!isWaiting(state))
+            continue;
+        const uint64_t claimTime = slots[i].claimTime.load(std::memory_order_relaxed);
+        if(now > claimTime && now - claimTime > timeout)
+            evict(slots[i], state);
+    }
+}
+
+void StereoFramePairer::flush() {
+    for(unsigned int i=0; i<window; i++) {
+        uint64_t state = slots[i].state.load(std::memory_order_acquire);
+        while(isWaiting(state) && !evict(slots[i], state))
+            state = slots[i].state.load(std::memory_order_acquire);
+    }
+}
+
+uint64_t StereoFramePairer::getPairedFrames() const {
+    return paired.load(std::memory_order_relaxed);
+}
+
+uint64_t StereoFramePairer::getOrphanedFrames(int camera) const {
+    if(camera != 0 && camera != 1)
+        return 0;
+    return orphaned[camera].load(std::memory_order_relaxed);
+}
+
+uint64_t StereoFramePairer::getDuplicateFrames() const {
+    return duplicates.load(std::memory_order_relaxed);
+}
+
+// Each camera drops about 1% of the frames, repeats about 0.5% and swaps about 10% of neighbouring frames. Like hardware triggered
+// cameras, neither camera thread gets more than half the window ahead of the other, so every frame number delivered by both cameras
+// must be paired, and every other image must be counted as orphaned or duplicate.
+int StereoFramePairer::simulate(int count) {
+
+    if(count <= 0) {
+        std::cerr << "Number of frames must be positive" << std::endl;
+        return -1;
+    }
+
+    const unsigned int window = 16;
+    StereoFramePairer pairer(window, 0);
+
+    std::vector<uint64_t> frames[2];
+    std::set<uint64_t> delivered[2];
+    uint64_t duplicatesSent = 0;
+    for(int c=0; c<2; c++) {
+        std::mt19937 random(1234 + c);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for(int i=0; i<count; i++) {
+            const double r = uniform(random);
+            if(r < 0.01)
+                continue;
+            frames[c].push_back(i);
+            delivered[c].insert(i);
+            if(r < 0.015) {
+                frames[c].push_back(i);
+                duplicatesSent++;
+            }
+        }
+        for(size_t i=1; i<frames[c].size(); i++) {
+            if(uniform(random) < 0.1)
+                std::swap(frames[c][i-1], frames[c][i]);
+        }
+    }
+    uint64_t expectedPairs = 0;
+    for(uint64_t f : delivered[0])
+        expectedPairs += delivered[1].count(f);
+
+    std::atomic<uint64_t> progress[2];
+    std::atomic<bool> finished[2];
+    std::atomic<uint64_t> pairsReceived(0);
+    std::atomic<uint64_t> mismatches(0);
+    for(int c=0; c<2; c++) {
+        progress[c].store(0);
+        finished[c].store(false);
+    }
+
+    auto grab = [&](int c) {
+        const int other = 1 - c;
+        CameraImage stereoImage;
+        for(uint64_t f : frames[c]) {
+            while(!finished[other].load(std::memory_order_acquire) && f > progress[other].load(std::memory_order_acquire) + window / 2)
+                std::this_thread::yield();
+
+            cv::Mat img(1, 1, CV_32SC2, cv::Scalar(static_cast<int>(f), c));
+            if(pairer.push(c, f, f, img, stereoImage)) {
+                pairsReceived++;
+                const cv::Vec2i mainValue = stereoImage.img.at<cv::Vec2i>(0, 0);
+                const cv::Vec2i secondaryValue = stereoImage.imgSecondary.at<cv::Vec2i>(0, 0);
+                if(mainValue[0] != static_cast<int>(stereoImage.frameNumber) || mainValue[1] != 0 ||
+                   secondaryValue[0] != static_cast<int>(stereoImage.frameNumber) || secondaryValue[1] != 1)
+                    mismatches++;
+            }
+            progress[c].store(std::max(progress[c].load(std::memory_order_relaxed), f), std::memory_order_release);
+        }
+        finished[c].store(true, std::memory_order_release);
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::thread mainGrabber(grab, 0);
+    std::thread secondaryGrabber(grab, 1);
+    mainGrabber.join();
+    secondaryGrabber.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    pairer.flush();
+
+    std::cout << "Paired " << pairer.getPairedFrames() << " of " << expectedPairs << " expected stereo images in " << seconds << " s ("
+              << pairer.getPairedFrames() / std::max(seconds, 1e-9) << " per s)" << std::endl;
+    std::cout << "Orphaned frames: main " << pairer.getOrphanedFrames(0) << ", secondary " << pairer.getOrphanedFrames(1)
+              << ", duplicates " << pairer.getDuplicateFrames() << " of " << duplicatesSent << ", mismatched pairs " << mismatches << std::endl;
+
+    bool consistent = mismatches == 0 &&
+            pairsReceived == pairer.getPairedFrames() &&
+            pairer.getPairedFrames() == expectedPairs &&
+            pairer.getDuplicateFrames() == duplicatesSent;
+    for(int c=0; c<2; c++)
+        consistent = consistent && delivered[c].size() == pairer.getPairedFrames() + pairer.getOrphanedFrames(c);
+
+    std::cout << (consistent ? "Pairing consistent" : "Pairing INCONSISTENT") << std::endl;
+    return consistent ? 0 : 1;
+}
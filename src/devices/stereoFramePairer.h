@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <opencv2/core/mat.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "camera.h"
+
+/**
+    Pairs the images of the two cameras of a stereo camera into stereo images by their frame number, independent of the camera hardware
+
+    Both cameras push their images from their own grab thread without any lock: the images wait in a small reorder buffer of
+    window slots, indexed by frame number modulo window, until the image of the other camera with the same frame number arrives.
+    Each slot holds a single atomic state word (frame number and which cameras are present), each camera only ever writes its
+    own half of a slot, so the images are never copied under a lock and arrival order within the window does not matter.
+
+    A half-pair is orphaned (dropped and counted) if its slot is needed for a frame number window frames later, if the image
+    of the other camera arrives only after that, or if it waited longer than timeout without its counterpart. The timeout is in
+    the unit of the timestamps passed to push(), StereoCameraImageEventHandler passes system time in ms (converted from the
+    ns ticks of the Pylon camera timestamps). The timeout is disabled by default (0), as the timestamps of the two cameras
+    may drift apart.
+    A second image of the same camera with the same frame number is counted as duplicate and dropped.
+
+    push(): hands over the image of camera 0 (main) or 1 (secondary), thread-safe for one thread per camera,
+            returns true and fills stereoImage if the image completed a stereo image
+    flush(): orphans all half-pairs still waiting, e.g. after grabbing stopped
+    getPairedFrames(): number of completed stereo images
+    getOrphanedFrames(): number of images of the given camera that were dropped without counterpart
+    getDuplicateFrames(): number of images dropped because their frame number was already present for that camera
+    simulate(): pushes count frames of both cameras with reordering, drops and duplicates from two threads and checks the
+                pairing and counters, returns 0 if they are consistent
+*/
+class StereoFramePairer {
+
+public:
+
+    explicit StereoFramePairer(unsigned int window=16, uint64_t timeout=0);
+
+    bool push(int camera, uint64_t frameNumber, uint64_t timestamp, const cv::Mat &img, CameraImage &stereoImage);
+    void flush();
+
+    uint64_t getPairedFrames() const;
+    uint64_t getOrphanedFrames(int camera) const;
+    uint64_t getDuplicateFrames() const;
+
+    static int simulate(int count);
+
+private:
+
+    // State word of a slot: (frame number + 1) << 3 | busy bit | presence bit of each camera, 0 if the slot was never used
+    // A completed slot keeps its frame number (both presence bits set) to detect duplicates, busy while the pair is taken out
+    static const uint64_t presentBits = 3;
+    static const uint64_t busyBit = 4;
+    static const int tagShift = 3;
+
+    struct Half {
+        cv::Mat img;
+        uint64_t timestamp = 0;
+    };
+
+    struct Slot {
+        std::atomic<uint64_t> state;
+        std::atomic<uint64_t> claimTime;
+        Half half[2];
+    };
+
+    const unsigned int window;
+    const uint64_t timeout;
+    std::unique_ptr<Slot[]> slots;
+
+    std::atomic<uint64_t> paired;
+    std::atomic<uint64_t> orphaned[2];
+    std::atomic<uint64_t> duplicates;
+
+    static bool isWaiting(uint64_t state);
+    bool evict(Slot &slot, uint64_t state);
+    void evictTimedOut(uint64_t now);
+};
@@ -0,0 +1,360 @@
+
+#include "syntheticCamera.h"
+
+#include <QDateTime>
+#include <QStringList>
+#include <chrono>
+#include <thread>
+#include <cmath>
+
+// Number of precomputed noise frames, cycled through by frame number
+static const int SYNTHETIC_NOISE_FRAMES = 8;
+
+static const uchar SYNTHETIC_SKIN = 150;
+static const uchar SYNTHETIC_SCLERA = 205;
+static const uchar SYNTHETIC_IRIS = 105;
+static const uchar SYNTHETIC_PUPIL = 22;
+static const uchar SYNTHETIC_GLINT = 250;
+
+SyntheticEyeRenderer::SyntheticEyeRenderer(const SyntheticCameraParams &params) : params(params) {
+
+    // The static part of the image: skin with the sclera in the middle, which the iris moves over
+    background = cv::Mat(params.height, params.width, CV_8UC1, cv::Scalar(SYNTHETIC_SKIN));
+    cv::ellipse(background,
+                cv::RotatedRect(cv::Point2f(params.width/2.0f, params.height/2.0f),
+                                cv::Size2f((float)(2.0*(params.irisRadius+params.gazeAmplitudeX)*1.3), (float)(2.0*params.eyelidOpening)), 0),
+                cv::Scalar(SYNTHETIC_SCLERA), cv::FILLED, cv::LINE_AA);
+
+    // Zero-mean sensor noise, stored signed so that it can be added with saturation in a single pass
+    if(params.noiseSigma > 0) {
+        for(int i=0; i<SYNTHETIC_NOISE_FRAMES; i++) {
+            cv::Mat noise(params.height, params.width, CV_16SC1);
+            cv::randn(noise, cv::Scalar(0), cv::Scalar(params.noiseSigma));
+            noiseFrames.push_back(noise);
+        }
+    }
+}
+
+const SyntheticCameraParams &SyntheticEyeRenderer::getParams() const {
+    return params;
+}
+
+// Computes the eye state for time t and renders the view(s)
+// Gaze follows a Lissajous curve, the pupil radius a cosine, and blinks close and reopen the lids within blinkDuration
+void SyntheticEyeRenderer::render(double t, uint64_t frameNumber, cv::Mat &img, cv::Mat &imgSecondary, SyntheticGroundTruth &truth) {
+
+    const double gx = params.gazeAmplitudeX * std::sin(2.0*CV_PI * t / params.gazePeriod);
+    const double gy = params.gazeAmplitudeY * std::sin(2.0*CV_PI * t / (params.gazePeriod*1.37));
+    const double r = params.pupilRadiusMin + (params.pupilRadiusMax-params.pupilRadiusMin) * (0.5 - 0.5*std::cos(2.0*CV_PI * t / params.pupilPeriod));
+
+    // Eye rotation foreshortens the pupil along the direction of the gaze offset
+    const double offset = std::sqrt(gx*gx + gy*gy);
+    const double foreshortening = std::cos(std::asin(std::min(offset / params.eyeballRadius, 0.95)));
+    const float angle = (float)(std::atan2(gy, gx) * 180.0 / CV_PI);
+
+    const cv::Point2f center((float)(params.width/2.0 + gx), (float)(params.height/2.0 + gy));
+    const cv::RotatedRect pupil(center, cv::Size2f((float)(2.0*r*foreshortening), (float)(2.0*r)), angle);
+
+    double opening = 1.0;
+    if(params.blinkInterval > 0 && params.blinkDuration > 0) {
+        const double phase = std::fmod(t, params.blinkInterval);
+        if(phase < params.blinkDuration)
+            opening = 0.5 + 0.5*std::cos(2.0*CV_PI * phase / params.blinkDuration);
+    }
+    const double lidHalfHeight = params.eyelidOpening * opening;
+
+    truth.frameNumber = frameNumber;
+    truth.pupil = pupil;
+    truth.eyelidOpening = opening;
+    truth.blink = std::abs(center.y - params.height/2.0) >= lidHalfHeight;
+
+    renderView(pupil, center, lidHalfHeight, frameNumber, img);
+
+    if(params.stereo) {
+        const cv::Point2f shift((float)-params.stereoDisparity, 0.0f);
+        const cv::RotatedRect pupilSecondary(pupil.center + shift, pupil.size, pupil.angle);
+        truth.pupilSecondary = pupilSecondary;
+        renderView(pupilSecondary, center + shift, lidHalfHeight, frameNumber + SYNTHETIC_NOISE_FRAMES/2, imgSecondary);
+    }
+}
+
+void SyntheticEyeRenderer::renderView(const cv::RotatedRect &pupil, const cv::Point2f &irisCenter, double lidHalfHeight, uint64_t frameNumber, cv::Mat &out) const {
+
+    // NOTE: a new buffer each frame, as the emitted CameraImage shares its data with the receivers
+    out = background.clone();
+
+    const float irisScale = (float)(params.irisRadius / (pupil.size.height/2.0f));
+    cv::ellipse(out, cv::RotatedRect(irisCenter, pupil.size*irisScale, pupil.angle), cv::Scalar(SYNTHETIC_IRIS), cv::FILLED, cv::LINE_AA);
+    cv::ellipse(out, pupil, cv::Scalar(SYNTHETIC_PUPIL), cv::FILLED, cv::LINE_AA);
+
+    // Corneal reflections follow the eye only partially, as the light sources are fixed
+    const cv::Point2f imageCenter(params.width/2.0f, params.height/2.0f);
+    const cv::Point2f glintBase = imageCenter + (pupil.center - imageCenter)*0.7f + cv::Point2f(0.0f, -pupil.size.height*0.25f);
+    for(int i=0; i<params.glintCount; i++) {
+        const float dx = (float)((i - (params.glintCount-1)/2.0) * params.glintRadius * 5.0);
+        cv::circle(out, glintBase + cv::Point2f(dx, 0.0f), (int)std::round(params.glintRadius), cv::Scalar(SYNTHETIC_GLINT), cv::FILLED, cv::LINE_AA);
+    }
+
+    const int upperLid = (int)std::round(params.height/2.0 - lidHalfHeight);
+    const int lowerLid = (int)std::round(params.height/2.0 + lidHalfHeight);
+    if(upperLid > 0)
+        cv::rectangle(out, cv::Rect(0, 0, params.width, upperLid), cv::Scalar(SYNTHETIC_SKIN), cv::FILLED);
+    if(lowerLid < params.height)
+        cv::rectangle(out, cv::Rect(0, lowerLid, params.width, params.height-lowerLid), cv::Scalar(SYNTHETIC_SKIN), cv::FILLED);
+
+    if(params.blurKernel > 1)
+        cv::GaussianBlur(out, out, cv::Size(params.blurKernel|1, params.blurKernel|1), 0);
+
+    if(!noiseFrames.empty())
+        cv::add(out, noiseFrames[frameNumber % noiseFrames.size()], out, cv::noArray(), CV_8U);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SyntheticGrabber::SyntheticGrabber(const SyntheticCameraParams &params) : m_running(false), renderer(params) {
+}
+
+bool SyntheticGrabber::running() const {
+    return m_running;
+}
+
+// Renders frames until stop() is called
+// Frame n is scheduled at start + n/fps on the steady clock, its timestamp is the corresponding wall clock time in ms
+// NOTE: above 1000 fps consecutive frames can share the same millisecond timestamp, frameNumber stays unique
+void SyntheticGrabber::run() {
+    if(m_running)
+        return;
+    m_running = true;
+
+    const SyntheticCameraParams &params = renderer.getParams();
+    const double fps = std::max(params.fps, 1.0);
+    const std::chrono::duration<double> period(1.0 / fps);
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t startEpochMs = QDateTime::currentMSecsSinceEpoch();
+
+    uint64_t frameNumber = 0;
+    while(m_running) {
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(period * (double)frameNumber));
+
+        const double t = frameNumber / fps;
+
+        CameraImage result;
+        SyntheticGroundTruth truth;
+        renderer.render(t, frameNumber, result.img, result.imgSecondary, truth);
+
+        result.type = params.stereo ? CameraImageType::SYNTHETIC_STEREO_CAMERA : CameraImageType::SYNTHETIC_SINGLE_CAMERA;
+        result.timestamp = startEpochMs + (uint64_t)(t * 1000.0);
+        result.frameNumber = frameNumber;
+        emit onNewGrabResult(result);
+
+        frameNumber++;
+    }
+
+    emit finished();
+}
+
+void SyntheticGrabber::stop() {
+    m_running = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Creates the virtual camera and immediately starts rendering in a separate thread
+SyntheticCamera::SyntheticCamera(const SyntheticCameraParams &params, QObject *parent) : Camera(parent),
+        params(params),
+        open(false),
+        grabbingThread(new QThread()),
+        grabber(new SyntheticGrabber(params)),
+        frameCounter(new CameraFrameRateCounter(this)),
+        cameraCalibration(nullptr),
+        stereoCameraCalibration(nullptr),
+        calibrationThread(new QThread()) {
+
+    // Calibration objects exist so that the camera can be used like any other device, they are not calibrated by default
+    if(params.stereo) {
+        stereoCameraCalibration = new StereoCameraCalibration(nullptr);
+        stereoCameraCalibration->moveToThread(calibrationThread);
+    } else {
+        cameraCalibration = new CameraCalibration(nullptr);
+        cameraCalibration->moveToThread(calibrationThread);
+    }
+    calibrationThread->start();
+    calibrationThread->setPriority(QThread::HighPriority);
+
+    connect(grabber, SIGNAL(onNewGrabResult(CameraImage)), this, SIGNAL(onNewGrabResult(CameraImage)));
+    connect(grabber, SIGNAL(onNewGrabResult(CameraImage)), frameCounter, SLOT(count(CameraImage)));
+
+    connect(frameCounter, SIGNAL(fps(double)), this, SIGNAL(fps(double)));
+    connect(frameCounter, SIGNAL(framecount(int)), this, SIGNAL(framecount(int)));
+
+    grabber->moveToThread(grabbingThread);
+    connect(grabbingThread, &QThread::started, grabber, &SyntheticGrabber::run);
+    grabbingThread->start();
+    grabbingThread->setPriority(QThread::HighPriority);
+
+    open = true;
+}
+
+SyntheticCamera::~SyntheticCamera() {
+    if(open)
+        close();
+
+    // the grabbing thread has finished in close(), so the worker can be deleted directly
+    delete grabber;
+    delete grabbingThread;
+
+    if (cameraCalibration != nullptr)
+        cameraCalibration->deleteLater();
+    if (stereoCameraCalibration != nullptr)
+        stereoCameraCalibration->deleteLater();
+    if (calibrationThread != nullptr) {
+        calibrationThread->quit();
+        calibrationThread->deleteLater();
+    }
+}
+
+bool SyntheticCamera::isOpen() {
+    return open;
+}
+
+void SyntheticCamera::close() {
+    grabber->stop();
+    grabbingThread->quit();
+    grabbingThread->wait();
+    open = false;
+}
+
+CameraImageType SyntheticCamera::getType() {
+    return params.stereo ? CameraImageType::SYNTHETIC_STEREO_CAMERA : CameraImageType::SYNTHETIC_SINGLE_CAMERA;
+}
+
+void SyntheticCamera::startGrabbing() {
+    if(open && !grabber->running())
+        QMetaObject::invokeMethod(grabber, "run", Qt::QueuedConnection);
+}
+
+void SyntheticCamera::stopGrabbing() {
+    grabber->stop();
+}
+
+bool SyntheticCamera::isGrabbing() {
+    return grabber->running();
+}
+
+int SyntheticCamera::getImageROIwidth() {
+    return params.width;
+}
+
+int SyntheticCamera::getImageROIheight() {
+    return params.height;
+}
+
+int SyntheticCamera::getImageROIwidthMax() {
+    return params.width;
+}
+
+int SyntheticCamera::getImageROIheightMax() {
+    return params.height;
+}
+
+int SyntheticCamera::getImageROIoffsetX() {
+    return 0;
+}
+
+int SyntheticCamera::getImageROIoffsetY() {
+    return 0;
+}
+
+QRectF SyntheticCamera::getImageROI() {
+    return QRectF(0, 0, params.width, params.height);
+}
+
+const SyntheticCameraParams &SyntheticCamera::getParams() const {
+    return params;
+}
+
+CameraCalibration *SyntheticCamera::getCameraCalibration() {
+    return cameraCalibration;
+}
+
+StereoCameraCalibration *SyntheticCamera::getStereoCameraCalibration() {
+    return stereoCameraCalibration;
+}
+
+namespace {
+    // Parameters settable through parseParams(), the integer ones are rounded
+    struct SyntheticParamField {
+        const char *name;
+        double SyntheticCameraParams::*value;
+        int SyntheticCameraParams::*intValue;
+        double minimum;
+    };
+
+    const SyntheticParamField syntheticParamFields[] = {
+        {"width", nullptr, &SyntheticCameraParams::width, 64},
+        {"height", nullptr, &SyntheticCameraParams::height, 64},
+        {"fps", &SyntheticCameraParams::fps, nullptr, 0.1},
+        {"pupilRadiusMin", &SyntheticCameraParams::pupilRadiusMin, nullptr, 1},
+        {"pupilRadiusMax", &SyntheticCameraParams::pupilRadiusMax, nullptr, 1},
+        {"pupilPeriod", &SyntheticCameraParams::pupilPeriod, nullptr, 0.01},
+        {"irisRadius", &SyntheticCameraParams::irisRadius, nullptr, 1},
+        {"eyeballRadius", &SyntheticCameraParams::eyeballRadius, nullptr, 1},
+        {"gazeAmplitudeX", &SyntheticCameraParams::gazeAmplitudeX, nullptr, 0},
+        {"gazeAmplitudeY", &SyntheticCameraParams::gazeAmplitudeY, nullptr, 0},
+        {"gazePeriod", &SyntheticCameraParams::gazePeriod, nullptr, 0.01},
+        {"glintCount", nullptr, &SyntheticCameraParams::glintCount, 0},
+        {"glintRadius", &SyntheticCameraParams::glintRadius, nullptr, 0},
+        {"eyelidOpening", &SyntheticCameraParams::eyelidOpening, nullptr, 1},
+        {"blinkInterval", &SyntheticCameraParams::blinkInterval, nullptr, 0},
+        {"blinkDuration", &SyntheticCameraParams::blinkDuration, nullptr, 0.001},
+        {"noiseSigma", &SyntheticCameraParams::noiseSigma, nullptr, 0},
+        {"blurKernel", nullptr, &SyntheticCameraParams::blurKernel, 0},
+        {"stereoDisparity", &SyntheticCameraParams::stereoDisparity, nullptr, 0}
+    };
+}
+
+// The parameters are only changed if the whole string is valid
+bool SyntheticCamera::parseParams(const QString &spec, SyntheticCameraParams &params) {
+    SyntheticCameraParams parsed = params;
+
+    for(const QString &entry : spec.split(',', Qt::SkipEmptyParts)) {
+        const QStringList keyValue = entry.split('=');
+        if(keyValue.size() != 2)
+            return false;
+
+        bool ok = false;
+        const double value = keyValue[1].trimmed().toDouble(&ok);
+        if(!ok)
+            return false;
+
+        const SyntheticParamField *field = nullptr;
+        for(const SyntheticParamField &f : syntheticParamFields) {
+            if(keyValue[0].trimmed().compare(f.name, Qt::CaseInsensitive) == 0)
+                field = &f;
+        }
+        if(!field || value < field->minimum)
+            return false;
+
+        if(field->value)
+            parsed.*(field->value) = value;
+        else
+            parsed.*(field->intValue) = (int)std::lround(value);
+    }
+
+    if(parsed.pupilRadiusMax < parsed.pupilRadiusMin)
+        return false;
+
+    params = parsed;
+    return true;
+}
+
+QString SyntheticCamera::paramsToString(const SyntheticCameraParams &params) {
+    QStringList entries;
+    for(const SyntheticParamField &field : syntheticParamFields) {
+        const double value = field.value ? params.*(field.value) : params.*(field.intValue);
+        entries << QString("%1=%2").arg(field.name).arg(value);
+    }
+    return entries.join(',');
+}
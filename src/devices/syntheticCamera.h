@@ -0,0 +1,197 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+#include <QDebug>
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <vector>
+
+#include "camera.h"
+#include "../cameraCalibration.h"
+#include "../stereoCameraCalibration.h"
+#include "../cameraFrameRateCounter.h"
+
+/**
+    Parameters of the procedurally rendered eye image
+
+    All trajectories are periodic functions of the (virtual) acquisition time, so a given frame number
+    always renders the same image for the same parameters, which makes runs reproducible.
+    Lengths are given in pixels, periods and durations in seconds.
+*/
+struct SyntheticCameraParams {
+    int width = 640;
+    int height = 480;
+    double fps = 1000.0;
+    bool stereo = false;
+
+    double pupilRadiusMin = 14.0;
+    double pupilRadiusMax = 34.0;
+    double pupilPeriod = 4.0;
+
+    double irisRadius = 80.0;
+    double eyeballRadius = 160.0; // used for the foreshortening of the pupil ellipse when gaze leaves the optical axis
+    double gazeAmplitudeX = 90.0;
+    double gazeAmplitudeY = 50.0;
+    double gazePeriod = 3.0;
+
+    int glintCount = 2;
+    double glintRadius = 3.0;
+
+    double eyelidOpening = 150.0; // half height of the fully open palpebral fissure
+    double blinkInterval = 5.0; // 0 disables blinking
+    double blinkDuration = 0.15;
+
+    double noiseSigma = 4.0;
+    int blurKernel = 3; // odd, 0 or 1 disables blurring
+
+    double stereoDisparity = 40.0; // horizontal shift of the eye in the secondary view
+};
+
+/**
+    Ground truth of one rendered frame, as computed by SyntheticEyeRenderer::render()
+
+    pupil is in the coordinates of the main view, pupilSecondary in the coordinates of the secondary view (stereo only).
+    blink is set when the eyelid covers the pupil centre, eyelidOpening is the currently open fraction [0,1].
+*/
+struct SyntheticGroundTruth {
+    uint64_t frameNumber;
+    cv::RotatedRect pupil;
+    cv::RotatedRect pupilSecondary;
+    bool blink;
+    double eyelidOpening;
+};
+
+/**
+    Renders synthetic eye images: skin background, iris, dark elliptic pupil, corneal glints, eyelids, blur and sensor noise
+
+    The static background and a small set of noise frames are precomputed upon construction, so rendering a frame only
+    consists of a copy, a few filled primitives, an optional blur and a saturated add, which keeps up with 1000+ fps
+    at VGA resolution on ordinary machines.
+
+    render(): renders the frame for the given time, writing the main (and for stereo the secondary) image and the ground truth
+*/
+class SyntheticEyeRenderer {
+
+public:
+
+    explicit SyntheticEyeRenderer(const SyntheticCameraParams &params);
+
+    void render(double t, uint64_t frameNumber, cv::Mat &img, cv::Mat &imgSecondary, SyntheticGroundTruth &truth);
+
+    const SyntheticCameraParams &getParams() const;
+
+private:
+
+    SyntheticCameraParams params;
+
+    cv::Mat background;
+    std::vector<cv::Mat> noiseFrames;
+
+    void renderView(const cv::RotatedRect &pupil, const cv::Point2f &irisCenter, double lidHalfHeight, uint64_t frameNumber, cv::Mat &out) const;
+};
+
+/**
+    Worker running in its own thread, rendering frames paced on absolute deadlines of a steady clock
+
+    Frame n is due at start + n/fps, so pacing does not drift with the rendering time and no sleep granularity
+    accumulates, which makes rates well above 1000 fps reachable. If rendering falls behind, frames are produced
+    back-to-back until the schedule is met again.
+*/
+class SyntheticGrabber : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SyntheticGrabber(const SyntheticCameraParams &params);
+
+    bool running() const;
+
+signals:
+    void finished();
+    void onNewGrabResult(CameraImage grabResult);
+
+public slots:
+    void run();
+    void stop();
+
+private:
+    std::atomic<bool> m_running;
+    SyntheticEyeRenderer renderer;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+    Virtual camera which procedurally renders eye images in real time, for load and accuracy testing without camera hardware
+
+    Behaves like a live device: frames arrive through onNewGrabResult() with type SYNTHETIC_SINGLE_CAMERA or
+    SYNTHETIC_STEREO_CAMERA.
+
+    getParams(): rendering parameters the camera was created with
+    parseParams(): overrides the parameters named in a "key=value,key=value" string, e.g. "width=1280,height=1024,fps=500,gazePeriod=2",
+                   the keys are the names of the SyntheticCameraParams fields except stereo. Returns false on an unknown key or invalid value
+    paramsToString(): the parameters in the format read by parseParams()
+    getCameraCalibration(): calibration object for single mode (not calibrated by default)
+    getStereoCameraCalibration(): calibration object for stereo mode (not calibrated by default)
+
+signals:
+    fps(double fps): frames per second of the rendered stream
+    framecount(int framecount): number of rendered frames
+*/
+class SyntheticCamera : public Camera {
+    Q_OBJECT
+
+public:
+
+    explicit SyntheticCamera(const SyntheticCameraParams &params, QObject *parent = 0);
+    ~SyntheticCamera() override;
+
+    bool isOpen() override;
+    void close() override;
+    CameraImageType getType() override;
+
+    void startGrabbing() override;
+    void stopGrabbing() override;
+    bool isGrabbing() override;
+
+    int getImageROIwidth() override;
+    int getImageROIheight() override;
+    int getImageROIwidthMax() override;
+    int getImageROIheightMax() override;
+    int getImageROIoffsetX() override;
+    int getImageROIoffsetY() override;
+    QRectF getImageROI() override;
+
+    const SyntheticCameraParams &getParams() const;
+
+    static bool parseParams(const QString &spec, SyntheticCameraParams &params);
+    static QString paramsToString(const SyntheticCameraParams &params);
+
+    CameraCalibration *getCameraCalibration();
+    StereoCameraCalibration *getStereoCameraCalibration();
+
+private:
+
+    SyntheticCameraParams params;
+    bool open;
+
+    QThread *grabbingThread;
+    SyntheticGrabber *grabber;
+
+    CameraFrameRateCounter *frameCounter;
+
+    CameraCalibration *cameraCalibration;
+    StereoCameraCalibration *stereoCameraCalibration;
+    QThread *calibrationThread;
+
+signals:
+    void fps(double fps);
+    void framecount(int framecount);
+
+};
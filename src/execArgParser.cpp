@@ -92,6 +92,12 @@ void ExecArgParser::iterThroughDuties() {
         if(execArgs[i].argID == getArgIdx(OPEN_SINGLE_WEBCAM) && execArgs[i].argVals.size()>=1 && !execArgs[i].argVals[0].isEmpty()) {
             w->PRGopenSingleWebcam(execArgs[i].argVals[0].toInt());
         }
+        if(execArgs[i].argID == getArgIdx(SET_SYNTHETIC_CAMERA_PARAMS) && execArgs[i].argVals.size()==1 && !execArgs[i].argVals[0].isEmpty()) {
+            w->PRGsetSyntheticCameraParams(execArgs[i].argVals[0]);
+        }
+        if(execArgs[i].argID == getArgIdx(OPEN_SYNTHETIC_CAMERA) && execArgs[i].argVals.size()>=1 && !execArgs[i].argVals[0].isEmpty()) {
+            w->PRGopenSyntheticCamera(execArgs[i].argVals[0].toLower());
+        }
         if(execArgs[i].argID == getArgIdx(CONNECT_MICROCONTROLLER_UDP) && execArgs[i].argVals.size()==1 && !execArgs[i].argVals[0].isEmpty()) {
             w->PRGconnectMicrocontrollerUDP(execArgs[i].argVals[0].toLower());
         }
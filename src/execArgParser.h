@@ -46,6 +46,8 @@ private:
         OPEN_SINGLE_CAMERA,
         OPEN_STEREO_CAMERA,
         OPEN_SINGLE_WEBCAM,
+        SET_SYNTHETIC_CAMERA_PARAMS,
+        OPEN_SYNTHETIC_CAMERA,
         CONNECT_MICROCONTROLLER_UDP,
         CONNECT_MICROCONTROLLER_COM,
         SET_EXPOSURE_TIME_MICROSEC,
@@ -86,6 +88,8 @@ private:
         {OPEN_SINGLE_CAMERA, "-openSingleCamera", 1},
         {OPEN_STEREO_CAMERA, "-openStereoCamera", 2},
         {OPEN_SINGLE_WEBCAM, "-openSingleWebcam", 1},
+        {SET_SYNTHETIC_CAMERA_PARAMS, "-setSyntheticCameraParams", 1},
+        {OPEN_SYNTHETIC_CAMERA, "-openSyntheticCamera", 1},
         {CONNECT_MICROCONTROLLER_UDP, "-connectMicrocontrollerUDP", 1},
         {CONNECT_MICROCONTROLLER_COM, "-connectMicrocontrollerCOM", 1},
         {SET_EXPOSURE_TIME_MICROSEC, "-setExposureTimeMicrosec", 1},
@@ -17,6 +17,7 @@ void EyeDataSerializer::populatePupilNodeXML(quint64 &timestamp, QDomElement &dO
     dObj.setAttribute("circumference_px", QString::number(Pupils[idx].circumference())); 
     dObj.setAttribute("confidence", QString::number(Pupils[idx].confidence)); 
     dObj.setAttribute("outlineConfidence", QString::number(Pupils[idx].outline_confidence)); 
+    dObj.setAttribute("blink", QString::number(Pupils[idx].blink));
     dObj.setAttribute("trial", QString::number(trialNum));
     dObj.setAttribute("message", message);
     dObj.setAttribute("temperature_c", QString::number(temperature));
@@ -122,6 +123,7 @@ void EyeDataSerializer::populatePupilNodeJSON(quint64 &timestamp, QJsonObject &d
     dObj["circumference_px"] = QString::number(Pupils[idx].circumference()); 
     dObj["confidence"] = QString::number(Pupils[idx].confidence); 
     dObj["outlineConfidence"] = QString::number(Pupils[idx].outline_confidence); 
+    dObj["blink"] = QString::number(Pupils[idx].blink);
     dObj["trial"] = QString::number(trialNum);
     dObj["message"] = message;
     dObj["temperature_c"] = QString::number(temperature);
@@ -217,11 +219,14 @@ QString EyeDataSerializer::getHeaderCSV(int procMode, QChar delim, DataWriterDat
             result = result % "circumference_px" % delim;
             result = result % "confidence" % delim;
             result = result % "outlineConfidence";
-            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_2) {
+            if(dataStyle >= DataWriterDataStyle::PUPILEXT_V0_1_2) {
                 result = result % delim % "trial" % delim;
                 result = result % "message" % delim;
                 result = result % "temperature_c";
             }
+            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_3) {
+                result = result % delim % "blink";
+            }
             break;
         case ProcMode::SINGLE_IMAGE_TWO_PUPIL:
             if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_1) {
@@ -253,11 +258,15 @@ QString EyeDataSerializer::getHeaderCSV(int procMode, QChar delim, DataWriterDat
             result = result % "outlineConfidenceA" % delim;
             result = result % "confidenceB" % delim;
             result = result % "outlineConfidenceB";
-            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_2) {
+            if(dataStyle >= DataWriterDataStyle::PUPILEXT_V0_1_2) {
                 result = result % delim % "trial" % delim;
                 result = result % "message" % delim;
                 result = result % "temperature_c";
             }
+            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_3) {
+                result = result % delim % "blinkA" % delim;
+                result = result % "blinkB";
+            }
             break;
         case ProcMode::STEREO_IMAGE_ONE_PUPIL:
             if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_1) {
@@ -288,12 +297,16 @@ QString EyeDataSerializer::getHeaderCSV(int procMode, QChar delim, DataWriterDat
             result = result % "outlineConfidenceMain" % delim;
             result = result % "confidenceSec" % delim;
             result = result % "outlineConfidenceSec";
-            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_2) {
+            if(dataStyle >= DataWriterDataStyle::PUPILEXT_V0_1_2) {
                 result = result % delim % "trial" % delim;
                 result = result % "message" % delim;
                 result = result % "temperatureMain_c" % delim;
                 result = result % "temperatureSec_c";
             }
+            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_3) {
+                result = result % delim % "blinkMain" % delim;
+                result = result % "blinkSec";
+            }
             break;
         case ProcMode::STEREO_IMAGE_TWO_PUPIL:
             if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_1) {
@@ -347,12 +360,18 @@ QString EyeDataSerializer::getHeaderCSV(int procMode, QChar delim, DataWriterDat
             result = result % "outlineConfidenceBMain" % delim;
             result = result % "confidenceBSec" % delim;
             result = result % "outlineConfidenceBSec"; //
-            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_2) {
+            if(dataStyle >= DataWriterDataStyle::PUPILEXT_V0_1_2) {
                 result = result % delim % "trial" % delim; //
                 result = result % "message" % delim;
                 result = result % "temperatureMain_c" % delim;
                 result = result % "temperatureSec_c";
             }
+            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_3) {
+                result = result % delim % "blinkAMain" % delim;
+                result = result % "blinkASec" % delim; //
+                result = result % "blinkBMain" % delim;
+                result = result % "blinkBSec"; //
+            }
             break;
         
         // case ProcMode::MIRR_IMAGE_ONE_PUPIL:
@@ -394,11 +413,14 @@ QString EyeDataSerializer::pupilToRowCSV(quint64 timestamp, int procMode, const
             result = result % QString::number(Pupils[SINGLE_IMAGE_ONE_PUPIL_MAIN].circumference()) % delim;
             result = result % QString::number(Pupils[SINGLE_IMAGE_ONE_PUPIL_MAIN].confidence) % delim;
             result = result % QString::number(Pupils[SINGLE_IMAGE_ONE_PUPIL_MAIN].outline_confidence);
-            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_2) {
+            if(dataStyle >= DataWriterDataStyle::PUPILEXT_V0_1_2) {
                 result = result %  delim % QString::number(trialNum) % delim;
                 result = result % message % delim;
                 result = result % QString::number(temperatures[0]);
             }
+            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_3) {
+                result = result % delim % QString::number(Pupils[SINGLE_IMAGE_ONE_PUPIL_MAIN].blink);
+            }
             break;
         case ProcMode::SINGLE_IMAGE_TWO_PUPIL:
             if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_1) {
@@ -430,11 +452,15 @@ QString EyeDataSerializer::pupilToRowCSV(quint64 timestamp, int procMode, const
             result = result % QString::number(Pupils[SINGLE_IMAGE_TWO_PUPIL_A].outline_confidence) % delim;
             result = result % QString::number(Pupils[SINGLE_IMAGE_TWO_PUPIL_B].confidence) % delim;
             result = result % QString::number(Pupils[SINGLE_IMAGE_TWO_PUPIL_B].outline_confidence);
-            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_2) {
+            if(dataStyle >= DataWriterDataStyle::PUPILEXT_V0_1_2) {
                 result = result % delim % QString::number(trialNum) % delim;
                 result = result % message % delim;
                 result = result % QString::number(temperatures[0]);
             }
+            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_3) {
+                result = result % delim % QString::number(Pupils[SINGLE_IMAGE_TWO_PUPIL_A].blink) % delim;
+                result = result % QString::number(Pupils[SINGLE_IMAGE_TWO_PUPIL_B].blink);
+            }
             break;
         case ProcMode::STEREO_IMAGE_ONE_PUPIL:
             if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_1) {
@@ -465,12 +491,16 @@ QString EyeDataSerializer::pupilToRowCSV(quint64 timestamp, int procMode, const
             result = result % QString::number(Pupils[STEREO_IMAGE_ONE_PUPIL_MAIN].outline_confidence) % delim;
             result = result % QString::number(Pupils[STEREO_IMAGE_ONE_PUPIL_SEC].confidence) % delim;
             result = result % QString::number(Pupils[STEREO_IMAGE_ONE_PUPIL_SEC].outline_confidence);
-            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_2) {
+            if(dataStyle >= DataWriterDataStyle::PUPILEXT_V0_1_2) {
                 result = result % delim % QString::number(trialNum) % delim;
                 result = result % message % delim;
                 result = result % QString::number(temperatures[0]) % delim;
                 result = result % QString::number(temperatures[1]);
             }
+            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_3) {
+                result = result % delim % QString::number(Pupils[STEREO_IMAGE_ONE_PUPIL_MAIN].blink) % delim;
+                result = result % QString::number(Pupils[STEREO_IMAGE_ONE_PUPIL_SEC].blink);
+            }
             break;
         case ProcMode::STEREO_IMAGE_TWO_PUPIL:
             if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_1) {
@@ -524,12 +554,18 @@ QString EyeDataSerializer::pupilToRowCSV(quint64 timestamp, int procMode, const
             result = result % QString::number(Pupils[STEREO_IMAGE_TWO_PUPIL_B_MAIN].outline_confidence) % delim;
             result = result % QString::number(Pupils[STEREO_IMAGE_TWO_PUPIL_B_SEC].confidence) % delim;
             result = result % QString::number(Pupils[STEREO_IMAGE_TWO_PUPIL_B_SEC].outline_confidence); //
-            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_2) {
+            if(dataStyle >= DataWriterDataStyle::PUPILEXT_V0_1_2) {
                 result = result % delim % QString::number(trialNum) % delim;
                 result = result % message % delim;
                 result = result % QString::number(temperatures[0]) % delim;
                 result = result % QString::number(temperatures[1]);
             }
+            if(dataStyle == DataWriterDataStyle::PUPILEXT_V0_1_3) {
+                result = result % delim % QString::number(Pupils[STEREO_IMAGE_TWO_PUPIL_A_MAIN].blink) % delim;
+                result = result % QString::number(Pupils[STEREO_IMAGE_TWO_PUPIL_A_SEC].blink) % delim; //
+                result = result % QString::number(Pupils[STEREO_IMAGE_TWO_PUPIL_B_MAIN].blink) % delim;
+                result = result % QString::number(Pupils[STEREO_IMAGE_TWO_PUPIL_B_SEC].blink); //
+            }
             break;
         
         // case ProcMode::MIRR_IMAGE_ONE_PUPIL:
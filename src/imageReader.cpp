@@ -3,14 +3,17 @@
 #include <opencv2/opencv.hpp>
 #include <QtConcurrent/QtConcurrent>
 #include "imageReader.h"
+#include "threadBudget.h"
 
 // Creates a new image reader which opens the given directory and plays back the contained image files
-// Image files are read in alphabetically order, using the OpenCV function cv::glob()
+// Image files are read in the order of their timestamps, as listed by the RecordingIndex
 // Actual playback process is performed using Qts concurrent thread execution, to no block the GUI thread
 // First it is checked wherever a stereo directory structure exists or not, which
 ImageReader::ImageReader(QString directory, QMutex *imageMutex, QWaitCondition *imagePublished, QWaitCondition *imageProcessed, int playbackSpeed, bool playbackLoop, QObject *parent) :
     QObject(parent),
     imageDirectory(directory),
+    videoReader(nullptr),
+    proxyCache(nullptr),
     startTimestamp(0),
     playbackSpeed(playbackSpeed),
     noDelay(false),
@@ -23,56 +26,53 @@ ImageReader::ImageReader(QString directory, QMutex *imageMutex, QWaitCondition *
     imageProcessed(imageProcessed),
     currentImageIndex(0) {
 
+    if(VideoReader::isVideoFileName(directory) && QFileInfo(directory).isFile()) {
+        videoReader = new VideoReader(directory.toStdString());
+        if(!videoReader->isOpen()) {
+            delete videoReader;
+            videoReader = nullptr;
+            throw std::invalid_argument( "Video file could not be opened." );
+        }
+
+        const std::string videoFileName = directory.toStdString();
+        for(int i = 0; i < videoReader->getNumFrames(); i++)
+            filenames.push_back(videoFileName + "#" + std::to_string(i));
+        acqTimestamps.assign(videoReader->getTimestamps().begin(), videoReader->getTimestamps().end());
+        foundImageWidth = videoReader->getWidth();
+        foundImageHeight = videoReader->getHeight();
+
+        setPlaybackSpeed(playbackSpeed);
+        return;
+    }
+
     if(!imageDirectory.exists()) {
         throw std::invalid_argument( "Image Directory does not exist." );
     }
 
-    // qDebug() << imageDirectory << Qt::endl;
-    // qDebug() << imageDirectory.exists("0") << Qt::endl;
-    // qDebug() << imageDirectory.exists("1") << Qt::endl;
-
     // Check if in directory, a stereo structure with directories 0 and 1 for main and secondary camera are present
-    if(imageDirectory.exists("0") && imageDirectory.exists("1")) {
-        stereoMode = true;
-
-//        qDebug()<<"ImageReader: Found stereo structure in directory, reading as stereo..." ;
-//        qDebug()<<"ImageReader: CAUTION: Make sure images in both directories have corresponding names and that no other files are present." ;
-
-        // Read directory files into list
-        // glob sorts the names alphabetically, so filenames without zeros like _19 come after _189
-        cv::glob(imageDirectory.filePath("0").toStdString(), filenames, false);
-        cv::glob(imageDirectory.filePath("1").toStdString(), filenamesSecondary, false);
-
-        purgeFilenamesVector(filenames);
-        purgeFilenamesVector(filenamesSecondary);
-        // TODO: add check to ensure the same timestamp has images in both directories
-
-        assert(filenames.size() == filenamesSecondary.size());
-    } else {
-
-//        qDebug()<<"ImageReader: Found images in directory, reading..." ;
-
-        // Read directory files into list
-        // glob sorts the names alphabetically, so filenames without zeros like _19 come after _189
-        cv::glob(imageDirectory.path().toStdString(), filenames, false);
-
-        purgeFilenamesVector(filenames);
+    stereoMode = imageDirectory.exists("0") && imageDirectory.exists("1");
+
+    // The index file written on recording (or on first opening) avoids listing and parsing all images of the recording
+    RecordingIndex index(stereoMode);
+    if(!index.load(imageDirectory.path())) {
+        if(index.scan(imageDirectory.path()))
+            index.save(imageDirectory.path());
+        else
+            std::cerr << "Image Reader: no images found in: " << imageDirectory.path().toStdString() << std::endl;
     }
 
-//    qDebug()<<"ImageReader: found " << filenames.size() << " images. Ready." ;
-
-    bool ok;
-    for(size_t u = 0; u < filenames.size(); u++) {
-        acqTimestamps.push_back( QFileInfo(QString::fromStdString(filenames[u])).baseName().toULongLong(&ok, 10) );
-    }
+    filenames = index.getFilePaths(imageDirectory.path());
+    if(stereoMode)
+        filenamesSecondary = index.getFilePaths(imageDirectory.path(), true);
+    acqTimestamps = index.getTimestamps();
 
     // GB: measure found images px size, for documenting in meta-snapshot
-    int b=0;
-    cv::Mat checkImg;
-    while(b < filenames.size() && (foundImageWidth<=0 || foundImageHeight<=0)) {
-        checkImg = cv::imread(filenames[b], cv::IMREAD_GRAYSCALE);
-        foundImageWidth = checkImg.cols;
-        foundImageHeight = checkImg.rows;
+    foundImageWidth = index.getImageWidth();
+    foundImageHeight = index.getImageHeight();
+
+    if(!filenames.empty()) {
+        proxyCache = new ProxyImageCache(filenames, filenamesSecondary, foundImageWidth, foundImageHeight);
+        proxyCache->start();
     }
 
     setPlaybackSpeed(playbackSpeed);
@@ -84,6 +84,15 @@ ImageReader::~ImageReader() {
 
         playbackProcess.waitForFinished();
     }
+    delete proxyCache;
+    delete videoReader;
+}
+
+// Reads the image from disk, or the frame from the video file
+cv::Mat ImageReader::readImage(int index) {
+    if(videoReader)
+        return videoReader->frame(index);
+    return cv::imread(filenames[index], cv::IMREAD_GRAYSCALE);
 }
 
 // Sets the speed with which the images are played back
@@ -106,6 +115,9 @@ void ImageReader::setPlaybackSpeed(int fps) {
 void ImageReader::run() {
 
     std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    // The image is read once and kept while waiting for the playback delay to pass
+    cv::Mat img;
+    int imgIndex = -1;
     while(currentImageIndex < filenames.size()) {
         if (state != PlaybackState::PLAYING) {
 //            qDebug() << "Image Reader: Run Loop found Stop/Pause signal" ;
@@ -116,7 +128,10 @@ void ImageReader::run() {
         std::chrono::steady_clock::time_point beginProcess = std::chrono::steady_clock::now();
         std::chrono::duration<int, std::milli> elapsedDuration = std::chrono::duration_cast<std::chrono::milliseconds>(beginProcess - startTime);
         int elapsedTime = elapsedDuration.count();
-        cv::Mat img = cv::imread(filenames[currentImageIndex], cv::IMREAD_GRAYSCALE);
+        if(imgIndex != currentImageIndex) {
+            img = readImage(currentImageIndex);
+            imgIndex = currentImageIndex;
+        }
         if(img.data && elapsedTime >= playbackDelay) {
 
             if (synchronised){
@@ -138,10 +153,12 @@ void ImageReader::run() {
 
 
             currentImageIndex++;
+            imgIndex = -1;
         }
         else if (!img.data){
 //            std::cerr << "Image Reader: Image could not be read, skipping: " << filenames[currentImageIndex] ;
             currentImageIndex++;
+            imgIndex = -1;
         }
         if (playbackLoop && currentImageIndex == filenames.size()) {
 //            qDebug() << "ImageReader: end reached, resetting playback, endless looping " ;
@@ -167,6 +184,8 @@ void ImageReader::run() {
 //        qDebug() << "paused()";
         emit paused();
     }
+    if(proxyCache)
+        proxyCache->setSuspended(false);
     imageProcessed->wakeAll();
     imagePublished->wakeAll();
 }
@@ -227,8 +246,8 @@ void ImageReader::runStereo() {
         int elapsedTime = elapsedDuration.count();
         QFutureSynchronizer<cv::Mat> synchronizer;
         // Read images from disk asynchronous to save time
-        synchronizer.addFuture(QtConcurrent::run(cv::imread, filenames[currentImageIndex], cv::IMREAD_GRAYSCALE));
-        synchronizer.addFuture(QtConcurrent::run(cv::imread, filenamesSecondary[currentImageIndex], cv::IMREAD_GRAYSCALE));
+        synchronizer.addFuture(QtConcurrent::run(ThreadBudget::pool(ThreadBudget::PLAYBACK), cv::imread, filenames[currentImageIndex], cv::IMREAD_GRAYSCALE));
+        synchronizer.addFuture(QtConcurrent::run(ThreadBudget::pool(ThreadBudget::PLAYBACK), cv::imread, filenamesSecondary[currentImageIndex], cv::IMREAD_GRAYSCALE));
         synchronizer.waitForFinished();
         cv::Mat img = synchronizer.futures().at(0).result();
         cv::Mat imgSecondary = synchronizer.futures().at(1).result();
@@ -275,6 +294,8 @@ void ImageReader::runStereo() {
         emit finished();
     }
 
+    if(proxyCache)
+        proxyCache->setSuspended(false);
     imageProcessed->wakeAll();
     imagePublished->wakeAll();
 
@@ -327,6 +348,9 @@ void ImageReader::start() {
 //    qDebug()<<"Image Reader: Starting ImageReader thread.";
 
     state = PlaybackState::PLAYING;
+    // Building the previews would compete with the playback for disk reads
+    if(proxyCache)
+        proxyCache->setSuspended(true);
     startTimestamp = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 
     if(stereoMode) {
@@ -366,69 +390,9 @@ void ImageReader::stop() {
 }
 
 
-void ImageReader::purgeFilenamesVector(std::vector<cv::String> &filenames) {
-
-    if(filenames.empty())
-        return;
-
-    // we find the most frequent extension in the folder (which must be the image extension we use)
-    std::vector<cv::String> fileExtensions;
-    std::vector<int> fileExtensionFreqencies;
-    size_t dotPos = cv::String::npos;
-    cv::String currExt;
-    //
-    for(int c=0; c<filenames.size(); c++) {
-        dotPos = filenames[c].find_last_of('.');
-        if(dotPos != cv::String::npos) {
-            currExt = filenames[c].substr(dotPos, filenames[c].length()-(dotPos));
-
-            auto whereInVector = std::find(fileExtensions.begin(), fileExtensions.end(), currExt);
-            if(whereInVector == fileExtensions.end()) { // if the extension can NOT be found in the vector, add it
-                fileExtensions.push_back(currExt);
-                fileExtensionFreqencies.push_back(1);
-                //std::cout << "Found files in the folder with the following extension = " << currExt ;
-            } else {
-                fileExtensionFreqencies[(int)(whereInVector-fileExtensions.begin())]++;
-            }
-        } else {
-            // töröljük simán a listából
-        }
-    }
-    int mostFreqIndex = std::max_element(fileExtensionFreqencies.begin(), fileExtensionFreqencies.end())-fileExtensionFreqencies.begin();
-    //std::cout << "Freq of the most frequent extension = " << fileExtensionFreqencies[mostFreqIndex] ;
-    //std::cout << "The most frequent extension = " << fileExtensions[mostFreqIndex] ;
-
-
-    size_t iterUntil = filenames.size()-1;
-    size_t iterIndex = 0;
-    bool flaggedForDeletion = false;
-    while(iterIndex <= iterUntil) {
-        //filenames[iter_index].find(s2) != std::string::npos
-        flaggedForDeletion = false;
-
-        dotPos = filenames[iterIndex].find_last_of('.');
-        if(dotPos != cv::String::npos) {
-            currExt = filenames[iterIndex].substr(dotPos, filenames[iterIndex].length()-(dotPos)); //also handles if the filename ends with dot but there are no characters afterwards
-
-            if(currExt != fileExtensions[mostFreqIndex]) {
-                flaggedForDeletion = true;
-            }
-        } else {
-            flaggedForDeletion = true;
-        }
-
-        if(flaggedForDeletion) {
-            std::cout << "Deleting unusual filename from detected filenames vector = " << filenames[iterIndex] ;
-            filenames.erase(filenames.begin()+iterIndex); //no index increment, because element was deleted, but iter_until needs to decrease
-            iterUntil--;
-        } else {
-            iterIndex++;
-        }
-    }
-
-}
-
 cv::Mat ImageReader::getStillImageSingle(int frameNumber) {
+    if(videoReader)
+        return videoReader->stillFrame(frameNumber);
     if(filenames.size() > frameNumber)
         return cv::imread(filenames[frameNumber], cv::IMREAD_GRAYSCALE);
     else
@@ -443,6 +407,32 @@ std::vector<cv::Mat> ImageReader::getStillImageStereo(int frameNumber) {
         return std::vector<cv::Mat>{cv::Mat(), cv::Mat()};
 }
 
+// The preview is upscaled to the image size, as the views take the image size from the displayed image
+cv::Mat ImageReader::getPreviewImageSingle(int frameNumber) {
+    if(!proxyCache || !proxyCache->isOpen())
+        return getStillImageSingle(frameNumber);
+
+    cv::Mat proxy, unused;
+    if(!proxyCache->getProxy(frameNumber, proxy, unused))
+        return cv::Mat();
+    cv::Mat img;
+    cv::resize(proxy, img, cv::Size(foundImageWidth, foundImageHeight), 0, 0, cv::INTER_LINEAR);
+    return img;
+}
+
+std::vector<cv::Mat> ImageReader::getPreviewImageStereo(int frameNumber) {
+    if(!proxyCache || !proxyCache->isOpen())
+        return getStillImageStereo(frameNumber);
+
+    cv::Mat proxy, proxySecondary;
+    if(!proxyCache->getProxy(frameNumber, proxy, proxySecondary))
+        return std::vector<cv::Mat>{cv::Mat(), cv::Mat()};
+    std::vector<cv::Mat> vec(2);
+    cv::resize(proxy, vec[0], cv::Size(foundImageWidth, foundImageHeight), 0, 0, cv::INTER_LINEAR);
+    cv::resize(proxySecondary, vec[1], cv::Size(foundImageWidth, foundImageHeight), 0, 0, cv::INTER_LINEAR);
+    return vec;
+}
+
 // This is not computationally expensive, so currently run on the main thread
 void ImageReader::step1frame(bool next) {
     if(state == PlaybackState::PLAYING)
@@ -467,8 +457,8 @@ void ImageReader::step1frame(bool next) {
     if(stereoMode) {
         QFutureSynchronizer<cv::Mat> synchronizer;
         // Read images from disk asynchronous to save time
-        synchronizer.addFuture(QtConcurrent::run(cv::imread, filenames[currentImageIndex], cv::IMREAD_GRAYSCALE));
-        synchronizer.addFuture(QtConcurrent::run(cv::imread, filenamesSecondary[currentImageIndex], cv::IMREAD_GRAYSCALE));
+        synchronizer.addFuture(QtConcurrent::run(ThreadBudget::pool(ThreadBudget::PLAYBACK), cv::imread, filenames[currentImageIndex], cv::IMREAD_GRAYSCALE));
+        synchronizer.addFuture(QtConcurrent::run(ThreadBudget::pool(ThreadBudget::PLAYBACK), cv::imread, filenamesSecondary[currentImageIndex], cv::IMREAD_GRAYSCALE));
         synchronizer.waitForFinished();
         cv::Mat img = synchronizer.futures().at(0).result();
         cv::Mat imgSecondary = synchronizer.futures().at(1).result();
@@ -490,7 +480,7 @@ void ImageReader::step1frame(bool next) {
 
         emit onNewImage(cimg);
     } else {
-        cv::Mat img = cv::imread(filenames[currentImageIndex], cv::IMREAD_GRAYSCALE);
+        cv::Mat img = readImage(currentImageIndex);
 
         if(!img.data) {
             std::cerr << "Image Reader: Image could not be read, skipping: " << filenames[currentImageIndex] ;
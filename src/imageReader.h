@@ -7,6 +7,9 @@
 #include <QtCore/QObject>
 #include <QtGui/QtGui>
 #include "devices/camera.h"
+#include "proxyImageCache.h"
+#include "recordingIndex.h"
+#include "videoReader.h"
 #include <vector>
 #include <algorithm>
 
@@ -21,12 +24,20 @@ enum PlaybackState { STOPPED=0, PAUSED=1, PLAYING=2 };
     For single camera images, all images are in a single directory, without any other files
     For stereo camera images, two directories exist, 0 for main camera images, 1 for secondary camera images, each image have corresponding filenames
 
-    CAUTION:
-    OpenCV's cv::glob is used to list the content of the directory, which returns the files in alphabetically order, a preceeding, zeros are necessary for the correct order
-    i.e. 10.jpg and 9.jpg are ordered wrong due to that (1<9), 09.jpg and 10.jpg do not have the problem (0<1)
+    The images are listed through a RecordingIndex, which is read from the index file of the recording if present and up to date,
+    otherwise the directory is listed and the index file written. Images are played back in the order of their timestamps (filenames),
+    images without a timestamp in their filename are played back in alphabetical order. For stereo recordings, only images present in
+    both directories are played back.
 
     CAUTION:
     Depending on the disk read speed, high replay framerates may not be possible due to disk read speed and filesize
+
+    For scrubbing, downscaled previews of the images are provided by a ProxyImageCache built in the background (paused during playback),
+    getPreviewImageSingle/Stereo() return them upscaled to image size, or empty images if no preview is available near the frame yet.
+    For video files, the still images are returned instead.
+
+    Instead of a directory, a video file can be given (see VideoReader::isVideoFileName()), its frames are then read through a VideoReader
+    and their filenames are given as "<video file>#<frame number>", the timestamps are the presentation timestamps of the frames in ms
 */
 class ImageReader : public QObject {
 Q_OBJECT
@@ -70,10 +81,16 @@ public:
 
     cv::Mat getStillImageSingle(int frameNumber);
     std::vector<cv::Mat> getStillImageStereo(int frameNumber);
+    cv::Mat getPreviewImageSingle(int frameNumber);
+    std::vector<cv::Mat> getPreviewImageStereo(int frameNumber);
 
     QString getImageDirectoryName() {
         return imageDirectory.absolutePath();
     }
+    // Main camera image filenames by frame index, fixed once the recording is opened
+    const std::vector<std::string> &getFilenames() {
+        return filenames;
+    }
     int getImageWidth() {
         return foundImageWidth;
     }
@@ -82,17 +99,13 @@ public:
     }
     
     int getFrameNumberForTimestamp(uint64_t &timestamp) {
-        // Global private var and indexing back from currentImageIndex, this is the fastest I guess.
-        // However, there is a conversion from uint64_t to quint64 every time the comparison happens..
-        // I could not get around this, as CameraImage employs uint64_t 
-        // (I guess because in case of real cameras, it gets the value from Pylon, which uses uint64_t)
-        for(imgNumSeekerIdx = acqTimestamps.size() - 1; imgNumSeekerIdx>=0; imgNumSeekerIdx--) {
-            if(acqTimestamps[imgNumSeekerIdx] == timestamp) 
-                return imgNumSeekerIdx;
-        }
-        return currentImageIndex; 
+        // The timestamps are in ascending order
+        const int frameNumber = RecordingIndex::findTimestamp(acqTimestamps, timestamp);
+        if(frameNumber >= 0)
+            return frameNumber;
+        return currentImageIndex;
     }
-    
+
     uint64_t getTimestampForFrameNumber(int frameNumber) {
         if(acqTimestamps.size() > frameNumber)
             return acqTimestamps[frameNumber];
@@ -137,6 +150,8 @@ private:
     QWaitCondition *imageProcessed;
 
     QDir imageDirectory;
+    VideoReader *videoReader;
+    ProxyImageCache *proxyCache;
 
     std::vector<std::string> filenames, filenamesSecondary;
 
@@ -154,13 +169,12 @@ private:
     bool synchronised;
 
     std::vector<quint64> acqTimestamps;
-    int imgNumSeekerIdx = 0;
     int lastCommissionedFrameNumber = -1; 
 
     int foundImageWidth = 0;
     int foundImageHeight = 0;
 
-    void purgeFilenamesVector(std::vector<cv::String> &filenames);
+    cv::Mat readImage(int index);
 
     void run();
     void runImpl(std::chrono::steady_clock::time_point& startTime, std::chrono::duration<int, std::milli> elapsedDuration, cv::Mat &img);
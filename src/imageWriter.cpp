@@ -3,14 +3,20 @@
 #include <QtConcurrent>
 #include <opencv2/imgcodecs.hpp>
 #include <QtCore/qthreadpool.h>
+#include <algorithm>
 #include "imageWriter.h"
 #include "supportFunctions.h"
+#include "threadBudget.h"
 
 // Creates a new image writer that outputs images in the given directory
 // If stereo is true, a stereo directory structure is created in the given directory
 ImageWriter::ImageWriter(const QString& directory, bool stereo, QObject *parent) :
     QObject(parent),
     stereoMode(stereo),
+    recordingDirectory(directory),
+    writeProgress(std::make_shared<WriteProgress>()),
+    index(stereo),
+    writeIndex(false),
     applicationSettings(new QSettings(QSettings::IniFormat, QSettings::UserScope, QCoreApplication::organizationName(), QCoreApplication::applicationName(), parent)) {
 
     imageWriterFormatString = applicationSettings->value("imageWriterFormat.chosenFormat", "tiff").toString();
@@ -37,6 +43,10 @@ ImageWriter::ImageWriter(const QString& directory, bool stereo, QObject *parent)
 
     outputDirectory = QDir(directory);
 
+    // Appending to an existing recording, the index would only cover the new images
+    writeIndex = QDir(directory).entryList({"*." + imageWriterFormatString}, QDir::Files).isEmpty() &&
+                 QDir(directory).entryList({"0", "1"}, QDir::Dirs).isEmpty();
+
     if(stereoMode) {
         outputDirectorySecondary = outputDirectory;
         if(!outputDirectory.exists("0")) {
@@ -51,7 +61,46 @@ ImageWriter::ImageWriter(const QString& directory, bool stereo, QObject *parent)
     }
 }
 
-ImageWriter::~ImageWriter() = default;
+ImageWriter::~ImageWriter() {
+    waitForWrites();
+    if(writeIndex)
+        saveIndex();
+}
+
+// Blocks until all images passed to write() are on disk (or failed)
+void ImageWriter::waitForWrites() {
+    const QMutexLocker locker(&writeProgress->mutex);
+    while(writeProgress->pending > 0)
+        writeProgress->finished.wait(&writeProgress->mutex);
+}
+
+// Only called after waitForWrites(), so that the index contains exactly the images that were written
+void ImageWriter::saveIndex() {
+
+    std::vector<quint64> failed = writeProgress->failed;
+    std::sort(failed.begin(), failed.end());
+    index.sortByTimestamp(true, failed);
+    if(index.size() > 0)
+        index.save(recordingDirectory);
+}
+
+// Write every image over the thread pool of the recording, this way nothing blocks and we can write images very fast (cpu heavy)
+void ImageWriter::write(const QString &filepath, const cv::Mat &img, quint64 timestamp) {
+    std::shared_ptr<WriteProgress> progress = writeProgress;
+    const std::vector<int> params = writeParams;
+    {
+        const QMutexLocker locker(&progress->mutex);
+        progress->pending++;
+    }
+    QtConcurrent::run(ThreadBudget::pool(ThreadBudget::RECORDING), [progress, filepath, img, params, timestamp]() {
+        const bool written = cv::imwrite(filepath.toStdString(), img, params);
+        const QMutexLocker locker(&progress->mutex);
+        if(!written)
+            progress->failed.push_back(timestamp);
+        if(--progress->pending == 0)
+            progress->finished.wakeAll();
+    });
+}
 
 // Slot callback which receives new camera images
 // Write the received image to disk using the specified image format
@@ -60,14 +109,18 @@ void ImageWriter::onNewImage(const CameraImage &img) {
 
     // std::cout<<"Saving image: " << filepath.toStdString() << std::endl;
 
-    // Write every image over a thread pool managed by QT, this way nothing blocks and we can write images very fast (cpu heavy)
-    QString filepath = outputDirectory.filePath(QString::number(img.timestamp) + "." + imageWriterFormatString);
-    QtConcurrent::run(cv::imwrite, filepath.toStdString(), img.img, writeParams);
+    const QString filename = QString::number(img.timestamp) + "." + imageWriterFormatString;
+    write(outputDirectory.filePath(filename), img.img, img.timestamp);
 
 //    if(stereoMode && (img.type == CameraImageType::STEREO_IMAGE_FILE || img.type == CameraImageType::LIVE_STEREO_CAMERA)) {
     if(stereoMode) {
-        QString filepathSecondary = outputDirectorySecondary.filePath(QString::number(img.timestamp) + "." + imageWriterFormatString);
-        QtConcurrent::run(cv::imwrite, filepathSecondary.toStdString(), img.imgSecondary, writeParams);
+        write(outputDirectorySecondary.filePath(filename), img.imgSecondary, img.timestamp);
+    }
+
+    if(writeIndex) {
+        if(index.size() == 0)
+            index.setImageSize(img.img.cols, img.img.rows);
+        index.addImage(img.timestamp, filename.toStdString(), filename.toStdString());
     }
 }
 
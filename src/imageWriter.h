@@ -6,7 +6,12 @@
 
 #include <QCoreApplication>
 #include <QtCore/qdir.h>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
 #include "devices/camera.h"
+#include "recordingIndex.h"
+
+#include <memory>
 
 /**
     Class to write camera images to disk
@@ -15,6 +20,13 @@
 
     onNewImage(): received new image and writes it to disk, file writing is performed concurrently for maximal performance
 
+    On destruction, the writer waits until all pending writes finished.
+
+    The written images are collected in a RecordingIndex, which is saved into the recording directory on destruction, so opening
+    the recording does not need to list the directory. The index must be the last file written into the recording directory,
+    otherwise it looks outdated when the recording is opened. This is skipped if the directory already contained images when
+    recording started (the index is then built when the recording is opened).
+
     CAUTION: Chosen image format has a large performance impact due to size and disk write speeds
 */
 class ImageWriter : public QObject {
@@ -45,6 +57,23 @@ private:
 
     std::vector<int> writeParams = std::vector<int>();
 
+    // Shared with the concurrent write tasks, a task may still hold it for a moment after waking the writer
+    struct WriteProgress {
+        QMutex mutex;
+        QWaitCondition finished;
+        int pending = 0;
+        std::vector<quint64> failed;
+    };
+
+    QString recordingDirectory;
+    std::shared_ptr<WriteProgress> writeProgress;
+    RecordingIndex index;
+    bool writeIndex;
+
+    void write(const QString &filepath, const cv::Mat &img, quint64 timestamp);
+    void waitForWrites();
+    void saveIndex();
+
 public slots:
 
     void onNewImage(const CameraImage &img);
@@ -6,6 +6,13 @@
 #include <pylon/PylonIncludes.h>
 
 #include "execArgParser.h"
+#include "pupilDetectionEvaluator.h"
+#include "pupilDetectionParameterSearch.h"
+#include "udpReceiverThread.h"
+#include "devices/stereoFramePairer.h"
+#include "devices/singleWebcam.h"
+#include "pupil-detection-methods/ElSe.h"
+#include "pupil-detection-methods/HaarSurroundLocalizer.h"
 
 // Stream operator for custom types needed to save those types to QTs application settings structure
 #ifndef QT_NO_DATASTREAM
@@ -58,6 +65,40 @@ int main(int argc, char *argv[])
 {
     try {
 
+        // Headless evaluation and parameter search of pupil detection algorithms on an image directory, no GUI or camera is involved
+        // Also headless: measurement of the remote control receive latency, simulation of stereo frame pairing, measurement of the webcam capture rate,
+        // and benchmarks of pupil detection building blocks against their former implementations
+        for(int i = 1; i < argc-1; ++i) {
+            if(QString(argv[i]) == "-evaluatePupilDetection") {
+                QCoreApplication a(argc, argv);
+                return PupilDetectionEvaluator::runJobFile(QString::fromLocal8Bit(argv[i+1]));
+            }
+            if(QString(argv[i]) == "-searchPupilDetectionParameters") {
+                QCoreApplication a(argc, argv);
+                return PupilDetectionParameterSearch::runJobFile(QString::fromLocal8Bit(argv[i+1]));
+            }
+            if(QString(argv[i]) == "-measureRemoteLatency") {
+                QCoreApplication a(argc, argv);
+                return UDPReceiverThread::measureLoopbackLatency(QString(argv[i+1]).toInt());
+            }
+            if(QString(argv[i]) == "-simulateStereoPairing") {
+                return StereoFramePairer::simulate(QString(argv[i+1]).toInt());
+            }
+            if(QString(argv[i]) == "-measureWebcamCapture") {
+                QCoreApplication a(argc, argv);
+                const QStringList values = QString::fromLocal8Bit(argv[i+1]).split(';');
+                return GrabberDummy::measureCapture(values[0],
+                                                    values.size() > 1 ? values[1].toDouble() : 30.0,
+                                                    values.size() > 2 ? values[2].toInt() : 10);
+            }
+            if(QString(argv[i]) == "-benchmarkElSeBlobFinder") {
+                return ElSe::benchmarkBlobFinder(QString(argv[i+1]).toInt());
+            }
+            if(QString(argv[i]) == "-benchmarkHaarSurround") {
+                return HaarSurroundLocalizer::benchmark(QString(argv[i+1]).toInt());
+            }
+        }
+
         int result = 0;
         do {
             QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
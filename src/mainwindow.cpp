@@ -14,6 +14,8 @@
 #include "subwindows/RestorableQMdiSubWindow.h"
 #include "subwindows/singleCameraSharpnessView.h"
 #include "supportFunctions.h"
+#include "videoReader.h"
+#include "threadBudget.h"
 
 int const MainWindow::EXIT_CODE_REBOOT = 2000;
 
@@ -57,6 +59,9 @@ MainWindow::MainWindow():
         //show();
     }
 
+    // Divide the cores between pupil detection, recording and playback before any of them starts working
+    ThreadBudget::configure(applicationSettings);
+
     imageMutex = new QMutex();
     imagePublished = new QWaitCondition();
     imageProcessed = new QWaitCondition();
@@ -98,6 +103,13 @@ MainWindow::MainWindow():
     // Pupil detection is conducted in another thread, move the created object to this thread and connect its finished signal for cleanup
     pupilDetectionWorker->moveToThread(pupilDetectionThread);
     connect(pupilDetectionThread, SIGNAL (finished()), pupilDetectionThread, SLOT (deleteLater()));
+    if(ThreadBudget::isDetectionThreadPinned()) {
+        // Without context object, the lambda is executed directly in the started thread
+        connect(pupilDetectionThread, &QThread::started, []() {
+            if(!ThreadBudget::pinCurrentThread(ThreadBudget::getDetectionCore()))
+                std::cerr << "Could not pin the pupil detection thread to core " << ThreadBudget::getDetectionCore() << std::endl;
+        });
+    }
     pupilDetectionThread->start();
     pupilDetectionThread->setPriority(QThread::HighPriority); // highest priority
 
@@ -217,6 +229,9 @@ void MainWindow::createActions() {
     fileOpenAct->setIcon(fileOpenIcon);
     fileOpenAct->setStatusTip(tr("Open Image Directory for Playback. Single and Stereo Mode supported."));
     fileMenu->addAction(fileOpenAct);
+    videoOpenAct = fileMenu->addAction(tr("Open Video File"), this, &MainWindow::onOpenVideoFile);
+    videoOpenAct->setIcon(fileOpenIcon);
+    videoOpenAct->setStatusTip(tr("Open Video File (e.g. MP4, AVI, MKV) for Playback. Single Mode supported."));
     fileMenu->addSeparator();
 
     QAction *exitAct = fileMenu->addAction(tr("E&xit"), qApp, &QApplication::closeAllWindows);
@@ -340,6 +355,18 @@ void MainWindow::createActions() {
     connect(openCVCamerasMenu, SIGNAL(aboutToShow()), this, SLOT(updateOpenCVCamerasMenu()));
     */
 
+    cameraMenu->addSeparator();
+
+    // Procedurally rendered eye images, for testing without camera hardware
+    QMenu *syntheticCamerasMenu = cameraMenu->addMenu(singleCameraIcon, tr("S&ynthetic Eye Camera"));
+    syntheticCamerasMenu->addAction(singleCameraIcon, tr("Single"))->setData(false);
+    syntheticCamerasMenu->addAction(stereoCameraIcon, tr("Stereo"))->setData(true);
+    syntheticCamerasMenu->addSeparator();
+    // Has no data, syntheticCameraSelected() ignores it
+    QAction *syntheticCameraSettingsAct = syntheticCamerasMenu->addAction(tr("Rendering Settings..."));
+    connect(syntheticCameraSettingsAct, &QAction::triggered, this, &MainWindow::onSyntheticCameraSettingsClick);
+    connect(syntheticCamerasMenu, SIGNAL(triggered(QAction *)), this, SLOT(syntheticCameraSelected(QAction *)));
+
     cameraAct->setMenu(cameraMenu);
     connect(cameraAct, &QAction::triggered, this, &MainWindow::onCameraClick);
     //fileMenu->addAction(newAct);
@@ -1067,9 +1094,9 @@ void MainWindow::onTrackActClick() {
         streamAct->setEnabled(streamingSettingsDialog && streamingSettingsDialog->isAnyConnected());
     }
 
-    if(stereoCameraChildWidget && (selectedCamera->getType() == CameraImageType::LIVE_STEREO_CAMERA || selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE)) {
+    if(stereoCameraChildWidget && (selectedCamera->getType() == CameraImageType::LIVE_STEREO_CAMERA || selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE || selectedCamera->getType() == CameraImageType::SYNTHETIC_STEREO_CAMERA)) {
         stereoCameraChildWidget->update();
-    } else if(singleCameraChildWidget && (selectedCamera->getType() == CameraImageType::LIVE_SINGLE_CAMERA || selectedCamera->getType() == CameraImageType::SINGLE_IMAGE_FILE)) {
+    } else if(singleCameraChildWidget && (selectedCamera->getType() == CameraImageType::LIVE_SINGLE_CAMERA || selectedCamera->getType() == CameraImageType::SINGLE_IMAGE_FILE || selectedCamera->getType() == CameraImageType::SYNTHETIC_SINGLE_CAMERA)) {
         singleCameraChildWidget->update();
     }
 }
@@ -1083,7 +1110,7 @@ void MainWindow::onStreamClick() {
 
     if(dataStreamer) { // if streaming is on, deactivate streaming
 
-        disconnect(pupilDetectionWorker, SIGNAL (processedPupilData(quint64, int, std::vector<Pupil>, QString)), dataStreamer, SLOT (newPupilData(quint64, int, std::vector<Pupil>, QString)));
+        disconnect(pupilDetectionWorker->getResultBroadcaster(), SIGNAL (resultPublished(quint64)), dataStreamer, SLOT (newPupilResults(quint64)));
 
         streamingSettingsDialog->setLimitationsWhileStreamingUDP(false);
         streamingSettingsDialog->setLimitationsWhileStreamingCOM(false);
@@ -1120,7 +1147,8 @@ void MainWindow::onStreamClick() {
         }
 //        streamingSettingsDialog->setLimitationsWhileStreaming(true);
 
-        connect(pupilDetectionWorker, SIGNAL (processedPupilData(quint64, int, std::vector<Pupil>, QString)), dataStreamer, SLOT (newPupilData(quint64, int, std::vector<Pupil>, QString)));
+        dataStreamer->setResultSource(pupilDetectionWorker->getResultBroadcaster());
+        connect(pupilDetectionWorker->getResultBroadcaster(), SIGNAL (resultPublished(quint64)), dataStreamer, SLOT (newPupilResults(quint64)));
 
         const QIcon streamIcon = SVGIconColorAdjuster::loadAndAdjustColors(QString(":/icons/Breeze/actions/22/kt-stop-all.svg"), applicationSettings);
         streamAct->setIcon(streamIcon);
@@ -1198,7 +1226,8 @@ void MainWindow::onRecordClick() {
                 pupilDetectionDir.filePath(metadataFileName),
                 selectedCamera, imageWriter, pupilDetectionWorker, dataWriter, MetaSnapshotOrganizer::Purpose::DATA_REC, applicationSettings);
 
-        connect(pupilDetectionWorker, SIGNAL (processedPupilData(quint64, int, std::vector<Pupil>, QString)), dataWriter, SLOT (newPupilData(quint64, int, std::vector<Pupil>, QString)));
+        dataWriter->setResultSource(pupilDetectionWorker->getResultBroadcaster());
+        connect(pupilDetectionWorker->getResultBroadcaster(), SIGNAL (resultPublished(quint64)), dataWriter, SLOT (newPupilResults(quint64)));
 
         const QIcon recordOnIcon = SVGIconColorAdjuster::loadAndAdjustColors(QString(":/icons/Breeze/actions/22/kt-stop-all.svg"), applicationSettings); //QIcon::fromTheme("camera-video");
         recordAct->setIcon(recordOnIcon);
@@ -1217,11 +1246,6 @@ void MainWindow::onRecordImageClick() {
         recordImagesAct->setIcon(recordOffIcon);
         recordImagesOn = false;
 
-        if (imageWriter != nullptr){
-            imageWriter->deleteLater();
-            imageWriter = nullptr;
-        }
-
         if(SupportFunctions::readBoolFromQSettings("saveOfflineEventLog", true, applicationSettings)) {
             recEventTracker->saveOfflineEventLog(
                 imageRecStartTimestamp,
@@ -1229,6 +1253,13 @@ void MainWindow::onRecordImageClick() {
                 outputDirectory + "/" + QString::fromStdString("offline_event_log.xml") );
                 //outputDirectory + "/" + QString::fromStdString("offline_event_log.csv") );
         }
+
+        // The image writer saves the recording index on destruction, it has to be written after the event log
+        if (imageWriter != nullptr){
+            imageWriter->deleteLater();
+            imageWriter = nullptr;
+        }
+        ThreadBudget::setActive(ThreadBudget::RECORDING, false);
         
         if(singleCameraSettingsDialog && !trackingOn)
             singleCameraSettingsDialog->setLimitationsWhileTracking(false);
@@ -1281,9 +1312,10 @@ void MainWindow::onRecordImageClick() {
         if(generalSettingsDialog)
             generalSettingsDialog->setLimitationsWhileImageWriting(true);
 
-        bool stereo = selectedCamera->getType() == CameraImageType::LIVE_STEREO_CAMERA || selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE;
+        bool stereo = selectedCamera->getType() == CameraImageType::LIVE_STEREO_CAMERA || selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE || selectedCamera->getType() == CameraImageType::SYNTHETIC_STEREO_CAMERA;
 
         imageWriter = new ImageWriter(outputDirectory, stereo, this);
+        ThreadBudget::setActive(ThreadBudget::RECORDING, true);
 
         // this should come here as the "directory already exists" dialog is only answered before, upon creation of imageWriter, and meta snapshot creation relies on that response
         if(SupportFunctions::readBoolFromQSettings("metaSnapshotsEnabled", true, applicationSettings)) {
@@ -1330,6 +1362,7 @@ void MainWindow::onCameraDisconnectClick() {
         imagePlaybackControlDialog = nullptr;
     }
     destroyCamTempMonitor();
+    ThreadBudget::setActive(ThreadBudget::PLAYBACK, false);
 
     if (cameraViewWindow) {
         cameraViewWindow->deleteLater();
@@ -1415,6 +1448,7 @@ void MainWindow::onCameraDisconnectClick() {
     }
 
     fileOpenAct->setEnabled(true);
+    videoOpenAct->setEnabled(true);
 
     if (selectedCamera && signalPubSubHandler) {
         disconnect(selectedCamera, SIGNAL(onNewGrabResult(CameraImage)), signalPubSubHandler,
@@ -1600,6 +1634,11 @@ void MainWindow::stereoCameraSelected() {
         return;
     }
 
+    // Reorder window of the frame pairing in frames, and the time in ms after which an image without counterpart is dropped (0: never)
+    dynamic_cast<StereoCamera*>(selectedCamera)->setFramePairing(
+            std::max(2, applicationSettings->value("StereoCamera.framePairingWindow", 16).toInt()),
+            static_cast<uint64_t>(std::max(0, applicationSettings->value("StereoCamera.framePairingTimeoutMs", 0).toInt())));
+
     //safelyResetTrialCounter();
     //safelyResetMessageRegister();
 
@@ -1644,6 +1683,70 @@ void MainWindow::stereoCameraSelected() {
 //    resetStatus(true);
 }
 
+// The parameters are edited as the "key=value,..." string also accepted on the command line, they apply to the next opened synthetic camera
+void MainWindow::onSyntheticCameraSettingsClick() {
+
+    SyntheticCameraParams params;
+    SyntheticCamera::parseParams(applicationSettings->value("syntheticCamera.params", "").toString(), params);
+
+    bool ok = false;
+    const QString spec = QInputDialog::getText(this, tr("Synthetic Eye Camera"),
+                                               tr("Rendering parameters (lengths in px, periods in s, blinkInterval=0 disables blinking):"),
+                                               QLineEdit::Normal, SyntheticCamera::paramsToString(params), &ok);
+    if(!ok)
+        return;
+
+    if(!SyntheticCamera::parseParams(spec, params)) {
+        QMessageBox::warning(this, tr("Synthetic Eye Camera"), tr("Invalid rendering parameters, the previous ones are kept."));
+        return;
+    }
+    applicationSettings->setValue("syntheticCamera.params", SyntheticCamera::paramsToString(params));
+}
+
+void MainWindow::syntheticCameraSelected(QAction *action) {
+
+    if(!action->data().isValid())
+        return;
+
+    // Resolution, rate and trajectories as set through the rendering settings or -setSyntheticCameraParams, the defaults otherwise
+    SyntheticCameraParams params;
+    SyntheticCamera::parseParams(applicationSettings->value("syntheticCamera.params", "").toString(), params);
+    params.stereo = action->data().toBool();
+
+    try {
+        selectedCamera = new SyntheticCamera(params, this);
+    } catch (const cv::Exception &e) {
+        std::cerr << "An exception occurred." << std::endl << e.what() << std::endl;
+        QMessageBox err(this);
+        err.critical(this, "Device Error", e.what());
+        return;
+    }
+
+    connect(selectedCamera, SIGNAL(onNewGrabResult(CameraImage)), signalPubSubHandler, SIGNAL (onNewGrabResult(CameraImage)));
+    connect(selectedCamera, SIGNAL(fps(double)), signalPubSubHandler, SIGNAL(cameraFPS(double)));
+    connect(selectedCamera, SIGNAL(framecount(int)), signalPubSubHandler, SIGNAL(cameraFramecount(int)));
+
+    cameraViewClick();
+
+    pupilDetectionWorker->setCamera(selectedCamera);
+    pupilDetectionSettingsDialog->onSettingsChange();
+
+    recEventTracker = new RecEventTracker();
+    connect(this, SIGNAL(commitTrialCounterIncrement(quint64)), recEventTracker, SLOT(addTrialIncrement(quint64)));
+    connect(this, SIGNAL(commitTrialCounterReset(quint64)), recEventTracker, SLOT(resetBufferTrialCounter(quint64)));
+    connect(this, SIGNAL(commitMessageRegisterReset(quint64)), recEventTracker, SLOT(resetBufferMessageRegister(quint64)));
+    connect(this, SIGNAL(commitRemoteMessage(quint64, QString)), recEventTracker, SLOT(addMessage(quint64, QString)));
+    safelyResetTrialCounter();
+    safelyResetMessageRegister();
+
+    if(params.stereo)
+        connect(pupilDetectionSettingsDialog, SIGNAL (pupilDetectionProcModeChanged(int)), stereoCameraChildWidget, SLOT (updateForPupilDetectionProcMode()));
+    else
+        connect(pupilDetectionSettingsDialog, SIGNAL (pupilDetectionProcModeChanged(int)), singleCameraChildWidget, SLOT (updateForPupilDetectionProcMode()));
+
+    resetStatus(true);
+}
+
 void MainWindow::onWebcamStartedToOpen() {
     currentStatusMessageLabel->setText("Opening OpenCV webcam. This might take a few seconds...");
 //    if(singleWebcamSettingsDialog) {
@@ -1699,7 +1802,8 @@ void MainWindow::cameraViewClick() {
     if(selectedCamera && (
         selectedCamera->getType() == CameraImageType::LIVE_SINGLE_CAMERA || 
         selectedCamera->getType() == CameraImageType::SINGLE_IMAGE_FILE ||
-        selectedCamera->getType() == CameraImageType::LIVE_SINGLE_WEBCAM
+        selectedCamera->getType() == CameraImageType::LIVE_SINGLE_WEBCAM ||
+        selectedCamera->getType() == CameraImageType::SYNTHETIC_SINGLE_CAMERA
         ) ) {
         //SingleCameraView *childWidget = new SingleCameraView(selectedCamera, pupilDetectionWorker, this);
         singleCameraChildWidget = new SingleCameraView(selectedCamera, pupilDetectionWorker, !cameraPlaying, this);
@@ -1711,7 +1815,8 @@ void MainWindow::cameraViewClick() {
 
     } else if(selectedCamera && (
         selectedCamera->getType() == CameraImageType::LIVE_STEREO_CAMERA || 
-        selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE
+        selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE ||
+        selectedCamera->getType() == CameraImageType::SYNTHETIC_STEREO_CAMERA
         ) ) {
         stereoCameraChildWidget = new StereoCameraView(selectedCamera, pupilDetectionWorker, !cameraPlaying, this);
         connect(subjectSelectionDialog, SIGNAL (onSettingsChange()), stereoCameraChildWidget, SLOT (onSettingsChange()));
@@ -1730,13 +1835,15 @@ void MainWindow::cameraViewClick() {
         if(selectedCamera && (
                 selectedCamera->getType() == CameraImageType::LIVE_SINGLE_CAMERA ||
                 selectedCamera->getType() == CameraImageType::SINGLE_IMAGE_FILE ||
-                selectedCamera->getType() == CameraImageType::LIVE_SINGLE_WEBCAM
+                selectedCamera->getType() == CameraImageType::LIVE_SINGLE_WEBCAM ||
+                selectedCamera->getType() == CameraImageType::SYNTHETIC_SINGLE_CAMERA
         ) ) {
             singleCameraChildWidget->deleteLater();
             singleCameraChildWidget = nullptr;
         } else if(selectedCamera && (
                 selectedCamera->getType() == CameraImageType::LIVE_STEREO_CAMERA ||
-                selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE
+                selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE ||
+                selectedCamera->getType() == CameraImageType::SYNTHETIC_STEREO_CAMERA
         ) ) {
             stereoCameraChildWidget->deleteLater();
             stereoCameraChildWidget = nullptr;
@@ -2098,12 +2205,23 @@ void MainWindow::onOpenImageDirectory() {
     openImageDirectory(tempDir);
 }
 
+// Video files are played back by a FileCamera just like image directories
+void MainWindow::onOpenVideoFile() {
+    const QString videoFile = QFileDialog::getOpenFileName(this, tr("Video File"), recentPath,
+                                                           tr("Video Files (*.mp4 *.m4v *.mov *.avi *.mkv *.webm *.mpg *.mpeg *.wmv *.h264 *.h265)"));
+    if(videoFile.isEmpty() || !VideoReader::isVideoFileName(videoFile))
+        return;
+
+    openImageDirectory(videoFile);
+}
+
 void MainWindow::openImageDirectory(QString imageDirectory) {
 
     if(imageDirectory[imageDirectory.length()-1]=='/')
         imageDirectory.chop(1);
 
     fileOpenAct->setEnabled(false);
+    videoOpenAct->setEnabled(false);
 
 //    std::cout << recentPath.toStdString() << std::endl;
     currentStatusMessageLabel->setText("Current directory: " + SupportFunctions::shortenStringForDisplay(imageDirectory, 100));
@@ -2144,6 +2262,8 @@ void MainWindow::openImageDirectory(QString imageDirectory) {
 
     selectedCamera = new FileCamera(imageDirectory, imageMutex, imagePublished, imageProcessed, playbackSpeed, playbackLoop, this);
     std::cout<<"FileCamera created using playbackspeed [fps]: "<<playbackSpeed <<std::endl;
+    // Only the stereo playback reads over the playback pool
+    ThreadBudget::setActive(ThreadBudget::PLAYBACK, selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE);
 
     connect(selectedCamera, SIGNAL(onNewGrabResult(CameraImage)), signalPubSubHandler, SIGNAL (onNewGrabResult(CameraImage)));
     connect(selectedCamera, SIGNAL(fps(double)), signalPubSubHandler, SIGNAL(cameraFPS(double)));
@@ -2337,6 +2457,8 @@ void MainWindow::onGeneralSettingsChange() {
 
     this->repaint();
 
+    ThreadBudget::configure(applicationSettings);
+
     if(pupilDetectionSettingsDialog)
         pupilDetectionSettingsDialog->repaint();
 
@@ -2659,12 +2781,14 @@ void MainWindow::startCamera()
 void MainWindow::resetStatus(bool isConnect)
 {
     bool realCameraSelected = (selectedCamera && (selectedCamera->getType() != CameraImageType::SINGLE_IMAGE_FILE && selectedCamera->getType() != CameraImageType::STEREO_IMAGE_FILE));
+    // synthetic cameras behave like live devices, but have no device settings and nothing to calibrate
+    bool syntheticCameraSelected = (selectedCamera && (selectedCamera->getType() == CameraImageType::SYNTHETIC_SINGLE_CAMERA || selectedCamera->getType() == CameraImageType::SYNTHETIC_STEREO_CAMERA));
 
     if (isConnect){
         cameraAct->setEnabled(false);
-        cameraSettingsAct->setEnabled(realCameraSelected);
+        cameraSettingsAct->setEnabled(realCameraSelected && !syntheticCameraSelected);
         cameraActDisconnectAct->setEnabled(true);
-        calibrateAct->setEnabled(true);
+        calibrateAct->setEnabled(!syntheticCameraSelected);
         sharpnessAct->setEnabled(selectedCamera && selectedCamera->getType() == CameraImageType::LIVE_SINGLE_CAMERA);
 //        subjectsAct->setEnabled(true);
         subjectsAct->setEnabled(false);
@@ -2813,8 +2937,10 @@ void MainWindow::connectCameraPlaybackChangedSlots()
     // implemented for both single and stereo camera views. This is ok too
     if(selectedCamera->getType() == CameraImageType::SINGLE_IMAGE_FILE && singleCameraChildWidget) {
         connect(imagePlaybackControlDialog, SIGNAL(stillImageChange(int)), singleCameraChildWidget, SLOT(displayFileCameraFrame(int)));
+        connect(imagePlaybackControlDialog, SIGNAL(stillImagePreview(int)), singleCameraChildWidget, SLOT(displayFileCameraPreview(int)));
     } else if(selectedCamera->getType() == CameraImageType::STEREO_IMAGE_FILE && stereoCameraChildWidget) {
         connect(imagePlaybackControlDialog, SIGNAL(stillImageChange(int)), stereoCameraChildWidget, SLOT(displayFileCameraFrame(int)));
+        connect(imagePlaybackControlDialog, SIGNAL(stillImagePreview(int)), stereoCameraChildWidget, SLOT(displayFileCameraPreview(int)));
     }
 }
 
@@ -2846,6 +2972,12 @@ void MainWindow::dropEvent(QDropEvent* e)
         }
         qDebug() << "Attempting to open: " << fileInfo.filePath();
         openImageDirectory(fileInfo.filePath());
+    } else if(fileInfo.isFile() && VideoReader::isVideoFileName(fileInfo.filePath())) {
+        if(selectedCamera && selectedCamera->isOpen()) {
+            onCameraDisconnectClick();
+        }
+        qDebug() << "Attempting to open: " << fileInfo.filePath();
+        openImageDirectory(fileInfo.filePath());
     } else if(fileInfo.isFile()) {
         // TODO: shorter, cleaner, better
         if(fileInfo.completeSuffix() == "tiff" || fileInfo.completeSuffix() == "tif" || fileInfo.completeSuffix() == "png"  ||
@@ -32,6 +32,7 @@
 #include "connPoolCOM.h"
 #include "connPoolUDP.h"
 #include "devices/singleWebcam.h"
+#include "devices/syntheticCamera.h"
 #include "subwindows/singleWebcamSettingsDialog.h"
 #include "subwindows/singleWebcamCalibrationView.h"
 #include <QDragEnterEvent>
@@ -210,6 +211,7 @@ private:
     QSpinBox *webcamDeviceBox;
 
     QAction *fileOpenAct; // GB: made global to let it disable when image directory is already open
+    QAction *videoOpenAct;
     QAction *toggleFullscreenAct;
     QAction *streamingSettingsAct;
     QAction *streamAct;
@@ -274,6 +276,7 @@ private slots:
     void onCameraCalibrationDisabled();
 
     void onOpenImageDirectory();
+    void onOpenVideoFile();
 
     void onCameraClick();
     void onCameraDisconnectClick();
@@ -327,6 +330,8 @@ private slots:
 //    void onGettingsStartedWizardFinish();
 
     void singleWebcamSelected(QAction *action);
+    void syntheticCameraSelected(QAction *action);
+    void onSyntheticCameraSettingsClick();
     void onSingleWebcamSettingsClick();
 
     void onStreamClick();
@@ -373,6 +378,8 @@ public slots:
     void PRGopenSingleCamera(const QString &camName);
     void PRGopenStereoCamera(const QString &camName1, const QString &camName2);
     void PRGopenSingleWebcam(int deviceID);
+    void PRGopenSyntheticCamera(const QString &mode);
+    void PRGsetSyntheticCameraParams(const QString &spec);
     void PRGcloseCamera();
     void PRGtrackStart();
     void PRGtrackStop();
@@ -99,6 +99,10 @@ void MetaSnapshotOrganizer::addCameraNode(QDomDocument &document, QDomElement &r
         cameraImageType = "LIVE_STEREO_CAMERA";
     else if(camera->getType() == LIVE_SINGLE_WEBCAM)
         cameraImageType = "LIVE_SINGLE_WEBCAM";
+    else if(camera->getType() == SYNTHETIC_SINGLE_CAMERA)
+        cameraImageType = "SYNTHETIC_SINGLE_CAMERA";
+    else if(camera->getType() == SYNTHETIC_STEREO_CAMERA)
+        cameraImageType = "SYNTHETIC_STEREO_CAMERA";
 
     
 
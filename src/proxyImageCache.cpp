@@ -0,0 +1,241 @@
+
+#include "proxyImageCache.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStandardPaths>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    const quint32 proxyMagic = 0x50585058; // "PXPX"
+    const quint32 proxyVersion = 1;
+    const int headerWords = 8;
+    const qint64 headerSize = headerWords * sizeof(quint32);
+    const int keptCacheFiles = 4;
+}
+
+ProxyImageCache::ProxyImageCache(const std::vector<std::string> &filenames, const std::vector<std::string> &filenamesSecondary,
+                                 int imageWidth, int imageHeight, int maxProxySize, quint64 cacheSizeLimit) :
+    filenames(filenames),
+    filenamesSecondary(filenamesSecondary),
+    numImages(filenamesSecondary.empty() ? 1 : 2),
+    imageReduction(1),
+    stride(1),
+    numSlots(0),
+    slotBytes(0),
+    map(nullptr),
+    mapFlags(nullptr),
+    mapPixels(nullptr),
+    numCached(0),
+    stopRequested(false),
+    suspended(false),
+    requestedSlot(-1) {
+
+    if(filenames.empty() || imageWidth <= 0 || imageHeight <= 0 || (numImages == 2 && filenamesSecondary.size() != filenames.size()))
+        return;
+
+    const double scale = std::min(1.0, maxProxySize / static_cast<double>(std::max(imageWidth, imageHeight)));
+    proxySize = cv::Size(std::max(1, static_cast<int>(std::lround(imageWidth * scale))),
+                         std::max(1, static_cast<int>(std::lround(imageHeight * scale))));
+
+    // The largest reduction that still decodes at least at proxy size
+    for(int reduction : {8, 4, 2}) {
+        if(imageWidth / reduction >= proxySize.width && imageHeight / reduction >= proxySize.height) {
+            imageReduction = reduction;
+            break;
+        }
+    }
+
+    slotBytes = static_cast<size_t>(numImages) * proxySize.area();
+    const quint64 totalBytes = static_cast<quint64>(filenames.size()) * slotBytes;
+    stride = static_cast<int>(std::max<quint64>(1, (totalBytes + cacheSizeLimit - 1) / cacheSizeLimit));
+    numSlots = static_cast<int>((filenames.size() + stride - 1) / stride);
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::fromStdString(filenames.front()));
+    hash.addData(QByteArray::fromStdString(filenames.back()));
+    hash.addData(QByteArray::number(static_cast<qulonglong>(filenames.size())));
+    if(numImages == 2)
+        hash.addData(QByteArray::fromStdString(filenamesSecondary.front()));
+
+    const QString cacheDirectory = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("proxies");
+    QDir().mkpath(cacheDirectory);
+    const QString cacheFileName = QDir(cacheDirectory).filePath(QString::fromLatin1(hash.result().toHex()) + ".proxy");
+
+    if(!openFile(cacheFileName)) {
+        std::cerr << "ProxyImageCache: could not create cache file: " << cacheFileName.toStdString() << std::endl;
+        return;
+    }
+    removeOldCacheFiles(cacheDirectory, cacheFileName);
+}
+
+ProxyImageCache::~ProxyImageCache() {
+    stopRequested = true;
+    if(buildingThread.joinable())
+        buildingThread.join();
+    if(map)
+        file.unmap(map);
+    file.close();
+}
+
+// File layout: header, one flag byte per slot (proxy written), proxy pixels of each slot (main and secondary image)
+bool ProxyImageCache::openFile(const QString &cacheFileName) {
+
+    const qint64 flagsOffset = headerSize;
+    const qint64 pixelsOffset = (flagsOffset + numSlots + 63) / 64 * 64;
+    const qint64 fileSize = pixelsOffset + static_cast<qint64>(numSlots) * static_cast<qint64>(slotBytes);
+
+    const quint32 header[headerWords] = {proxyMagic, proxyVersion, static_cast<quint32>(numSlots), static_cast<quint32>(stride),
+                                         static_cast<quint32>(proxySize.width), static_cast<quint32>(proxySize.height),
+                                         static_cast<quint32>(numImages), 0};
+
+    file.setFileName(cacheFileName);
+    if(!file.open(QIODevice::ReadWrite))
+        return false;
+
+    quint32 stored[headerWords];
+    const bool reuse = file.size() == fileSize && file.read(reinterpret_cast<char*>(stored), headerSize) == headerSize &&
+                       std::memcmp(stored, header, headerSize) == 0;
+    if(!reuse) {
+        // Resizing to 0 first clears the flags of an existing file, the new file is sparse until the proxies are written
+        if(!file.resize(0) || !file.resize(fileSize) || !file.seek(0) ||
+           file.write(reinterpret_cast<const char*>(header), headerSize) != headerSize || !file.flush())
+            return false;
+    }
+    // Marks the file as recently used
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    map = file.map(0, fileSize);
+    if(!map)
+        return false;
+    mapFlags = map + flagsOffset;
+    mapPixels = map + pixelsOffset;
+
+    cached.reset(new std::atomic<bool>[numSlots]);
+    int count = 0;
+    for(int i=0; i<numSlots; i++) {
+        const bool ready = reuse && mapFlags[i] == 1;
+        cached[i].store(ready, std::memory_order_relaxed);
+        count += ready;
+    }
+    numCached = count;
+    return true;
+}
+
+void ProxyImageCache::removeOldCacheFiles(const QString &cacheDirectory, const QString &keep) {
+    const QFileInfoList files = QDir(cacheDirectory).entryInfoList({"*.proxy"}, QDir::Files, QDir::Time);
+    int kept = 0;
+    for(const QFileInfo &info : files) {
+        if(info.absoluteFilePath() == QFileInfo(keep).absoluteFilePath() || ++kept < keptCacheFiles)
+            continue;
+        QFile::remove(info.absoluteFilePath());
+    }
+}
+
+bool ProxyImageCache::isOpen() const {
+    return map != nullptr;
+}
+
+cv::Size ProxyImageCache::getProxySize() const {
+    return proxySize;
+}
+
+int ProxyImageCache::getNumCached() const {
+    return numCached.load(std::memory_order_relaxed);
+}
+
+void ProxyImageCache::start() {
+    if(!isOpen() || buildingThread.joinable() || numCached.load() == numSlots)
+        return;
+    buildingThread = std::thread(&ProxyImageCache::build, this);
+}
+
+void ProxyImageCache::setSuspended(bool value) {
+    suspended = value;
+}
+
+// Builds slot 0, numSlots/2, then numSlots/4 and 3*numSlots/4 etc., each slot once. Before each slot, the slots close to
+// the last requested position are built, if any of them is missing
+void ProxyImageCache::build() {
+
+    int step = 1;
+    while(step * 2 < numSlots)
+        step *= 2;
+
+    for(; step >= 1 && !stopRequested; step /= 2) {
+        for(int slot=0; slot<numSlots && !stopRequested; slot+=step) {
+
+            while(suspended && !stopRequested)
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            int requested;
+            while((requested = requestedSlot.exchange(-1)) >= 0 && !stopRequested) {
+                for(int d=0; d<=maxSearchDistance && !stopRequested && requestedSlot.load() < 0; d++) {
+                    for(int s : {requested + d, requested - d}) {
+                        if(s >= 0 && s < numSlots && !cached[s].load(std::memory_order_relaxed))
+                            buildSlot(s);
+                    }
+                }
+            }
+
+            if(!stopRequested && !cached[slot].load(std::memory_order_relaxed))
+                buildSlot(slot);
+        }
+    }
+}
+
+// An image that cannot be read gets a black proxy, so it is not tried again
+void ProxyImageCache::buildSlot(int slot) {
+
+    const int frameNumber = slot * stride;
+    const int flag = imageReduction == 8 ? cv::IMREAD_REDUCED_GRAYSCALE_8 :
+                     imageReduction == 4 ? cv::IMREAD_REDUCED_GRAYSCALE_4 :
+                     imageReduction == 2 ? cv::IMREAD_REDUCED_GRAYSCALE_2 : cv::IMREAD_GRAYSCALE;
+
+    for(int i=0; i<numImages; i++) {
+        cv::Mat proxy(proxySize, CV_8UC1, mapPixels + slot * slotBytes + i * proxySize.area());
+        const cv::Mat img = cv::imread(i == 0 ? filenames[frameNumber] : filenamesSecondary[frameNumber], flag);
+        if(img.empty() || img.type() != CV_8UC1)
+            proxy.setTo(0);
+        else
+            cv::resize(img, proxy, proxySize, 0, 0, cv::INTER_AREA);
+    }
+
+    mapFlags[slot] = 1;
+    cached[slot].store(true, std::memory_order_release);
+    numCached++;
+}
+
+// The proxies are copied out, as the memory of the mapping is only valid as long as the cache exists
+bool ProxyImageCache::getProxy(int frameNumber, cv::Mat &img, cv::Mat &imgSecondary) {
+
+    if(!isOpen() || frameNumber < 0 || frameNumber >= static_cast<int>(filenames.size()))
+        return false;
+
+    const int slot = std::min(numSlots - 1, (frameNumber + stride / 2) / stride);
+    if(!cached[slot].load(std::memory_order_acquire))
+        requestedSlot = slot;
+
+    for(int d=0; d<=maxSearchDistance; d++) {
+        for(int s : {slot + d, slot - d}) {
+            if(s < 0 || s >= numSlots || !cached[s].load(std::memory_order_acquire))
+                continue;
+            const uchar *pixels = mapPixels + s * slotBytes;
+            img = cv::Mat(proxySize, CV_8UC1, const_cast<uchar*>(pixels)).clone();
+            if(numImages == 2)
+                imgSecondary = cv::Mat(proxySize, CV_8UC1, const_cast<uchar*>(pixels + proxySize.area())).clone();
+            return true;
+        }
+    }
+    return false;
+}
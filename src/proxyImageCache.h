@@ -0,0 +1,80 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QFile>
+#include <QtCore/QString>
+#include <opencv2/core/mat.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+    Cache of downscaled grayscale copies (proxies) of the images of a recording, for instant previews while scrubbing through the playback
+
+    The proxies are kept in a memory-mapped file in the application cache directory, so they survive restarts and are
+    reused when the recording is opened again. A background thread builds them with a reduced resolution decode
+    (IMREAD_REDUCED_GRAYSCALE_*, which is much faster for JPEG) and resizes them to a fixed size of at most maxProxySize pixels.
+    If the proxies of all images would not fit into cacheSizeLimit bytes, only every n-th image gets a proxy and the proxy of
+    the closest image is served. Images are cached coarse to fine, so the whole recording can be scrubbed through early on,
+    and the images close to a requested position are cached next. Building pauses while suspended, e.g. during playback.
+    Only the cache files of the most recently opened recordings are kept.
+
+    isOpen(): whether the cache file could be created
+    start(): starts building the missing proxies in the background
+    setSuspended(): pauses or resumes building
+    getProxy(): fills the proxy image(s) of the frame, or of the closest frame having one, returns false if there is none near
+    getProxySize(): size of the proxy images
+    getNumCached(): number of proxies ready
+*/
+class ProxyImageCache {
+
+public:
+
+    explicit ProxyImageCache(const std::vector<std::string> &filenames, const std::vector<std::string> &filenamesSecondary,
+                             int imageWidth, int imageHeight, int maxProxySize=320, quint64 cacheSizeLimit=512ull*1024*1024);
+    ~ProxyImageCache();
+
+    bool isOpen() const;
+    void start();
+    void setSuspended(bool suspended);
+
+    bool getProxy(int frameNumber, cv::Mat &img, cv::Mat &imgSecondary);
+    cv::Size getProxySize() const;
+    int getNumCached() const;
+
+private:
+
+    static const int maxSearchDistance = 8; // in slots
+
+    std::vector<std::string> filenames, filenamesSecondary;
+    int numImages; // per slot, 1 or 2 for stereo
+    int imageReduction;
+    cv::Size proxySize;
+
+    int stride; // frames per slot
+    int numSlots;
+    size_t slotBytes;
+
+    QFile file;
+    uchar *map;
+    uchar *mapFlags;
+    uchar *mapPixels;
+    std::unique_ptr<std::atomic<bool>[]> cached;
+    std::atomic<int> numCached;
+
+    std::thread buildingThread;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> suspended;
+    std::atomic<int> requestedSlot;
+
+    bool openFile(const QString &cacheFileName);
+    void build();
+    void buildSlot(int slot);
+    static void removeOldCacheFiles(const QString &cacheDirectory, const QString &keep);
+};
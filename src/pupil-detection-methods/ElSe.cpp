@@ -17,8 +17,8 @@
 
 using namespace cv;
 
-float ElSe::minArea = 0;
-float ElSe::maxArea = 0;
+thread_local float ElSe::minArea = 0;
+thread_local float ElSe::maxArea = 0;
 
 #define IMG_SIZE 640 //400
 #define MAX_LINE 10000
@@ -899,6 +899,9 @@ static Mat canny_impl(Mat *pic, Mat *magni)
     return res_lin;
 }
 
+// Per block of (fak+1)² pixels, the mean of the pixels not brighter than the mean of the (2·fak+1)² window around the block corner
+// (row and column 0 excluded). The window means come from an integral image, and instead of building a 256-bin histogram per
+// window, the mean of the darker pixels is summed up in one pass over the window, with the same (integer) results.
 static void mum(Mat *pic, Mat *result, int fak)
 {
 
@@ -908,124 +911,103 @@ static void mum(Mat *pic, Mat *result, int fak)
 
     *result = Mat::zeros(sz_y, sz_x, CV_8U);
 
-    int hist[256];
-    int mean = 0;
-    int cnt = 0;
-    int mean_2 = 0;
-
-    int idx = 0;
-    int idy = 0;
+    Mat sum;
+    integral(*pic, sum, CV_32S);
 
     for (int i = 0; i < sz_y; i++)
     {
-        idy += fak_ges;
+        int idy = (i + 1) * fak_ges;
+        int st_y = max(1, idy - fak);
+        int en_y = min(pic->rows - 1, idy + fak);
+        uchar *p_res = result->ptr<uchar>(i);
 
         for (int j = 0; j < sz_x; j++)
         {
-            idx += fak_ges;
-
-            for (int k = 0; k < 256; k++)
-                hist[k] = 0;
-
-            mean = 0;
-            cnt = 0;
+            int idx = (j + 1) * fak_ges;
+            int st_x = max(1, idx - fak);
+            int en_x = min(pic->cols - 1, idx + fak);
 
-            for (int ii = -fak; ii <= fak; ii++)
-                for (int jj = -fak; jj <= fak; jj++)
-                {
+            int cnt = (en_y - st_y + 1) * (en_x - st_x + 1);
+            if (cnt <= 0)
+                continue;
 
-                    if (idy + ii > 0 && idy + ii < pic->rows && idx + jj > 0 && idx + jj < pic->cols)
-                    {
-                        if ((unsigned int)pic->data[(pic->cols * (idy + ii)) + (idx + jj)] > 255)
-                            pic->data[(pic->cols * (idy + ii)) + (idx + jj)] = 255;
+            int mean = (sum.at<int>(en_y + 1, en_x + 1) - sum.at<int>(st_y, en_x + 1) - sum.at<int>(en_y + 1, st_x) + sum.at<int>(st_y, st_x)) / cnt;
 
-                        hist[pic->data[(pic->cols * (idy + ii)) + (idx + jj)]]++;
-                        cnt++;
-                        mean += pic->data[(pic->cols * (idy + ii)) + (idx + jj)];
-                    }
-                }
-            mean = mean / cnt;
-
-            mean_2 = 0;
+            int mean_2 = 0;
             cnt = 0;
-            for (int ii = 0; ii <= mean; ii++)
+            for (int y = st_y; y <= en_y; y++)
             {
-                mean_2 += ii * hist[ii];
-                cnt += hist[ii];
+                const uchar *p = pic->ptr<uchar>(y);
+                for (int x = st_x; x <= en_x; x++)
+                {
+                    // branchless, the comparison is unpredictable on noisy images
+                    int darker = p[x] <= mean;
+                    mean_2 += p[x] * darker;
+                    cnt += darker;
+                }
             }
 
-            if (cnt == 0)
-                mean_2 = mean;
-            else
-                mean_2 = mean_2 / cnt;
-
-            result->data[(sz_x * (i)) + (j)] = mean_2;
+            p_res[j] = (uchar)(cnt == 0 ? mean : mean_2 / cnt);
         }
-        idx = 0;
     }
 }
 
-static void gen_blob_neu(int rad, Mat *all_mat, Mat *all_mat_neg)
+// Responses of the blob kernels (positive and negative one) on the image, with replicated borders. The kernel of radius rad is a
+// (4·rad+1)² square with weight 1/posis, except for a disc of radius rad in its center with weight -1/negis (1/negis in the negative
+// kernel), posis and negis being the number of square and disc pixels. Instead of filtering with the dense kernels, the square is a
+// box sum from an integral image and the disc the sum of one horizontal run per row from row-wise prefix sums.
+static void blob_filter(Mat *img, int rad, Mat *result, Mat *result_neg)
 {
 
-    int len = 1 + (4 * rad);
     int c0 = rad * 2;
-    float negis = 0;
-    float posis = 0;
+    int len = 1 + (4 * rad);
 
-    *all_mat = Mat::zeros(len, len, CV_32FC1);
-    *all_mat_neg = Mat::zeros(len, len, CV_32FC1);
+    std::vector<int> sz_w(2 * rad + 1);
+    double negis = 0;
+    for (int i = -rad; i <= rad; i++)
+    {
+        sz_w[i + rad] = (int)sqrt(float(rad * rad) - float(i * i));
+        negis += 2 * sz_w[i + rad] + 1;
+    }
+    double posis = double(len) * len - negis;
 
-    float *p, *p_neg;
-    for (int i = -rad * 2; i <= rad * 2; i++)
-    { //height
-        p = all_mat->ptr<float>(c0 + i);
+    Mat padded;
+    copyMakeBorder(*img, padded, c0, c0, c0, c0, BORDER_REPLICATE);
 
-        for (int j = -rad * 2; j <= rad * 2; j++)
-        {
+    Mat box;
+    integral(padded, box, CV_32S);
 
-            if (i < -rad || i > rad)
-            { //pos
-                p[c0 + j] = 1;
-                posis++;
-            }
-            else
-            { //neg
-
-                int sz_w = (int)sqrt(float(rad * rad) - float(i * i));
-
-                if (abs(j) <= sz_w)
-                {
-                    p[c0 + j] = -1;
-                    negis++;
-                }
-                else
-                {
-                    p[c0 + j] = 1;
-                    posis++;
-                }
-            }
-        }
+    Mat row_sum(padded.rows, padded.cols + 1, CV_32S);
+    for (int i = 0; i < padded.rows; i++)
+    {
+        const uchar *p = padded.ptr<uchar>(i);
+        int *p_sum = row_sum.ptr<int>(i);
+        p_sum[0] = 0;
+        for (int j = 0; j < padded.cols; j++)
+            p_sum[j + 1] = p_sum[j] + p[j];
     }
 
-    for (int i = 0; i < len; i++)
+    *result = Mat::zeros(img->rows, img->cols, CV_32FC1);
+    *result_neg = Mat::zeros(img->rows, img->cols, CV_32FC1);
+
+    for (int i = 0; i < img->rows; i++)
     {
-        p = all_mat->ptr<float>(i);
-        p_neg = all_mat_neg->ptr<float>(i);
+        float *p_res = result->ptr<float>(i);
+        float *p_neg_res = result_neg->ptr<float>(i);
 
-        for (int j = 0; j < len; j++)
+        for (int j = 0; j < img->cols; j++)
         {
+            double square = box.at<int>(i + len, j + len) - box.at<int>(i, j + len) - box.at<int>(i + len, j) + box.at<int>(i, j);
 
-            if (p[j] > 0)
+            double disc = 0;
+            for (int k = -rad; k <= rad; k++)
             {
-                p[j] = (int)1.0 / posis;
-                p_neg[j] = 0.0;
-            }
-            else
-            {
-                p[j] = (int)-1.0 / negis;
-                p_neg[j] = (int)1.0 / negis;
+                const int *p_sum = row_sum.ptr<int>(i + c0 + k);
+                disc += p_sum[j + c0 + sz_w[k + rad] + 1] - p_sum[j + c0 - sz_w[k + rad]];
             }
+
+            p_res[j] = (float)((square - disc) / posis - disc / negis);
+            p_neg_res[j] = (float)(disc / negis);
         }
     }
 }
@@ -1107,7 +1089,6 @@ static RotatedRect blob_finder(Mat *pic)
     float abs_max = 0;
 
     float *p_erg;
-    Mat blob_mat, blob_mat_neg;
 
     int fak_mum = 5;
     int fakk = pic->cols > pic->rows ? (pic->cols / 100) + 1 : (pic->rows / 100) + 1;
@@ -1118,10 +1099,7 @@ static RotatedRect blob_finder(Mat *pic)
 
     Mat result, result_neg;
 
-    gen_blob_neu(fakk, &blob_mat, &blob_mat_neg);
-
-    img.convertTo(img, CV_32FC1);
-    filter2D(img, result, -1, blob_mat, Point(-1, -1), 0, BORDER_REPLICATE);
+    blob_filter(&img, fakk, &result, &result_neg);
 
     float *p_res, *p_neg_res;
     for (int i = 0; i < result.rows; i++)
@@ -1135,8 +1113,6 @@ static RotatedRect blob_finder(Mat *pic)
         }
     }
 
-    filter2D(img, result_neg, -1, blob_mat_neg, Point(-1, -1), 0, BORDER_REPLICATE);
-
     for (int i = 0; i < result.rows; i++)
     {
         p_res = result.ptr<float>(i);
@@ -1359,3 +1335,190 @@ void ElSe::run(const cv::Mat &frame, const cv::Rect &roi, Pupil &pupil, const fl
     if (pupil.center.x > 0 && pupil.center.y > 0)
         pupil.shift(roi.tl());
 }
+
+// Reference versions of mum() and blob_filter(), as they were before the integral images, only used by benchmarkBlobFinder()
+static void mum_histogram(Mat *pic, Mat *result, int fak)
+{
+
+    int fak_ges = fak + 1;
+    int sz_x = pic->cols / fak_ges;
+    int sz_y = pic->rows / fak_ges;
+
+    *result = Mat::zeros(sz_y, sz_x, CV_8U);
+
+    int hist[256];
+    int idy = 0;
+
+    for (int i = 0; i < sz_y; i++)
+    {
+        idy += fak_ges;
+        int idx = 0;
+
+        for (int j = 0; j < sz_x; j++)
+        {
+            idx += fak_ges;
+
+            for (int k = 0; k < 256; k++)
+                hist[k] = 0;
+
+            int mean = 0;
+            int cnt = 0;
+
+            for (int ii = -fak; ii <= fak; ii++)
+                for (int jj = -fak; jj <= fak; jj++)
+                {
+                    if (idy + ii > 0 && idy + ii < pic->rows && idx + jj > 0 && idx + jj < pic->cols)
+                    {
+                        hist[pic->data[(pic->cols * (idy + ii)) + (idx + jj)]]++;
+                        cnt++;
+                        mean += pic->data[(pic->cols * (idy + ii)) + (idx + jj)];
+                    }
+                }
+            mean = mean / cnt;
+
+            int mean_2 = 0;
+            cnt = 0;
+            for (int ii = 0; ii <= mean; ii++)
+            {
+                mean_2 += ii * hist[ii];
+                cnt += hist[ii];
+            }
+
+            result->data[(sz_x * (i)) + (j)] = cnt == 0 ? mean : mean_2 / cnt;
+        }
+    }
+}
+
+static void blob_filter_dense(Mat *img, int rad, Mat *result, Mat *result_neg)
+{
+
+    int len = 1 + (4 * rad);
+    int c0 = rad * 2;
+    float negis = 0;
+    float posis = 0;
+
+    Mat blob_mat = Mat::zeros(len, len, CV_32FC1);
+    Mat blob_mat_neg = Mat::zeros(len, len, CV_32FC1);
+
+    for (int i = -c0; i <= c0; i++)
+    {
+        float *p = blob_mat.ptr<float>(c0 + i);
+        int sz_w = (i < -rad || i > rad) ? -1 : (int)sqrt(float(rad * rad) - float(i * i));
+
+        for (int j = -c0; j <= c0; j++)
+        {
+            if (abs(j) <= sz_w)
+            {
+                p[c0 + j] = -1;
+                negis++;
+            }
+            else
+            {
+                p[c0 + j] = 1;
+                posis++;
+            }
+        }
+    }
+
+    for (int i = 0; i < len; i++)
+    {
+        float *p = blob_mat.ptr<float>(i);
+        float *p_neg = blob_mat_neg.ptr<float>(i);
+
+        for (int j = 0; j < len; j++)
+        {
+            p_neg[j] = p[j] > 0 ? 0.0f : 1.0f / negis;
+            p[j] = p[j] > 0 ? 1.0f / posis : -1.0f / negis;
+        }
+    }
+
+    Mat img_float;
+    img->convertTo(img_float, CV_32FC1);
+    filter2D(img_float, *result, -1, blob_mat, Point(-1, -1), 0, BORDER_REPLICATE);
+    filter2D(img_float, *result_neg, -1, blob_mat_neg, Point(-1, -1), 0, BORDER_REPLICATE);
+}
+
+// Noise image with a dark elliptic blob, as seen by blob_finder() when the edge based detection fails
+static Mat benchmark_image(RNG &rng, int cols, int rows)
+{
+    Mat img(rows, cols, CV_8U);
+    rng.fill(img, RNG::UNIFORM, 60, 200);
+    const Point center(rng.uniform(cols / 4, 3 * cols / 4), rng.uniform(rows / 4, 3 * rows / 4));
+    const int radius = std::max(3, std::min(cols, rows) / rng.uniform(6, 12));
+    ellipse(img, center, Size(radius, radius * 4 / 5), rng.uniform(0, 180), 0, 360, Scalar(rng.uniform(10, 40)), FILLED);
+    return img;
+}
+
+int ElSe::benchmarkBlobFinder(int images)
+{
+
+    if (images <= 0)
+    {
+        std::cerr << "Number of images must be positive" << std::endl;
+        return -1;
+    }
+
+    RNG rng(1234);
+    const int fak_mum = 5;
+
+    // Timing on the size of a typical eye image
+    Mat pic = benchmark_image(rng, 640, 480);
+    const int fakk = (pic.cols / 100) + 1;
+    Mat img, img_reference, result, result_neg;
+    mum(&pic, &img, fak_mum);
+
+    double ms[4] = {0, 0, 0, 0};
+    for (int n = 0; n < images; n++)
+    {
+        int64 t0 = getTickCount();
+        mum(&pic, &img, fak_mum);
+        int64 t1 = getTickCount();
+        mum_histogram(&pic, &img_reference, fak_mum);
+        int64 t2 = getTickCount();
+        blob_filter(&img, fakk, &result, &result_neg);
+        int64 t3 = getTickCount();
+        blob_filter_dense(&img, fakk, &result, &result_neg);
+        int64 t4 = getTickCount();
+        ms[0] += (t1 - t0) * 1000.0 / getTickFrequency();
+        ms[1] += (t2 - t1) * 1000.0 / getTickFrequency();
+        ms[2] += (t3 - t2) * 1000.0 / getTickFrequency();
+        ms[3] += (t4 - t3) * 1000.0 / getTickFrequency();
+    }
+    std::cout << "640x480, mean of " << images << " runs" << std::endl;
+    std::cout << "mum: " << ms[0] / images << " ms (histogram reference: " << ms[1] / images << " ms)" << std::endl;
+    std::cout << "blob filter: " << ms[2] / images << " ms (dense reference: " << ms[3] / images << " ms)" << std::endl;
+
+    // Agreement with the reference versions on random image sizes
+    int mumMismatches = 0;
+    int argmaxMismatches = 0;
+    double maxDifference = 0;
+    for (int n = 0; n < images; n++)
+    {
+        pic = benchmark_image(rng, rng.uniform(100, 641), rng.uniform(100, 641));
+        const int rad = pic.cols > pic.rows ? (pic.cols / 100) + 1 : (pic.rows / 100) + 1;
+
+        mum(&pic, &img, fak_mum);
+        mum_histogram(&pic, &img_reference, fak_mum);
+        if (countNonZero(img != img_reference) > 0)
+            mumMismatches++;
+
+        Mat result_reference, result_neg_reference;
+        blob_filter(&img, rad, &result, &result_neg);
+        blob_filter_dense(&img, rad, &result_reference, &result_neg_reference);
+        maxDifference = std::max(maxDifference, norm(result, result_reference, NORM_INF));
+        maxDifference = std::max(maxDifference, norm(result_neg, result_neg_reference, NORM_INF));
+
+        // Response blob_finder() searches the maximum of
+        Mat erg = cv::max(result, 0.0).mul(255.0 - result_neg);
+        Mat erg_reference = cv::max(result_reference, 0.0).mul(255.0 - result_neg_reference);
+        Point pos, pos_reference;
+        minMaxLoc(erg, nullptr, nullptr, nullptr, &pos);
+        minMaxLoc(erg_reference, nullptr, nullptr, nullptr, &pos_reference);
+        if (pos != pos_reference)
+            argmaxMismatches++;
+    }
+    std::cout << images << " random sizes: " << mumMismatches << " mum mismatches, " << argmaxMismatches
+              << " blob position mismatches, largest response difference " << maxDifference << std::endl;
+
+    return mumMismatches == 0 && argmaxMismatches == 0 ? 0 : 1;
+}
@@ -17,8 +17,9 @@ class ElSe : public PupilDetectionMethod {
 
 public:
 
-    static float minArea;
-    static float maxArea;
+    // thread_local, as several ElSe instances may run concurrently (two-pupil/stereo modes, evaluation runs)
+    static thread_local float minArea;
+    static thread_local float maxArea;
 
     ElSe() {
         mDesc = "ElSe (Fuhl et al. 2016)";
@@ -40,6 +41,10 @@ public:
         return false;
     }
 
+    // Compares the integral image versions of the blob fallback (mum and blob kernel filtering) with the former direct ones, in speed on
+    // a 640x480 image and in results on the given number of random image sizes, see -benchmarkElSeBlobFinder in Misc/Executable_arguments.md
+    static int benchmarkBlobFinder(int images);
+
     float minAreaRatio = 0.005;
     float maxAreaRatio = 0.2;
 
@@ -0,0 +1,218 @@
+
+#include "HaarSurroundLocalizer.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Coarse candidates refined at full resolution. More than one, as the coarse grid may rank a wrong radius or a dark
+    // spot (eyelashes, shadows) first while the pupil lies between its grid points
+    const size_t refinedCandidates = 3;
+
+    // Grid spacing of the coarse pass, the kernel of radius r covers at least 2r+1 pixels so half of it still hits every pupil
+    int coarseSpacing(int r) {
+        return std::max(4, r / 2);
+    }
+}
+
+HaarSurroundLocalizer::HaarSurroundLocalizer(const cv::Mat &image, int padding) :
+    padding(padding),
+    rows(image.rows),
+    cols(image.cols) {
+
+    if(padding > 0) {
+        cv::Mat padded;
+        cv::copyMakeBorder(image, padded, padding, padding, padding, padding, cv::BORDER_REPLICATE);
+        cv::integral(padded, integral, CV_64F);
+    } else {
+        cv::integral(image, integral, CV_64F);
+    }
+}
+
+bool HaarSurroundLocalizer::isInside(int x, int y, int r) const {
+    return x >= r && x < cols - r && y >= r && y < rows - r;
+}
+
+// Responses at (x0 + i*xstep, y) for i in [0, count). Branch-free code over plain row pointers, so compilers vectorise it
+void HaarSurroundLocalizer::responseRow(int y, int r, int x0, int count, int xstep, double *responses) const {
+
+    const int R = 3 * r;
+    const double *inner0 = integral.ptr<double>(y + padding - r) + padding + x0;
+    const double *inner1 = integral.ptr<double>(y + padding + r + 1) + padding + x0;
+    const double *outer0 = integral.ptr<double>(y + padding - R) + padding + x0;
+    const double *outer1 = integral.ptr<double>(y + padding + R + 1) + padding + x0;
+
+    for(int i=0, x=0; i<count; i++, x+=xstep) {
+        const double inner = inner0[x - r] + inner1[x + r + 1] - inner0[x + r + 1] - inner1[x - r];
+        const double outer = outer0[x - R] + outer1[x + R + 1] - outer0[x + R + 1] - outer1[x - R];
+        responses[i] = 9 * inner - outer;
+    }
+}
+
+HaarSurroundLocalizer::Location HaarSurroundLocalizer::findMinimum(int minRadius, int maxRadius) const {
+
+    minRadius = std::max(1, minRadius);
+
+    // Coarse pass: best location of each radius on its grid
+    std::vector<Location> candidates;
+    std::vector<double> responses;
+
+    for(int r = minRadius; r < maxRadius && isInside(r, r, r); r += 2) {
+
+        const int spacing = coarseSpacing(r);
+        const int count = (cols - 2 * r - 1) / spacing + 1;
+        responses.resize(count);
+
+        double bestValue = std::numeric_limits<double>::infinity();
+        Location best;
+        for(int y = r; y < rows - r; y += spacing) {
+            responseRow(y, r, r, count, spacing, responses.data());
+            const auto it = std::min_element(responses.begin(), responses.end());
+            if(*it < bestValue) {
+                bestValue = *it;
+                best.centre = cv::Point(r + static_cast<int>(it - responses.begin()) * spacing, y);
+            }
+        }
+        best.radius = r;
+        best.response = bestValue / (8.0 * r * r);
+        candidates.push_back(best);
+    }
+
+    const size_t numRefined = std::min(candidates.size(), refinedCandidates);
+    std::partial_sort(candidates.begin(), candidates.begin() + numRefined, candidates.end(),
+                      [](const Location &a, const Location &b) { return a.response < b.response; });
+
+    // Fine pass around the best candidates
+    Location result;
+    for(size_t i=0; i<numRefined; i++) {
+        Location candidate = candidates[i];
+        refine(candidate, coarseSpacing(candidate.radius), minRadius, maxRadius);
+        if(candidate.response < result.response)
+            result = candidate;
+    }
+    return result;
+}
+
+// Descends over the 3x3 neighbourhood and the neighbouring radii, halving the neighbourhood spacing down to one pixel
+void HaarSurroundLocalizer::refine(Location &location, int spacing, int minRadius, int maxRadius) const {
+
+    do {
+        spacing = std::max(1, spacing / 2);
+
+        Location best = location;
+        for(int r = std::max(minRadius, location.radius - 1); r <= std::min(maxRadius - 1, location.radius + 1); r++) {
+            const double scale = 1.0 / (8.0 * r * r);
+            for(int dy=-1; dy<=1; dy++) {
+                for(int dx=-1; dx<=1; dx++) {
+                    const int x = location.centre.x + dx * spacing;
+                    const int y = location.centre.y + dy * spacing;
+                    if(!isInside(x, y, r))
+                        continue;
+                    const double value = response(x, y, r) * scale;
+                    if(value < best.response) {
+                        best.centre = cv::Point(x, y);
+                        best.radius = r;
+                        best.response = value;
+                    }
+                }
+            }
+        }
+        location = best;
+    } while(spacing > 1);
+}
+
+HaarSurroundLocalizer::Location HaarSurroundLocalizer::findMinimumDense(int minRadius, int maxRadius) const {
+
+    minRadius = std::max(1, minRadius);
+
+    Location result;
+    std::vector<double> responses;
+    for(int r = minRadius; r < maxRadius && isInside(r, r, r); r++) {
+        const int count = cols - 2 * r;
+        responses.resize(count);
+        const double scale = 1.0 / (8.0 * r * r);
+        for(int y = r; y < rows - r; y++) {
+            responseRow(y, r, r, count, 1, responses.data());
+            const auto it = std::min_element(responses.begin(), responses.end());
+            if(*it * scale < result.response) {
+                result.centre = cv::Point(r + static_cast<int>(it - responses.begin()), y);
+                result.radius = r;
+                result.response = *it * scale;
+            }
+        }
+    }
+    return result;
+}
+
+int HaarSurroundLocalizer::benchmark(int images) {
+
+    if(images <= 0) {
+        std::cerr << "Number of images must be positive" << std::endl;
+        return -1;
+    }
+
+    struct Setup {
+        const char *name;
+        cv::Size size;
+        int minRadius;
+        int maxRadius;
+    };
+    // Swirski2D with its default radii, and the coarse pupil detection on its downscaled image (radii as in coarsePupilDetection())
+    const Setup setups[] = {
+        {"Swirski2D", cv::Size(640, 480), 40, 80},
+        {"coarse detection", cv::Size(160, 120), 4, 21},
+    };
+
+    cv::RNG rng(1234);
+    bool agreed = true;
+    for(const Setup &setup : setups) {
+
+        double ms[2] = {0, 0};
+        int found[2] = {0, 0};
+        int same = 0;
+        double responseRatio = 0;
+        for(int n=0; n<images; n++) {
+
+            // Noise image with a dark pupil, whose inscribed square fits the searched radii
+            cv::Mat image(setup.size, CV_8U);
+            rng.fill(image, cv::RNG::UNIFORM, 80, 200);
+            const int pupilRadius = static_cast<int>(rng.uniform(setup.minRadius, setup.maxRadius) * 1.4);
+            const cv::Point pupil(rng.uniform(pupilRadius, std::max(pupilRadius + 1, setup.size.width - pupilRadius)),
+                                  rng.uniform(pupilRadius, std::max(pupilRadius + 1, setup.size.height - pupilRadius)));
+            cv::circle(image, pupil, pupilRadius, cv::Scalar(rng.uniform(10, 50)), cv::FILLED);
+
+            const HaarSurroundLocalizer localizer(image, 2 * setup.maxRadius);
+            Location locations[2];
+            const int64 t0 = cv::getTickCount();
+            locations[0] = localizer.findMinimum(setup.minRadius, setup.maxRadius);
+            const int64 t1 = cv::getTickCount();
+            locations[1] = localizer.findMinimumDense(setup.minRadius, setup.maxRadius);
+            const int64 t2 = cv::getTickCount();
+            ms[0] += (t1 - t0) * 1000.0 / cv::getTickFrequency();
+            ms[1] += (t2 - t1) * 1000.0 / cv::getTickFrequency();
+
+            for(int i=0; i<2; i++) {
+                if(cv::norm(locations[i].centre - pupil) <= pupilRadius)
+                    found[i]++;
+            }
+            if(cv::norm(locations[0].centre - locations[1].centre) <= 1.5 && std::abs(locations[0].radius - locations[1].radius) <= 1)
+                same++;
+            // Both are negative for a dark pupil, 1 means the coarse-to-fine search reached the dense minimum
+            if(locations[1].response < 0)
+                responseRatio += locations[0].response / locations[1].response;
+        }
+
+        std::cout << setup.name << " (" << setup.size.width << "x" << setup.size.height << ", radii " << setup.minRadius << "-"
+                  << setup.maxRadius - 1 << "), mean of " << images << " images" << std::endl;
+        std::cout << "coarse-to-fine: " << ms[0] / images << " ms, pupil found in " << found[0] << std::endl;
+        std::cout << "dense: " << ms[1] / images << " ms, pupil found in " << found[1] << std::endl;
+        std::cout << "same location: " << same << ", mean response relative to the dense minimum: " << responseRatio / images << std::endl;
+
+        agreed = agreed && found[0] >= found[1];
+    }
+    return agreed ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <opencv2/core.hpp>
+
+#include <limits>
+
+/**
+    Pupil localisation with the Haar-like surround feature suggested by Swirski: a dark square of radius r (the pupil) inside a
+    brighter square of radius 3r (the surround). See
+    Świrski, Lech, Andreas Bulling, and Neil Dodgson.
+    "Robust real-time pupil tracking in highly off-axis images."
+    Proceedings of the Symposium on Eye Tracking Research and Applications. ACM, 2012.
+
+    The integral image of the (optionally border replicated) image is computed once on construction, all box sums of all radii and
+    positions are then read from it. It is kept in doubles, which hold the pixel sums of any image exactly (a 32 bit integral overflows
+    above about 8.4 megapixels of 8 bit images). As box sums of any size come from the same integral image, it serves every level of the
+    search "pyramid" without resampling the image.
+
+    findMinimum() searches coarse-to-fine: a coarse pass samples each radius on a grid spaced proportionally to the radius (the
+    response of a large kernel changes slowly with its position), then the best candidates are refined down to single pixel and
+    radius steps by searching their neighbourhood with halving spacing. This evaluates a fraction of the positions of a dense search.
+
+    The response is Swirski's square radius normalised one, inner pixels weighted 1/r^2 and surround pixels weighted so the kernel
+    sums to zero. As the surround has 8 times the pixels of the inner square, it is evaluated as 8*inner - surround and only scaled
+    to compare different radii.
+
+    boxSum(): sum of the pixels of a rectangle in image coordinates, may reach into the padding
+    findMinimum(): centre and radius with the minimal response (darkest centre relative to its surround)
+    findMinimumDense(): the same by evaluating every centre and radius, the reference for findMinimum()
+    benchmark(): compares findMinimum() with findMinimumDense() in speed and result on synthetic eye images of the sizes and radii used by
+        Swirski2D and the coarse pupil detection (see -benchmarkHaarSurround in Misc/Executable_arguments.md)
+*/
+class HaarSurroundLocalizer {
+
+public:
+
+    struct Location {
+        cv::Point centre;
+        int radius = 0;
+        double response = std::numeric_limits<double>::infinity();
+    };
+
+    // Padding must be at least twice the largest radius searched with findMinimum(), as the surround reaches 2r over the search region
+    explicit HaarSurroundLocalizer(const cv::Mat &image, int padding=0);
+
+    // Sum of the pixels in [x0,x1) x [y0,y1)
+    inline double boxSum(int x0, int y0, int x1, int y1) const {
+        const double *row0 = integral.ptr<double>(y0 + padding);
+        const double *row1 = integral.ptr<double>(y1 + padding);
+        return row0[x0 + padding] + row1[x1 + padding] - row0[x1 + padding] - row1[x0 + padding];
+    }
+
+    // Searches centres with at least the radius distance to the image border, radii in [minRadius, maxRadius)
+    Location findMinimum(int minRadius, int maxRadius) const;
+    Location findMinimumDense(int minRadius, int maxRadius) const;
+
+    static int benchmark(int images);
+
+private:
+
+    cv::Mat integral;
+    int padding;
+    int rows;
+    int cols;
+
+    // Response (scaled by 8r^2) of the kernel of radius r centred at (x,y)
+    inline double response(int x, int y, int r) const {
+        const double inner = boxSum(x - r, y - r, x + r + 1, y + r + 1);
+        const double outer = boxSum(x - 3 * r, y - 3 * r, x + 3 * r + 1, y + 3 * r + 1);
+        return 9 * inner - outer;
+    }
+
+    void responseRow(int y, int r, int x0, int count, int xstep, double *responses) const;
+    bool isInside(int x, int y, int r) const;
+    void refine(Location &location, int spacing, int minRadius, int maxRadius) const;
+};
@@ -39,19 +39,19 @@ class Pupil : public cv::RotatedRect {
 public:
 
     Pupil(const RotatedRect &outline, const float &confidence) :
-            RotatedRect(outline), confidence(confidence), outline_confidence(NO_CONFIDENCE), eyelid(0), physicalDiameter(-1.0), undistortedDiameter(-1.0), algorithmName("") {
+            RotatedRect(outline), confidence(confidence), outline_confidence(NO_CONFIDENCE), eyelid(0), physicalDiameter(-1.0), undistortedDiameter(-1.0), algorithmName(""), blink(false) {
     }
 
     Pupil(const RotatedRect &outline, const float &confidence, const float &outline_confidence, const float &eyelid, const float &physicalDiameter, const float &undistortedDiameter) :
-            RotatedRect(outline), confidence(confidence), outline_confidence(outline_confidence), eyelid(eyelid), physicalDiameter(physicalDiameter), undistortedDiameter(undistortedDiameter), algorithmName("") {
+            RotatedRect(outline), confidence(confidence), outline_confidence(outline_confidence), eyelid(eyelid), physicalDiameter(physicalDiameter), undistortedDiameter(undistortedDiameter), algorithmName(""), blink(false) {
     }
 
     Pupil(const Pupil &other) :
-            RotatedRect(other), confidence(other.confidence), outline_confidence(other.outline_confidence), eyelid(other.eyelid), physicalDiameter(other.physicalDiameter), undistortedDiameter(other.undistortedDiameter), algorithmName(other.algorithmName) {
+            RotatedRect(other), confidence(other.confidence), outline_confidence(other.outline_confidence), eyelid(other.eyelid), physicalDiameter(other.physicalDiameter), undistortedDiameter(other.undistortedDiameter), algorithmName(other.algorithmName), blink(other.blink) {
     }
 
     Pupil(const RotatedRect &outline) :
-            RotatedRect(outline), confidence(NO_CONFIDENCE), outline_confidence(NO_CONFIDENCE), eyelid(0), physicalDiameter(-1.0), undistortedDiameter(-1.0), algorithmName("") {
+            RotatedRect(outline), confidence(NO_CONFIDENCE), outline_confidence(NO_CONFIDENCE), eyelid(0), physicalDiameter(-1.0), undistortedDiameter(-1.0), algorithmName(""), blink(false) {
     }
 
     Pupil() {
@@ -71,6 +71,9 @@ public:
 
     std::string algorithmName;
 
+    // The frame was rejected as blink or without visible pupil before running the detection, the pupil is invalid
+    bool blink;
+
     void clear() {
         angle = -1.0;
         center = { -1.0, -1.0 };
@@ -81,6 +84,7 @@ public:
         physicalDiameter=-1.0;
         undistortedDiameter=-1.0;
         algorithmName="";
+        blink=false;
     }
 
     void resize(const float &xf, const float &yf) {
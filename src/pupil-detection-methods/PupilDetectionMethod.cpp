@@ -24,9 +24,10 @@ OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 */
 
 #include <opencv2/imgproc.hpp>
-#include <deque>
+#include <cmath>
 #include <bitset>
 #include "PupilDetectionMethod.h"
+#include "HaarSurroundLocalizer.h"
 
 cv::Rect PupilDetectionMethod::coarsePupilDetection(const cv::Mat &frame, const float &minCoverage, const int &workingWidth, const int &workingHeight)
 {
@@ -39,123 +40,42 @@ cv::Rect PupilDetectionMethod::coarsePupilDetection(const cv::Mat &frame, const
     cv::Mat downscaled;
     cv::resize(frame, downscaled, cv::Size(), 1 / fr, 1 / fr, cv::INTER_LINEAR);
 
-    int ystep = (int)cv::max<float>(0.01f * downscaled.rows, 1.0f);
-    int xstep = (int)cv::max<float>(0.01f * downscaled.cols, 1.0f);
-
     float d = (float)sqrt(pow(downscaled.rows, 2) + pow(downscaled.cols, 2));
 
-    // Pupil radii is based on PuRe assumptions
-    int min_r = (int)(0.5 * 0.07 * d);
-    int max_r = (int)(0.5 * 0.29 * d);
-    int r_step = (int)cv::max<float>(0.2f * (max_r + min_r), 1.0f);
-
-    // TODO: padding so we consider the borders as well!
+    // Pupil radii is based on PuRe assumptions, the inner box of radius r fits into a pupil of radius sqrt(2)*r
+    int minRadius = cv::max((int)(0.7 * 0.5 * 0.07 * d), 1);
+    int maxRadius = cv::max((int)(0.7 * 0.5 * 0.29 * d), minRadius) + 1;
 
-    /* Haar-like feature suggested by Swirski. For details, see
-     * Świrski, Lech, Andreas Bulling, and Neil Dodgson.
-     * "Robust real-time pupil tracking in highly off-axis images."
-     * Proceedings of the Symposium on Eye Tracking Research and Applications. ACM, 2012.
-     *
-     * However, we collect a per-pixel maxima instead of the global one
-    */
-    cv::Mat itg;
-    integral(downscaled, itg, CV_32S);
-    cv::Mat res = cv::Mat::zeros(downscaled.rows, downscaled.cols, CV_32F);
-    float best_response = std::numeric_limits<float>::min();
+    /* Haar-like feature suggested by Swirski, searched coarse-to-fine by the HaarSurroundLocalizer shared with blinkDetection().
+     * The padding replicates the border, so pupils close to the border are considered as well
+     */
+    HaarSurroundLocalizer localizer(downscaled, 2 * maxRadius);
+    HaarSurroundLocalizer::Location darkest = localizer.findMinimum(minRadius, maxRadius);
 
-    std::deque<std::pair<cv::Rect, float>> candidates;
+    cv::Rect imRoi = cv::Rect(0, 0, frame.cols, frame.rows);
+    if (std::isinf(darkest.response))
+        return imRoi;
 
-    for (int r = min_r; r <= max_r; r += r_step)
+    // The surround of the darkest location, grown around it until we reach the minimum coverage
+    const int R = 3 * darkest.radius;
+    cv::Rect coarse(darkest.centre.x - R, darkest.centre.y - R, 2 * R + 1, 2 * R + 1);
+    int minWidth = static_cast<int>(minCoverage * downscaled.cols);
+    int minHeight = static_cast<int>(minCoverage * downscaled.rows);
+    if (coarse.width <= minWidth)
     {
-        int step = 3 * r;
-
-        cv::Point ia, ib, ic, id;
-        cv::Point oa, ob, oc, od;
-
-        int inner_count = (2 * r) * (2 * r);
-        int outer_count = (2 * step) * (2 * step) - inner_count;
-
-        float inner_norm = 1.0f / (255 * inner_count);
-        float outer_norm = 1.0f / (255 * outer_count);
-
-        for (int y = step; y < downscaled.rows - step; y += ystep)
-        {
-            oa.y = y - step;
-            ob.y = y - step;
-            oc.y = y + step;
-            od.y = y + step;
-            ia.y = y - r;
-            ib.y = y - r;
-            ic.y = y + r;
-            id.y = y + r;
-            for (int x = step; x < downscaled.cols - step; x += xstep)
-            {
-                oa.x = x - step;
-                ob.x = x + step;
-                oc.x = x + step;
-                od.x = x - step;
-                ia.x = x - r;
-                ib.x = x + r;
-                ic.x = x + r;
-                id.x = x - r;
-                int inner = itg.ptr<int>(ic.y)[ic.x] + itg.ptr<int>(ia.y)[ia.x] -
-                            itg.ptr<int>(ib.y)[ib.x] - itg.ptr<int>(id.y)[id.x];
-                int outer = itg.ptr<int>(oc.y)[oc.x] + itg.ptr<int>(oa.y)[oa.x] -
-                            itg.ptr<int>(ob.y)[ob.x] - itg.ptr<int>(od.y)[od.x] - inner;
-
-                float inner_mean = inner_norm * inner;
-                float outer_mean = outer_norm * outer;
-                float response = (outer_mean - inner_mean);
-
-                if (response < 0.5 * best_response)
-                    continue;
-
-                if (response < 0.5 * best_response)
-                    continue;
-
-                if (response > best_response)
-                    best_response = response;
-
-                if (response > res.ptr<float>(y)[x])
-                {
-                    res.ptr<float>(y)[x] = response;
-                    // The pupil is too small, the padding too large; we combine them.
-                    candidates.push_back(std::make_pair(cv::Rect(0.5 * (ia + oa), 0.5 * (ic + oc)), response));
-                }
-            }
-        }
+        coarse.x -= (minWidth + 1 - coarse.width) / 2;
+        coarse.width = minWidth + 1;
     }
-
-    auto compare = [](const std::pair<cv::Rect, float> &a, const std::pair<cv::Rect, float> &b)
+    if (coarse.height <= minHeight)
     {
-        return (a.second > b.second);
-    };
-    sort(candidates.begin(), candidates.end(), compare);
+        coarse.y -= (minHeight + 1 - coarse.height) / 2;
+        coarse.height = minHeight + 1;
+    }
 
 #ifdef DBG_COARSE_PUPIL_DETECTION
     Mat dbg;
     cvtColor(downscaled, dbg, CV_GRAY2BGR);
-#endif
-
-    // Now add until we reach the minimum coverage or run out of candidates
-    cv::Rect coarse;
-    int minWidth = static_cast<int>(minCoverage * downscaled.cols);
-    int minHeight = static_cast<int>(minCoverage * downscaled.rows);
-    for (int i = 0; i < candidates.size(); i++)
-    {
-        auto &c = candidates[i];
-        if (coarse.area() == 0)
-            coarse = c.first;
-        else
-            coarse |= c.first;
-#ifdef DBG_COARSE_PUPIL_DETECTION
-        rectangle(dbg, candidates[i].first, Scalar(0, 255, 255));
-#endif
-        if (coarse.width > minWidth && coarse.height > minHeight)
-            break;
-    }
-
-#ifdef DBG_COARSE_PUPIL_DETECTION
+    circle(dbg, darkest.centre, darkest.radius, Scalar(0, 255, 255));
     rectangle(dbg, coarse, Scalar(0, 255, 0));
     resize(dbg, dbg, Size(), fr, fr);
     imshow("Coarse Detection Debug", dbg);
@@ -168,7 +88,6 @@ cv::Rect PupilDetectionMethod::coarsePupilDetection(const cv::Mat &frame, const
     coarse.height *= fr;
 
     // Sanity test
-    cv::Rect imRoi = cv::Rect(0, 0, frame.cols, frame.rows);
     coarse &= imRoi;
     if (coarse.area() == 0)
         return imRoi;
@@ -176,6 +95,70 @@ cv::Rect PupilDetectionMethod::coarsePupilDetection(const cv::Mat &frame, const
     return coarse;
 }
 
+/* Rejects frames without a visible pupil (blinks, looking away) before the detection, whose fallbacks are the most expensive on
+ * exactly these frames. Two cheap tests on a very small input:
+ * - histogram shape: a visible pupil adds a dark tail to the intensity histogram, closed lids or skin are rather uniform
+ * - dark blob: the darkest pupil sized blob (Haar-like surround feature, see coarsePupilDetection) must be darker than its
+ *   surround, eyelashes and lid edges are too thin for the inner box to respond
+ * The contrasts are in grey levels. Returns true if the frame should be skipped.
+ */
+bool PupilDetectionMethod::blinkDetection(const cv::Mat &frame, const float &minDarkContrast, const float &minBlobContrast, const int &workingWidth, const int &workingHeight)
+{
+    if (frame.empty())
+        return false;
+
+    float xr = frame.cols / (float)workingWidth;
+    float yr = frame.rows / (float)workingHeight;
+    float fr = cv::max(xr, yr);
+
+    cv::Mat downscaled;
+    if (fr > 1)
+        cv::resize(frame, downscaled, cv::Size(), 1 / fr, 1 / fr, cv::INTER_AREA);
+    else
+        downscaled = frame;
+
+    // Histogram shape: median against the darkest half percent, the smallest pupils (see below) cover about one percent
+    int histogram[256] = {0};
+    for (int y = 0; y < downscaled.rows; y++)
+    {
+        const uchar *row = downscaled.ptr<uchar>(y);
+        for (int x = 0; x < downscaled.cols; x++)
+            histogram[row[x]]++;
+    }
+
+    const int total = downscaled.rows * downscaled.cols;
+    auto percentile = [&histogram, total](float fraction)
+    {
+        const int target = static_cast<int>(fraction * total);
+        int count = 0;
+        for (int value = 0; value < 256; value++)
+        {
+            count += histogram[value];
+            if (count > target)
+                return value;
+        }
+        return 255;
+    };
+
+    if (percentile(0.5f) - percentile(0.005f) < minDarkContrast)
+        return true;
+
+    // Pupil radii is based on PuRe assumptions, the inner box of radius r fits into a pupil of radius sqrt(2)*r
+    float d = (float)sqrt(pow(downscaled.rows, 2) + pow(downscaled.cols, 2));
+    int minRadius = cv::max((int)(0.7 * 0.5 * 0.07 * d), 1);
+    int maxRadius = cv::max((int)(0.7 * 0.5 * 0.29 * d), minRadius) + 1;
+
+    HaarSurroundLocalizer localizer(downscaled, 2 * maxRadius);
+    HaarSurroundLocalizer::Location darkest = localizer.findMinimum(minRadius, maxRadius);
+
+    // No radius fits into the frame, the detection has to decide
+    if (std::isinf(darkest.response))
+        return false;
+
+    // The response is about 4 times the mean of the inner box minus the one of the surround
+    return darkest.response > -4.0 * minBlobContrast;
+}
+
 static const float sinTable[] = {
     0.0000000f, 0.0174524f, 0.0348995f, 0.0523360f, 0.0697565f, 0.0871557f,
     0.1045285f, 0.1218693f, 0.1391731f, 0.1564345f, 0.1736482f, 0.1908090f,
@@ -96,6 +96,9 @@ public:
     // Generic coarse pupil detection
     static cv::Rect coarsePupilDetection(const cv::Mat &frame, const float &minCoverage=0.5f, const int &workingWidth=60, const int &workingHeight=40);
 
+    // Generic blink / no-pupil rejection, true if the frame shows no pupil worth running the detection on
+    static bool blinkDetection(const cv::Mat &frame, const float &minDarkContrast=20.0f, const float &minBlobContrast=10.0f, const int &workingWidth=60, const int &workingHeight=40);
+
     // Generic confidence metrics
     static float outlineContrastConfidence(const cv::Mat &frame, const Pupil &pupil, const int &bias=5);
     static float edgeRatioConfidence(const cv::Mat &edgeImage, const Pupil &pupil, std::vector<cv::Point> &edgePoints, const int &band=5);
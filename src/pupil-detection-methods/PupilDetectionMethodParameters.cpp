@@ -0,0 +1,216 @@
+
+#include <algorithm>
+#include <cctype>
+
+#include "PupilDetectionMethodParameters.h"
+#include "ElSe.h"
+#include "ExCuSe.h"
+#include "PuRe.h"
+#include "PuReST.h"
+#include "Starburst.h"
+#include "Swirski2D.h"
+#include "Swirski3D.h"
+
+using json = nlohmann::json;
+
+static std::string toLower(std::string str) {
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return std::tolower(c); });
+    return str;
+}
+
+// Reads a numeric (or boolean, as written by the settings widgets) value if the key exists in the parameter set
+static bool getValue(const json &parameterSet, const char *key, double &value) {
+    auto it = parameterSet.find(key);
+    if(it == parameterSet.end())
+        return false;
+    if(it->is_boolean()) {
+        value = it->get<bool>() ? 1.0 : 0.0;
+        return true;
+    }
+    if(it->is_number()) {
+        value = it->get<double>();
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+static void setIfPresent(const json &parameterSet, const char *key, T &field) {
+    double value;
+    if(getValue(parameterSet, key, value))
+        field = static_cast<T>(value);
+}
+
+static void setIfPresent(const json &parameterSet, const char *key, bool &field) {
+    double value;
+    if(getValue(parameterSet, key, value))
+        field = value != 0.0;
+}
+
+PupilDetectionMethod *PupilDetectionMethodParameters::create(const std::string &algorithm) {
+    const std::string name = toLower(algorithm);
+    if(name == "else")
+        return new ElSe();
+    if(name == "excuse")
+        return new ExCuSe();
+    if(name == "pure")
+        return new PuRe();
+    if(name == "purest")
+        return new PuReST();
+    if(name == "starburst")
+        return new Starburst();
+    if(name == "swirski2d")
+        return new Swirski2D();
+    if(name == "swirski3d")
+        return new Swirski3D();
+    return nullptr;
+}
+
+std::vector<std::string> PupilDetectionMethodParameters::algorithmNames() {
+    return {"ElSe", "ExCuSe", "PuRe", "PuReST", "Starburst", "Swirski2D", "Swirski3D"};
+}
+
+// The keys correspond to the ones read by loadSettingsFromFile() of the respective *Settings widget
+// NOTE: PuReST derives from PuRe, so it has to be checked first
+bool PupilDetectionMethodParameters::apply(PupilDetectionMethod *method, const json &parameterSet) {
+
+    if(!method || !parameterSet.is_object())
+        return false;
+
+    if(ElSe *p = dynamic_cast<ElSe*>(method)) {
+        setIfPresent(parameterSet, "minAreaRatio", p->minAreaRatio);
+        setIfPresent(parameterSet, "maxAreaRatio", p->maxAreaRatio);
+    } else if(ExCuSe *p = dynamic_cast<ExCuSe*>(method)) {
+        setIfPresent(parameterSet, "max_ellipse_radi", p->max_ellipse_radi);
+        setIfPresent(parameterSet, "good_ellipse_threshold", p->good_ellipse_threshold);
+    } else if(PuRe *p = dynamic_cast<PuRe*>(method)) {
+        setIfPresent(parameterSet, "meanCanthiDistanceMM", p->meanCanthiDistanceMM);
+        setIfPresent(parameterSet, "minPupilDiameterMM", p->minPupilDiameterMM);
+        setIfPresent(parameterSet, "maxPupilDiameterMM", p->maxPupilDiameterMM);
+        setIfPresent(parameterSet, "baseWidth", p->baseSize.width);
+        setIfPresent(parameterSet, "baseHeight", p->baseSize.height);
+    } else if(Starburst *p = dynamic_cast<Starburst*>(method)) {
+        setIfPresent(parameterSet, "edge_threshold", p->edge_threshold);
+        setIfPresent(parameterSet, "rays", p->rays);
+        setIfPresent(parameterSet, "min_feature_candidates", p->min_feature_candidates);
+        setIfPresent(parameterSet, "corneal_reflection_ratio_to_image_size", p->corneal_reflection_ratio_to_image_size);
+        setIfPresent(parameterSet, "crWindowSize", p->crWindowSize);
+    } else if(Swirski2D *p = dynamic_cast<Swirski2D*>(method)) {
+        setIfPresent(parameterSet, "Radius_Min", p->params.Radius_Min);
+        setIfPresent(parameterSet, "Radius_Max", p->params.Radius_Max);
+        setIfPresent(parameterSet, "CannyBlur", p->params.CannyBlur);
+        setIfPresent(parameterSet, "CannyThreshold1", p->params.CannyThreshold1);
+        setIfPresent(parameterSet, "CannyThreshold2", p->params.CannyThreshold2);
+        setIfPresent(parameterSet, "StarburstPoints", p->params.StarburstPoints);
+        setIfPresent(parameterSet, "PercentageInliers", p->params.PercentageInliers);
+        setIfPresent(parameterSet, "InlierIterations", p->params.InlierIterations);
+        setIfPresent(parameterSet, "EarlyTerminationPercentage", p->params.EarlyTerminationPercentage);
+        setIfPresent(parameterSet, "ImageAwareSupport", p->params.ImageAwareSupport);
+        setIfPresent(parameterSet, "EarlyRejection", p->params.EarlyRejection);
+    } else if(Swirski3D *p = dynamic_cast<Swirski3D*>(method)) {
+        // The parameters of the wrapped 2D detection share the parameter set
+        apply(p->pupilDetector, parameterSet);
+        setIfPresent(parameterSet, "FocalLength", p->params.FocalLength);
+        setIfPresent(parameterSet, "ObservationCount", p->params.ObservationCount);
+        setIfPresent(parameterSet, "RefineWithRegionContrast", p->params.RefineWithRegionContrast);
+        setIfPresent(parameterSet, "RegionBandWidth", p->params.RegionBandWidth);
+        setIfPresent(parameterSet, "RegionStepEpsilon", p->params.RegionStepEpsilon);
+        setIfPresent(parameterSet, "ReliabilityThreshold", p->params.ReliabilityThreshold);
+        p->resetModel();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+json PupilDetectionMethodParameters::read(PupilDetectionMethod *method) {
+
+    json parameterSet = json::object();
+
+    if(ElSe *p = dynamic_cast<ElSe*>(method)) {
+        parameterSet["minAreaRatio"] = p->minAreaRatio;
+        parameterSet["maxAreaRatio"] = p->maxAreaRatio;
+    } else if(ExCuSe *p = dynamic_cast<ExCuSe*>(method)) {
+        parameterSet["max_ellipse_radi"] = p->max_ellipse_radi;
+        parameterSet["good_ellipse_threshold"] = p->good_ellipse_threshold;
+    } else if(PuRe *p = dynamic_cast<PuRe*>(method)) {
+        parameterSet["meanCanthiDistanceMM"] = p->meanCanthiDistanceMM;
+        parameterSet["minPupilDiameterMM"] = p->minPupilDiameterMM;
+        parameterSet["maxPupilDiameterMM"] = p->maxPupilDiameterMM;
+        parameterSet["baseWidth"] = p->baseSize.width;
+        parameterSet["baseHeight"] = p->baseSize.height;
+    } else if(Starburst *p = dynamic_cast<Starburst*>(method)) {
+        parameterSet["edge_threshold"] = p->edge_threshold;
+        parameterSet["rays"] = p->rays;
+        parameterSet["min_feature_candidates"] = p->min_feature_candidates;
+        parameterSet["corneal_reflection_ratio_to_image_size"] = p->corneal_reflection_ratio_to_image_size;
+        parameterSet["crWindowSize"] = p->crWindowSize;
+    } else if(Swirski2D *p = dynamic_cast<Swirski2D*>(method)) {
+        parameterSet["Radius_Min"] = p->params.Radius_Min;
+        parameterSet["Radius_Max"] = p->params.Radius_Max;
+        parameterSet["CannyBlur"] = p->params.CannyBlur;
+        parameterSet["CannyThreshold1"] = p->params.CannyThreshold1;
+        parameterSet["CannyThreshold2"] = p->params.CannyThreshold2;
+        parameterSet["StarburstPoints"] = p->params.StarburstPoints;
+        parameterSet["PercentageInliers"] = p->params.PercentageInliers;
+        parameterSet["InlierIterations"] = p->params.InlierIterations;
+        parameterSet["EarlyTerminationPercentage"] = p->params.EarlyTerminationPercentage;
+        parameterSet["ImageAwareSupport"] = p->params.ImageAwareSupport;
+        parameterSet["EarlyRejection"] = p->params.EarlyRejection;
+    } else if(Swirski3D *p = dynamic_cast<Swirski3D*>(method)) {
+        parameterSet = read(p->pupilDetector);
+        parameterSet["FocalLength"] = p->params.FocalLength;
+        parameterSet["ObservationCount"] = p->params.ObservationCount;
+        parameterSet["RefineWithRegionContrast"] = p->params.RefineWithRegionContrast;
+        parameterSet["RegionBandWidth"] = p->params.RegionBandWidth;
+        parameterSet["RegionStepEpsilon"] = p->params.RegionStepEpsilon;
+        parameterSet["ReliabilityThreshold"] = p->params.ReliabilityThreshold;
+    }
+    return parameterSet;
+}
+
+// Bounds enclose the default and the ROI dependent presets of the *Settings widgets with some margin
+// The pixel based parameters (ExCuSe, Starburst, Swirski2D) refer to the size of the (ROI cropped) image
+// NOTE: PuRe base size is not tuned, it only defines the internal working resolution
+std::vector<ParameterRange> PupilDetectionMethodParameters::searchSpace(const std::string &algorithm) {
+    const std::string name = toLower(algorithm);
+    if(name == "else")
+        return {
+            {"minAreaRatio", 0.0005, 0.05, false, "maxAreaRatio"},
+            {"maxAreaRatio", 0.02, 0.9, false, ""}
+        };
+    if(name == "excuse")
+        return {
+            {"max_ellipse_radi", 20, 250, true, ""},
+            {"good_ellipse_threshold", 0, 40, true, ""}
+        };
+    if(name == "pure" || name == "purest")
+        return {
+            {"meanCanthiDistanceMM", 20.0, 100.0, false, ""},
+            {"minPupilDiameterMM", 0.1, 6.0, false, "maxPupilDiameterMM"},
+            {"maxPupilDiameterMM", 4.0, 20.0, false, ""}
+        };
+    if(name == "starburst")
+        return {
+            {"edge_threshold", 5, 100, true, ""},
+            {"rays", 4, 36, true, ""},
+            {"min_feature_candidates", 1, 15, true, ""},
+            {"corneal_reflection_ratio_to_image_size", 1, 12, true, ""},
+            {"crWindowSize", 51, 501, true, ""}
+        };
+    if(name == "swirski2d")
+        return {
+            {"Radius_Min", 5, 60, true, "Radius_Max"},
+            {"Radius_Max", 30, 150, true, ""},
+            {"CannyBlur", 0.1, 6.0, false, ""},
+            {"CannyThreshold1", 5, 60, true, "CannyThreshold2"},
+            {"CannyThreshold2", 10, 100, true, ""},
+            {"StarburstPoints", 0, 40, true, ""},
+            {"PercentageInliers", 10, 50, true, ""},
+            {"InlierIterations", 1, 10, true, ""},
+            {"EarlyTerminationPercentage", 10, 100, true, ""},
+            {"ImageAwareSupport", 0, 1, true, ""},
+            {"EarlyRejection", 0, 1, true, ""}
+        };
+    return {};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <string>
+#include <vector>
+
+#include "PupilDetectionMethod.h"
+#include "../subwindows/pupil-detection-methods/json.h"
+
+/**
+    Range of one tunable parameter of an algorithm, used to span the search space of the automatic parameter search
+
+    key: name of the parameter in the "Parameter Set"
+    min, max: inclusive bounds
+    integer: value must be rounded, also used for boolean switches with range [0,1]
+    lessThan: key of a parameter this one must stay below (e.g. a minimum radius and its maximum), empty if unconstrained
+*/
+struct ParameterRange {
+    std::string key;
+    double min;
+    double max;
+    bool integer;
+    std::string lessThan;
+};
+
+/**
+    Creates pupil detection algorithms by name and transfers their tunable parameters from/to the "Parameter Set"
+    JSON format, which is the same format the algorithm settings widgets load with "Load config file"
+
+    This allows using the algorithms outside of the GUI, e.g. in headless evaluation or parameter optimization runs.
+
+    create(): creates a new instance of the named algorithm (case-insensitive title), nullptr if unknown
+    algorithmNames(): titles of all algorithms that can be created
+    apply(): sets the parameters present in the given parameter set on the algorithm, unknown keys are ignored
+    read(): returns the current parameters of the algorithm as parameter set
+    searchSpace(): ranges of the parameters worth tuning for the named algorithm, empty if unknown
+*/
+class PupilDetectionMethodParameters {
+
+public:
+
+    static PupilDetectionMethod *create(const std::string &algorithm);
+    static std::vector<std::string> algorithmNames();
+
+    static bool apply(PupilDetectionMethod *method, const nlohmann::json &parameterSet);
+    static nlohmann::json read(PupilDetectionMethod *method);
+
+    static std::vector<ParameterRange> searchSpace(const std::string &algorithm);
+
+};
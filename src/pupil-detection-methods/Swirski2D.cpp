@@ -24,6 +24,7 @@ Modified by Moritz Lode 2020
 */
 
 #include "Swirski2D.h"
+#include "HaarSurroundLocalizer.h"
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgproc.hpp>
 
@@ -37,7 +38,6 @@ Modified by Moritz Lode 2020
 #include <algorithm>
 
 const double SQRT_2 = std::sqrt(2.0);
-const cv::Point2f UNKNOWN_POSITION = cv::Point2f(-1, -1);
 
 template <typename T>
 inline cv::Rect_<T> roiAround(T x, T y, T radius)
@@ -283,8 +283,6 @@ void Swirski2D::run(const cv::Mat &frame, Pupil &pupil)
 cv::Rect Swirski2D::findMaxHaarResponse(const cv::Mat &frame)
 {
 
-    cv::Mat_<uchar> mEye = frame;
-
     // -----------------------
     // Find best haar response
     // -----------------------
@@ -307,125 +305,17 @@ cv::Rect Swirski2D::findMaxHaarResponse(const cv::Mat &frame)
     // |_________________________|
     //
 
-    cv::Mat_<int32_t> mEyeIntegral;
-    int padding = 2 * params.Radius_Max;
-
-    cv::Mat mEyePad;
-    // Need to pad by an additional 1 to get bottom & right edges.
-    cv::copyMakeBorder(mEye, mEyePad, padding, padding, padding, padding, cv::BORDER_REPLICATE);
-    cv::integral(mEyePad, mEyeIntegral);
-
-    cv::Point2f pHaarPupil;
-    int haarRadius = 0;
-
-    const int rstep = 2;
-    const int ystep = 4;
-    const int xstep = 4;
-
-    double minResponse = std::numeric_limits<double>::infinity();
-
-    for (int r = params.Radius_Min; r < params.Radius_Max; r += rstep)
-    {
-        // Get Haar feature
-        int r_inner = r;
-        int r_outer = 3 * r;
-        HaarSurroundFeature f(r_inner, r_outer);
-
-        // Use TBB for rows
-        std::pair<double, cv::Point2f> minRadiusResponse = tbb::parallel_reduce(
-            tbb::blocked_range<int>(0, (mEye.rows - r - r - 1) / ystep + 1,
-                                    ((mEye.rows - r - r - 1) / ystep + 1) / 8),
-            std::make_pair(std::numeric_limits<double>::infinity(), UNKNOWN_POSITION),
-            [&](tbb::blocked_range<int> range,
-                const std::pair<double, cv::Point2f> &minValIn) -> std::pair<double, cv::Point2f>
-            {
-                std::pair<double, cv::Point2f> minValOut = minValIn;
-                for (int i = range.begin(), y = r + range.begin() * ystep; i < range.end(); i++, y += ystep)
-                {
-                    //            �         �
-                    // row1_outer.|         |  p00._____________________.p01
-                    //            |         |     |         Haar kernel |
-                    //            |         |     |                     |
-                    // row1_inner.|         |     |   p00._______.p01   |
-                    //            |-padding-|     |      |       |      |
-                    //            |         |     |      | (x,y) |      |
-                    // row2_inner.|         |     |      |_______|      |
-                    //            |         |     |   p10'       'p11   |
-                    //            |         |     |                     |
-                    // row2_outer.|         |     |_____________________|
-                    //            |         |  p10'                     'p11
-                    //            �         �
-
-                    int *row1_inner = mEyeIntegral[y + padding - r_inner];
-                    int *row2_inner = mEyeIntegral[y + padding + r_inner + 1];
-                    int *row1_outer = mEyeIntegral[y + padding - r_outer];
-                    int *row2_outer = mEyeIntegral[y + padding + r_outer + 1];
-
-                    int *p00_inner = row1_inner + r + padding - r_inner;
-                    int *p01_inner = row1_inner + r + padding + r_inner + 1;
-                    int *p10_inner = row2_inner + r + padding - r_inner;
-                    int *p11_inner = row2_inner + r + padding + r_inner + 1;
-
-                    int *p00_outer = row1_outer + r + padding - r_outer;
-                    int *p01_outer = row1_outer + r + padding + r_outer + 1;
-                    int *p10_outer = row2_outer + r + padding - r_outer;
-                    int *p11_outer = row2_outer + r + padding + r_outer + 1;
-
-                    for (int x = r; x < mEye.cols - r; x += xstep)
-                    {
-                        int sumInner = *p00_inner + *p11_inner - *p01_inner - *p10_inner;
-                        int sumOuter = *p00_outer + *p11_outer - *p01_outer - *p10_outer - sumInner;
-
-                        double response = f.val_inner * sumInner + f.val_outer * sumOuter;
-
-                        if (response < minValOut.first)
-                        {
-                            minValOut.first = response;
-                            minValOut.second = cv::Point(x, y);
-                        }
-
-                        p00_inner += xstep;
-                        p01_inner += xstep;
-                        p10_inner += xstep;
-                        p11_inner += xstep;
-
-                        p00_outer += xstep;
-                        p01_outer += xstep;
-                        p10_outer += xstep;
-                        p11_outer += xstep;
-                    }
-                }
-                return minValOut;
-            },
-            [](const std::pair<double, cv::Point2f> &x,
-               const std::pair<double, cv::Point2f> &y) -> std::pair<double, cv::Point2f>
-            {
-                if (x.first < y.first)
-                    return x;
-                else
-                    return y;
-            });
-
-        if (minRadiusResponse.first < minResponse)
-        {
-            minResponse = minRadiusResponse.first;
-            // Set return values
-            pHaarPupil = minRadiusResponse.second;
-            haarRadius = r;
-        }
-    }
+    // The image is padded by 2*Radius_Max, so the kernel can reach over the border of the search region
+    HaarSurroundLocalizer localizer(frame, 2 * params.Radius_Max);
+    HaarSurroundLocalizer::Location haarPupil = localizer.findMinimum(params.Radius_Min, params.Radius_Max);
 
     // Paradoxically, a good Haar fit won't catch the entire pupil, so expand it a bit
-    haarRadius = (int)(haarRadius * SQRT_2);
+    int haarRadius = (int)(haarPupil.radius * SQRT_2);
 
     // ---------------------------
     // Pupil ROI around Haar point
     // ---------------------------
-    cv::Rect roiHaarPupil = roiAround(cv::Point(pHaarPupil.x, pHaarPupil.y), haarRadius);
-    //cv::Mat_<uchar> mHaarPupil;
-    //getROI(mEye, mHaarPupil, roiHaarPupil, cv::BORDER_REPLICATE);
-
-    return roiHaarPupil;
+    return roiAround(haarPupil.centre, haarRadius);
 }
 
 void Swirski2D::run(const cv::Mat &frame, Pupil &pupil, std::vector<cv::Point2f> &inlierPts)
@@ -451,140 +341,11 @@ void Swirski2D::run(const cv::Mat &frame, Pupil &pupil, std::vector<cv::Point2f>
     //        throw std::runtime_error("Unsupported number of channels");
     //    }
 
-    // -----------------------
-    // Find best haar response
-    // -----------------------
-
-    //             _____________________
-    //            |         Haar kernel |
-    //            |                     |
-    //  __________|______________       |
-    // | Image    |      |       |      |
-    // |    ______|______|___.-r-|--2r--|
-    // |   |      |      |___|___|      |
-    // |   |      |          |   |      |
-    // |   |      |          |   |      |
-    // |   |      |__________|___|______|
-    // |   |    Search       |   |
-    // |   |    region       |   |
-    // |   |                 |   |
-    // |   |_________________|   |
-    // |                         |
-    // |_________________________|
-    //
-
-    cv::Mat_<int32_t> mEyeIntegral;
-    int padding = 2 * params.Radius_Max;
-
-    cv::Mat mEyePad;
-    // Need to pad by an additional 1 to get bottom & right edges.
-    cv::copyMakeBorder(mEye, mEyePad, padding, padding, padding, padding, cv::BORDER_REPLICATE);
-    cv::integral(mEyePad, mEyeIntegral);
-
-    cv::Point2f pHaarPupil;
-    int haarRadius = 0;
-
-    const int rstep = 2;
-    const int ystep = 4;
-    const int xstep = 4;
-
-    double minResponse = std::numeric_limits<double>::infinity();
-
-    for (int r = params.Radius_Min; r < params.Radius_Max; r += rstep)
-    {
-        // Get Haar feature
-        int r_inner = r;
-        int r_outer = 3 * r;
-        HaarSurroundFeature f(r_inner, r_outer);
-
-        // Use TBB for rows
-        std::pair<double, cv::Point2f> minRadiusResponse = tbb::parallel_reduce(
-            tbb::blocked_range<int>(0, (mEye.rows - r - r - 1) / ystep + 1, ((mEye.rows - r - r - 1) / ystep + 1) / 8),
-            std::make_pair(std::numeric_limits<double>::infinity(), UNKNOWN_POSITION),
-            [&](tbb::blocked_range<int> range, const std::pair<double, cv::Point2f> &minValIn) -> std::pair<double, cv::Point2f>
-            {
-                std::pair<double, cv::Point2f> minValOut = minValIn;
-                for (int i = range.begin(), y = r + range.begin() * ystep; i < range.end(); i++, y += ystep)
-                {
-                    //            �         �
-                    // row1_outer.|         |  p00._____________________.p01
-                    //            |         |     |         Haar kernel |
-                    //            |         |     |                     |
-                    // row1_inner.|         |     |   p00._______.p01   |
-                    //            |-padding-|     |      |       |      |
-                    //            |         |     |      | (x,y) |      |
-                    // row2_inner.|         |     |      |_______|      |
-                    //            |         |     |   p10'       'p11   |
-                    //            |         |     |                     |
-                    // row2_outer.|         |     |_____________________|
-                    //            |         |  p10'                     'p11
-                    //            �         �
-
-                    int *row1_inner = mEyeIntegral[y + padding - r_inner];
-                    int *row2_inner = mEyeIntegral[y + padding + r_inner + 1];
-                    int *row1_outer = mEyeIntegral[y + padding - r_outer];
-                    int *row2_outer = mEyeIntegral[y + padding + r_outer + 1];
-
-                    int *p00_inner = row1_inner + r + padding - r_inner;
-                    int *p01_inner = row1_inner + r + padding + r_inner + 1;
-                    int *p10_inner = row2_inner + r + padding - r_inner;
-                    int *p11_inner = row2_inner + r + padding + r_inner + 1;
-
-                    int *p00_outer = row1_outer + r + padding - r_outer;
-                    int *p01_outer = row1_outer + r + padding + r_outer + 1;
-                    int *p10_outer = row2_outer + r + padding - r_outer;
-                    int *p11_outer = row2_outer + r + padding + r_outer + 1;
-
-                    for (int x = r; x < mEye.cols - r; x += xstep)
-                    {
-                        int sumInner = *p00_inner + *p11_inner - *p01_inner - *p10_inner;
-                        int sumOuter = *p00_outer + *p11_outer - *p01_outer - *p10_outer - sumInner;
-
-                        double response = f.val_inner * sumInner + f.val_outer * sumOuter;
-
-                        if (response < minValOut.first)
-                        {
-                            minValOut.first = response;
-                            minValOut.second = cv::Point(x, y);
-                        }
-
-                        p00_inner += xstep;
-                        p01_inner += xstep;
-                        p10_inner += xstep;
-                        p11_inner += xstep;
-
-                        p00_outer += xstep;
-                        p01_outer += xstep;
-                        p10_outer += xstep;
-                        p11_outer += xstep;
-                    }
-                }
-                return minValOut;
-            },
-            [](const std::pair<double, cv::Point2f> &x, const std::pair<double, cv::Point2f> &y) -> std::pair<double, cv::Point2f>
-            {
-                if (x.first < y.first)
-                    return x;
-                else
-                    return y;
-            });
-
-        if (minRadiusResponse.first < minResponse)
-        {
-            minResponse = minRadiusResponse.first;
-            // Set return values
-            pHaarPupil = minRadiusResponse.second;
-            haarRadius = r;
-        }
-    }
-
-    // Paradoxically, a good Haar fit won't catch the entire pupil, so expand it a bit
-    haarRadius = (int)(haarRadius * SQRT_2);
-
-    // ---------------------------
-    // Pupil ROI around Haar point
-    // ---------------------------
-    cv::Rect roiHaarPupil = roiAround(cv::Point(pHaarPupil.x, pHaarPupil.y), haarRadius);
+    // ---------------------------------------
+    // Pupil ROI around the best Haar response
+    // ---------------------------------------
+    cv::Rect roiHaarPupil = findMaxHaarResponse(mEye);
+    int haarRadius = (roiHaarPupil.width - 1) / 2;
     cv::Mat_<uchar> mHaarPupil;
     getROI(mEye, mHaarPupil, roiHaarPupil, cv::BORDER_REPLICATE);
 
@@ -1164,5 +925,8 @@ void Swirski2D::run(const cv::Mat &frame, const cv::Rect &roi, Pupil &pupil, con
     (void)minPupilDiameterPx;
     (void)maxPupilDiameterPx;
 
+    // The pupil is expected in frame coordinates, as for the other algorithms
     pupil = run(frame(roi));
+    if (pupil.center.x > 0 && pupil.center.y > 0)
+        pupil.shift(roi.tl());
 }
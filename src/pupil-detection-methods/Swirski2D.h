@@ -99,54 +99,6 @@ public:
 
 };
 
-class HaarSurroundFeature {
-
-public:
-
-    HaarSurroundFeature(int r1, int r2) : r_inner(r1), r_outer(r2) {
-        //  _________________
-        // |        -ve      |
-        // |     _______     |
-        // |    |   +ve |    |
-        // |    |   .   |    |
-        // |    |_______|    |
-        // |         <r1>    |
-        // |_________<--r2-->|
-
-        // Number of pixels in each part of the kernel
-        int count_inner = r_inner*r_inner;
-        int count_outer = r_outer*r_outer - r_inner*r_inner;
-
-        // Frobenius normalized values
-        //
-        // Want norm = 1 where norm = sqrt(sum(pixelvals^2)), so:
-        //  sqrt(count_inner*val_inner^2 + count_outer*val_outer^2) = 1
-        //
-        // Also want sum(pixelvals) = 0, so:
-        //  count_inner*val_inner + count_outer*val_outer = 0
-        //
-        // Solving both of these gives:
-        //val_inner = std::sqrt( (double)count_outer/(count_inner*count_outer + sq(count_inner)) );
-        //val_outer = -std::sqrt( (double)count_inner/(count_inner*count_outer + sq(count_outer)) );
-
-        // Square radius normalised values
-        //
-        // Want the response to be scale-invariant, so scale it by the number of pixels inside it:
-        //  val_inner = 1/count = 1/r_outer^2
-        //
-        // Also want sum(pixelvals) = 0, so:
-        //  count_inner*val_inner + count_outer*val_outer = 0
-        //
-        // Hence:
-        val_inner = 1.0 / (r_inner*r_inner);
-        val_outer = -val_inner*count_inner/count_outer;
-
-    }
-
-    double val_inner, val_outer;
-    int r_inner, r_outer;
-};
-
 template<typename T>
 class ConicSection_ {
 
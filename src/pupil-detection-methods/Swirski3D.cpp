@@ -26,6 +26,24 @@ Modified by Moritz Lode 2020
 #include "Swirski3D.h"
 #include "PupilDetectionMethod.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    // Cap of the per bin pupil count: the replacement probability of a bin's observation does not drop below 1/maxBinSeen,
+    // so the reservoir keeps following a long session instead of freezing on its first minutes
+    const int maxBinSeen = 100;
+}
+
+Swirski3D::~Swirski3D()
+{
+    if (fittingThread.joinable())
+        fittingThread.join();
+    delete pupilDetector;
+}
+
 Pupil Swirski3D::run(const cv::Mat &frame)
 {
 
@@ -46,147 +64,244 @@ Pupil Swirski3D::run(const cv::Mat &frame)
     }
 
     bool pupil_found = rr_pf.valid(-2.0); // -2.0 because we ignore confidence for this check
+    if (!pupil_found)
+        return rr_pf;
 
-    std::cout << "Pupil found: " << pupil_found << " " << inlier_pts.size() << std::endl;
+    // The model lives in the coordinates of the image centre, another image size (ROI) invalidates it
+    if (resetRequested.exchange(false) || frame.size() != modelImageSize)
+        startNewModel(frame.size());
 
     singleeyefitter::Ellipse2D<double> el = singleeyefitter::toEllipse<double>(toImgCoordInv(rr_pf, frame, 1.0));
 
-    // found pupil is then feed to model, for generation
-
-    // 3D eye pose estimation
-    bool is_reliable = false;
-    bool is_added = false;
-    const bool force_add = false;
-
-    const double kReliabilityThreshold = 0.8; // 0.96;
-    double ellipse_reliability = 0.0;         /// Reliability of a detected 2D ellipse based on 3D eye model
-
-    if (pupil_found)
+    // 3D eye pose estimation with the current model
+    if (isModelBuilt())
     {
-        if (is_model_built())
-        {
-            ellipse_reliability = compute_reliability(frame, el, inlier_pts);
-            is_reliable = (ellipse_reliability > kReliabilityThreshold);
-            std::cout << "Reliability: " << is_reliable << " " << ellipse_reliability << std::endl;
-        }
-        else
-        {
-            std::cout << "Sampling observation for building." << std::endl;
-            add_observation(frame, el, inlier_pts, force_add);
-        }
+        double ellipse_reliability = 0.0; /// Reliability of a detected 2D ellipse based on 3D eye model
+        sef::EyeModelFitter::Circle curr_circle = unproject(el, inlier_pts, ellipse_reliability);
+
+        if (curr_circle && ellipse_reliability > params.ReliabilityThreshold)
+            rr_pf.physicalDiameter = static_cast<float>(2.0 * curr_circle.radius);
     }
 
+    // The found pupil is offered to the reservoir, also after the model is built to keep updating it
+    add_observation(frame, el, inlier_pts);
+
     return rr_pf;
 }
 
+// The eye model is fitted in the coordinates of the whole frame, a search window changing from frame to frame would reset it every time,
+// so the window is ignored and the whole frame is searched. The pupil is in frame coordinates either way
 void Swirski3D::run(const cv::Mat &frame, const cv::Rect &roi, Pupil &pupil, const float &minPupilDiameterPx, const float &maxPupilDiameterPx)
 {
+    (void)roi;
+    (void)minPupilDiameterPx;
+    (void)maxPupilDiameterPx;
+
+    pupil = run(frame);
+}
 
-    // TODO we could use minPupilDiameterPx for setting minRadius etc., but how reset?
+void Swirski3D::resetModel()
+{
+    resetRequested = true;
+}
 
-    if (roi.area() < 10)
+// A running fit is not waited for, its results are dropped as the generation and model version changed
+void Swirski3D::startNewModel(const cv::Size &imageSize)
+{
     {
-        std::cout << "Bad ROI: falling back to regular detection.";
-        PupilDetectionMethod::run(frame, pupil);
-        return;
+        std::lock_guard<std::mutex> lock_model(modelFitter.model_mutex);
+        modelGeneration++;
+        modelFitter.model_version++;
+        modelBuilt = false;
     }
 
-    (void)minPupilDiameterPx;
-    (void)maxPupilDiameterPx;
+    reservoir.clear();
+    freshCount = 0;
+    modelImageSize = imageSize;
 
-    pupil = run(frame(roi));
+    spaceBinSearcher.reset(new SpaceBinSearcher(imageSize.width, imageSize.height));
 }
 
-bool Swirski3D::add_observation(const cv::Mat &image, sef::Ellipse2D<double> &pupil, std::vector<cv::Point2f> &pupil_inliers, bool force)
+bool Swirski3D::add_observation(const cv::Mat &image, sef::Ellipse2D<double> &pupil, std::vector<cv::Point2f> &pupil_inliers)
 {
+    const size_t capacity = static_cast<size_t>(std::max(2, params.ObservationCount));
 
-    if (!spaceBinSearcher.is_initialized())
-    {
-        spaceBinSearcher.initialize(image.cols, image.rows);
-    }
+    frameCount++;
 
-    bool is_added = false;
+    const int bin = spaceBinSearcher->find_bin(
+            (int)(pupil.centre.x() + image.cols / 2),
+            (int)(pupil.centre.y() + image.rows / 2));
 
-    if (force || (!is_model_built_ && fitter_count < fitter_max_count))
-    {
-        cv::Vec2i pt;
-        float dist;
+    auto slot = std::find_if(reservoir.begin(), reservoir.end(), [bin](const ReservoirSlot &s) { return s.bin == bin; });
 
-        // Check if we already added a 2D ellipse close to the current 2D ellipse given
-        if (force || spaceBinSearcher.search(
-                         (int)(pupil.centre.x() + image.cols / 2),
-                         (int)(pupil.centre.y() + image.rows / 2), pt, dist))
-        {
+    if (slot != reservoir.end())
+    {
+        slot->lastSeen = frameCount;
+        slot->seen = std::min(slot->seen + 1, maxBinSeen);
 
-            modelFitter.add_observation(image, pupil, pupil_inliers);
-            fitter_count++;
+        // Reservoir sampling within the bin, the pupil replaces the kept one with probability 1/seen
+        if (std::uniform_int_distribution<int>(1, slot->seen)(reservoirRandom) != 1)
+            return false;
 
-            std::cout << "Observation added to model." << std::endl;
+        slot->observation = cropObservation(image, pupil, pupil_inliers);
+        if (!slot->fresh)
+        {
+            slot->fresh = true;
+            freshCount++;
+        }
+    }
+    else
+    {
+        ReservoirSlot newSlot{bin, cropObservation(image, pupil, pupil_inliers), 1, frameCount, true};
 
-            if (fitter_count == fitter_max_count)
+        if (reservoir.size() < capacity)
+        {
+            reservoir.push_back(std::move(newSlot));
+        }
+        else
+        {
+            // Evict the bin not hit for the longest time, the gaze may have left it for good. Fresh ones wait for their fit
+            auto oldest = reservoir.end();
+            for (auto it = reservoir.begin(); it != reservoir.end(); ++it)
             {
-                modelFitter.unproject_observations();
-                modelFitter.initialise_model();
-                is_model_built_ = true;
-                std::cout << "Model finished building." << std::endl;
+                if (!it->fresh && (oldest == reservoir.end() || it->lastSeen < oldest->lastSeen))
+                    oldest = it;
             }
-            is_added = true;
+            if (oldest == reservoir.end())
+                return false;
+
+            *oldest = std::move(newSlot);
         }
+        freshCount++;
     }
 
-    return is_added;
+    // Fit once the reservoir is full, and again whenever a quarter of it was refreshed. The fit of an outdated model has to finish first
+    if (fitting || reservoir.size() < capacity || freshCount < std::max<int>(1, static_cast<int>(capacity) / 4))
+        return true;
+
+    if (fittingThread.joinable())
+        fittingThread.join();
+
+    // The crops are shared with the fit, they are never written to, only replaced
+    std::vector<sef::EyeModelFitter::Observation> fitObservations;
+    fitObservations.reserve(reservoir.size());
+    for (ReservoirSlot &reservoirSlot : reservoir)
+    {
+        fitObservations.push_back(reservoirSlot.observation);
+        reservoirSlot.fresh = false;
+    }
+    freshCount = 0;
+
+    Swirski3DParams fitParams = params;
+    if (fitParams.FocalLength <= 0)
+        fitParams.FocalLength = modelImageSize.width;
+
+    const bool warmStart = isModelBuilt();
+    fitting = true;
+    fittingThread = std::thread(&Swirski3D::fitModel, this, std::move(fitObservations), modelGeneration, fitParams, warmStart);
+
+    return true;
 }
 
-double Swirski3D::compute_reliability(const cv::Mat &img, sef::Ellipse2D<double> &el, std::vector<cv::Point2f> &inlier_pts)
+// Crop around the pupil holding what the region contrast term reads: the ellipse with its inner and outer band, with room for
+// the refinement to move and grow the ellipse
+sef::EyeModelFitter::Observation Swirski3D::cropObservation(const cv::Mat &image, const sef::Ellipse2D<double> &pupil, const std::vector<cv::Point2f> &pupil_inliers) const
 {
-    double realiabiliy = 0.0;
+    const cv::Point imageCentre(image.cols / 2, image.rows / 2);
+    const double margin = 1.5 * pupil.major_radius + params.RegionBandWidth + params.RegionStepEpsilon + 2;
 
-    if (modelFitter.eye)
-    {
+    cv::Rect crop(cvFloor(pupil.centre.x() + imageCentre.x - margin), cvFloor(pupil.centre.y() + imageCentre.y - margin),
+                  cvCeil(2 * margin), cvCeil(2 * margin));
+    crop &= cv::Rect(cv::Point(), image.size());
 
-        // Unproject the current 2D ellipse observation to a 3D disk
-        sef::EyeModelFitter::Circle curr_circle = unproject(img, el, inlier_pts);
+    // The crop is copied, as the frame buffer is reused by the camera
+    return sef::EyeModelFitter::Observation(image(crop).clone(), imageCentre - crop.tl(), pupil, pupil_inliers);
+}
 
-        if (curr_circle && !isnan(curr_circle.normal(0, 0)))
-        {
-            const double displayscale = 1.0;
+// Runs on the fitting thread. The model is fitted into a separate EyeModelFitter, so the detection keeps unprojecting with the current
+// model meanwhile, and only swapped in under the model_mutex if the fit succeeded and the model was not reset. The detection thread only
+// reads the eye, and only once modelBuilt is set for the current generation
+void Swirski3D::fitModel(std::vector<sef::EyeModelFitter::Observation> fitObservations, int generation, Swirski3DParams fitParams, bool warmStart)
+{
+    try
+    {
+        sef::EyeModelFitter candidate(fitParams.FocalLength, fitParams.RegionBandWidth, fitParams.RegionStepEpsilon);
 
-            sef::Ellipse2D<double> pupil_el(sef::project(curr_circle, focal_length));
-            realiabiliy = el.similarity(pupil_el);
+        // An update keeps the eye centre of the built model, only a first fit or a failed update searches it from scratch
+        bool updated = false;
+        if (warmStart)
+        {
+            {
+                std::lock_guard<std::mutex> lock_model(modelFitter.model_mutex);
+                candidate.eye = modelFitter.eye;
+            }
+            // The observations are still needed for a refit if they disagree with the model, their crops are only shared
+            updated = candidate.update_model(fitObservations);
+        }
 
-            //// 3D eyeball
-            //cv::RotatedRect rr_eye = eye_tracker::toImgCoord(sef::toRotatedRect(sef::project(simple_fitter_.eye, focal_length_)), img, displayscale);
+        if (!updated)
+        {
+            candidate.reset();
+            for (sef::EyeModelFitter::Observation &observation : fitObservations)
+                candidate.add_observation(std::move(observation));
 
-            //// 3D pupil
-            //singleeyefitter::Ellipse2D<double> pupil_el(sef::project(curr_circle, focal_length_));
-            //cv::RotatedRect rr_pupil = eye_tracker::toImgCoord(singleeyefitter::toRotatedRect(pupil_el), img, displayscale);
+            candidate.unproject_observations();
+            candidate.initialise_model();
+        }
 
-            //// 3D gaze vector
-            //singleeyefitter::EyeModelFitter::Circle c_end = curr_circle;
-            //c_end.centre = curr_circle.centre + (10.0)*curr_circle.normal; // Unit: mm
-            //singleeyefitter::Ellipse2D<double> e_end(sef::project(c_end, focal_length_));
-            //cv::RotatedRect rr_end = eye_tracker::toImgCoord(singleeyefitter::toRotatedRect(e_end), img, displayscale);
+        bool swapped = false;
+        {
+            std::lock_guard<std::mutex> lock_model(modelFitter.model_mutex);
+            if (generation == modelGeneration && candidate.eye)
+            {
+                modelFitter.focal_length = candidate.focal_length;
+                modelFitter.region_band_width = candidate.region_band_width;
+                modelFitter.region_step_epsilon = candidate.region_step_epsilon;
+                modelFitter.region_threads = std::max(1, fitParams.RegionThreads);
+                modelFitter.eye = candidate.eye;
+                modelFitter.pupils = std::move(candidate.pupils);
+                modelFitter.model_version++;
+                modelBuilt = true;
+                swapped = true;
+            }
         }
+
+        // The refinement only holds the model_mutex to copy the model and to apply the result, which is dropped if the model
+        // was reset meanwhile (model_version)
+        if (fitParams.RefineWithRegionContrast && swapped)
+            modelFitter.refine_with_region_contrast();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Swirski3D: eye model fitting failed: " << e.what() << std::endl;
     }
 
-    return realiabiliy;
+    fitting = false;
 }
 
-sef::EyeModelFitter::Circle Swirski3D::unproject(const cv::Mat &img, sef::Ellipse2D<double> &el, std::vector<cv::Point2f> &inlier_pts)
+sef::EyeModelFitter::Circle Swirski3D::unproject(sef::Ellipse2D<double> &el, std::vector<cv::Point2f> &inlier_pts, double &reliability)
 {
+    reliability = 0.0;
 
-    if (modelFitter.eye)
-    {
-        // Unproject the current 2D ellipse observations
-        sef::EyeModelFitter::Observation curr_obs(img, el, inlier_pts);
-        sef::EyeModelFitter::Pupil curr_pupil(curr_obs);
+    std::lock_guard<std::mutex> lock_model(modelFitter.model_mutex);
+
+    if (!modelFitter.eye)
+        return singleeyefitter::EyeModelFitter::Circle::Null;
 
-        modelFitter.unproject_single_observation(curr_pupil, modelFitter.eye.radius);
-        singleeyefitter::EyeModelFitter::Circle curr_circle = modelFitter.initialise_single_observation(curr_pupil);
+    // Unproject the current 2D ellipse observation to a 3D disk, the image is not needed for it
+    sef::EyeModelFitter::Observation curr_obs(cv::Mat(), el, inlier_pts);
+    sef::EyeModelFitter::Pupil curr_pupil(curr_obs);
 
-        return curr_circle;
+    modelFitter.unproject_single_observation(curr_pupil, modelFitter.eye.radius);
+    singleeyefitter::EyeModelFitter::Circle curr_circle = modelFitter.initialise_single_observation(curr_pupil);
+
+    if (curr_circle && !std::isnan(curr_circle.normal(0, 0)))
+    {
+        sef::Ellipse2D<double> pupil_el(sef::project(curr_circle, modelFitter.focal_length));
+        reliability = el.similarity(pupil_el);
     }
-    return singleeyefitter::EyeModelFitter::Circle::Null;
+
+    return curr_circle;
 }
 
 cv::Point2f Swirski3D::toImgCoord(const cv::Point2f &point, const cv::Mat &m, double scale, int shift)
@@ -249,17 +364,17 @@ void SpaceBinSearcher::initialize(int w, int h)
         return;
     }
 
-    if (w < 0 || h < 0)
+    if (w <= 0 || h <= 0)
     {
-        std::cout << "SpaceBinSearcher: Map size must be positive" << std::endl;
-        throw;
+        throw std::invalid_argument("SpaceBinSearcher: Map size must be positive");
     }
-    const int w_num = w / kSearchGridSize_;
-    const int h_num = h / kSearchGridSize_;
+    // One grid point every kSearchGridSize_ pixels, starting at 0
+    const int w_num = (w + kSearchGridSize_ - 1) / kSearchGridSize_;
+    const int h_num = (h + kSearchGridSize_ - 1) / kSearchGridSize_;
 
     // Create matrices
     ClusterMembers_.create(cv::Size(2, kN_), CV_32S); // The set A
-    sample_num_ = (w_num + 1) * (h_num + 1);
+    sample_num_ = w_num * h_num;
     taken_flags_.resize(sample_num_);
     std::fill(taken_flags_.begin(), taken_flags_.end(), false);
 
@@ -324,12 +439,12 @@ void SpaceBinSearcher::reset_indices()
     std::fill(taken_flags_.begin(), taken_flags_.end(), false);
 }
 
-bool SpaceBinSearcher::search(int x, int y, cv::Vec2i &pt, float &dist)
+// Index of the bin (grid point) nearest to (x,y)
+int SpaceBinSearcher::find_bin(int x, int y)
 {
     if (!is_initialized_)
     {
-        std::cout << "SpaceBinSearcher::search: search tree is not initialized" << std::endl;
-        throw;
+        throw std::logic_error("SpaceBinSearcher::find_bin: search tree is not initialized");
     }
 
     ClusterMembers_.at<int>(0, 0) = x;
@@ -342,20 +457,21 @@ bool SpaceBinSearcher::search(int x, int y, cv::Vec2i &pt, float &dist)
 
     // Search KdTree
     kdtrees->knnSearch(ClusterMembers_, matches, distances, 1, cvflann::SearchParams(8));
-    int NN_index;
-    for (int i = 0; i < kN_; i++)
+    return matches.at<int>(0, 0);
+}
+
+bool SpaceBinSearcher::search(int x, int y, cv::Vec2i &pt, float &dist)
+{
+    const int NN_index = find_bin(x, y);
+    pt = ClusterCenters_.row(NN_index);
+    dist = static_cast<float>((pt[0] - x) * (pt[0] - x) + (pt[1] - y) * (pt[1] - y)); // squared, as the L2 distance of flann
+    if (taken_flags_[NN_index])
     {
-        NN_index = matches.at<int>(i, 0);
-        dist = distances.at<float>(i, 0);
-        pt = ClusterCenters_.row(NN_index);
-        if (taken_flags_[NN_index])
-        {
-            return false; // sample is taken already
-        }
-        else
-        {
-            taken_flags_[NN_index] = true;
-            return true; // newly searched point
-        }
+        return false; // sample is taken already
     }
-}
\ No newline at end of file
+    else
+    {
+        taken_flags_[NN_index] = true;
+        return true; // newly searched point
+    }
+}
@@ -32,9 +32,10 @@ Modified by Moritz Lode 2020
 #include "../../singleeyefitter/singleeyefitter/projection.h"
 #include <opencv2/opencv.hpp>
 
-// needs first training
-// take first N frames for training then classify
-// take N, then classify all again? -> open video again or save frames?
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
 
 namespace sef = singleeyefitter;
 
@@ -52,6 +53,7 @@ public:
     void reset_indices();
 
     bool search(int x, int y, cv::Vec2i &pt, float &dist);
+    int find_bin(int x, int y);
     bool is_initialized(){ return is_initialized_; };
 
 protected:
@@ -70,39 +72,67 @@ protected:
 
 };
 
+struct Swirski3DParams
+{
+    double FocalLength; // [px], 0 uses the image width
+    int ObservationCount;
+    bool RefineWithRegionContrast;
+    double RegionBandWidth;
+    double RegionStepEpsilon;
+    double ReliabilityThreshold;
+    int RegionThreads; // Threads of the region contrast refinement, set by the application from its thread budget, not a detection parameter
+};
 
+/**
+    3D eye model based pupil detection: the pupil is detected in 2D by the wrapped algorithm (Swirski2D by default), its ellipse is
+    unprojected onto a 3D eye model, which gives the gaze corrected pupil diameter (in mm, for an eyeball radius of 12 mm) as physicalDiameter
+
+    The eye model is fitted to a reservoir of at most ObservationCount observations, one per spatial bin of the pupil centre
+    (SpaceBinSearcher), so the observations stay spread over the gaze range. Within a bin, the kept observation is replaced by a
+    newer one with probability 1/seen (reservoir sampling, seen capped so the bin keeps following the session); a new bin evicts
+    the bin that was not hit for the longest time. Only the crop around the pupil that the region contrast reads is stored. Refit
+    cost and memory thus stay constant regardless of the session length.
+
+    The first fit runs once the reservoir is full, further fits whenever a quarter of it was refreshed. Once the model is built,
+    these are warm-started updates (EyeModelFitter::update_model) keeping the eye centre, falling back to a full fit if the
+    observations no longer agree with it. Fits and the refinement with the region contrast (spii LBFGS, may take seconds) run on a
+    background thread, so the detection only pays for the 2D detection, the unprojection of the single observation and an
+    occasional crop. A fit works on its own EyeModelFitter, the model is published to the detection thread once initialised (a failed
+    fit keeps the previous model), and updated again when the refinement finishes. A changed image size (e.g. ROI) resets the model; refinements of an outdated model are discarded via the
+    model_version of the EyeModelFitter. For the same reason, the search window of the ROI variant of run() is not used.
+
+    Until the model is built, the pupils are reported without physicalDiameter.
+
+    resetModel(): discards the model with the next frame and starts collecting observations again, e.g. after parameter changes
+    isModelBuilt(): whether unprojection results are available
+    isModelFitting(): whether a fit is running in the background
+*/
 class Swirski3D: public PupilDetectionMethod {
 
 public:
 
     PupilDetectionMethod *pupilDetector;
-    sef::EyeModelFitter modelFitter;
-    SpaceBinSearcher spaceBinSearcher;
-
-    static const size_t kFitterMaxCountDefault = 30;// 100;
-    size_t fitter_count = 0;
-    size_t fitter_max_count = kFitterMaxCountDefault;// 100;
+    Swirski3DParams params;
 
+    Swirski3D() : Swirski3D(new Swirski2D()) {
+    }
 
-    Swirski3D(double focal_length, double region_band_width, double region_step_epsilon)
-        : focal_length(focal_length), modelFitter(focal_length, region_band_width, region_step_epsilon), fitter_max_count(kFitterMaxCountDefault) {
+    explicit Swirski3D(PupilDetectionMethod *pupilMethod) : pupilDetector(pupilMethod), fitting(false), modelBuilt(false), resetRequested(false), modelGeneration(0), freshCount(0), frameCount(0) {
 
         mDesc = "Swirski3D (Swirski et al.)";
         mTitle = "Swirski3D";
 
-        pupilDetector = new Swirski2D();
+        params.FocalLength = 0;
+        params.ObservationCount = 30;
+        params.RefineWithRegionContrast = true;
+        params.RegionBandWidth = 5;
+        params.RegionStepEpsilon = 0.5;
+        params.ReliabilityThreshold = 0.8;
+        params.RegionThreads = 1;
     }
 
-    Swirski3D(PupilDetectionMethod *pupilMethod, double focal_length, double region_band_width, double region_step_epsilon)
-            : pupilDetector(pupilMethod), focal_length(focal_length), modelFitter(focal_length, region_band_width, region_step_epsilon), fitter_max_count(kFitterMaxCountDefault) {
-
-        mDesc = "Swirski3D (Swirski et al.)";
-        mTitle = "Swirski3D";
-    }
-
-    ~Swirski3D() override {
-        delete pupilDetector;
-    };
+    // Waits for a running fit
+    ~Swirski3D() override;
 
     Pupil run(const cv::Mat &frame) override;
     void run(const cv::Mat &frame, const cv::Rect &roi, Pupil &pupil, const float &minPupilDiameterPx, const float &maxPupilDiameterPx) override;
@@ -119,21 +149,52 @@ public:
         return false;
     }
 
-    bool is_model_built() {
-        return is_model_built_;
+    void resetModel();
+
+    bool isModelBuilt() const {
+        return modelBuilt;
     }
 
+    bool isModelFitting() const {
+        return fitting;
+    }
 
 private:
 
-    double focal_length;
-    bool is_model_built_ = false;
+    // Observation kept for a spatial bin of the pupil centre
+    struct ReservoirSlot {
+        int bin;
+        sef::EyeModelFitter::Observation observation;
+        int seen;           // Pupils seen in the bin since it entered the reservoir, capped
+        long long lastSeen; // Frame the bin was last hit, for evicting the least recently hit bin
+        bool fresh;         // Not yet part of a fit
+    };
+
+    // Only the eye of the model fitter is read by the detection, under its model_mutex
+    sef::EyeModelFitter modelFitter;
+    std::unique_ptr<SpaceBinSearcher> spaceBinSearcher;
+    std::vector<ReservoirSlot> reservoir;
+    int freshCount;
+    long long frameCount;
+    std::minstd_rand reservoirRandom;
+    cv::Size modelImageSize;
+
+    std::thread fittingThread;
+    std::atomic<bool> fitting;
+    std::atomic<bool> modelBuilt;
+    std::atomic<bool> resetRequested;
+    // Changed by the detection thread under the model_mutex of the model fitter, read by the fitting thread under it
+    int modelGeneration;
+
+    void startNewModel(const cv::Size &imageSize);
+
+    void fitModel(std::vector<sef::EyeModelFitter::Observation> fitObservations, int generation, Swirski3DParams fitParams, bool warmStart);
 
-    double compute_reliability(const cv::Mat &img, sef::Ellipse2D<double> &el, std::vector<cv::Point2f> &inlier_pts);
+    sef::EyeModelFitter::Observation cropObservation(const cv::Mat &image, const sef::Ellipse2D<double> &pupil, const std::vector<cv::Point2f> &pupil_inliers) const;
 
-    sef::EyeModelFitter::Circle unproject(const cv::Mat &img, sef::Ellipse2D<double> &el, std::vector<cv::Point2f> &inlier_pts);
+    sef::EyeModelFitter::Circle unproject(sef::Ellipse2D<double> &el, std::vector<cv::Point2f> &inlier_pts, double &reliability);
 
-    bool add_observation(const cv::Mat &image, sef::Ellipse2D<double> &pupil, std::vector<cv::Point2f> &pupil_inliers, bool force);
+    bool add_observation(const cv::Mat &image, sef::Ellipse2D<double> &pupil, std::vector<cv::Point2f> &pupil_inliers);
 
     cv::RotatedRect toImgCoordInv(const cv::RotatedRect& rect, const cv::Mat& m, float scale=1);
 
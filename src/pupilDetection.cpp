@@ -1,5 +1,4 @@
 
-#include <QtConcurrent/QtConcurrent>
 #include "pupilDetection.h"
 #include "pupil-detection-methods/ElSe.h"
 #include "pupil-detection-methods/ExCuSe.h"
@@ -10,26 +9,105 @@
 #include "pupil-detection-methods/Swirski2D.h"
 #include "devices/stereoCamera.h"
 #include "devices/fileCamera.h"
+#include "pupil-detection-methods/PupilDetectionMethodParameters.h"
+#include "threadBudget.h"
 
+#include <algorithm>
 #include <fstream>
 #include <cmath>
-
+#include <iostream>
+#include <sstream>
+
+namespace {
+    // Pupil depth range of the epipolar search without known depth, in calibration units (mm), and the tolerance around a known depth
+    const double epipolarMinDepth = 20.0;
+    const double epipolarMaxDepth = 2000.0;
+    const double epipolarDepthTolerance = 0.25;
+    // Window margin besides the pupil diameter, covering the calibration's epipolar error
+    const int epipolarMarginPx = 8;
+    const int epipolarReportInterval = 500;
+}
 
 // QTs event signal eventloop queues images for us, we run this pupildetection worker in a extra thread and every call to newImage is queued automatically
 // This may however queue a large number of images if the processing speed is slow, increasing the memory potentially until it is full and the application is killed
 // We dont have access to the eventloop to handle this, so its up to the user for now to not use a rate too high
 
 void PupilDetection::populateWithMethods(std::vector<PupilDetectionMethod*> &vec) {
-    vec.push_back(new ElSe());
-    vec.push_back(new ExCuSe());
-    vec.push_back(new PuRe());
-    vec.push_back(new PuReST());
-    vec.push_back(new Starburst());
-    vec.push_back(new Swirski2D());
+    for(const std::string &name : PupilDetectionMethodParameters::algorithmNames())
+        vec.push_back(PupilDetectionMethodParameters::create(name));
+}
+
+// Returns the instance of the algorithm at index for one of the slots 2-4, creating it on first use
+// A new instance gets the parameters of the slot 1 instance, which is the one configured through the settings dialog and its saved configuration
+PupilDetectionMethod* PupilDetection::slotMethod(std::vector<PupilDetectionMethod*> &slot, int index) {
+    const QMutexLocker locker(&methodMutex);
+
+    if(!slot[index]) {
+        PupilDetectionMethod *method = PupilDetectionMethodParameters::create(pupilDetectionMethods1[index]->title());
+        PupilDetectionMethodParameters::apply(method, PupilDetectionMethodParameters::read(pupilDetectionMethods1[index]));
+        slot[index] = method;
+        applyThreadBudget();
+        invalidateResultCacheKey();
+
+        // The slots are parametrized for their own ROI
+        if(autoParamEnabled)
+            autoParamScheduled = true;
+
+        emit methodInstancesChanged();
+    }
+    return slot[index];
+}
+
+PupilDetectionMethod* PupilDetection::existingSlotMethod(std::vector<PupilDetectionMethod*> &slot, const std::string &method) {
+    const QMutexLocker locker(&methodMutex);
+
+    for(auto pm: slot) {
+        if(pm && pm->title() == method)
+            return pm;
+    }
+    return nullptr;
+}
 
-    // TODO finish integrating Swirski3D
-    //double focal_length = 0.5;
-    //pupilDetectionMethods.push_back(new Swirski3D(new PuReST(), focal_length, 5, 0.5));
+// Deletes the slot 2-4 instances of all but the current algorithm, these are created again when the algorithm is selected
+// methodInstancesReleasing() is emitted before deleting them, so that holders of the instances drop their pointers first
+void PupilDetection::releaseSlotMethods() {
+    const QMutexLocker locker(&methodMutex);
+
+    std::vector<PupilDetectionMethod*> released;
+    for(std::vector<PupilDetectionMethod*> *slot : {&pupilDetectionMethods2, &pupilDetectionMethods3, &pupilDetectionMethods4}) {
+        for(int i=0; i<static_cast<int>(slot->size()); i++) {
+            if((*slot)[i] && i != pupilDetectionIndex) {
+                released.push_back((*slot)[i]);
+                (*slot)[i] = nullptr;
+            }
+        }
+    }
+    if(released.empty())
+        return;
+
+    emit methodInstancesReleasing();
+    for(PupilDetectionMethod *method : released)
+        delete method;
+    emit methodInstancesChanged();
+}
+
+// The eye model refinement of Swirski3D runs next to the detection of the other views, so each view's instance gets its share of the
+// detection thread budget instead of all cores
+void PupilDetection::applyThreadBudget() {
+    int views = 1;
+    if(currentProcMode == SINGLE_IMAGE_TWO_PUPIL || currentProcMode == STEREO_IMAGE_ONE_PUPIL)
+        views = 2;
+    else if(currentProcMode == STEREO_IMAGE_TWO_PUPIL)
+        views = 4;
+    const int regionThreads = std::max(1, ThreadBudget::getBudget(ThreadBudget::DETECTION) / views);
+
+    const QMutexLocker locker(&methodMutex);
+    for(std::vector<PupilDetectionMethod*> *slot : {&pupilDetectionMethods1, &pupilDetectionMethods2, &pupilDetectionMethods3, &pupilDetectionMethods4}) {
+        for(PupilDetectionMethod *method : *slot) {
+            if(Swirski3D *swirski = dynamic_cast<Swirski3D*>(method))
+                swirski->params.RegionThreads = regionThreads;
+        }
+    }
 }
 
 // Creates a new pupil detection worker which include all pupil detection algorithms
@@ -37,9 +115,17 @@ void PupilDetection::populateWithMethods(std::vector<PupilDetectionMethod*> &vec
 PupilDetection::PupilDetection(QMutex *imageMutex, QWaitCondition *imagePublished, QWaitCondition *imageProcessed, QObject *parent) : QObject(parent),
                                                   camera(nullptr),
                                                   frameCounter(new FrameRateCounter(parent)),
+                                                  resultBroadcaster(new PupilResultBroadcaster(this)),
+                                                  detectionTasks([this](const DetectionTaskGroup::View &view) { return detectPupil(view.method, view.frame, view.window, view.minPupilDiameterPx, view.maxPupilDiameterPx); },
+                                                                 ThreadBudget::pool(ThreadBudget::DETECTION)),
                                                   useOutlineConfidence(true),
                                                   useROIPreProcessing(false),
                                                   useImageUndistort(false),
+                                                  useResultCache(false),
+                                                  useBlinkRejection(false),
+                                                  blinkDarkContrast(20),
+                                                  blinkBlobContrast(10),
+                                                  useEpipolarSearch(false),
                                                   usePupilUndistort(false),
                                                   trackingOn(false),
                                                   calibrated(false),
@@ -67,10 +153,11 @@ PupilDetection::PupilDetection(QMutex *imageMutex, QWaitCondition *imagePublishe
     drawDelay = 33; // ~30fps
 
     // we initialize the algorithms here one time and save them in a list, the created objects are then changed through index change of the list
+    // Only slot 1 is populated, the other slots are filled on demand by the processing modes using them
     populateWithMethods(pupilDetectionMethods1);
-    populateWithMethods(pupilDetectionMethods2);
-    populateWithMethods(pupilDetectionMethods3);
-    populateWithMethods(pupilDetectionMethods4);
+    pupilDetectionMethods2.assign(pupilDetectionMethods1.size(), nullptr);
+    pupilDetectionMethods3.assign(pupilDetectionMethods1.size(), nullptr);
+    pupilDetectionMethods4.assign(pupilDetectionMethods1.size(), nullptr);
 
     // Default algorithm PuRe
     pupilDetectionIndex = 2;
@@ -78,7 +165,7 @@ PupilDetection::PupilDetection(QMutex *imageMutex, QWaitCondition *imagePublishe
     // Processing speed frame counter
     connect(frameCounter, SIGNAL(fps(double)), this, SIGNAL(fps(double)));
 
-    assert( connect(this, SIGNAL(processedPupilData(quint64, int, std::vector<Pupil>, QString)), frameCounter, SLOT(count())) );
+    connect(resultBroadcaster, SIGNAL(resultPublished(quint64)), frameCounter, SLOT(count()));
 
     drawTimer.start();
     processingTimer.start();
@@ -87,6 +174,11 @@ PupilDetection::PupilDetection(QMutex *imageMutex, QWaitCondition *imagePublishe
 }
 
 PupilDetection::~PupilDetection() {
+    saveResultCache();
+
+    for(std::vector<PupilDetectionMethod*> *slot : {&pupilDetectionMethods2, &pupilDetectionMethods3, &pupilDetectionMethods4})
+        for(PupilDetectionMethod *method : *slot)
+            delete method;
 }
 
 // Attaches a camera to the pupil detection process
@@ -94,14 +186,24 @@ PupilDetection::~PupilDetection() {
 void PupilDetection::setCamera(Camera *m_camera) {
 
     if (camera != m_camera) {
+        saveResultCache();
+        resultCacheFileName.clear();
         camera = m_camera;
 
+        if(m_camera && (m_camera->getType() == SINGLE_IMAGE_FILE || m_camera->getType() == STEREO_IMAGE_FILE))
+            resultBroadcaster->setFilenames(static_cast<FileCamera*>(m_camera)->getFilenames());
+        else
+            resultBroadcaster->setFilenames({});
+
         // This can happen upon camera disconnect, especially important upon main window closing when a camera was open
         // The m_camera is set to nullptr then, but the following code does not get executed because of this return;
         if(!m_camera)
             return;
 
         calibrated = false;
+        singleCalibration = nullptr;
+        stereoCalibration = nullptr;
+        epipolarDepths[0] = epipolarDepths[1] = -1.0;
 
         if (camera->getType() == CameraImageType::LIVE_STEREO_CAMERA) {
             stereoCalibration = dynamic_cast<StereoCamera *>(camera)->getCameraCalibration();
@@ -120,10 +222,321 @@ void PupilDetection::setCamera(Camera *m_camera) {
             singleCalibration = dynamic_cast<SingleWebcam *>(camera)->getCameraCalibration();
             calibrated = static_cast<bool>(singleCalibration->isCalibrated());
         }
+        else if (camera->getType() == CameraImageType::SYNTHETIC_SINGLE_CAMERA) {
+            singleCalibration = dynamic_cast<SyntheticCamera *>(camera)->getCameraCalibration();
+            calibrated = static_cast<bool>(singleCalibration->isCalibrated());
+        } else if (camera->getType() == CameraImageType::SYNTHETIC_STEREO_CAMERA) {
+            stereoCalibration = dynamic_cast<SyntheticCamera *>(camera)->getStereoCameraCalibration();
+            calibrated = static_cast<bool>(stereoCalibration->isCalibrated());
+        }
+        // Results cached with another calibration must not be served, and the calibration may also change while the camera stays attached
+        QObject *calibration = isStereo() ? static_cast<QObject*>(stereoCalibration) : static_cast<QObject*>(singleCalibration);
+        if(calibration) {
+            connect(calibration, SIGNAL(finishedCalibration()), this, SLOT(onCalibrationChanged()), Qt::UniqueConnection);
+            connect(calibration, SIGNAL(unavailableCalibration()), this, SLOT(onCalibrationChanged()), Qt::UniqueConnection);
+        }
+        invalidateResultCacheKey();
+
+        loadResultCache();
         configureCameraConnection(true);
     }
 }
 
+void PupilDetection::enableResultCache(bool value) {
+    if(useResultCache == value)
+        return;
+    if(!value)
+        saveResultCache();
+    useResultCache = value;
+    if(value)
+        loadResultCache();
+}
+
+void PupilDetection::setBlinkRejectionContrasts(int darkContrast, int blobContrast) {
+    blinkDarkContrast = std::max(0, darkContrast);
+    blinkBlobContrast = std::max(0, blobContrast);
+}
+
+void PupilDetection::enableEpipolarSearch(bool value) {
+    if(useEpipolarSearch == value)
+        return;
+    useEpipolarSearch = value;
+    epipolarDepths[0] = epipolarDepths[1] = -1.0;
+    epipolarStatistics = EpipolarSearchStatistics();
+}
+
+// The results of an image playback are cached per recording, in the application cache directory
+void PupilDetection::loadResultCache() {
+    resultCache.clear();
+    resultCacheFileName.clear();
+    if(!useResultCache || !camera || (camera->getType() != SINGLE_IMAGE_FILE && camera->getType() != STEREO_IMAGE_FILE))
+        return;
+
+    FileCamera *fileCamera = static_cast<FileCamera*>(camera);
+    std::vector<quint64> timestamps(fileCamera->getNumImagesTotal());
+    for(size_t i=0; i<timestamps.size(); i++)
+        timestamps[i] = fileCamera->getTimestampForFrameNumber(static_cast<int>(i));
+    resultCacheRecording = PupilResultCache::recordingIdentity(timestamps);
+    resultCacheFileName = PupilResultCache::fileNameForRecording(fileCamera->getImageDirectoryName());
+    if(resultCache.load(resultCacheFileName, resultCacheRecording))
+        std::cout << "PupilDetection: loaded " << resultCache.size() << " cached pupil detection results" << std::endl;
+}
+
+void PupilDetection::saveResultCache() {
+    if(!resultCacheFileName.isEmpty())
+        resultCache.save(resultCacheFileName, resultCacheRecording);
+}
+
+// Hash of everything the pupil detection result of a frame depends on besides the image, so changing any setting yields another key
+// The algorithm parameters and the calibration are only hashed again after they changed (see resultParametersHash()), the ROIs and options every frame
+// Returns 0 (not cached) for live cameras, and while the automatic parametrization is about to change the parameters
+// NOTE: PuReST tracks the pupil over consecutive frames, its cached results are the ones of the first (sequential) pass
+quint64 PupilDetection::resultCacheKey() {
+    if(!useResultCache || !camera || (camera->getType() != SINGLE_IMAGE_FILE && camera->getType() != STEREO_IMAGE_FILE))
+        return 0;
+
+    if(resultParametersStale.exchange(false))
+        resultParametersKey = resultParametersHash();
+
+    if(autoParamEnabled && autoParamScheduled)
+        return 0;
+
+    const int settings[] = {
+        pupilDetectionIndex, currentProcMode, useROIPreProcessing, useImageUndistort, usePupilUndistort, useOutlineConfidence, useBlinkRejection, blinkDarkContrast, blinkBlobContrast, useEpipolarSearch, calibrated,
+        ROIsingleImageOnePupil.x, ROIsingleImageOnePupil.y, ROIsingleImageOnePupil.width, ROIsingleImageOnePupil.height,
+        ROIsingleImageTwoPupilA.x, ROIsingleImageTwoPupilA.y, ROIsingleImageTwoPupilA.width, ROIsingleImageTwoPupilA.height,
+        ROIsingleImageTwoPupilB.x, ROIsingleImageTwoPupilB.y, ROIsingleImageTwoPupilB.width, ROIsingleImageTwoPupilB.height,
+        ROIstereoImageOnePupil1.x, ROIstereoImageOnePupil1.y, ROIstereoImageOnePupil1.width, ROIstereoImageOnePupil1.height,
+        ROIstereoImageOnePupil2.x, ROIstereoImageOnePupil2.y, ROIstereoImageOnePupil2.width, ROIstereoImageOnePupil2.height,
+        ROIstereoImageTwoPupilA1.x, ROIstereoImageTwoPupilA1.y, ROIstereoImageTwoPupilA1.width, ROIstereoImageTwoPupilA1.height,
+        ROIstereoImageTwoPupilA2.x, ROIstereoImageTwoPupilA2.y, ROIstereoImageTwoPupilA2.width, ROIstereoImageTwoPupilA2.height,
+        ROIstereoImageTwoPupilB1.x, ROIstereoImageTwoPupilB1.y, ROIstereoImageTwoPupilB1.width, ROIstereoImageTwoPupilB1.height,
+        ROIstereoImageTwoPupilB2.x, ROIstereoImageTwoPupilB2.y, ROIstereoImageTwoPupilB2.width, ROIstereoImageTwoPupilB2.height
+    };
+
+    const quint64 key = PupilResultCache::hash(settings, sizeof(settings), resultParametersKey);
+    return key != 0 ? key : 1;
+}
+
+// Hash of the algorithm parameters and the calibration content, as part of resultCacheKey()
+// Recomputed after invalidateResultCacheKey(), i.e. whenever the settings dialog applied parameters, the automatic parametrization ran,
+// the algorithm or processing mode changed, or the calibration finished or was reset
+quint64 PupilDetection::resultParametersHash() {
+
+    // Only the slot instances which exist already, creating them here would schedule the automatic parametrization
+    // A slot instance created later invalidates the key (see slotMethod())
+    std::ostringstream settings;
+    {
+        const QMutexLocker locker(&methodMutex);
+        settings << pupilDetectionMethods1[pupilDetectionIndex]->title();
+        for(std::vector<PupilDetectionMethod*> *slot : {&pupilDetectionMethods1, &pupilDetectionMethods2, &pupilDetectionMethods3, &pupilDetectionMethods4}) {
+            if((*slot)[pupilDetectionIndex])
+                settings << PupilDetectionMethodParameters::read((*slot)[pupilDetectionIndex]).dump();
+        }
+    }
+
+    quint64 key = PupilResultCache::hash(settings.str());
+
+    std::vector<cv::Mat> calibration;
+    if(calibrated && isStereo())
+        calibration = {stereoCalibration->getCameraMatrix(), stereoCalibration->getDistCoefficients(), stereoCalibration->getCameraMatrixSecondary(),
+                       stereoCalibration->getDistCoefficientsSecondary(), stereoCalibration->getRotationMatrix(), stereoCalibration->getTranslationMatrix()};
+    else if(calibrated)
+        calibration = {singleCalibration->getCameraMatrix(), singleCalibration->getDistCoefficients()};
+
+    for(const cv::Mat &mat : calibration) {
+        const cv::Mat data = mat.isContinuous() ? mat : mat.clone();
+        key = PupilResultCache::hash(data.data, data.total() * data.elemSize(), key);
+    }
+    return key;
+}
+
+void PupilDetection::invalidateResultCacheKey() {
+    resultParametersStale = true;
+}
+
+// The calibration of the current camera finished or was reset
+void PupilDetection::onCalibrationChanged() {
+    if(!camera)
+        return;
+
+    if(isStereo())
+        calibrated = stereoCalibration && stereoCalibration->isCalibrated();
+    else
+        calibrated = singleCalibration && singleCalibration->isCalibrated();
+
+    epipolarDepths[0] = epipolarDepths[1] = -1.0;
+    invalidateResultCacheKey();
+}
+
+// Pupil detection of one view, as run concurrently for the views of the multi-pupil and stereo processing modes
+// Frames rejected as blink skip the detection and its expensive fallbacks altogether
+// With a window, only the window is searched for a pupil of the given diameter range, this is the case when another view already found it,
+// so there is no blink rejection. The pupil is in frame coordinates either way
+Pupil PupilDetection::detectPupil(PupilDetectionMethod *method, const cv::Mat &frame, const cv::Rect &window, float minPupilDiameterPx, float maxPupilDiameterPx) {
+    Pupil pupil;
+    if(window.area() > 0) {
+        if(useOutlineConfidence)
+            method->runWithConfidence(frame, window, pupil, minPupilDiameterPx, maxPupilDiameterPx);
+        else
+            method->run(frame, window, pupil, minPupilDiameterPx, maxPupilDiameterPx);
+    } else if(useBlinkRejection && PupilDetectionMethod::blinkDetection(frame, blinkDarkContrast, blinkBlobContrast))
+        pupil.blink = true;
+    else if(useOutlineConfidence)
+        pupil = method->runWithConfidence(frame);
+    else
+        pupil = method->run(frame);
+    return pupil;
+}
+
+// Preprocessing shared by the pupils (views) detected on one physical image: undistortion and grayscale conversion run once over the
+// bounding region of all crops, and each detection frame is a view into the result, without copying
+// Undistorting the whole image is rather slow (~4ms on our test system), so only that region is remapped, using fixed-point maps
+// If the crops lie far apart, e.g. the ROIs of both eyes, their bounding region has more pixels than the crops together, then every
+// crop is preprocessed on its own instead
+// Returns the undistorted image if it covers the whole image, so it can be reused for display, otherwise an empty image
+cv::Mat PupilDetection::preprocessImage(const cv::Mat &image, const std::vector<cv::Rect> &crops, bool undistort, std::vector<cv::Mat> &frames) {
+
+    const cv::Rect imageRect(0, 0, image.cols, image.rows);
+
+    cv::Rect bounds = crops.front() & imageRect;
+    int cropArea = 0;
+    for(const cv::Rect &crop : crops) {
+        bounds |= crop & imageRect;
+        cropArea += (crop & imageRect).area();
+    }
+    const bool shared = bounds.area() <= cropArea;
+    const std::vector<cv::Rect> regions = shared ? std::vector<cv::Rect>{bounds} : crops;
+
+    cv::Mat undistortedFrame;
+    frames.resize(crops.size());
+    for(size_t i=0; i<regions.size(); i++) {
+        const cv::Rect region = regions[i] & imageRect;
+
+        cv::Mat preprocessed = undistort ? singleCalibration->undistortImage(image, region) : image(region);
+        if(undistort && preprocessed.size() == image.size())
+            undistortedFrame = preprocessed;
+        if(preprocessed.channels() > 1)
+            cv::cvtColor(preprocessed, preprocessed, cv::COLOR_BGR2GRAY);
+
+        if(shared) {
+            for(size_t j=0; j<crops.size(); j++)
+                frames[j] = preprocessed((crops[j] & imageRect) - region.tl());
+        } else {
+            frames[i] = preprocessed;
+        }
+    }
+    return undistortedFrame;
+}
+
+// Stereo detection constrained by the epipolar geometry: the main views are detected over their whole ROIs first, then each secondary view
+// only within the window its main view pupil can appear in, i.e. around the segment of the epipolar line of the main pupil center for the
+// expected depth range (see StereoCameraCalibration::epipolarSearchWindow()). Once a pupil pair of an eye was triangulated, the depth range
+// is narrowed around its depth. Secondary views without main view pupil, and those without valid pupil in their window, fall back to the
+// independent detection over their whole ROI. Only algorithms implementing the ROI variant of run() profit, the others still search the ROI.
+// Pupils are returned in image coordinates, pupils[i] of crops[i] in the main and pupilsSecondary[i] of cropsSecondary[i] in the secondary image
+// Returns false if a detection threw an exception
+bool PupilDetection::detectStereoPupilsEpipolar(const CameraImage &simg,
+                                                const std::vector<PupilDetectionMethod*> &methods, const std::vector<PupilDetectionMethod*> &methodsSecondary,
+                                                const std::vector<cv::Rect> &crops, const std::vector<cv::Rect> &cropsSecondary,
+                                                std::vector<Pupil> &pupils, std::vector<Pupil> &pupilsSecondary) {
+
+    const size_t count = crops.size();
+    pupils.assign(count, Pupil());
+    pupilsSecondary.assign(count, Pupil());
+
+    std::vector<cv::Mat> frames;
+    std::vector<cv::Mat> framesSecondary;
+    preprocessImage(simg.img, crops, false, frames);
+    preprocessImage(simg.imgSecondary, cropsSecondary, false, framesSecondary);
+
+    std::vector<DetectionTaskGroup::View> views;
+    for(size_t i=0; i<count; i++)
+        views.emplace_back(methods[i], frames[i], &pupils[i]);
+
+    QElapsedTimer timer;
+    timer.start();
+    if(!detectionTasks.run(views))
+        return false;
+    const double mainTime = timer.nsecsElapsed() / 1e6;
+
+    const cv::Rect imageRect(0, 0, simg.img.cols, simg.img.rows);
+    const cv::Rect imageRectSecondary(0, 0, simg.imgSecondary.cols, simg.imgSecondary.rows);
+
+    std::vector<bool> windowed(count, false);
+    views.clear();
+    for(size_t i=0; i<count; i++) {
+        const bool valid = pupils[i].valid(-2.0);
+        pupils[i].shift((crops[i] & imageRect).tl());
+
+        const cv::Rect cropSecondary = cropsSecondary[i] & imageRectSecondary;
+        const float diameter = static_cast<float>(pupils[i].diameter());
+        cv::Rect window;
+        if(valid && diameter > 0) {
+            double minDepth = epipolarMinDepth;
+            double maxDepth = epipolarMaxDepth;
+            if(epipolarDepths[i] > 0) {
+                minDepth = epipolarDepths[i] / (1.0 + epipolarDepthTolerance);
+                maxDepth = epipolarDepths[i] * (1.0 + epipolarDepthTolerance);
+            }
+            window = stereoCalibration->epipolarSearchWindow(pupils[i].center, minDepth, maxDepth);
+            // The secondary view pupil has about the size of the main view one and must lie completely inside the window
+            const int margin = cvCeil(diameter) + epipolarMarginPx;
+            window = cv::Rect(window.x - margin, window.y - margin, window.width + 2 * margin, window.height + 2 * margin) & cropSecondary;
+        }
+
+        epipolarStatistics.roiPixels += cropSecondary.area();
+        if(window.area() > 0 && window.area() < cropSecondary.area()) {
+            windowed[i] = true;
+            epipolarStatistics.searchedPixels += window.area();
+            views.emplace_back(methodsSecondary[i], framesSecondary[i], &pupilsSecondary[i], window - cropSecondary.tl(), 0.5f * diameter, 2.0f * diameter);
+        } else {
+            epipolarStatistics.searchedPixels += cropSecondary.area();
+            views.emplace_back(methodsSecondary[i], framesSecondary[i], &pupilsSecondary[i]);
+        }
+    }
+
+    timer.restart();
+    if(!detectionTasks.run(views))
+        return false;
+
+    views.clear();
+    for(size_t i=0; i<count; i++) {
+        if(windowed[i] && !pupilsSecondary[i].valid(-2.0))
+            views.emplace_back(methodsSecondary[i], framesSecondary[i], &pupilsSecondary[i]);
+    }
+    if(!detectionTasks.run(views))
+        return false;
+    const double secondaryTime = timer.nsecsElapsed() / 1e6;
+
+    for(size_t i=0; i<count; i++)
+        pupilsSecondary[i].shift((cropsSecondary[i] & imageRectSecondary).tl());
+
+    const std::vector<double> depths = stereoCalibration->pupilDepths(pupils, pupilsSecondary);
+    for(size_t i=0; i<count && i<2; i++) {
+        if(depths[i] > 0)
+            epipolarDepths[i] = depths[i];
+    }
+
+    epipolarStatistics.frames++;
+    epipolarStatistics.views += static_cast<int>(count);
+    epipolarStatistics.windowed += static_cast<int>(std::count(windowed.begin(), windowed.end(), true));
+    epipolarStatistics.fallbacks += static_cast<int>(views.size());
+    epipolarStatistics.mainTime += mainTime;
+    epipolarStatistics.secondaryTime += secondaryTime;
+
+    // The main views are detected as the secondary views were without the epipolar constraint, so their time is the reference
+    if(epipolarStatistics.frames % epipolarReportInterval == 0 && epipolarStatistics.secondaryTime > 0) {
+        const EpipolarSearchStatistics &stats = epipolarStatistics;
+        qDebug().nospace() << "Epipolar search: " << 100.0 * stats.windowed / stats.views << "% of secondary views searched within "
+                           << 100.0 * stats.searchedPixels / stats.roiPixels << "% of their ROI pixels, "
+                           << 100.0 * stats.fallbacks / std::max(1, stats.windowed) << "% fell back to the whole ROI; "
+                           << stats.secondaryTime / stats.frames << " ms instead of " << stats.mainTime / stats.frames << " ms per frame ("
+                           << stats.mainTime / stats.secondaryTime << "x speedup)";
+    }
+    return true;
+}
+
 // Starts the algorithm by connecting the camera image signals to the processing callbacks
 // GB: now the distinction between stereo/single modes is made using procMode enum
 void PupilDetection::startDetection() {
@@ -134,6 +547,9 @@ void PupilDetection::startDetection() {
     if(autoParamEnabled)
         performAutoParam();
 
+    // The budget may have changed in the general settings meanwhile
+    applyThreadBudget();
+
     trackingOn = true;
     if(camera) {
         //configureCameraConnection();
@@ -166,14 +582,22 @@ void PupilDetection::setAlgorithm(QString method) {
 
     frameCounter->reset();
 
-    int i = 0;
-    for(auto pm: pupilDetectionMethods1) {
-        //if(pm->title() == method.toStdString())
-        //modified for tolower to care for when someone is setting this through an UDP command and had a case-typo
-        if(QString::fromStdString(pm->title()).toLower() == method.toLower())
-            pupilDetectionIndex = i;
-        i++;
+    {
+        // A frame still being processed keeps the instances of the previous algorithm until it is done
+        const QMutexLocker locker(&methodMutex);
+
+        int i = 0;
+        for(auto pm: pupilDetectionMethods1) {
+            //if(pm->title() == method.toStdString())
+            //modified for tolower to care for when someone is setting this through an UDP command and had a case-typo
+            if(QString::fromStdString(pm->title()).toLower() == method.toLower())
+                pupilDetectionIndex = i;
+            i++;
+        }
+
+        releaseSlotMethods();
     }
+    invalidateResultCacheKey();
 
     // NOTE: maybe not here? But one algorithm is changed, we certainly need to re-parameter
     if(autoParamEnabled)
@@ -225,13 +649,6 @@ void PupilDetection::onNewSingleImageForOnePupilImpl(const CameraImage &image) {
 
     cv::Mat bwFrame = image.img;
 
-    // Undistorting the whole image is rather slow (~4ms on our test system), use contour point undistort instead (>~1ms)
-    if(!usePupilUndistort && useImageUndistort) {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        bwFrame = singleCalibration->undistortImage(image.img);
-        //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
-    }
-
     cv::Rect roi = cv::Rect(0, 0, bwFrame.cols, bwFrame.rows);
 
     if(useROIPreProcessing && !ROIsingleImageOnePupil.empty() && roi != ROIsingleImageOnePupil && ROIsingleImageOnePupil.width<=bwFrame.cols && ROIsingleImageOnePupil.height<=bwFrame.rows) {
@@ -240,52 +657,69 @@ void PupilDetection::onNewSingleImageForOnePupilImpl(const CameraImage &image) {
     } else if(autoParamEnabled && autoParamScheduled)
         ROIsingleImageOnePupil = roi;
 
-    if(autoParamEnabled && autoParamScheduled) {
-        performAutoParam();
-        autoParamScheduled = false;
-    }
+    // Results of an image playback frame already detected with the same settings are taken from the cache
+    std::vector<Pupil> Pupils;
+    cv::Mat undistortedFrame;
+    const quint64 resultKey = resultCacheKey();
+    if(!resultCache.find(image.frameNumber, resultKey, Pupils)) {
+        // Undistorting the whole image is rather slow (~4ms on our test system), so only the ROI is remapped, using fixed-point maps
+        // The undistorted frame is kept for display in case the ROI spans the whole image
+        if(!usePupilUndistort && useImageUndistort) {
+            //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            undistortedFrame = singleCalibration->undistortImage(image.img, roi);
+            bwFrame = undistortedFrame;
+            //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
+        }
 
-    if (bwFrame.channels() > 1) {
-        cv::cvtColor(bwFrame, bwFrame, cv::COLOR_BGR2GRAY);
-    }
+        if(autoParamEnabled && autoParamScheduled) {
+            performAutoParam();
+            autoParamScheduled = false;
+        }
 
-    Pupil pupil = Pupil();
+        if (bwFrame.channels() > 1) {
+            cv::cvtColor(bwFrame, bwFrame, cv::COLOR_BGR2GRAY);
+        }
 
-    // Pupil detection
-    try {
-        if(useOutlineConfidence) {
+        Pupil pupil = Pupil();
+
+        // Pupil detection
+        try {
+            if(useBlinkRejection && PupilDetectionMethod::blinkDetection(bwFrame, blinkDarkContrast, blinkBlobContrast)) {
+                pupil.blink = true;
+            } else if(useOutlineConfidence) {
+
+                //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                getCurrentMethod1()->runWithConfidence(bwFrame, pupil);
+                //runtimeHistory.push_back(std::make_pair(cimg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+            } else {
+                //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                getCurrentMethod1()->run(bwFrame, pupil);
+                //runtimeHistory.push_back(std::make_pair(cimg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+            }
+        } catch (...) {
+            pupil.clear();
+        }
 
+        // Shift the pupil center position to be in the coordinate of the whole image instead of the ROI
+        if(useROIPreProcessing) {
+            pupil.shift(roi.tl());
+        }
+
+        // Undistort the pupil contour points to get an undistorted pupil size
+        if(usePupilUndistort && !useImageUndistort) {
             //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-            pupilDetectionMethods1[pupilDetectionIndex]->runWithConfidence(bwFrame, pupil);
-            //runtimeHistory.push_back(std::make_pair(cimg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
-        } else {
-            //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-            pupilDetectionMethods1[pupilDetectionIndex]->run(bwFrame, pupil);
-            //runtimeHistory.push_back(std::make_pair(cimg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+            pupil.undistortedDiameter = singleCalibration->undistortPupilDiameter(pupil);
+            //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
+        } else if(!usePupilUndistort && useImageUndistort) {
+            pupil.undistortedDiameter = pupil.diameter();
         }
-    } catch (...) {
-        pupil.clear();
-    }
 
-    // Shift the pupil center position to be in the coordinate of the whole image instead of the ROI
-    if(useROIPreProcessing) {
-        pupil.shift(roi.tl());
-    }
+        pupil.algorithmName = getCurrentMethod1()->title();
 
-    // Undistort the pupil contour points to get an undistorted pupil size
-    if(usePupilUndistort && !useImageUndistort) {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        pupil.undistortedDiameter = singleCalibration->undistortPupilDiameter(pupil);
-        //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
-    } else if(!usePupilUndistort && useImageUndistort) {
-        pupil.undistortedDiameter = pupil.diameter();
+        Pupils.push_back(pupil);
+        resultCache.insert(image.frameNumber, resultKey, Pupils);
     }
 
-    pupil.algorithmName = pupilDetectionMethods1[pupilDetectionIndex]->title();
-
-    std::vector<Pupil> Pupils;
-    Pupils.push_back(pupil);
-
     // Drawing of pupil detections on the image is only performed at ~30fps
     // NOTE: It is important to not only check for drawDelay, but care for the special case,
     // when the last signals from an image playback arrive before another drawDelay is happened,
@@ -299,10 +733,15 @@ void PupilDetection::onNewSingleImageForOnePupilImpl(const CameraImage &image) {
         drawTimer.start();
 
         const CameraImage &mimg = image;
-        mimg.img = image.img.clone();
 
         if(!usePupilUndistort && useImageUndistort) {
-            mimg.img = singleCalibration->undistortImage(image.img);
+            // Reuse the undistorted detection frame if it already covers the whole image
+            if(undistortedFrame.size() == image.img.size())
+                mimg.img = undistortedFrame;
+            else
+                mimg.img = singleCalibration->undistortImage(image.img);
+        } else {
+            mimg.img = image.img.clone();
         }
         // not necessary to copy twice
         //else {
@@ -347,7 +786,7 @@ void PupilDetection::onNewSingleImageForOnePupilImpl(const CameraImage &image) {
         emit processedPupilDataLowFPS(image.timestamp, currentProcMode, Pupils, QString::fromStdString(image.filename));
     }
 
-    emit processedPupilData(image.timestamp, currentProcMode, Pupils, QString::fromStdString(image.filename));
+    publishPupilData(image, Pupils);
 }
 
 // Slot callback for receiving new single camera images that contain two pupils/eyes
@@ -387,90 +826,79 @@ void PupilDetection::onNewSingleImageForTwoPupilImpl(const CameraImage &cimg) {
         return;
     }
 
-    cv::Mat bwFrameA;
-    cv::Mat bwFrameB;
-
-    // Undistorting the whole image is rather slow (~4ms on our test system), use contour point undistort instead (>~1ms)
-    if(!usePupilUndistort && useImageUndistort) {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        bwFrameA = singleCalibration->undistortImage(cimg.img);
-        //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
-    } else {
-        bwFrameA = cimg.img;
-    }
-    bwFrameB = bwFrameA;
-
     // BG: NOTE: by default we only use the left and right halves of the input image
     cv::Rect roiA = cv::Rect(0, 0, (int)std::floor(cimg.img.cols/2)-1, cimg.img.rows);
     cv::Rect roiB = cv::Rect((int)std::ceil(cimg.img.cols/2)+1, 0, cimg.img.cols, cimg.img.rows);
 
-    if(useROIPreProcessing && !ROIsingleImageTwoPupilA.empty() && roiA != ROIsingleImageTwoPupilA && ROIsingleImageTwoPupilA.width<=bwFrameA.cols && ROIsingleImageTwoPupilA.height<=bwFrameA.rows) {
+    // Image regions the detection runs on, the whole image unless a ROI is set
+    cv::Rect cropA = cv::Rect(0, 0, cimg.img.cols, cimg.img.rows);
+    cv::Rect cropB = cropA;
+
+    if(useROIPreProcessing && !ROIsingleImageTwoPupilA.empty() && roiA != ROIsingleImageTwoPupilA && ROIsingleImageTwoPupilA.width<=cimg.img.cols && ROIsingleImageTwoPupilA.height<=cimg.img.rows) {
         roiA = ROIsingleImageTwoPupilA;
-        bwFrameA = bwFrameA(ROIsingleImageTwoPupilA);
+        cropA = roiA;
     } else if(autoParamEnabled && autoParamScheduled)
         ROIsingleImageTwoPupilA = roiA;
 
-    if(useROIPreProcessing && !ROIsingleImageTwoPupilB.empty() && roiB != ROIsingleImageTwoPupilB && ROIsingleImageTwoPupilB.width<=bwFrameB.cols && ROIsingleImageTwoPupilB.height<=bwFrameB.rows) {
+    if(useROIPreProcessing && !ROIsingleImageTwoPupilB.empty() && roiB != ROIsingleImageTwoPupilB && ROIsingleImageTwoPupilB.width<=cimg.img.cols && ROIsingleImageTwoPupilB.height<=cimg.img.rows) {
         roiB = ROIsingleImageTwoPupilB;
-        bwFrameB = bwFrameB(ROIsingleImageTwoPupilB);
+        cropB = roiB;
     } else if(autoParamEnabled && autoParamScheduled)
         ROIsingleImageTwoPupilB = roiB;
 
-    if(autoParamEnabled && autoParamScheduled) {
-        performAutoParam();
-        autoParamScheduled = false;
-    }
-
-    if (cimg.img.channels() > 1) {
-        cv::cvtColor(bwFrameA, bwFrameA, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(bwFrameB, bwFrameB, cv::COLOR_BGR2GRAY);
-    }
+    // The method instances of the other slots must not be released by an algorithm change while the frame is processed
+    const QMutexLocker methodLocker(&methodMutex);
 
-    // We execute pupil detection for main and secondary images concurrently using treads, we execute both in separate threads, then wait till both are finished
-    QFutureSynchronizer<Pupil> synchronizer;
-    Pupil pupilA;
-    Pupil pupilB;
+    // Results of an image playback frame already detected with the same settings are taken from the cache
+    std::vector<Pupil> Pupils;
+    cv::Mat undistortedFrame;
+    const quint64 resultKey = resultCacheKey();
+    if(!resultCache.find(cimg.frameNumber, resultKey, Pupils)) {
+        if(autoParamEnabled && autoParamScheduled) {
+            performAutoParam();
+            autoParamScheduled = false;
+        }
 
-    try {
+        // Undistortion and grayscale conversion are done once for both eyes, a whole-image undistortion is kept for display
         //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        if(useOutlineConfidence) {
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods1[pupilDetectionIndex], &PupilDetectionMethod::runWithConfidence, bwFrameA));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods2[pupilDetectionIndex], &PupilDetectionMethod::runWithConfidence, bwFrameB));
-        } else {
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods1[pupilDetectionIndex], &PupilDetectionMethod::run, bwFrameA));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods2[pupilDetectionIndex], &PupilDetectionMethod::run, bwFrameB));
+        std::vector<cv::Mat> frames;
+        undistortedFrame = preprocessImage(cimg.img, {cropA, cropB}, !usePupilUndistort && useImageUndistort, frames);
+        //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
+
+        // We execute pupil detection for both eyes concurrently, then wait till both are finished
+        Pupil pupilA;
+        Pupil pupilB;
+
+        if(!detectionTasks.run({{getCurrentMethod1(), frames[0], &pupilA},
+                                {getCurrentMethod2(), frames[1], &pupilB}})) {
+            pupilA.clear();
+            pupilB.clear();
         }
-        synchronizer.waitForFinished();
-        // Unhandled exceptions in the QtConcurrent::run function are thrown at the result() call
-        pupilA = synchronizer.futures().at(0).result();
-        pupilB = synchronizer.futures().at(1).result();
-    } catch (...) {
-        pupilA.clear();
-        pupilB.clear();
-    }
 
-    // Shift the pupil position back to the original image coordinates instead of ROI
-    if(useROIPreProcessing) {
-        pupilA.shift(roiA.tl());
-        pupilB.shift(roiB.tl());
-    }
+        // Shift the pupil position back to the original image coordinates instead of ROI
+        if(useROIPreProcessing) {
+            pupilA.shift(roiA.tl());
+            pupilB.shift(roiB.tl());
+        }
 
-    if(usePupilUndistort && !useImageUndistort) {
-        pupilA.undistortedDiameter = singleCalibration->undistortPupilDiameter(pupilA);
-        pupilB.undistortedDiameter = singleCalibration->undistortPupilDiameter(pupilB);
-    } else if(!usePupilUndistort && useImageUndistort) {
-        pupilA.undistortedDiameter = pupilA.diameter();
-        pupilB.undistortedDiameter = pupilB.diameter();
-    }
+        if(usePupilUndistort && !useImageUndistort) {
+            std::vector<double> diameters = singleCalibration->undistortPupilDiameters({pupilA, pupilB});
+            pupilA.undistortedDiameter = diameters[0];
+            pupilB.undistortedDiameter = diameters[1];
+        } else if(!usePupilUndistort && useImageUndistort) {
+            pupilA.undistortedDiameter = pupilA.diameter();
+            pupilB.undistortedDiameter = pupilB.diameter();
+        }
 
-    pupilA.algorithmName = pupilDetectionMethods1[pupilDetectionIndex]->title();
-    pupilB.algorithmName = pupilA.algorithmName;
+        pupilA.algorithmName = getCurrentMethod1()->title();
+        pupilB.algorithmName = pupilA.algorithmName;
 
-    // TODO: ? Implement basic pythagorean px-mm mapping
+        // TODO: ? Implement basic pythagorean px-mm mapping
 
-    std::vector<Pupil> Pupils;
-    Pupils.push_back(pupilA);
-    Pupils.push_back(pupilB);
+        Pupils.push_back(pupilA);
+        Pupils.push_back(pupilB);
+        resultCache.insert(cimg.frameNumber, resultKey, Pupils);
+    }
 
     // NOTE: It is important to not only check for drawDelay, but care for the special case,
     // when the last signals from an image playback arrive before another drawDelay is happened,
@@ -489,7 +917,11 @@ void PupilDetection::onNewSingleImageForTwoPupilImpl(const CameraImage &cimg) {
 // //        mimg->imgB = cimg->img.clone(); // would be the same
 
         if(!usePupilUndistort && useImageUndistort) {
-            mimg.img = singleCalibration->undistortImage(cimg.img);
+            // Reuse the undistorted detection frame if it already covers the whole image
+            if(!undistortedFrame.empty())
+                mimg.img = undistortedFrame;
+            else
+                mimg.img = singleCalibration->undistortImage(cimg.img);
         } else {
             mimg.img = cimg.img.clone();
         }
@@ -512,7 +944,7 @@ void PupilDetection::onNewSingleImageForTwoPupilImpl(const CameraImage &cimg) {
 
         emit processedPupilDataLowFPS(cimg.timestamp, currentProcMode, Pupils, QString::fromStdString(cimg.filename));
     }
-    emit processedPupilData(cimg.timestamp, currentProcMode, Pupils, QString::fromStdString(cimg.filename));
+    publishPupilData(cimg, Pupils);
 
 }
 
@@ -558,110 +990,93 @@ void PupilDetection::onNewStereoImageForOnePupilImpl(const CameraImage &simg) {
         return;
     }
 
-    cv::Mat bwFrame = simg.img;
-    cv::Mat bwFrameSecondary = simg.imgSecondary;
     cv::Rect roi = cv::Rect(0, 0, simg.img.cols, simg.img.rows);
     cv::Rect roiSecondary = cv::Rect(0, 0, simg.img.cols, simg.img.rows);
 
     // GB: like this the global ROI variables can inform performAutoParam() about ROI sizes
-    if(useROIPreProcessing && !ROIstereoImageOnePupil1.empty() && roi != ROIstereoImageOnePupil1 && ROIstereoImageOnePupil1.width<=bwFrame.cols && ROIstereoImageOnePupil1.height<=bwFrame.rows) {
+    if(useROIPreProcessing && !ROIstereoImageOnePupil1.empty() && roi != ROIstereoImageOnePupil1 && ROIstereoImageOnePupil1.width<=simg.img.cols && ROIstereoImageOnePupil1.height<=simg.img.rows) {
         roi = ROIstereoImageOnePupil1;
-        bwFrame = bwFrame(ROIstereoImageOnePupil1);
     } else if(autoParamEnabled && autoParamScheduled)
         ROIstereoImageOnePupil1 = roi;
 
-    if(useROIPreProcessing && !ROIstereoImageOnePupil2.empty() && roiSecondary != ROIstereoImageOnePupil2 && ROIstereoImageOnePupil2.width<=bwFrameSecondary.cols && ROIstereoImageOnePupil2.height<=bwFrameSecondary.rows) {
+    if(useROIPreProcessing && !ROIstereoImageOnePupil2.empty() && roiSecondary != ROIstereoImageOnePupil2 && ROIstereoImageOnePupil2.width<=simg.imgSecondary.cols && ROIstereoImageOnePupil2.height<=simg.imgSecondary.rows) {
         roiSecondary = ROIstereoImageOnePupil2;
-        bwFrameSecondary = bwFrameSecondary(ROIstereoImageOnePupil2);
     } else if(autoParamEnabled && autoParamScheduled)
         ROIstereoImageOnePupil2 = roiSecondary;
 
-    if(autoParamEnabled && autoParamScheduled) {
-        performAutoParam();
-        autoParamScheduled = false;
-    }
-
-    if (simg.img.channels() > 1) {
-        cv::cvtColor(bwFrame, bwFrame, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(bwFrameSecondary, bwFrameSecondary, cv::COLOR_BGR2GRAY);
-    }
-
-    // We execute pupil detection for main and secondary images concurrently using treads, we execute both in separate threads, then wait till both are finished
-    QFutureSynchronizer<Pupil> synchronizer;
-    Pupil pupil;
-    Pupil pupilSecondary;
+    // The method instances of the other slots must not be released by an algorithm change while the frame is processed
+    const QMutexLocker methodLocker(&methodMutex);
 
-    try {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        if(useOutlineConfidence) {
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods1[pupilDetectionIndex], &PupilDetectionMethod::runWithConfidence, bwFrame));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods2[pupilDetectionIndex], &PupilDetectionMethod::runWithConfidence, bwFrameSecondary));
-        } else {
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods1[pupilDetectionIndex], &PupilDetectionMethod::run, bwFrame));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods2[pupilDetectionIndex], &PupilDetectionMethod::run, bwFrameSecondary));
+    // Results of an image playback frame already detected with the same settings are taken from the cache
+    std::vector<Pupil> Pupils;
+    const quint64 resultKey = resultCacheKey();
+    if(!resultCache.find(simg.frameNumber, resultKey, Pupils)) {
+        if(autoParamEnabled && autoParamScheduled) {
+            performAutoParam();
+            autoParamScheduled = false;
         }
-        synchronizer.waitForFinished();
-        // Unhandled exceptions in the QtConcurrent::run function are thrown at the result() call
-        pupil = synchronizer.futures().at(0).result();
-        pupilSecondary = synchronizer.futures().at(1).result();
-    } catch (...) {
-        pupil.clear();
-        pupilSecondary.clear();
-    }
-    //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()));
-
-    // Shift the pupil position back to the original image coordinates instead of ROI
-    if(useROIPreProcessing) {
-        pupil.shift(roi.tl());
-        pupilSecondary.shift(roiSecondary.tl());
-    }
-
-    if(usePupilUndistort && !useImageUndistort) {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        std::pair<double, double> diameters = stereoCalibration->undistortPupilDiameters(pupil, pupilSecondary);
-        pupil.undistortedDiameter = diameters.first;
-        pupilSecondary.undistortedDiameter = diameters.second;
-        //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
-    } else if(!usePupilUndistort && useImageUndistort) {
-        pupil.undistortedDiameter = pupil.diameter();
-        pupilSecondary.undistortedDiameter = pupil.diameter();
-    }
-
-    pupil.algorithmName = pupilDetectionMethods1[pupilDetectionIndex]->title();
-    pupilSecondary.algorithmName = pupil.algorithmName;
 
-    // If both pupil detections are valid and the camera is calibrated, we can perform unit conversion to absolute measure
-    if(pupil.valid(-2.0) && pupilSecondary.valid(-2.0) && calibrated) {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Pupil pupil;
+        Pupil pupilSecondary;
+
+        if(useEpipolarSearch && calibrated) {
+            // The secondary view is only searched where the main view pupil can appear, pupils are already in image coordinates
+            std::vector<Pupil> pupils;
+            std::vector<Pupil> pupilsSecondary;
+            if(detectStereoPupilsEpipolar(simg, {getCurrentMethod1()}, {getCurrentMethod2()},
+                                          {roi}, {roiSecondary}, pupils, pupilsSecondary)) {
+                pupil = pupils[0];
+                pupilSecondary = pupilsSecondary[0];
+            }
+        } else {
+            std::vector<cv::Mat> frames;
+            std::vector<cv::Mat> framesSecondary;
+            preprocessImage(simg.img, {roi}, false, frames);
+            preprocessImage(simg.imgSecondary, {roiSecondary}, false, framesSecondary);
 
-        Pupil rotPupil(pupil);
-        rotPupil.angle += 360-rotPupil.angle;
-        Pupil rotPupilSecondary(pupilSecondary);
-        rotPupilSecondary.angle += 360-rotPupilSecondary.angle;
+            // We execute pupil detection for main and secondary images concurrently, then wait till both are finished
+            //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if(!detectionTasks.run({{getCurrentMethod1(), frames[0], &pupil},
+                                    {getCurrentMethod2(), framesSecondary[0], &pupilSecondary}})) {
+                pupil.clear();
+                pupilSecondary.clear();
+            }
+            //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()));
+
+            // Shift the pupil position back to the original image coordinates instead of ROI
+            if(useROIPreProcessing) {
+                pupil.shift(roi.tl());
+                pupilSecondary.shift(roiSecondary.tl());
+            }
+        }
 
-        // convert pupil detection from pixel into mm through stereo calibration
-        // Select the top left and top right corner of the bounding rects of the pupils as the points we triangulate
-        cv::Point2f mainPointsArr[4]; // rotatedRect points in order: bottomLeft, topLeft, topRight, bottomRight
-        rotPupil.points(mainPointsArr);
-        int secondPoint = rotPupil.size.width > rotPupil.size.height ? 2 : 0; // if the pupil major axis is horizontal use topLeft and topRight, else topLeft and bottomLeft
-        //cv::line(mimg->img,mainPointsArr[1], mainPointsArr[secondPoint], cv::Scalar(255, 0, 0));
+        if(usePupilUndistort && !useImageUndistort) {
+            //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::pair<double, double> diameters = stereoCalibration->undistortPupilDiameters(pupil, pupilSecondary);
+            pupil.undistortedDiameter = diameters.first;
+            pupilSecondary.undistortedDiameter = diameters.second;
+            //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
+        } else if(!usePupilUndistort && useImageUndistort) {
+            pupil.undistortedDiameter = pupil.diameter();
+            pupilSecondary.undistortedDiameter = pupil.diameter();
+        }
 
-        cv::Point2f secondaryPointsArr[4];
-        rotPupilSecondary.points(secondaryPointsArr);
-        //cv::line(mimg->imgSecondary,secondaryPointsArr[1], secondaryPointsArr[secondPoint], cv::Scalar(255, 0, 0));
+        pupil.algorithmName = getCurrentMethod1()->title();
+        pupilSecondary.algorithmName = pupil.algorithmName;
 
-        std::vector<cv::Point2f> mainPoints{mainPointsArr[1], mainPointsArr[secondPoint]}, secondaryPoints{secondaryPointsArr[1], secondaryPointsArr[secondPoint]};
-        std::vector<cv::Point3f> worldPoints = stereoCalibration->convertPointsTo3D(mainPoints, secondaryPoints);
+        // If both pupil detections are valid and the camera is calibrated, we can perform unit conversion to absolute measure
+        if(pupil.valid(-2.0) && pupilSecondary.valid(-2.0) && calibrated) {
+            //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            pupil.physicalDiameter = static_cast<float>(stereoCalibration->physicalPupilDiameters({pupil}, {pupilSecondary}).front());
+            pupilSecondary.physicalDiameter = pupil.physicalDiameter;
+            //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+        }
 
-        pupil.physicalDiameter = static_cast<float>(cv::norm(worldPoints[0] - worldPoints[1]));
-        pupilSecondary.physicalDiameter = pupil.physicalDiameter;
-        //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+        Pupils.push_back(pupil);
+        Pupils.push_back(pupilSecondary);
+        resultCache.insert(simg.frameNumber, resultKey, Pupils);
     }
 
-    std::vector<Pupil> Pupils;
-    Pupils.push_back(pupil);
-    Pupils.push_back(pupilSecondary);
-
     // NOTE: It is important to not only check for drawDelay, but care for the special case,
     // when the last signals from an image playback arrive before another drawDelay is happened,
     // to not make the playback stuck just near the end. That is why we check for frame number too
@@ -695,7 +1110,7 @@ void PupilDetection::onNewStereoImageForOnePupilImpl(const CameraImage &simg) {
         emit processedPupilDataLowFPS(simg.timestamp, currentProcMode, Pupils, QString::fromStdString(simg.filename));
     }
 
-    emit processedPupilData(simg.timestamp, currentProcMode, Pupils, QString::fromStdString(simg.filename));
+    publishPupilData(simg, Pupils);
 }
 // Slot callback for receiving new stereo camera images, associated with two viewpoints, both looking at both eyes
 // Performs the processing/pupil detection
@@ -737,180 +1152,134 @@ void PupilDetection::onNewStereoImageForTwoPupilImpl(const CameraImage &simg) {
         return;
     }
 
-    cv::Mat bwFrameA1 = simg.img;
-    cv::Mat bwFrameA2 = simg.imgSecondary;
-    cv::Mat bwFrameB1 = simg.img;
-    cv::Mat bwFrameB2 = simg.imgSecondary;
     cv::Rect roiA1 = cv::Rect(0, 0, simg.img.cols, simg.img.rows);
     cv::Rect roiA2 = cv::Rect(0, 0, simg.img.cols, simg.img.rows);
     cv::Rect roiB1 = cv::Rect(0, 0, simg.img.cols, simg.img.rows);
     cv::Rect roiB2 = cv::Rect(0, 0, simg.img.cols, simg.img.rows);
 
-    if(useROIPreProcessing && !ROIstereoImageTwoPupilA1.empty() && roiA1 != ROIstereoImageTwoPupilA1 && ROIstereoImageTwoPupilA1.width<=bwFrameA1.cols && ROIstereoImageTwoPupilA1.height<=bwFrameA1.rows) {
+    if(useROIPreProcessing && !ROIstereoImageTwoPupilA1.empty() && roiA1 != ROIstereoImageTwoPupilA1 && ROIstereoImageTwoPupilA1.width<=simg.img.cols && ROIstereoImageTwoPupilA1.height<=simg.img.rows) {
         roiA1 = ROIstereoImageTwoPupilA1;
-        bwFrameA1 = bwFrameA1(ROIstereoImageTwoPupilA1);
     } else if(autoParamEnabled && autoParamScheduled)
         ROIstereoImageTwoPupilA1 = roiA1;
 
-    if(useROIPreProcessing && !ROIstereoImageTwoPupilA2.empty() && roiA2 != ROIstereoImageTwoPupilA2 && ROIstereoImageTwoPupilA2.width<=bwFrameA2.cols && ROIstereoImageTwoPupilA2.height<=bwFrameA2.rows) {
+    if(useROIPreProcessing && !ROIstereoImageTwoPupilA2.empty() && roiA2 != ROIstereoImageTwoPupilA2 && ROIstereoImageTwoPupilA2.width<=simg.imgSecondary.cols && ROIstereoImageTwoPupilA2.height<=simg.imgSecondary.rows) {
         roiA2 = ROIstereoImageTwoPupilA2;
-        bwFrameA2 = bwFrameA2(ROIstereoImageTwoPupilA2);
     } else if(autoParamEnabled && autoParamScheduled)
         ROIstereoImageTwoPupilA2 = roiA2;
 
-    if(useROIPreProcessing && !ROIstereoImageTwoPupilB1.empty() && roiB1 != ROIstereoImageTwoPupilB1 && ROIstereoImageTwoPupilB1.width<=bwFrameB1.cols && ROIstereoImageTwoPupilB1.height<=bwFrameB1.rows) {
+    if(useROIPreProcessing && !ROIstereoImageTwoPupilB1.empty() && roiB1 != ROIstereoImageTwoPupilB1 && ROIstereoImageTwoPupilB1.width<=simg.img.cols && ROIstereoImageTwoPupilB1.height<=simg.img.rows) {
         roiB1 = ROIstereoImageTwoPupilB1;
-        bwFrameB1 = bwFrameB1(ROIstereoImageTwoPupilB1);
     } else if(autoParamEnabled && autoParamScheduled)
         ROIstereoImageTwoPupilB1 = roiB1;
 
-    if(useROIPreProcessing && !ROIstereoImageTwoPupilB2.empty() && roiB2 != ROIstereoImageTwoPupilB2 && ROIstereoImageTwoPupilB2.width<=bwFrameB2.cols && ROIstereoImageTwoPupilB2.height<=bwFrameB2.rows) {
+    if(useROIPreProcessing && !ROIstereoImageTwoPupilB2.empty() && roiB2 != ROIstereoImageTwoPupilB2 && ROIstereoImageTwoPupilB2.width<=simg.imgSecondary.cols && ROIstereoImageTwoPupilB2.height<=simg.imgSecondary.rows) {
         roiB2 = ROIstereoImageTwoPupilB2;
-        bwFrameB2 = bwFrameB2(ROIstereoImageTwoPupilB2);
     } else if(autoParamEnabled && autoParamScheduled)
         ROIstereoImageTwoPupilB2 = roiB2;
 
-    if(autoParamEnabled && autoParamScheduled) {
-        performAutoParam();
-        autoParamScheduled = false;
-    }
-
-    if (bwFrameA1.channels() > 1) {
-        cv::cvtColor(bwFrameA1, bwFrameA1, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(bwFrameB1, bwFrameB1, cv::COLOR_BGR2GRAY);
-    }
-    if (bwFrameA2.channels() > 1) {
-        cv::cvtColor(bwFrameA2, bwFrameA2, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(bwFrameB2, bwFrameB2, cv::COLOR_BGR2GRAY);
-    }
+    // The method instances of the other slots must not be released by an algorithm change while the frame is processed
+    const QMutexLocker methodLocker(&methodMutex);
 
-    // We execute pupil detection for main and secondary images concurrently using treads, we execute both in separate threads, then wait till both are finished
-    QFutureSynchronizer<Pupil> synchronizer;
-    Pupil pupilA1;
-    Pupil pupilA2;
-    Pupil pupilB1;
-    Pupil pupilB2;
-
-    try {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        if(useOutlineConfidence) {
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods1[pupilDetectionIndex], &PupilDetectionMethod::runWithConfidence, bwFrameA1));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods2[pupilDetectionIndex], &PupilDetectionMethod::runWithConfidence, bwFrameA2));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods3[pupilDetectionIndex], &PupilDetectionMethod::runWithConfidence, bwFrameB1));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods4[pupilDetectionIndex], &PupilDetectionMethod::runWithConfidence, bwFrameB2));
-        } else {
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods1[pupilDetectionIndex], &PupilDetectionMethod::run, bwFrameA1));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods2[pupilDetectionIndex], &PupilDetectionMethod::run, bwFrameA2));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods3[pupilDetectionIndex], &PupilDetectionMethod::run, bwFrameB1));
-            synchronizer.addFuture(QtConcurrent::run(pupilDetectionMethods4[pupilDetectionIndex], &PupilDetectionMethod::run, bwFrameB2));
+    // Results of an image playback frame already detected with the same settings are taken from the cache
+    std::vector<Pupil> Pupils;
+    const quint64 resultKey = resultCacheKey();
+    if(!resultCache.find(simg.frameNumber, resultKey, Pupils)) {
+        if(autoParamEnabled && autoParamScheduled) {
+            performAutoParam();
+            autoParamScheduled = false;
         }
-        synchronizer.waitForFinished();
-        // Unhandled exceptions in the QtConcurrent::run function are thrown at the result() call
-        pupilA1 = synchronizer.futures().at(0).result();
-        pupilA2 = synchronizer.futures().at(1).result();
-        pupilB1 = synchronizer.futures().at(2).result();
-        pupilB2 = synchronizer.futures().at(3).result();
-    } catch (...) {
-        pupilA1.clear();
-        pupilA2.clear();
-        pupilB1.clear();
-        pupilB2.clear();
-    }
-    //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()));
-
-    // Shift the pupil position back to the original image coordinates instead of ROI
-    if(useROIPreProcessing) {
-        pupilA1.shift(roiA1.tl());
-        pupilA2.shift(roiA2.tl());
-        pupilB1.shift(roiB1.tl());
-        pupilB2.shift(roiB2.tl());
-    }
-
-    if(usePupilUndistort && !useImageUndistort) {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        std::pair<double, double> diameters1 = stereoCalibration->undistortPupilDiameters(pupilA1, pupilB1);
-        pupilA1.undistortedDiameter = diameters1.first;
-        pupilB1.undistortedDiameter = diameters1.second;
-        std::pair<double, double> diameters2 = stereoCalibration->undistortPupilDiameters(pupilA2, pupilB2);
-        pupilA2.undistortedDiameter = diameters2.first;
-        pupilB2.undistortedDiameter = diameters2.second;
-        //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
-    } else if(!usePupilUndistort && useImageUndistort) {
-        pupilA1.undistortedDiameter = pupilA1.diameter();
-        pupilA2.undistortedDiameter = pupilA1.diameter();
-        pupilB1.undistortedDiameter = pupilB1.diameter();
-        pupilB2.undistortedDiameter = pupilB1.diameter();
-    }
-
-    pupilA1.algorithmName = pupilDetectionMethods1[pupilDetectionIndex]->title();
-    pupilA2.algorithmName = pupilA1.algorithmName;
-    pupilB1.algorithmName = pupilDetectionMethods1[pupilDetectionIndex]->title();
-    pupilB2.algorithmName = pupilB1.algorithmName;
-
-    // Eye A
-    // If both pupil detections are valid and the camera is calibrated, we can perform unit conversion to absolute measure
-    if(pupilA1.valid(-2.0) && pupilA2.valid(-2.0) && calibrated) {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-
-        Pupil rotPupilA1(pupilA1);
-        rotPupilA1.angle += 360-rotPupilA1.angle;
-        Pupil rotPupilA2(pupilA2);
-        rotPupilA2.angle += 360-rotPupilA2.angle;
-
-        // convert pupil detection from pixel into mm through stereo calibration
-        // Select the top left and top right corner of the bounding rects of the pupils as the points we triangulate
-        cv::Point2f mainPointsArrA[4]; // rotatedRect points in order: bottomLeft, topLeft, topRight, bottomRight
-        rotPupilA1.points(mainPointsArrA);
-        int secondPointA = rotPupilA1.size.width > rotPupilA1.size.height ? 2 : 0; // if the pupil major axis is horizontal use topLeft and topRight, else topLeft and bottomLeft
-        //cv::line(mimg->img,mainPointsArr[1], mainPointsArr[secondPoint], cv::Scalar(255, 0, 0));
-
-        cv::Point2f secondaryPointsArrA[4];
-        rotPupilA2.points(secondaryPointsArrA);
-        //cv::line(mimg->imgSecondary,secondaryPointsArr[1], secondaryPointsArr[secondPoint], cv::Scalar(255, 0, 0));
 
-        std::vector<cv::Point2f> mainPointsA{mainPointsArrA[1], mainPointsArrA[secondPointA]}, secondaryPointsA{secondaryPointsArrA[1], secondaryPointsArrA[secondPointA]};
-        std::vector<cv::Point3f> worldPointsA = stereoCalibration->convertPointsTo3D(mainPointsA, secondaryPointsA);
-
-        pupilA1.physicalDiameter = static_cast<float>(cv::norm(worldPointsA[0] - worldPointsA[1]));
-        pupilA2.physicalDiameter = pupilA1.physicalDiameter;
-        //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
-    }
-
-    // Eye B
-    // If both pupil detections are valid and the camera is calibrated, we can perform unit conversion to absolute measure
-    if(pupilB1.valid(-2.0) && pupilB2.valid(-2.0) && calibrated) {
-        //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Pupil pupilA1;
+        Pupil pupilA2;
+        Pupil pupilB1;
+        Pupil pupilB2;
+
+        if(useEpipolarSearch && calibrated) {
+            // The secondary views are only searched where the main view pupils can appear, pupils are already in image coordinates
+            std::vector<Pupil> pupils;
+            std::vector<Pupil> pupilsSecondary;
+            if(detectStereoPupilsEpipolar(simg, {getCurrentMethod1(), getCurrentMethod3()},
+                                          {getCurrentMethod2(), getCurrentMethod4()},
+                                          {roiA1, roiB1}, {roiA2, roiB2}, pupils, pupilsSecondary)) {
+                pupilA1 = pupils[0];
+                pupilB1 = pupils[1];
+                pupilA2 = pupilsSecondary[0];
+                pupilB2 = pupilsSecondary[1];
+            }
+        } else {
+            // Grayscale conversion is done once per view for both eyes, the 1 crops are in the main, the 2 crops in the secondary image
+            std::vector<cv::Mat> frames;
+            std::vector<cv::Mat> framesSecondary;
+            preprocessImage(simg.img, {roiA1, roiB1}, false, frames);
+            preprocessImage(simg.imgSecondary, {roiA2, roiB2}, false, framesSecondary);
 
-        Pupil rotPupilB1(pupilB1);
-        rotPupilB1.angle += 360-rotPupilB1.angle;
-        Pupil rotPupilB2(pupilB2);
-        rotPupilB2.angle += 360-rotPupilB2.angle;
+            // We execute pupil detection for both eyes in main and secondary images concurrently, then wait till all are finished
+            //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if(!detectionTasks.run({{getCurrentMethod1(), frames[0], &pupilA1},
+                                    {getCurrentMethod2(), framesSecondary[0], &pupilA2},
+                                    {getCurrentMethod3(), frames[1], &pupilB1},
+                                    {getCurrentMethod4(), framesSecondary[1], &pupilB2}})) {
+                pupilA1.clear();
+                pupilA2.clear();
+                pupilB1.clear();
+                pupilB2.clear();
+            }
+            //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()));
+
+            // Shift the pupil position back to the original image coordinates instead of ROI
+            if(useROIPreProcessing) {
+                pupilA1.shift(roiA1.tl());
+                pupilA2.shift(roiA2.tl());
+                pupilB1.shift(roiB1.tl());
+                pupilB2.shift(roiB2.tl());
+            }
+        }
 
-        // convert pupil detection from pixel into mm through stereo calibration
-        // Select the top left and top right corner of the bounding rects of the pupils as the points we triangulate
-        cv::Point2f mainPointsArrB[4]; // rotatedRect points in order: bottomLeft, topLeft, topRight, bottomRight
-        rotPupilB1.points(mainPointsArrB);
-        int secondPointB = rotPupilB1.size.width > rotPupilB1.size.height ? 2 : 0; // if the pupil major axis is horizontal use topLeft and topRight, else topLeft and bottomLeft
-        //cv::line(mimg->img,mainPointsArr[1], mainPointsArr[secondPoint], cv::Scalar(255, 0, 0));
+        if(usePupilUndistort && !useImageUndistort) {
+            //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            // Both eyes in one batch, the 1 pupils are in the main, the 2 pupils in the secondary view
+            std::vector<std::pair<double, double>> diameters = stereoCalibration->undistortPupilDiameters({pupilA1, pupilB1}, {pupilA2, pupilB2});
+            pupilA1.undistortedDiameter = diameters[0].first;
+            pupilA2.undistortedDiameter = diameters[0].second;
+            pupilB1.undistortedDiameter = diameters[1].first;
+            pupilB2.undistortedDiameter = diameters[1].second;
+            //qDebug()<< std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0 ;
+        } else if(!usePupilUndistort && useImageUndistort) {
+            pupilA1.undistortedDiameter = pupilA1.diameter();
+            pupilA2.undistortedDiameter = pupilA1.diameter();
+            pupilB1.undistortedDiameter = pupilB1.diameter();
+            pupilB2.undistortedDiameter = pupilB1.diameter();
+        }
 
-        cv::Point2f secondaryPointsArrB[4];
-        rotPupilB2.points(secondaryPointsArrB);
-        //cv::line(mimg->imgSecondary,secondaryPointsArr[1], secondaryPointsArr[secondPoint], cv::Scalar(255, 0, 0));
+        pupilA1.algorithmName = getCurrentMethod1()->title();
+        pupilA2.algorithmName = pupilA1.algorithmName;
+        pupilB1.algorithmName = getCurrentMethod1()->title();
+        pupilB2.algorithmName = pupilB1.algorithmName;
 
-        std::vector<cv::Point2f> mainPointsB{mainPointsArrB[1], mainPointsArrB[secondPointB]}, secondaryPointsB{secondaryPointsArrB[1], secondaryPointsArrB[secondPointB]};
-        std::vector<cv::Point3f> worldPointsB = stereoCalibration->convertPointsTo3D(mainPointsB, secondaryPointsB);
+        // If both pupil detections of an eye are valid and the camera is calibrated, we can perform unit conversion to absolute measure
+        // Both eyes are measured in one batch, an eye without valid detection in both views gets no physical diameter
+        if(calibrated && ((pupilA1.valid(-2.0) && pupilA2.valid(-2.0)) || (pupilB1.valid(-2.0) && pupilB2.valid(-2.0)))) {
+            //std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::vector<double> physicalDiameters = stereoCalibration->physicalPupilDiameters({pupilA1, pupilB1}, {pupilA2, pupilB2});
+
+            if(pupilA1.valid(-2.0) && pupilA2.valid(-2.0)) {
+                pupilA1.physicalDiameter = static_cast<float>(physicalDiameters[0]);
+                pupilA2.physicalDiameter = pupilA1.physicalDiameter;
+            }
+            if(pupilB1.valid(-2.0) && pupilB2.valid(-2.0)) {
+                pupilB1.physicalDiameter = static_cast<float>(physicalDiameters[1]);
+                pupilB2.physicalDiameter = pupilB1.physicalDiameter;
+            }
+            //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+        }
 
-        pupilB1.physicalDiameter = static_cast<float>(cv::norm(worldPointsB[0] - worldPointsB[1]));
-        pupilB2.physicalDiameter = pupilB1.physicalDiameter;
-        //runtimeHistory.push_back(std::make_pair(simg->timestamp, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+        Pupils.push_back(pupilA1);
+        Pupils.push_back(pupilA2);
+        Pupils.push_back(pupilB1);
+        Pupils.push_back(pupilB2);
+        resultCache.insert(simg.frameNumber, resultKey, Pupils);
     }
 
-    std::vector<Pupil> Pupils;
-    Pupils.push_back(pupilA1);
-    Pupils.push_back(pupilA2);
-    Pupils.push_back(pupilB1);
-    Pupils.push_back(pupilB2);
-
     // NOTE: It is important to not only check for drawDelay, but care for the special case,
     // when the last signals from an image playback arrive before another drawDelay is happened,
     // to not make the playback stuck just near the end. That is why we check for frame number too
@@ -947,7 +1316,7 @@ void PupilDetection::onNewStereoImageForTwoPupilImpl(const CameraImage &simg) {
         emit processedPupilDataLowFPS(simg.timestamp, currentProcMode, Pupils, QString::fromStdString(simg.filename));
     }
 
-    emit processedPupilData(simg.timestamp, currentProcMode, Pupils, QString::fromStdString(simg.filename));
+    publishPupilData(simg, Pupils);
 }
 
 // GB: I found this function like this, and did not bother it
@@ -972,6 +1341,8 @@ template <typename T> void PupilDetection::writeVectorCSV(std::vector<std::pair<
 // When the config changes, emit a signal to inform others of the current settings config i.e. subject configuration
 void PupilDetection::setConfigLabel(QString config) {
     currentConfigLabel = config;
+    // Emitted by the algorithm settings whenever they applied their parameters
+    invalidateResultCacheKey();
         if (config =="Automatic Parametrization")
         setAutoParamSettingsEnabled(true);
     else
@@ -1068,11 +1439,31 @@ ProcMode PupilDetection::getCurrentProcMode() {
     return (ProcMode)currentProcMode;
 }
 
+PupilResultBroadcaster *PupilDetection::getResultBroadcaster() {
+    return resultBroadcaster;
+}
+
+// Publishes the full-rate detection result of a frame through the result broadcaster, which only queues a sequence number per consumer
+// The frame index is published instead of the filename, consumers look the filename up from the recording's filenames set in setCamera()
+// The legacy processedPupilData signal copies the pupil vector and filename for every queued receiver, so it is only emitted when connected
+void PupilDetection::publishPupilData(const CameraImage &image, const std::vector<Pupil> &Pupils) {
+    frameResult.timestamp = image.timestamp;
+    frameResult.frameNumber = image.frameNumber;
+    frameResult.procMode = currentProcMode;
+    frameResult.setPupils(Pupils);
+    resultBroadcaster->publish(frameResult);
+
+    if(receivers(SIGNAL(processedPupilData(quint64, int, std::vector<Pupil>, QString))) > 0)
+        emit processedPupilData(image.timestamp, currentProcMode, Pupils, QString::fromStdString(image.filename));
+}
+
 void PupilDetection::setCurrentProcMode(int val) {
 
     configureCameraConnection(true);
 
     currentProcMode = (ProcMode)val;
+    invalidateResultCacheKey();
+    applyThreadBudget();
 
     configureCameraConnection(false);
 }
@@ -1110,6 +1501,8 @@ void PupilDetection::performAutoParam() {
     if(!autoParamEnabled)
         return;
 
+    const QMutexLocker locker(&methodMutex);
+
     std::vector<PupilDetectionMethod*> algInstances;
 
     std::vector<cv::Rect> rois;
@@ -1203,7 +1596,7 @@ void PupilDetection::performAutoParam() {
             qDebug() << "Set AutoParam for algorithm ExCuSe, instance " << c;
             qDebug() << "max_ellipse_radi =" << alg->max_ellipse_radi;
 
-        } if(pupilDetectionIndex == 2) {
+        } else if(pupilDetectionIndex == 2) {
             // PURE
             PuRe *alg = dynamic_cast<PuRe*>(algInstances[c]);
 
@@ -1220,7 +1613,7 @@ void PupilDetection::performAutoParam() {
             qDebug() << "maxPupilDiameterMM =" << alg->maxPupilDiameterMM;
             qDebug() << "minPupilDiameterMM =" << alg->minPupilDiameterMM;
 
-        } if(pupilDetectionIndex == 3) {
+        } else if(pupilDetectionIndex == 3) {
             // PUREST
             PuReST *alg = dynamic_cast<PuReST*>(algInstances[c]);
 
@@ -1233,7 +1626,7 @@ void PupilDetection::performAutoParam() {
             qDebug() << "maxPupilDiameterMM =" << alg->maxPupilDiameterMM;
             qDebug() << "minPupilDiameterMM =" << alg->minPupilDiameterMM;
 
-        } if(pupilDetectionIndex == 4) {
+        } else if(pupilDetectionIndex == 4) {
             // STARBURST
             Starburst *alg = dynamic_cast<Starburst*>(algInstances[c]);
 
@@ -1249,7 +1642,7 @@ void PupilDetection::performAutoParam() {
             qDebug() << "set now: corneal_reflection_ratio_to_image_size =" << alg->corneal_reflection_ratio_to_image_size;
             qDebug() << "set now: crWindowSize =" << alg->crWindowSize;
 
-        } if(pupilDetectionIndex == 5) {
+        } else if(pupilDetectionIndex == 5) {
             // SWIRSKI2D
             Swirski2D *alg = dynamic_cast<Swirski2D*>(algInstances[c]);
 
@@ -1260,9 +1653,24 @@ void PupilDetection::performAutoParam() {
             qDebug() << "set now: params.Radius_Min =" << alg->params.Radius_Min;
             qDebug() << "set now: params.Radius_Max =" << alg->params.Radius_Max;
 
+        } else if(pupilDetectionIndex == 6) {
+            // SWIRSKI3D, its 2D detection is parametrized like Swirski2D
+            Swirski3D *alg = dynamic_cast<Swirski3D*>(algInstances[c]);
+            Swirski2D *alg2D = dynamic_cast<Swirski2D*>(alg->pupilDetector);
+            if(alg2D) {
+                alg2D->params.Radius_Min = static_cast<int>( round(minRadius) );
+                alg2D->params.Radius_Max = static_cast<int>( round(maxRadius) );
+
+                qDebug() << "Set AutoParam for algorithm Swirski3D, instance " << c;
+                qDebug() << "set now: params.Radius_Min =" << alg2D->params.Radius_Min;
+                qDebug() << "set now: params.Radius_Max =" << alg2D->params.Radius_Max;
+            }
+            alg->resetModel();
         }
 
     }
+
+    invalidateResultCacheKey();
 }
 
 void PupilDetection::setSynchronised(bool synchronised) {
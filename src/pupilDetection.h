@@ -7,11 +7,16 @@
 #include <QtCore/QObject>
 #include <QtCore/QMutex>
 #include <QtCore/QRect>
+#include <atomic>
 #include "devices/camera.h"
 #include "pupil-detection-methods/PupilDetectionMethod.h"
 #include "devices/singleCamera.h"
 #include "stereoCameraCalibration.h"
 #include "devices/singleWebcam.h"
+#include "devices/syntheticCamera.h"
+#include "pupilFrameResult.h"
+#include "pupilResultCache.h"
+#include "detectionTaskGroup.h"
 
 Q_DECLARE_METATYPE(Pupil)
 Q_DECLARE_METATYPE(cv::Rect)
@@ -103,6 +108,40 @@ public:
         useImageUndistort = value;
     }
 
+    bool isResultCacheEnabled() {
+        return useResultCache;
+    }
+
+    void enableResultCache(bool value);
+
+    bool isBlinkRejectionEnabled() {
+        return useBlinkRejection;
+    }
+
+    // Frames classified as blink / without pupil (PupilDetectionMethod::blinkDetection()) skip the detection and yield an invalid pupil flagged as blink
+    void enableBlinkRejection(bool value) {
+        useBlinkRejection = value;
+    }
+
+    int getBlinkDarkContrast() {
+        return blinkDarkContrast;
+    }
+
+    int getBlinkBlobContrast() {
+        return blinkBlobContrast;
+    }
+
+    // Thresholds of the blink rejection in grey levels: the median minus the darkest half percent of the image, and the darkest
+    // pupil sized blob against its surround, must reach them for the detection to run
+    void setBlinkRejectionContrasts(int darkContrast, int blobContrast);
+
+    bool isEpipolarSearchEnabled() {
+        return useEpipolarSearch;
+    }
+
+    // Calibrated stereo modes detect the secondary views only within the epipolar window of the main view pupil (see detectStereoPupilsEpipolar())
+    void enableEpipolarSearch(bool value);
+
     void setCamera(Camera *m_camera);
 
     bool hasCamera() {
@@ -110,6 +149,8 @@ public:
     }
 
     // all maximum of 4 threads, using 4 different pupilDetectionMethods variables thread-safely
+    // Slot 1 holds an instance of every algorithm, these are the ones configured by the settings dialog
+    // The instances of slots 2-4 are only created once a processing mode needs them, see slotMethod()
     PupilDetectionMethod* getCurrentMethod1() {
         return pupilDetectionMethods1[pupilDetectionIndex];
     }
@@ -122,42 +163,32 @@ public:
     }
     //
     PupilDetectionMethod* getCurrentMethod2() {
-        return pupilDetectionMethods2[pupilDetectionIndex];
+        return slotMethod(pupilDetectionMethods2, pupilDetectionIndex);
     }
+    // Returns nullptr if the instance was not created (yet), getMethod3() and getMethod4() likewise
     PupilDetectionMethod* getMethod2(std::string method) {
-        for(auto pm: pupilDetectionMethods2) {
-            if(pm->title() == method)
-                return pm;
-        }
-        return nullptr;
+        return existingSlotMethod(pupilDetectionMethods2, method);
     }
 
     PupilDetectionMethod* getCurrentMethod3() {
-        return pupilDetectionMethods3[pupilDetectionIndex];
+        return slotMethod(pupilDetectionMethods3, pupilDetectionIndex);
     }
     PupilDetectionMethod* getMethod3(std::string method) {
-        for(auto pm: pupilDetectionMethods3) {
-            if(pm->title() == method)
-                return pm;
-        }
-        return nullptr;
+        return existingSlotMethod(pupilDetectionMethods3, method);
     }
 
     PupilDetectionMethod* getCurrentMethod4() {
-        return pupilDetectionMethods4[pupilDetectionIndex];
+        return slotMethod(pupilDetectionMethods4, pupilDetectionIndex);
     }
     PupilDetectionMethod* getMethod4(std::string method) {
-        for(auto pm: pupilDetectionMethods4) {
-            if(pm->title() == method)
-                return pm;
-        }
-        return nullptr;
+        return existingSlotMethod(pupilDetectionMethods4, method);
     }
     //
     bool isStereo() {
         if( camera &&
             (   camera->getType() == CameraImageType::LIVE_STEREO_CAMERA ||
-                camera->getType() == CameraImageType::STEREO_IMAGE_FILE ) )
+                camera->getType() == CameraImageType::STEREO_IMAGE_FILE ||
+                camera->getType() == CameraImageType::SYNTHETIC_STEREO_CAMERA ) )
             return true;
         else
             return false;
@@ -176,14 +207,26 @@ private:
 
     Camera *camera;
 
-    CameraCalibration *singleCalibration;
-    StereoCameraCalibration *stereoCalibration;
+    CameraCalibration *singleCalibration = nullptr;
+    StereoCameraCalibration *stereoCalibration = nullptr;
 
     int pupilDetectionIndex;
     QString currentConfigLabel;
 
     FrameRateCounter *frameCounter;
 
+    PupilResultBroadcaster *resultBroadcaster;
+    PupilFrameResult frameResult;
+
+    PupilResultCache resultCache;
+    QString resultCacheFileName;
+    quint64 resultCacheRecording = 0;
+    // Algorithm parameter and calibration part of the result cache key, rehashed with the next frame once stale
+    quint64 resultParametersKey = 0;
+    std::atomic<bool> resultParametersStale{true};
+
+    DetectionTaskGroup detectionTasks;
+
     ProcMode currentProcMode;
 
     std::vector<PupilDetectionMethod*> pupilDetectionMethods1;
@@ -213,6 +256,8 @@ private:
     int drawDelay;
 
     QMutex mutex;
+    // Guards the creation and release of the slot 2-4 method instances against their use in a frame, recursive as the frame processing creates them
+    QRecursiveMutex methodMutex;
     QMutex *imageMutex;
     QWaitCondition *imageProcessed;
     QWaitCondition *imagePublished;
@@ -223,6 +268,11 @@ private:
     bool useROIPreProcessing;
     bool usePupilUndistort;
     bool useImageUndistort;
+    bool useResultCache;
+    bool useBlinkRejection;
+    int blinkDarkContrast;
+    int blinkBlobContrast;
+    bool useEpipolarSearch;
     //bool showROI;
     //bool showPupilCenter;
 
@@ -231,6 +281,10 @@ private:
     template<typename T> void writeVectorCSV(std::vector<std::pair<uint64_t , T>> data, const std::string &header, const std::string &filename);
 
     void populateWithMethods(std::vector<PupilDetectionMethod*> &vec);
+    PupilDetectionMethod* slotMethod(std::vector<PupilDetectionMethod*> &slot, int index);
+    PupilDetectionMethod* existingSlotMethod(std::vector<PupilDetectionMethod*> &slot, const std::string &method);
+    void releaseSlotMethods();
+    void applyThreadBudget();
 
 
     bool autoParamEnabled = false; // true as long as there is demand for autoParam. Also for informing other class instances through getter
@@ -252,12 +306,44 @@ private:
     void onNewStereoImageForOnePupilImpl(const CameraImage &simg);
     void onNewStereoImageForTwoPupilImpl(const CameraImage &simg);
 
+    Pupil detectPupil(PupilDetectionMethod *method, const cv::Mat &frame, const cv::Rect &window=cv::Rect(), float minPupilDiameterPx=-1, float maxPupilDiameterPx=-1);
+    cv::Mat preprocessImage(const cv::Mat &image, const std::vector<cv::Rect> &crops, bool undistort, std::vector<cv::Mat> &frames);
+
+    bool detectStereoPupilsEpipolar(const CameraImage &simg,
+                                    const std::vector<PupilDetectionMethod*> &methods, const std::vector<PupilDetectionMethod*> &methodsSecondary,
+                                    const std::vector<cv::Rect> &crops, const std::vector<cv::Rect> &cropsSecondary,
+                                    std::vector<Pupil> &pupils, std::vector<Pupil> &pupilsSecondary);
+
+    // Depth of the last pupil pair of each eye (A, B) in calibration units, narrows the epipolar search window, -1 if unknown
+    double epipolarDepths[2] = {-1.0, -1.0};
+
+    // Epipolar search statistics since it was enabled, reported on the console every few hundred frames
+    struct EpipolarSearchStatistics {
+        int frames = 0;
+        int views = 0;
+        int windowed = 0; // secondary views searched within their window
+        int fallbacks = 0; // windowed views detected again over their whole ROI
+        double searchedPixels = 0;
+        double roiPixels = 0;
+        double mainTime = 0; // ms, main views over their whole ROI
+        double secondaryTime = 0; // ms, secondary views including fallbacks
+    } epipolarStatistics;
+
+    quint64 resultCacheKey();
+    quint64 resultParametersHash();
+    void invalidateResultCacheKey();
+    void loadResultCache();
+    void saveResultCache();
+
+    void publishPupilData(const CameraImage &image, const std::vector<Pupil> &Pupils);
+
     void configureCameraConnection(bool connectOrDisconnect);
 
 public slots:
 
     void setAlgorithm(QString method);
     void setConfigLabel(QString config);
+    void onCalibrationChanged();
 
     void onNewSingleImageForOnePupil(const CameraImage &img);
     void onNewSingleImageForTwoPupil(const CameraImage &img);
@@ -274,6 +360,7 @@ public slots:
 
     bool isTrackingOn();
     ProcMode getCurrentProcMode();
+    PupilResultBroadcaster *getResultBroadcaster();
     void setCurrentProcMode(int val);
     
     QRect getROIsingleImageOnePupil();
@@ -318,6 +405,11 @@ signals:
 
     void fps(double fps);
     void algorithmChanged();
+    // Slot 2-4 method instances were created or released, see getMethod2()
+    void methodInstancesChanged();
+    // Slot 2-4 method instances are about to be deleted, emitted by the thread releasing them, so receivers must connect with
+    // Qt::DirectConnection to drop their pointers before the deletion
+    void methodInstancesReleasing();
     void configChanged(QString config);
 
 };
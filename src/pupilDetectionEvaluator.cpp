@@ -0,0 +1,533 @@
+
+#include "pupilDetectionEvaluator.h"
+#include "pupil-detection-methods/PupilDetectionMethodParameters.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTextStream>
+#include <QtCore/QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+using json = nlohmann::json;
+
+// CPU time consumed by the calling thread in milliseconds
+static double threadCpuTimeMs() {
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if(!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0.0;
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return (kernel.QuadPart + user.QuadPart) / 10000.0; // 100 ns units
+#else
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+PupilDetectionEvaluator::PupilDetectionEvaluator() : thresholds({1.0, 2.0, 5.0, 10.0}), roi(), useOutlineConfidence(true) {
+}
+
+QStringList PupilDetectionEvaluator::listImages(const QString &directory) const {
+
+    QDir dir(directory);
+    if(!dir.exists()) {
+        std::cerr << "Evaluation: image directory does not exist: " << directory.toStdString() << std::endl;
+        return QStringList();
+    }
+    return dir.entryList(QStringList() << "*.png" << "*.jpg" << "*.jpeg" << "*.bmp" << "*.tif" << "*.tiff" << "*.pgm",
+                         QDir::Files, QDir::Name);
+}
+
+// Loads the selected entries as grayscale, decoding runs in parallel on the global thread pool
+bool PupilDetectionEvaluator::readImages(const QString &directory, const QStringList &entries, const std::vector<int> &selected, const std::vector<int> &segments) {
+
+    QDir dir(directory);
+
+    frames.clear();
+    frames.resize(selected.size());
+    std::vector<std::string> paths(selected.size());
+    for(size_t i=0; i<selected.size(); i++) {
+        frames[i].name = QFileInfo(entries[selected[i]]).completeBaseName().toStdString();
+        frames[i].segment = segments[i];
+        paths[i] = dir.filePath(entries[selected[i]]).toStdString();
+    }
+
+    std::vector<size_t> indices(frames.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    QtConcurrent::blockingMap(indices, [this, &paths](size_t i) {
+        frames[i].image = cv::imread(paths[i], cv::IMREAD_GRAYSCALE);
+    });
+
+    frames.erase(std::remove_if(frames.begin(), frames.end(), [](const EvaluationFrame &f) { return f.image.empty(); }), frames.end());
+
+    std::cout << "Evaluation: loaded " << frames.size() << " images from " << directory.toStdString() << std::endl;
+    return !frames.empty();
+}
+
+// Loads all images of the directory, sorted by filename like the ImageReader does
+bool PupilDetectionEvaluator::loadImages(const QString &directory, int maxFrames, int frameStep) {
+
+    QStringList entries = listImages(directory);
+
+    std::vector<int> selected;
+    frameStep = std::max(frameStep, 1);
+    for(int i=0; i<entries.size(); i+=frameStep) {
+        if(maxFrames > 0 && (int)selected.size() >= maxFrames)
+            break;
+        selected.push_back(i);
+    }
+    return readImages(directory, entries, selected, std::vector<int>(selected.size(), 0));
+}
+
+// Loads segments of consecutive images whose starts are evenly spread over the recording, so that a sample
+// covers the whole session (lighting, pupil size, gaze) while still allowing frame-to-frame comparisons
+bool PupilDetectionEvaluator::loadImageSample(const QString &directory, int segments, int segmentLength) {
+
+    QStringList entries = listImages(directory);
+
+    segments = std::max(segments, 1);
+    segmentLength = std::max(std::min(segmentLength, (int)entries.size()), 1);
+
+    std::vector<int> selected;
+    std::vector<int> segmentIds;
+    const int span = std::max((int)entries.size() - segmentLength, 0);
+    int lastEnd = 0;
+    for(int s=0; s<segments; s++) {
+        const int begin = std::max(segments > 1 ? (int)((int64_t)span * s / (segments - 1)) : span / 2, lastEnd);
+        for(int i=begin; i<begin+segmentLength && i<entries.size(); i++) {
+            selected.push_back(i);
+            segmentIds.push_back(s);
+        }
+        lastEnd = begin + segmentLength;
+    }
+    return readImages(directory, entries, selected, segmentIds);
+}
+
+// Reads the ground truth CSV and matches its rows to the loaded frames by image basename
+bool PupilDetectionEvaluator::loadGroundTruth(const QString &csvFile) {
+
+    QFile file(csvFile);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        std::cerr << "Evaluation: could not open ground truth file: " << csvFile.toStdString() << std::endl;
+        return false;
+    }
+    QTextStream in(&file);
+
+    QString header = in.readLine();
+    QChar delim = ',';
+    if(header.count(';') > header.count(delim))
+        delim = ';';
+    if(header.count('\t') > header.count(delim))
+        delim = '\t';
+
+    QStringList columns = header.split(delim);
+    for(QString &column : columns)
+        column = column.trimmed();
+
+    auto findColumn = [&columns](const QStringList &names) {
+        for(const QString &name : names) {
+            int idx = columns.indexOf(name);
+            if(idx >= 0)
+                return idx;
+        }
+        return -1;
+    };
+
+    const int nameIdx = findColumn({"filename", "timestamp_ms"});
+    const int xIdx = findColumn({"center_x", "x"});
+    const int yIdx = findColumn({"center_y", "y"});
+    const int widthIdx = findColumn({"width_px", "width"});
+    const int heightIdx = findColumn({"height_px", "height"});
+    const int angleIdx = findColumn({"angle_deg", "angle"});
+
+    if(nameIdx < 0 || xIdx < 0 || yIdx < 0 || widthIdx < 0 || heightIdx < 0) {
+        std::cerr << "Evaluation: ground truth header needs filename (or timestamp_ms), center_x, center_y, width_px and height_px columns" << std::endl;
+        return false;
+    }
+
+    std::map<std::string, size_t> frameByName;
+    for(size_t i=0; i<frames.size(); i++)
+        frameByName[frames[i].name] = i;
+
+    size_t matched = 0;
+    while(!in.atEnd()) {
+        QStringList values = in.readLine().split(delim);
+        if(values.size() < columns.size())
+            continue;
+
+        std::string name = QFileInfo(values[nameIdx].trimmed()).completeBaseName().toStdString();
+        auto it = frameByName.find(name);
+        if(it == frameByName.end())
+            continue;
+
+        EvaluationFrame &frame = frames[it->second];
+        frame.truth = cv::RotatedRect(cv::Point2f(values[xIdx].toFloat(), values[yIdx].toFloat()),
+                                      cv::Size2f(values[widthIdx].toFloat(), values[heightIdx].toFloat()),
+                                      angleIdx >= 0 ? values[angleIdx].toFloat() : 0.0f);
+        frame.hasTruth = frame.truth.size.width > 0 && frame.truth.size.height > 0;
+        matched++;
+    }
+
+    std::cout << "Evaluation: matched " << matched << " ground truth rows, " << getNumFramesWithTruth() << " frames with visible pupil" << std::endl;
+    return matched > 0;
+}
+
+void PupilDetectionEvaluator::setROI(const cv::Rect &roi) {
+    this->roi = roi;
+}
+
+void PupilDetectionEvaluator::setThresholds(const std::vector<double> &thresholds) {
+    this->thresholds = thresholds;
+}
+
+void PupilDetectionEvaluator::setUseOutlineConfidence(bool state) {
+    useOutlineConfidence = state;
+}
+
+const std::vector<EvaluationFrame> &PupilDetectionEvaluator::getFrames() const {
+    return frames;
+}
+
+size_t PupilDetectionEvaluator::getNumFramesWithTruth() const {
+    return std::count_if(frames.begin(), frames.end(), [](const EvaluationFrame &f) { return f.hasTruth; });
+}
+
+// Runs every candidate on the given frames (all frames if empty)
+// Each job owns its algorithm instance, as the algorithms keep per-instance state (e.g. PuReST tracking)
+// NOTE: splitting a candidate into chunks restarts tracking based algorithms at each chunk border
+std::vector<EvaluationResult> PupilDetectionEvaluator::evaluate(const std::vector<EvaluationCandidate> &candidates, const std::vector<size_t> &frameIndices) const {
+
+    std::vector<size_t> indices = frameIndices;
+    if(indices.empty()) {
+        indices.resize(frames.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+
+    struct Job {
+        size_t candidate;
+        size_t begin;
+        size_t end;
+        std::vector<Pupil> pupils;
+        std::vector<double> runtimesMs;
+        double cpuTimeMs = 0.0;
+        bool valid = false;
+    };
+
+    const size_t threads = std::max(QThreadPool::globalInstance()->maxThreadCount(), 1);
+    const size_t chunks = std::max<size_t>(1, std::min(indices.size(), (threads + candidates.size() - 1) / std::max<size_t>(candidates.size(), 1)));
+    const size_t chunkSize = (indices.size() + chunks - 1) / chunks;
+
+    std::vector<Job> jobs;
+    for(size_t c=0; c<candidates.size(); c++) {
+        for(size_t begin=0; begin<indices.size(); begin+=chunkSize) {
+            Job job;
+            job.candidate = c;
+            job.begin = begin;
+            job.end = std::min(begin + chunkSize, indices.size());
+            jobs.push_back(job);
+        }
+    }
+
+    std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+
+    QtConcurrent::blockingMap(jobs, [this, &candidates, &indices](Job &job) {
+        const EvaluationCandidate &candidate = candidates[job.candidate];
+        std::unique_ptr<PupilDetectionMethod> method(PupilDetectionMethodParameters::create(candidate.algorithm));
+        if(!method)
+            return;
+        PupilDetectionMethodParameters::apply(method.get(), candidate.parameterSet);
+
+        job.pupils.reserve(job.end - job.begin);
+        job.runtimesMs.reserve(job.end - job.begin);
+
+        const double cpuStart = threadCpuTimeMs();
+        for(size_t i=job.begin; i<job.end; i++) {
+            const cv::Mat &image = frames[indices[i]].image;
+            cv::Rect frameRoi = roi.area() > 0 ? (roi & cv::Rect(0, 0, image.cols, image.rows)) : cv::Rect(0, 0, image.cols, image.rows);
+            cv::Mat bwFrame = image(frameRoi);
+
+            Pupil pupil;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            try {
+                if(useOutlineConfidence)
+                    method->runWithConfidence(bwFrame, pupil);
+                else
+                    method->run(bwFrame, pupil);
+            } catch (...) {
+                pupil.clear();
+            }
+            job.runtimesMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+            if(pupil.center.x > 0 && pupil.center.y > 0)
+                pupil.shift(frameRoi.tl());
+            pupil.algorithmName = method->title();
+            job.pupils.push_back(pupil);
+        }
+        job.cpuTimeMs = threadCpuTimeMs() - cpuStart;
+        job.valid = true;
+    });
+
+    const double wallTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+    std::vector<EvaluationResult> results(candidates.size());
+    for(size_t c=0; c<candidates.size(); c++) {
+        results[c].candidate = candidates[c];
+        results[c].valid = true;
+        results[c].wallTimeMs = wallTimeMs;
+    }
+    // jobs are in candidate and frame order, so appending keeps the frame order
+    for(Job &job : jobs) {
+        EvaluationResult &result = results[job.candidate];
+        result.valid = result.valid && job.valid;
+        result.cpuTimeMs += job.cpuTimeMs;
+        result.pupils.insert(result.pupils.end(), job.pupils.begin(), job.pupils.end());
+        result.runtimesMs.insert(result.runtimesMs.end(), job.runtimesMs.begin(), job.runtimesMs.end());
+    }
+    for(EvaluationResult &result : results) {
+        if(!result.valid) {
+            std::cerr << "Evaluation: unknown algorithm " << result.candidate.algorithm << " of candidate " << result.candidate.name << std::endl;
+            continue;
+        }
+        computeMetrics(result, indices);
+    }
+
+    return results;
+}
+
+void PupilDetectionEvaluator::computeMetrics(EvaluationResult &result, const std::vector<size_t> &frameIndices) const {
+
+    result.frames = result.pupils.size();
+    result.thresholds = thresholds;
+    result.detectionRates.assign(thresholds.size(), 0.0);
+
+    double centerErrorSum = 0.0, diameterErrorSum = 0.0, relativeDiameterErrorSum = 0.0, confidenceSum = 0.0;
+    size_t centerErrorCount = 0, diameterErrorCount = 0, confidenceCount = 0;
+    std::vector<size_t> hits(thresholds.size(), 0);
+
+    for(size_t i=0; i<result.pupils.size(); i++) {
+        const Pupil &pupil = result.pupils[i];
+        const EvaluationFrame &frame = frames[frameIndices[i]];
+        const bool detected = pupil.center.x > 0 && pupil.center.y > 0;
+
+        if(detected) {
+            result.detections++;
+            const float confidence = useOutlineConfidence ? pupil.outline_confidence : pupil.confidence;
+            if(confidence >= 0) {
+                confidenceSum += confidence;
+                confidenceCount++;
+            }
+        }
+
+        if(!frame.hasTruth)
+            continue;
+        result.framesWithTruth++;
+        if(!detected)
+            continue;
+
+        const double centerError = cv::norm(pupil.center - frame.truth.center);
+        centerErrorSum += centerError;
+        centerErrorCount++;
+        for(size_t t=0; t<thresholds.size(); t++)
+            if(centerError <= thresholds[t])
+                hits[t]++;
+
+        if(pupil.hasOutline()) {
+            const double truthDiameter = std::max(frame.truth.size.width, frame.truth.size.height);
+            const double diameterError = std::abs(std::max(pupil.size.width, pupil.size.height) - truthDiameter);
+            diameterErrorSum += diameterError;
+            relativeDiameterErrorSum += diameterError / truthDiameter;
+            diameterErrorCount++;
+        }
+    }
+
+    if(result.framesWithTruth > 0)
+        for(size_t t=0; t<thresholds.size(); t++)
+            result.detectionRates[t] = hits[t] / (double)result.framesWithTruth;
+    if(centerErrorCount > 0)
+        result.meanCenterErrorPx = centerErrorSum / centerErrorCount;
+    if(diameterErrorCount > 0) {
+        result.meanDiameterErrorPx = diameterErrorSum / diameterErrorCount;
+        result.meanRelativeDiameterError = relativeDiameterErrorSum / diameterErrorCount;
+    }
+    if(confidenceCount > 0)
+        result.meanConfidence = confidenceSum / confidenceCount;
+
+    if(!result.runtimesMs.empty()) {
+        std::vector<double> sorted = result.runtimesMs;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for(double r : sorted)
+            sum += r;
+        result.meanRuntimeMs = sum / sorted.size();
+        result.p99RuntimeMs = sorted[std::min(sorted.size()-1, (size_t)std::ceil(0.99 * sorted.size()) - 1)];
+        result.maxRuntimeMs = sorted.back();
+    }
+}
+
+json PupilDetectionEvaluator::toJson(const EvaluationResult &result) {
+
+    json j;
+    j["name"] = result.candidate.name;
+    j["algorithm"] = result.candidate.algorithm;
+    j["Parameter Set"] = result.candidate.parameterSet;
+    j["valid"] = result.valid;
+    j["frames"] = result.frames;
+    j["framesWithTruth"] = result.framesWithTruth;
+    j["detections"] = result.detections;
+
+    json rates = json::object();
+    for(size_t t=0; t<result.thresholds.size() && t<result.detectionRates.size(); t++)
+        rates[QString::number(result.thresholds[t]).toStdString() + "px"] = result.detectionRates[t];
+    j["detectionRate"] = rates;
+
+    j["meanCenterError_px"] = result.meanCenterErrorPx;
+    j["meanDiameterError_px"] = result.meanDiameterErrorPx;
+    j["meanRelativeDiameterError"] = result.meanRelativeDiameterError;
+    j["meanConfidence"] = result.meanConfidence;
+    j["meanRuntime_ms"] = result.meanRuntimeMs;
+    j["p99Runtime_ms"] = result.p99RuntimeMs;
+    j["maxRuntime_ms"] = result.maxRuntimeMs;
+    j["cpuTime_ms"] = result.cpuTimeMs;
+    j["cpuTimePerFrame_ms"] = result.frames > 0 ? result.cpuTimeMs / result.frames : 0.0;
+    return j;
+}
+
+double PupilDetectionEvaluator::detectionRateAt(const EvaluationResult &result, double threshold) {
+    for(size_t t=0; t<result.thresholds.size() && t<result.detectionRates.size(); t++)
+        if(result.thresholds[t] >= threshold)
+            return result.detectionRates[t];
+    return result.detectionRates.empty() ? 0.0 : result.detectionRates.back();
+}
+
+// A result is dominated if another one is at least as accurate and as fast, and strictly better in one of both
+std::vector<size_t> PupilDetectionEvaluator::paretoFront(const std::vector<EvaluationResult> &results, double threshold) {
+
+    std::vector<size_t> front;
+    for(size_t i=0; i<results.size(); i++) {
+        if(!results[i].valid)
+            continue;
+        bool dominated = false;
+        for(size_t k=0; k<results.size() && !dominated; k++) {
+            if(k == i || !results[k].valid)
+                continue;
+            const double ri = detectionRateAt(results[i], threshold), rk = detectionRateAt(results[k], threshold);
+            dominated = rk >= ri && results[k].meanRuntimeMs <= results[i].meanRuntimeMs &&
+                        (rk > ri || results[k].meanRuntimeMs < results[i].meanRuntimeMs);
+        }
+        if(!dominated)
+            front.push_back(i);
+    }
+    return front;
+}
+
+// Headless evaluation run, configured by a JSON job file, e.g.:
+// { "imageDirectory": "rec/", "groundTruth": "gt.csv", "report": "report.json", "thresholds": [1, 2, 5, 10],
+//   "roi": [x, y, w, h], "maxFrames": 0, "frameStep": 1, "outlineConfidence": true,
+//   "candidates": [ { "name": "PuRe default", "algorithm": "PuRe", "Parameter Set": { ... } },
+//                   { "name": "ElSe tuned", "algorithm": "ElSe", "parameterFile": "else.json" } ] }
+// Relative paths are resolved relative to the job file
+int PupilDetectionEvaluator::runJobFile(const QString &jobFile) {
+
+    json job;
+    try {
+        std::ifstream file(jobFile.toStdString());
+        file >> job;
+    } catch(...) {
+        std::cerr << "Evaluation: could not parse job file: " << jobFile.toStdString() << std::endl;
+        return 1;
+    }
+
+    QDir jobDir = QFileInfo(jobFile).absoluteDir();
+    auto resolve = [&jobDir](const std::string &path) {
+        return QDir::cleanPath(jobDir.absoluteFilePath(QString::fromStdString(path)));
+    };
+
+    PupilDetectionEvaluator evaluator;
+    if(job.contains("thresholds"))
+        evaluator.setThresholds(job["thresholds"].get<std::vector<double>>());
+    if(job.contains("roi") && job["roi"].size() == 4)
+        evaluator.setROI(cv::Rect(job["roi"][0].get<int>(), job["roi"][1].get<int>(), job["roi"][2].get<int>(), job["roi"][3].get<int>()));
+    evaluator.setUseOutlineConfidence(job.value("outlineConfidence", true));
+
+    if(!evaluator.loadImages(resolve(job.value("imageDirectory", "")), job.value("maxFrames", 0), job.value("frameStep", 1)))
+        return 1;
+    if(job.contains("groundTruth") && !evaluator.loadGroundTruth(resolve(job["groundTruth"].get<std::string>())))
+        return 1;
+
+    std::vector<EvaluationCandidate> candidates;
+    for(const json &c : job.value("candidates", json::array())) {
+        EvaluationCandidate candidate;
+        candidate.algorithm = c.value("algorithm", "");
+        candidate.name = c.value("name", candidate.algorithm + " #" + std::to_string(candidates.size()));
+        if(c.contains("Parameter Set")) {
+            candidate.parameterSet = c["Parameter Set"];
+        } else if(c.contains("parameterFile")) {
+            try {
+                std::ifstream parameterFile(resolve(c["parameterFile"].get<std::string>()).toStdString());
+                json parameters;
+                parameterFile >> parameters;
+                candidate.parameterSet = parameters["Parameter Set"];
+            } catch(...) {
+                std::cerr << "Evaluation: could not read parameter file of candidate " << candidate.name << std::endl;
+                return 1;
+            }
+        }
+        candidates.push_back(candidate);
+    }
+    if(candidates.empty()) {
+        std::cerr << "Evaluation: no candidates given" << std::endl;
+        return 1;
+    }
+
+    std::vector<EvaluationResult> results = evaluator.evaluate(candidates);
+
+    json report;
+    report["imageDirectory"] = resolve(job.value("imageDirectory", "")).toStdString();
+    report["frames"] = evaluator.getFrames().size();
+    report["framesWithTruth"] = evaluator.getNumFramesWithTruth();
+    report["threads"] = QThreadPool::globalInstance()->maxThreadCount();
+    report["results"] = json::array();
+    for(const EvaluationResult &result : results)
+        report["results"].push_back(toJson(result));
+
+    const double paretoThreshold = job.value("paretoThreshold", 5.0);
+    report["paretoThreshold_px"] = paretoThreshold;
+    report["paretoFront"] = json::array();
+    for(size_t idx : paretoFront(results, paretoThreshold))
+        report["paretoFront"].push_back(results[idx].candidate.name);
+
+    const QString reportFile = resolve(job.value("report", "evaluation_report.json"));
+    std::ofstream out(reportFile.toStdString());
+    if(!out.is_open()) {
+        std::cerr << "Evaluation: could not write report: " << reportFile.toStdString() << std::endl;
+        return 1;
+    }
+    out << std::setw(4) << report << std::endl;
+
+    std::cout << "Evaluation: report written to " << reportFile.toStdString() << std::endl;
+    return 0;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <opencv2/core/mat.hpp>
+
+#include <string>
+#include <vector>
+
+#include "pupil-detection-methods/Pupil.h"
+#include "subwindows/pupil-detection-methods/json.h"
+
+/**
+    One image of an evaluation dataset, with its (optional) ground truth pupil ellipse in full image coordinates
+
+    Frames of the same segment are consecutive images of the recording, which allows frame-to-frame stability measures.
+*/
+struct EvaluationFrame {
+    std::string name; // image basename without extension, e.g. the timestamp for PupilEXT recordings
+    int segment = 0;
+    cv::Mat image;
+    bool hasTruth = false;
+    cv::RotatedRect truth;
+};
+
+/**
+    An algorithm together with the parameter set (same format as the algorithm JSON config files) to evaluate it with
+*/
+struct EvaluationCandidate {
+    std::string name;
+    std::string algorithm;
+    nlohmann::json parameterSet = nlohmann::json::object();
+};
+
+/**
+    Accuracy and speed metrics of one candidate over the evaluated frames
+
+    detectionRates[i] is the fraction of ground truth frames whose detected centre lies within thresholds[i] pixels.
+    Diameter errors compare the major axes, runtimes are per frame, cpuTimeMs is the thread CPU time summed over all workers.
+    pupils and runtimesMs hold the per-frame outputs in frame order.
+*/
+struct EvaluationResult {
+    EvaluationCandidate candidate;
+
+    size_t frames = 0;
+    size_t framesWithTruth = 0;
+    size_t detections = 0;
+
+    std::vector<double> thresholds;
+    std::vector<double> detectionRates;
+
+    double meanCenterErrorPx = -1.0;
+    double meanDiameterErrorPx = -1.0;
+    double meanRelativeDiameterError = -1.0;
+    double meanConfidence = -1.0;
+
+    double meanRuntimeMs = 0.0;
+    double p99RuntimeMs = 0.0;
+    double maxRuntimeMs = 0.0;
+    double cpuTimeMs = 0.0;
+    double wallTimeMs = 0.0;
+
+    std::vector<Pupil> pupils;
+    std::vector<double> runtimesMs;
+
+    bool valid = false;
+};
+
+/**
+    Offline evaluation of pupil detection algorithms and parameter sets against an annotated image dataset
+
+    Images are loaded once into memory, then every candidate runs on every frame. Candidates (and, if there are fewer
+    candidates than cores, contiguous chunks of frames) are distributed over the global thread pool, each job using its
+    own algorithm instance. Runtime is measured per frame, CPU time per job on the worker thread.
+
+    The ground truth CSV uses the column names of the single-pupil PupilEXT output (center_x, center_y, width_px,
+    height_px, angle_deg and either filename or timestamp_ms to match the image basenames), so a corrected PupilEXT
+    recording can directly serve as ground truth. The delimiter is detected from the header. Rows with non-positive
+    width or height mark frames without visible pupil and are excluded from the accuracy metrics.
+
+    loadImages(): loads the images of a directory, optionally only every frameStep-th and at most maxFrames
+    loadImageSample(): loads the given number of segments of consecutive images, spread evenly over the directory
+    loadGroundTruth(): reads the ground truth CSV and attaches it to the loaded frames
+    evaluate(): runs all candidates in parallel, optionally on a subset of frame indices
+    toJson(): machine-readable form of a result
+    detectionRateAt(): detection rate of a result at the first threshold not below the given one
+    paretoFront(): indices of the results not dominated in (detection rate at the given threshold, mean runtime)
+    runJobFile(): headless entry point, reads an evaluation job JSON file and writes the JSON report (see Misc/Executable_arguments.md)
+*/
+class PupilDetectionEvaluator {
+
+public:
+
+    PupilDetectionEvaluator();
+
+    bool loadImages(const QString &directory, int maxFrames=0, int frameStep=1);
+    bool loadImageSample(const QString &directory, int segments, int segmentLength);
+    bool loadGroundTruth(const QString &csvFile);
+
+    void setROI(const cv::Rect &roi);
+    void setThresholds(const std::vector<double> &thresholds);
+    void setUseOutlineConfidence(bool state);
+
+    const std::vector<EvaluationFrame> &getFrames() const;
+    size_t getNumFramesWithTruth() const;
+
+    std::vector<EvaluationResult> evaluate(const std::vector<EvaluationCandidate> &candidates, const std::vector<size_t> &frameIndices = std::vector<size_t>()) const;
+
+    static nlohmann::json toJson(const EvaluationResult &result);
+    static double detectionRateAt(const EvaluationResult &result, double threshold);
+    static std::vector<size_t> paretoFront(const std::vector<EvaluationResult> &results, double threshold);
+
+    static int runJobFile(const QString &jobFile);
+
+private:
+
+    std::vector<EvaluationFrame> frames;
+    std::vector<double> thresholds;
+    cv::Rect roi;
+    bool useOutlineConfidence;
+
+    QStringList listImages(const QString &directory) const;
+    bool readImages(const QString &directory, const QStringList &entries, const std::vector<int> &selected, const std::vector<int> &segments);
+
+    void computeMetrics(EvaluationResult &result, const std::vector<size_t> &frameIndices) const;
+};
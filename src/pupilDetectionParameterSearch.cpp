@@ -0,0 +1,304 @@
+
+#include "pupilDetectionParameterSearch.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+using json = nlohmann::json;
+
+PupilDetectionParameterSearch::PupilDetectionParameterSearch(const PupilDetectionEvaluator &evaluator) : evaluator(evaluator), rng(1) {
+}
+
+void PupilDetectionParameterSearch::setValue(json &parameterSet, const ParameterRange &range, double value) {
+    value = std::min(std::max(value, range.min), range.max);
+    if(range.integer)
+        parameterSet[range.key] = (int)std::lround(value);
+    else
+        parameterSet[range.key] = value;
+}
+
+bool PupilDetectionParameterSearch::isOrdered(const std::vector<ParameterRange> &space, const json &parameterSet) {
+    for(const ParameterRange &range : space) {
+        if(range.lessThan.empty() || !parameterSet.contains(range.key) || !parameterSet.contains(range.lessThan))
+            continue;
+        if(parameterSet[range.key].get<double>() >= parameterSet[range.lessThan].get<double>())
+            return false;
+    }
+    return true;
+}
+
+// Uniform sample of the whole search space, parameters outside of the space keep their base value
+json PupilDetectionParameterSearch::sample(const std::vector<ParameterRange> &space, const json &base) {
+
+    json parameterSet = base;
+    for(int attempt=0; attempt<20; attempt++) {
+        for(const ParameterRange &range : space) {
+            if(range.integer) {
+                std::uniform_int_distribution<int> dist((int)range.min, (int)range.max);
+                setValue(parameterSet, range, dist(rng));
+            } else {
+                std::uniform_real_distribution<double> dist(range.min, range.max);
+                setValue(parameterSet, range, dist(rng));
+            }
+        }
+        if(isOrdered(space, parameterSet))
+            return parameterSet;
+    }
+    return base;
+}
+
+// Gaussian perturbation with a standard deviation of radius times the parameter range
+// Switches (integer range [0,1]) flip with probability radius
+json PupilDetectionParameterSearch::perturb(const std::vector<ParameterRange> &space, const json &center, double radius) {
+
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    json parameterSet = center;
+    for(int attempt=0; attempt<20; attempt++) {
+        for(const ParameterRange &range : space) {
+            const double value = center.contains(range.key) ? center[range.key].get<double>() : (range.min + range.max) / 2.0;
+            if(range.integer && range.max - range.min <= 1.0)
+                setValue(parameterSet, range, uniform(rng) < radius ? range.min + range.max - value : value);
+            else
+                setValue(parameterSet, range, value + normal(rng) * radius * (range.max - range.min));
+        }
+        if(isOrdered(space, parameterSet) && parameterSet != center)
+            return parameterSet;
+    }
+    return sample(space, center);
+}
+
+// Mean frame-to-frame change of consecutive detections within the same segment, mapped to [0,1]
+// Center jumps are relative to the pupil diameter, so the measure does not depend on the image resolution
+double PupilDetectionParameterSearch::stability(const EvaluationResult &result) const {
+
+    const std::vector<EvaluationFrame> &frames = evaluator.getFrames();
+
+    double change = 0.0;
+    size_t pairs = 0;
+    for(size_t i=1; i<result.pupils.size() && i<frames.size(); i++) {
+        if(frames[i].segment != frames[i-1].segment)
+            continue;
+        const Pupil &previous = result.pupils[i-1];
+        const Pupil &current = result.pupils[i];
+        if(previous.center.x <= 0 || previous.center.y <= 0 || current.center.x <= 0 || current.center.y <= 0)
+            continue;
+
+        const double previousDiameter = std::max(previous.size.width, previous.size.height);
+        const double currentDiameter = std::max(current.size.width, current.size.height);
+        const double diameter = std::max(previousDiameter, currentDiameter);
+        if(diameter <= 0)
+            continue;
+
+        change += std::abs(currentDiameter - previousDiameter) / diameter + cv::norm(current.center - previous.center) / diameter;
+        pairs++;
+    }
+
+    if(pairs == 0)
+        return 0.0;
+    return 1.0 / (1.0 + change / pairs);
+}
+
+double PupilDetectionParameterSearch::score(const EvaluationResult &result, const ParameterSearchSettings &settings, double &stability) const {
+
+    stability = this->stability(result);
+    if(!result.valid || result.frames == 0)
+        return -std::numeric_limits<double>::infinity();
+
+    double accuracy;
+    if(result.framesWithTruth > 0) {
+        accuracy = PupilDetectionEvaluator::detectionRateAt(result, settings.threshold);
+    } else {
+        const double detected = result.detections / (double)result.frames;
+        accuracy = detected * std::max(result.meanConfidence, 0.0) * stability;
+    }
+    return accuracy - settings.runtimeWeight * result.meanRuntimeMs;
+}
+
+std::vector<ParameterSearchEntry> PupilDetectionParameterSearch::run(const ParameterSearchSettings &settings) {
+
+    std::vector<ParameterSearchEntry> entries;
+
+    const std::vector<ParameterRange> space = PupilDetectionMethodParameters::searchSpace(settings.algorithm);
+    std::unique_ptr<PupilDetectionMethod> method(PupilDetectionMethodParameters::create(settings.algorithm));
+    if(!method || space.empty()) {
+        std::cerr << "Parameter search: unknown algorithm " << settings.algorithm << std::endl;
+        return entries;
+    }
+
+    // Complete the base parameter set with the algorithm defaults, so the result is a full config
+    PupilDetectionMethodParameters::apply(method.get(), settings.baseParameterSet);
+    json base = PupilDetectionMethodParameters::read(method.get());
+    // Switches are read as booleans, the search handles all searched parameters as numbers
+    for(const ParameterRange &range : space)
+        if(base.contains(range.key) && base[range.key].is_boolean())
+            base[range.key] = base[range.key].get<bool>() ? 1 : 0;
+
+    rng.seed(settings.seed);
+
+    const int threads = std::max(QThreadPool::globalInstance()->maxThreadCount(), 1);
+    const int batchSize = settings.batchSize > 0 ? settings.batchSize : 2 * threads;
+    const int iterations = std::max(settings.iterations, 1);
+    const int explorationIterations = (int)std::ceil(iterations * std::min(std::max(settings.explorationFraction, 0.0), 1.0));
+
+    int iteration = 0;
+    while(iteration < iterations) {
+
+        const int count = std::min(batchSize, iterations - iteration);
+
+        const ParameterSearchEntry *best = entries.empty() ? nullptr : &*std::max_element(entries.begin(), entries.end(),
+            [](const ParameterSearchEntry &a, const ParameterSearchEntry &b) { return a.score < b.score; });
+
+        std::vector<EvaluationCandidate> candidates;
+        for(int i=0; i<count; i++) {
+            const int n = iteration + i;
+            EvaluationCandidate candidate;
+            candidate.algorithm = settings.algorithm;
+            candidate.name = settings.algorithm + " #" + std::to_string(n);
+            if(n == 0) {
+                candidate.name = settings.algorithm + " base";
+                candidate.parameterSet = base;
+            } else if(n < explorationIterations || !best) {
+                candidate.parameterSet = sample(space, base);
+            } else {
+                // Radius shrinks linearly over the refinement phase
+                const double progress = (n - explorationIterations) / (double)std::max(iterations - explorationIterations, 1);
+                candidate.parameterSet = perturb(space, best->result.candidate.parameterSet, 0.15 - 0.13 * progress);
+            }
+            candidates.push_back(candidate);
+        }
+
+        std::vector<EvaluationResult> results = evaluator.evaluate(candidates);
+        for(size_t i=0; i<results.size(); i++) {
+            ParameterSearchEntry entry;
+            entry.iteration = iteration + (int)i;
+            entry.score = score(results[i], settings, entry.stability);
+            // per-frame outputs are not needed anymore, dropping them keeps long searches small in memory
+            entry.result = std::move(results[i]);
+            entry.result.pupils.clear();
+            entry.result.pupils.shrink_to_fit();
+            entry.result.runtimesMs.clear();
+            entry.result.runtimesMs.shrink_to_fit();
+            entries.push_back(std::move(entry));
+        }
+        iteration += count;
+
+        const ParameterSearchEntry &currentBest = *std::max_element(entries.begin(), entries.end(),
+            [](const ParameterSearchEntry &a, const ParameterSearchEntry &b) { return a.score < b.score; });
+        std::cout << "Parameter search: " << iteration << "/" << iterations << " candidates, best score " << currentBest.score
+                  << " (" << currentBest.result.candidate.name << ")" << std::endl;
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const ParameterSearchEntry &a, const ParameterSearchEntry &b) { return a.score > b.score; });
+    return entries;
+}
+
+// Headless parameter search, configured by a JSON job file, e.g.:
+// { "imageDirectory": "rec/", "groundTruth": "gt.csv", "algorithm": "PuRe", "Parameter Set": { ... },
+//   "output": "pure_optimized.json", "report": "search_report.json", "iterations": 200, "batchSize": 0,
+//   "segments": 10, "segmentLength": 30, "seed": 1, "explorationFraction": 0.5, "runtimeWeight": 0.01,
+//   "threshold": 5, "roi": [x, y, w, h], "outlineConfidence": true }
+// Relative paths are resolved relative to the job file
+int PupilDetectionParameterSearch::runJobFile(const QString &jobFile) {
+
+    json job;
+    try {
+        std::ifstream file(jobFile.toStdString());
+        file >> job;
+    } catch(...) {
+        std::cerr << "Parameter search: could not parse job file: " << jobFile.toStdString() << std::endl;
+        return 1;
+    }
+
+    QDir jobDir = QFileInfo(jobFile).absoluteDir();
+    auto resolve = [&jobDir](const std::string &path) {
+        return QDir::cleanPath(jobDir.absoluteFilePath(QString::fromStdString(path)));
+    };
+
+    ParameterSearchSettings settings;
+    settings.algorithm = job.value("algorithm", "");
+    if(job.contains("Parameter Set"))
+        settings.baseParameterSet = job["Parameter Set"];
+    settings.iterations = job.value("iterations", settings.iterations);
+    settings.batchSize = job.value("batchSize", settings.batchSize);
+    settings.seed = job.value("seed", settings.seed);
+    settings.explorationFraction = job.value("explorationFraction", settings.explorationFraction);
+    settings.runtimeWeight = job.value("runtimeWeight", settings.runtimeWeight);
+    settings.threshold = job.value("threshold", settings.threshold);
+
+    PupilDetectionEvaluator evaluator;
+    std::vector<double> thresholds = {1.0, 2.0, 5.0, 10.0};
+    if(std::find(thresholds.begin(), thresholds.end(), settings.threshold) == thresholds.end()) {
+        thresholds.push_back(settings.threshold);
+        std::sort(thresholds.begin(), thresholds.end());
+    }
+    evaluator.setThresholds(thresholds);
+    if(job.contains("roi") && job["roi"].size() == 4)
+        evaluator.setROI(cv::Rect(job["roi"][0].get<int>(), job["roi"][1].get<int>(), job["roi"][2].get<int>(), job["roi"][3].get<int>()));
+    evaluator.setUseOutlineConfidence(job.value("outlineConfidence", true));
+
+    if(!evaluator.loadImageSample(resolve(job.value("imageDirectory", "")), job.value("segments", 10), job.value("segmentLength", 30)))
+        return 1;
+    if(job.contains("groundTruth") && !evaluator.loadGroundTruth(resolve(job["groundTruth"].get<std::string>())))
+        return 1;
+
+    PupilDetectionParameterSearch search(evaluator);
+    std::vector<ParameterSearchEntry> entries = search.run(settings);
+    if(entries.empty())
+        return 1;
+
+    const ParameterSearchEntry &best = entries.front();
+
+    // Same format as the algorithm config files, so it can be loaded with "Load config file" in the algorithm settings
+    json config;
+    config["Parameter Set"] = best.result.candidate.parameterSet;
+
+    const QString outputFile = resolve(job.value("output", settings.algorithm + "_optimized.json"));
+    std::ofstream output(outputFile.toStdString());
+    if(!output.is_open()) {
+        std::cerr << "Parameter search: could not write config: " << outputFile.toStdString() << std::endl;
+        return 1;
+    }
+    output << std::setw(4) << config << std::endl;
+
+    json report;
+    report["imageDirectory"] = resolve(job.value("imageDirectory", "")).toStdString();
+    report["algorithm"] = settings.algorithm;
+    report["frames"] = evaluator.getFrames().size();
+    report["framesWithTruth"] = evaluator.getNumFramesWithTruth();
+    report["threads"] = QThreadPool::globalInstance()->maxThreadCount();
+    report["scoring"] = evaluator.getNumFramesWithTruth() > 0 ? "detectionRate" : "confidenceStability";
+    report["runtimeWeight"] = settings.runtimeWeight;
+    report["threshold_px"] = settings.threshold;
+    report["seed"] = settings.seed;
+    report["candidates"] = json::array();
+    for(const ParameterSearchEntry &entry : entries) {
+        json j = PupilDetectionEvaluator::toJson(entry.result);
+        j["iteration"] = entry.iteration;
+        j["stability"] = entry.stability;
+        j["score"] = entry.score;
+        report["candidates"].push_back(j);
+    }
+
+    const QString reportFile = resolve(job.value("report", settings.algorithm + "_search_report.json"));
+    std::ofstream out(reportFile.toStdString());
+    if(!out.is_open()) {
+        std::cerr << "Parameter search: could not write report: " << reportFile.toStdString() << std::endl;
+        return 1;
+    }
+    out << std::setw(4) << report << std::endl;
+
+    std::cout << "Parameter search: best candidate " << best.result.candidate.name << " with score " << best.score
+              << ", config written to " << outputFile.toStdString() << std::endl;
+    return 0;
+}
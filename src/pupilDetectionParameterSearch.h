@@ -0,0 +1,88 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QString>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pupilDetectionEvaluator.h"
+#include "pupil-detection-methods/PupilDetectionMethodParameters.h"
+#include "subwindows/pupil-detection-methods/json.h"
+
+/**
+    Settings of one automatic parameter search run
+
+    iterations: number of evaluated candidates, including the base parameter set
+    batchSize: candidates evaluated in parallel per round, 0 uses twice the thread pool size
+    explorationFraction: fraction of the iterations sampled uniformly from the whole search space, the rest refines the best candidate
+    runtimeWeight: score penalty per millisecond of mean runtime per frame
+    threshold: pixel threshold of the detection rate used as accuracy score when ground truth is available
+*/
+struct ParameterSearchSettings {
+    std::string algorithm;
+    nlohmann::json baseParameterSet = nlohmann::json::object();
+    int iterations = 200;
+    int batchSize = 0;
+    unsigned int seed = 1;
+    double explorationFraction = 0.5;
+    double runtimeWeight = 0.01;
+    double threshold = 5.0;
+};
+
+/**
+    One evaluated candidate of a parameter search, with its score and frame-to-frame stability [0,1]
+*/
+struct ParameterSearchEntry {
+    EvaluationResult result;
+    int iteration = 0;
+    double stability = 0.0;
+    double score = 0.0;
+};
+
+/**
+    Offline search for the pupil detection parameters of one algorithm on a sample of frames of a recording
+
+    The parameter space is declared per algorithm by PupilDetectionMethodParameters::searchSpace(). Candidates are
+    generated in rounds and each round is evaluated in parallel by the PupilDetectionEvaluator. The first rounds sample
+    uniformly from the whole space (random search), the later ones perturb the best candidate found so far with a
+    shrinking radius (local refinement). The base parameter set is always evaluated first as baseline.
+
+    A candidate is scored by its accuracy minus runtimeWeight times its mean runtime in milliseconds. With ground truth,
+    accuracy is the detection rate at the pixel threshold. Without, it is the product of the detected fraction of frames,
+    the mean confidence and the stability of the detections between consecutive frames of the same sample segment, as
+    real pupils move and change size only little from one frame to the next.
+
+    run(): performs the search, returns all evaluated candidates sorted by descending score
+    score(): score of an evaluation result, also returns its stability
+    stability(): frame-to-frame stability of the detections of an evaluation result
+    runJobFile(): headless entry point, reads a search job JSON file, writes the best config in the algorithm config file format and a JSON report (see Misc/Executable_arguments.md)
+*/
+class PupilDetectionParameterSearch {
+
+public:
+
+    explicit PupilDetectionParameterSearch(const PupilDetectionEvaluator &evaluator);
+
+    std::vector<ParameterSearchEntry> run(const ParameterSearchSettings &settings);
+
+    double score(const EvaluationResult &result, const ParameterSearchSettings &settings, double &stability) const;
+    double stability(const EvaluationResult &result) const;
+
+    static int runJobFile(const QString &jobFile);
+
+private:
+
+    const PupilDetectionEvaluator &evaluator;
+    std::mt19937 rng;
+
+    nlohmann::json sample(const std::vector<ParameterRange> &space, const nlohmann::json &base);
+    nlohmann::json perturb(const std::vector<ParameterRange> &space, const nlohmann::json &center, double radius);
+
+    static void setValue(nlohmann::json &parameterSet, const ParameterRange &range, double value);
+    static bool isOrdered(const std::vector<ParameterRange> &space, const nlohmann::json &parameterSet);
+};
@@ -0,0 +1,147 @@
+
+#include "pupilFrameResult.h"
+
+#include <algorithm>
+#include <cstring>
+
+PupilAlgorithm pupilAlgorithmFromName(const std::string &name) {
+    if(name == "PuRe")
+        return PupilAlgorithm::PURE;
+    if(name == "PuReST")
+        return PupilAlgorithm::PUREST;
+    if(name == "ElSe")
+        return PupilAlgorithm::ELSE;
+    if(name == "ExCuSe")
+        return PupilAlgorithm::EXCUSE;
+    if(name == "Starburst")
+        return PupilAlgorithm::STARBURST;
+    if(name == "Swirski2D")
+        return PupilAlgorithm::SWIRSKI2D;
+    if(name == "Swirski3D")
+        return PupilAlgorithm::SWIRSKI3D;
+    return PupilAlgorithm::UNKNOWN;
+}
+
+const char *pupilAlgorithmName(PupilAlgorithm algorithm) {
+    switch(algorithm) {
+        case PupilAlgorithm::ELSE: return "ElSe";
+        case PupilAlgorithm::EXCUSE: return "ExCuSe";
+        case PupilAlgorithm::PURE: return "PuRe";
+        case PupilAlgorithm::PUREST: return "PuReST";
+        case PupilAlgorithm::STARBURST: return "Starburst";
+        case PupilAlgorithm::SWIRSKI2D: return "Swirski2D";
+        case PupilAlgorithm::SWIRSKI3D: return "Swirski3D";
+        default: return "";
+    }
+}
+
+void PupilFrameResult::setPupils(const std::vector<Pupil> &Pupils) {
+    pupilCount = std::min(static_cast<int>(Pupils.size()), maxPupils);
+    for(int i=0; i<pupilCount; i++) {
+        const Pupil &p = Pupils[i];
+        PupilRecord &r = pupils[i];
+        r.centerX = p.center.x;
+        r.centerY = p.center.y;
+        r.width = p.size.width;
+        r.height = p.size.height;
+        r.angle = p.angle;
+        r.confidence = p.confidence;
+        r.outlineConfidence = p.outline_confidence;
+        r.eyelid = p.eyelid;
+        r.physicalDiameter = p.physicalDiameter;
+        r.undistortedDiameter = p.undistortedDiameter;
+        r.algorithm = pupilAlgorithmFromName(p.algorithmName);
+        r.blink = p.blink;
+    }
+}
+
+// A reader reusing the vector only assigns the algorithm name when it changed, so no string is built per result
+void PupilFrameResult::getPupils(std::vector<Pupil> &Pupils) const {
+    Pupils.resize(pupilCount);
+    for(int i=0; i<pupilCount; i++) {
+        const PupilRecord &r = pupils[i];
+        Pupil &p = Pupils[i];
+        p.center = cv::Point2f(r.centerX, r.centerY);
+        p.size = cv::Size2f(r.width, r.height);
+        p.angle = r.angle;
+        p.confidence = r.confidence;
+        p.outline_confidence = r.outlineConfidence;
+        p.eyelid = r.eyelid;
+        p.physicalDiameter = r.physicalDiameter;
+        p.undistortedDiameter = r.undistortedDiameter;
+        const char *algorithmName = pupilAlgorithmName(r.algorithm);
+        if(p.algorithmName != algorithmName)
+            p.algorithmName = algorithmName;
+        p.blink = r.blink;
+    }
+}
+
+PupilResultBroadcaster::PupilResultBroadcaster(QObject *parent) :
+    QObject(parent),
+    ring(new Slot[capacity]),
+    published(0),
+    filenames(std::make_shared<const std::vector<QString>>()) {
+
+    for(size_t i=0; i<capacity; i++) {
+        ring[i].sequence.store(0, std::memory_order_relaxed);
+        for(size_t w=0; w<resultWords; w++)
+            ring[i].words[w].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Sequence lock: the slot is marked as being written (0) before and stamped with the new sequence number after copying
+quint64 PupilResultBroadcaster::publish(const PupilFrameResult &result) {
+    const quint64 sequence = published.load(std::memory_order_relaxed) + 1;
+    Slot &slot = ring[sequence & (capacity - 1)];
+
+    quint64 words[resultWords] = {};
+    std::memcpy(words, &result, sizeof(PupilFrameResult));
+
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for(size_t w=0; w<resultWords; w++)
+        slot.words[w].store(words[w], std::memory_order_relaxed);
+    slot.sequence.store(sequence, std::memory_order_release);
+
+    published.store(sequence, std::memory_order_release);
+    emit resultPublished(sequence);
+    return sequence;
+}
+
+bool PupilResultBroadcaster::read(quint64 sequence, PupilFrameResult &result) const {
+    if(sequence == 0)
+        return false;
+    const Slot &slot = ring[sequence & (capacity - 1)];
+
+    if(slot.sequence.load(std::memory_order_acquire) != sequence)
+        return false;
+    quint64 words[resultWords];
+    for(size_t w=0; w<resultWords; w++)
+        words[w] = slot.words[w].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(slot.sequence.load(std::memory_order_relaxed) != sequence)
+        return false;
+
+    std::memcpy(&result, words, sizeof(PupilFrameResult));
+    return true;
+}
+
+quint64 PupilResultBroadcaster::latestSequence() const {
+    return published.load(std::memory_order_acquire);
+}
+
+// Called when a recording is opened or a camera attached, the QStrings are converted once and then only shared with the consumers
+void PupilResultBroadcaster::setFilenames(const std::vector<std::string> &names) {
+    std::shared_ptr<std::vector<QString>> converted = std::make_shared<std::vector<QString>>();
+    converted->reserve(names.size());
+    for(const std::string &name : names)
+        converted->push_back(QString::fromStdString(name));
+    std::atomic_store(&filenames, std::shared_ptr<const std::vector<QString>>(converted));
+}
+
+QString PupilResultBroadcaster::filename(quint64 frameNumber) const {
+    const std::shared_ptr<const std::vector<QString>> names = std::atomic_load(&filenames);
+    if(frameNumber >= names->size())
+        return QString();
+    return (*names)[frameNumber];
+}
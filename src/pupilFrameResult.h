@@ -0,0 +1,179 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "pupil-detection-methods/Pupil.h"
+
+/**
+    Identifies the pupil detection algorithm of a result without carrying its name as a string
+*/
+enum class PupilAlgorithm : quint8 {
+    UNKNOWN = 0,
+    ELSE = 1,
+    EXCUSE = 2,
+    PURE = 3,
+    PUREST = 4,
+    STARBURST = 5,
+    SWIRSKI2D = 6,
+    SWIRSKI3D = 7
+};
+
+PupilAlgorithm pupilAlgorithmFromName(const std::string &name);
+const char *pupilAlgorithmName(PupilAlgorithm algorithm);
+
+/**
+    Fixed-size, trivially copyable pupil detection result of one frame, for passing results between threads without heap allocations
+
+    The pupils are stored in the order of the std::vector<Pupil> of the processing mode (see the ProcMode index enums), the algorithm
+    is stored as PupilAlgorithm. Instead of the image filename, the frame index is stored, the PupilResultBroadcaster looks up the
+    filename of a recording frame from it.
+
+    setPupils(): stores the given pupils (at most maxPupils)
+    getPupils(): restores the pupils into the given vector, reusing its memory
+*/
+struct PupilFrameResult {
+
+    static const int maxPupils = 4;
+
+    struct PupilRecord {
+        float centerX;
+        float centerY;
+        float width;
+        float height;
+        float angle;
+        float confidence;
+        float outlineConfidence;
+        float eyelid;
+        float physicalDiameter;
+        float undistortedDiameter;
+        PupilAlgorithm algorithm;
+        bool blink;
+    };
+
+    quint64 timestamp;
+    quint64 frameNumber;
+    qint32 procMode;
+    qint32 pupilCount;
+    PupilRecord pupils[maxPupils];
+
+    void setPupils(const std::vector<Pupil> &Pupils);
+    void getPupils(std::vector<Pupil> &Pupils) const;
+};
+
+static_assert(std::is_trivially_copyable<PupilFrameResult>::value, "PupilFrameResult must stay trivially copyable");
+
+/**
+    Broadcasts the pupil detection results of each frame to any number of consumers through one preallocated ring of PupilFrameResult
+
+    The pupil detection thread is the only writer: publish() copies the result into the next slot and emits resultPublished()
+    with its sequence number (starting at 1), which is all that is queued per consumer. Consumers copy the results out of the
+    ring with read() in their own thread (preferably through a PupilResultReader). Slots are guarded by a sequence lock, so
+    a slot that was overwritten by the writer while or before being read is detected, read() then returns false. The result is
+    copied into and out of a slot as relaxed atomic words, so a concurrent overwrite is no data race, only a discarded read.
+    The ring holds some seconds of results even at high frame rates, so only a consumer stalled for that long loses results.
+
+    The image filenames of a recording are set once when it is opened, filename() looks them up by frame index, no per-frame
+    string is stored or allocated. Live cameras have no filenames.
+
+    publish(): stores a result, to be called from the pupil detection thread only
+    read(): copies the result with the given sequence number, false if it is not (or no longer) available
+    latestSequence(): sequence number of the last published result, 0 if none
+    setFilenames(): sets the image filenames of the current recording by frame index, empty for live cameras
+    filename(): filename of the frame index, empty if there is none
+
+signals:
+    resultPublished(sequence): a new result is available
+*/
+class PupilResultBroadcaster : public QObject {
+    Q_OBJECT
+
+public:
+
+    explicit PupilResultBroadcaster(QObject *parent=nullptr);
+
+    quint64 publish(const PupilFrameResult &result);
+    bool read(quint64 sequence, PupilFrameResult &result) const;
+    quint64 latestSequence() const;
+
+    void setFilenames(const std::vector<std::string> &names);
+    QString filename(quint64 frameNumber) const;
+
+private:
+
+    static const size_t capacity = 8192; // power of two
+    static const size_t resultWords = (sizeof(PupilFrameResult) + sizeof(quint64) - 1) / sizeof(quint64);
+
+    struct Slot {
+        std::atomic<quint64> sequence;
+        std::atomic<quint64> words[resultWords];
+    };
+
+    std::unique_ptr<Slot[]> ring;
+    std::atomic<quint64> published;
+
+    // Replaced as a whole, accessed through std::atomic_load/atomic_store
+    std::shared_ptr<const std::vector<QString>> filenames;
+
+signals:
+
+    void resultPublished(quint64 sequence);
+
+};
+
+/**
+    Consumer side of a PupilResultBroadcaster, keeps track of the results already read and the memory for restoring the pupils
+
+    setSource(): sets the broadcaster to read from, the next notified result is read first
+    readUpTo(): calls callback(timestamp, procMode, pupils, filename) for every result not read yet up to the given sequence number,
+                in order, and returns the number of results that were lost as the consumer fell behind by more than the ring size
+*/
+class PupilResultReader {
+
+public:
+
+    PupilResultReader() : source(nullptr), nextSequence(0) {
+    }
+
+    void setSource(PupilResultBroadcaster *broadcaster) {
+        source = broadcaster;
+        nextSequence = 0;
+    }
+
+    template<typename Callback>
+    quint64 readUpTo(quint64 sequence, Callback callback) {
+        if(!source)
+            return 0;
+        if(nextSequence == 0)
+            nextSequence = sequence;
+
+        quint64 lost = 0;
+        for(; nextSequence <= sequence; nextSequence++) {
+            if(!source->read(nextSequence, result)) {
+                lost++;
+                continue;
+            }
+            result.getPupils(pupils);
+            callback(result.timestamp, result.procMode, pupils, source->filename(result.frameNumber));
+        }
+        return lost;
+    }
+
+private:
+
+    PupilResultBroadcaster *source;
+    quint64 nextSequence;
+    PupilFrameResult result;
+    std::vector<Pupil> pupils;
+
+};
@@ -0,0 +1,172 @@
+
+#include "pupilGeometry.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+UndistortionLUT::UndistortionLUT() {
+}
+
+void UndistortionLUT::build(const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs, const cv::Mat &R, const cv::Mat &P, const cv::Size &imageSize, int step) {
+
+    if(imageSize.area() <= 0 || cameraMatrix.empty()) {
+        clear();
+        return;
+    }
+
+    std::shared_ptr<Table> t = std::make_shared<Table>();
+    t->step = std::max(step, 1);
+    // One extra grid line beyond the last pixel, so every pixel lies inside a grid cell
+    t->cols = (imageSize.width - 1) / t->step + 2;
+    t->rows = (imageSize.height - 1) / t->step + 2;
+
+    std::vector<cv::Point2f> grid;
+    grid.reserve(t->cols * t->rows);
+    for(int r=0; r<t->rows; r++)
+        for(int c=0; c<t->cols; c++)
+            grid.emplace_back(static_cast<float>(c * t->step), static_cast<float>(r * t->step));
+
+    std::vector<cv::Point2f> undistortedGrid;
+    cv::undistortPoints(grid, undistortedGrid, cameraMatrix, distCoeffs, R, P);
+
+    t->x.resize(undistortedGrid.size());
+    t->y.resize(undistortedGrid.size());
+    for(size_t i=0; i<undistortedGrid.size(); i++) {
+        if(!std::isfinite(undistortedGrid[i].x) || !std::isfinite(undistortedGrid[i].y)) {
+            clear();
+            return;
+        }
+        t->x[i] = undistortedGrid[i].x;
+        t->y[i] = undistortedGrid[i].y;
+    }
+
+    const QMutexLocker locker(&mutex);
+    table = t;
+}
+
+void UndistortionLUT::clear() {
+    const QMutexLocker locker(&mutex);
+    table.reset();
+}
+
+bool UndistortionLUT::isValid() {
+    const QMutexLocker locker(&mutex);
+    return table != nullptr;
+}
+
+// Bilinear interpolation in the grid cell of each point, cells at the border are extrapolated
+// Input and output may be the same vector
+bool UndistortionLUT::undistortPoints(const std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &undistortedPoints) {
+
+    std::shared_ptr<const Table> t;
+    {
+        const QMutexLocker locker(&mutex);
+        t = table;
+    }
+    if(!t)
+        return false;
+
+    const float invStep = 1.0f / t->step;
+    const int cols = t->cols;
+    const int maxCol = t->cols - 2;
+    const int maxRow = t->rows - 2;
+    const float *gx = t->x.data();
+    const float *gy = t->y.data();
+
+    const size_t count = points.size();
+    undistortedPoints.resize(count);
+    for(size_t i=0; i<count; i++) {
+        const float fx = points[i].x * invStep;
+        const float fy = points[i].y * invStep;
+        const int c = std::min(std::max(static_cast<int>(std::floor(fx)), 0), maxCol);
+        const int r = std::min(std::max(static_cast<int>(std::floor(fy)), 0), maxRow);
+        const float tx = fx - c;
+        const float ty = fy - r;
+        const int idx = r * cols + c;
+
+        const float x0 = gx[idx] + tx * (gx[idx+1] - gx[idx]);
+        const float x1 = gx[idx+cols] + tx * (gx[idx+cols+1] - gx[idx+cols]);
+        const float y0 = gy[idx] + tx * (gy[idx+1] - gy[idx]);
+        const float y1 = gy[idx+cols] + tx * (gy[idx+cols+1] - gy[idx+cols]);
+
+        undistortedPoints[i].x = x0 + ty * (x1 - x0);
+        undistortedPoints[i].y = y0 + ty * (y1 - y0);
+    }
+    return true;
+}
+
+void PupilGeometry::sampleContour(const cv::RotatedRect &ellipse, int count, std::vector<cv::Point2f> &points) {
+
+    const double alpha = ellipse.angle * CV_PI / 180.0;
+    const double ux = std::cos(alpha), uy = std::sin(alpha);
+    const double a = 0.5 * ellipse.size.width, b = 0.5 * ellipse.size.height;
+
+    points.reserve(points.size() + count);
+    for(int k=0; k<count; k++) {
+        const double theta = 2.0 * CV_PI * k / count;
+        const double ca = a * std::cos(theta), sb = b * std::sin(theta);
+        points.emplace_back(static_cast<float>(ellipse.center.x + ca * ux - sb * uy),
+                            static_cast<float>(ellipse.center.y + ca * uy + sb * ux));
+    }
+}
+
+double PupilGeometry::majorAxis(const cv::Point2f *points, int count) {
+    if(count < 5)
+        return -1.0;
+    cv::RotatedRect fitted = cv::fitEllipse(cv::Mat(count, 1, CV_32FC2, const_cast<cv::Point2f*>(points)));
+    return std::max(fitted.size.width, fitted.size.height);
+}
+
+// Each view contributes the two equations x*p3 - p1 and y*p3 - p2 on the inhomogeneous world point,
+// the resulting 4x3 system is solved through its 3x3 normal equations with Cramer's rule
+void PupilGeometry::triangulate(const cv::Mat &P1, const cv::Mat &P2,
+                                const std::vector<cv::Point2f> &points, const std::vector<cv::Point2f> &pointsSecondary,
+                                std::vector<cv::Point3f> &worldPoints) {
+
+    cv::Mat_<double> A, B;
+    P1.convertTo(A, CV_64F);
+    P2.convertTo(B, CV_64F);
+
+    const size_t count = std::min(points.size(), pointsSecondary.size());
+    worldPoints.resize(count);
+
+    for(size_t i=0; i<count; i++) {
+        const double x1 = points[i].x, y1 = points[i].y;
+        const double x2 = pointsSecondary[i].x, y2 = pointsSecondary[i].y;
+
+        double rows[4][4];
+        for(int j=0; j<4; j++) {
+            rows[0][j] = x1 * A(2,j) - A(0,j);
+            rows[1][j] = y1 * A(2,j) - A(1,j);
+            rows[2][j] = x2 * B(2,j) - B(0,j);
+            rows[3][j] = y2 * B(2,j) - B(1,j);
+        }
+
+        double m00=0, m01=0, m02=0, m11=0, m12=0, m22=0, v0=0, v1=0, v2=0;
+        for(int k=0; k<4; k++) {
+            const double *r = rows[k];
+            m00 += r[0]*r[0]; m01 += r[0]*r[1]; m02 += r[0]*r[2];
+            m11 += r[1]*r[1]; m12 += r[1]*r[2]; m22 += r[2]*r[2];
+            v0 -= r[0]*r[3]; v1 -= r[1]*r[3]; v2 -= r[2]*r[3];
+        }
+
+        const double c00 = m11*m22 - m12*m12;
+        const double c01 = m02*m12 - m01*m22;
+        const double c02 = m01*m12 - m02*m11;
+        const double det = m00*c00 + m01*c01 + m02*c02;
+        if(std::abs(det) < 1e-12) {
+            worldPoints[i] = cv::Point3f(0, 0, 0);
+            continue;
+        }
+        const double c11 = m00*m22 - m02*m02;
+        const double c12 = m01*m02 - m00*m12;
+        const double c22 = m00*m11 - m01*m01;
+
+        worldPoints[i].x = static_cast<float>((c00*v0 + c01*v1 + c02*v2) / det);
+        worldPoints[i].y = static_cast<float>((c01*v0 + c11*v1 + c12*v2) / det);
+        worldPoints[i].z = static_cast<float>((c02*v0 + c12*v1 + c22*v2) / det);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QMutex>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+
+#include <memory>
+#include <vector>
+
+/**
+    Cached inverse lens distortion: maps distorted image points to undistorted (and optionally rectified) image points
+
+    cv::undistortPoints solves the distortion model iteratively for every point, which is costly when whole pupil contours
+    are undistorted per frame. Since the mapping is smooth, it is evaluated once on a regular grid over the image upon build(),
+    and points are then undistorted by bilinear interpolation in the grid (with linear extrapolation beyond the image border).
+    The grid is stored as separate x and y arrays, so the interpolation loop over many points is vectorizable.
+
+    build(): evaluates the mapping on the grid, R and P as for cv::undistortPoints (R empty for no rectification)
+    clear(): removes the table
+    isValid(): whether a table is built
+    undistortPoints(): undistorts the given points in one batch, returns false if no table is built
+*/
+class UndistortionLUT {
+
+public:
+
+    UndistortionLUT();
+
+    void build(const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs, const cv::Mat &R, const cv::Mat &P, const cv::Size &imageSize, int step=4);
+    void clear();
+    bool isValid();
+
+    bool undistortPoints(const std::vector<cv::Point2f> &points, std::vector<cv::Point2f> &undistortedPoints);
+
+private:
+
+    struct Table {
+        int step;
+        int cols;
+        int rows;
+        std::vector<float> x;
+        std::vector<float> y;
+    };
+
+    // Swapped as a whole, so rebuilding in the calibration thread does not disturb a running lookup
+    QMutex mutex;
+    std::shared_ptr<const Table> table;
+
+};
+
+/**
+    Geometry helpers for pupil measurements on many points at once
+
+    contourSamples: number of contour points used per pupil for measurements
+    sampleContour(): appends count points evenly spaced (in ellipse parameter) on the outline of the ellipse
+    majorAxis(): length of the major axis of the ellipse fitted to count points, -1 if less than 5 points
+    triangulate(): linear least squares triangulation of corresponding points of two views with projection matrices P1 and P2,
+                   solved in closed form per point in one pass over the batch
+*/
+class PupilGeometry {
+
+public:
+
+    static const int contourSamples = 32;
+
+    static void sampleContour(const cv::RotatedRect &ellipse, int count, std::vector<cv::Point2f> &points);
+    static double majorAxis(const cv::Point2f *points, int count);
+
+    static void triangulate(const cv::Mat &P1, const cv::Mat &P2,
+                            const std::vector<cv::Point2f> &points, const std::vector<cv::Point2f> &pointsSecondary,
+                            std::vector<cv::Point3f> &worldPoints);
+
+};
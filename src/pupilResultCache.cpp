@@ -0,0 +1,172 @@
+
+#include "pupilResultCache.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStandardPaths>
+
+#include <iostream>
+
+namespace {
+    const quint32 resultsMagic = 0x50585052; // "PXPR"
+    const quint32 resultsVersion = 4; // 2: blink flag, which fits into the padding of the pupil records, 3: keyed by frame index, 4: recording identity
+
+    struct FileHeader {
+        quint32 magic;
+        quint32 version;
+        quint32 recordSize; // detects a changed PupilFrameResult layout
+        quint32 reserved;
+        quint64 count;
+        quint64 recording; // see recordingIdentity()
+    };
+
+    struct FileRecord {
+        quint64 frameNumber;
+        quint64 settingsKey;
+        PupilFrameResult result;
+    };
+}
+
+PupilResultCache::PupilResultCache(size_t capacity) :
+    capacity(capacity),
+    modified(false) {
+}
+
+bool PupilResultCache::find(quint64 frameNumber, quint64 settingsKey, std::vector<Pupil> &Pupils) {
+    if(settingsKey == 0)
+        return false;
+
+    const QMutexLocker locker(&mutex);
+    auto it = results.find({frameNumber, settingsKey});
+    if(it == results.end())
+        return false;
+    it->second.getPupils(Pupils);
+    return true;
+}
+
+void PupilResultCache::insert(quint64 frameNumber, quint64 settingsKey, const std::vector<Pupil> &Pupils) {
+    if(settingsKey == 0 || Pupils.size() > static_cast<size_t>(PupilFrameResult::maxPupils))
+        return;
+
+    PupilFrameResult result = PupilFrameResult();
+    result.setPupils(Pupils);
+
+    const QMutexLocker locker(&mutex);
+    if(results.size() >= capacity)
+        makeRoom(settingsKey);
+    if(results.size() >= capacity)
+        return;
+    results[{frameNumber, settingsKey}] = result;
+    modified = true;
+}
+
+// Results of other settings are less likely to be requested again than the ones currently in use
+void PupilResultCache::makeRoom(quint64 settingsKey) {
+    for(auto it = results.begin(); it != results.end();) {
+        if(it->first.settingsKey != settingsKey)
+            it = results.erase(it);
+        else
+            ++it;
+    }
+    modified = true;
+}
+
+void PupilResultCache::clear() {
+    const QMutexLocker locker(&mutex);
+    modified = modified || !results.empty();
+    results.clear();
+}
+
+size_t PupilResultCache::size() {
+    const QMutexLocker locker(&mutex);
+    return results.size();
+}
+
+bool PupilResultCache::load(const QString &fileName, quint64 recording) {
+
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    FileHeader header;
+    if(file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header) || header.magic != resultsMagic ||
+       header.version != resultsVersion || header.recordSize != sizeof(FileRecord) ||
+       file.size() != static_cast<qint64>(sizeof(header) + header.count * sizeof(FileRecord))) {
+        std::cerr << "PupilResultCache: ignoring invalid cache file: " << fileName.toStdString() << std::endl;
+        return false;
+    }
+    if(header.recording != recording) {
+        std::cout << "PupilResultCache: ignoring cache file of a changed recording: " << fileName.toStdString() << std::endl;
+        return false;
+    }
+
+    std::vector<FileRecord> records(header.count);
+    const qint64 bytes = static_cast<qint64>(records.size() * sizeof(FileRecord));
+    if(file.read(reinterpret_cast<char*>(records.data()), bytes) != bytes)
+        return false;
+
+    const QMutexLocker locker(&mutex);
+    results.clear();
+    results.reserve(records.size());
+    for(const FileRecord &record : records) {
+        if(results.size() >= capacity)
+            break;
+        results[{record.frameNumber, record.settingsKey}] = record.result;
+    }
+    modified = false;
+    return true;
+}
+
+bool PupilResultCache::save(const QString &fileName, quint64 recording) {
+
+    std::vector<FileRecord> records;
+    {
+        const QMutexLocker locker(&mutex);
+        if(!modified)
+            return true;
+        records.reserve(results.size());
+        for(const auto &entry : results)
+            records.push_back({entry.first.frameNumber, entry.first.settingsKey, entry.second});
+        modified = false;
+    }
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QFile file(fileName);
+    const FileHeader header = {resultsMagic, resultsVersion, static_cast<quint32>(sizeof(FileRecord)), 0, records.size(), recording};
+    const qint64 bytes = static_cast<qint64>(records.size() * sizeof(FileRecord));
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+       file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header) ||
+       file.write(reinterpret_cast<const char*>(records.data()), bytes) != bytes) {
+        std::cerr << "PupilResultCache: could not write cache file: " << fileName.toStdString() << std::endl;
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+QString PupilResultCache::fileNameForRecording(const QString &recordingPath) {
+    const QByteArray id = QCryptographicHash::hash(QFileInfo(recordingPath).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    const QString cacheDirectory = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("results");
+    return QDir(cacheDirectory).filePath(QString::fromLatin1(id) + ".results");
+}
+
+quint64 PupilResultCache::recordingIdentity(const std::vector<quint64> &timestamps) {
+    const quint64 count = timestamps.size();
+    return hash(timestamps.data(), timestamps.size() * sizeof(quint64), hash(&count, sizeof(count)));
+}
+
+quint64 PupilResultCache::hash(const std::string &data, quint64 seed) {
+    return hash(data.data(), data.size(), seed);
+}
+
+quint64 PupilResultCache::hash(const void *data, size_t size, quint64 seed) {
+    quint64 h = seed;
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for(size_t i=0; i<size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pupilFrameResult.h"
+
+/**
+    Cache of the pupil detection results of an image playback, so frames already detected with the same settings are not detected again,
+    e.g. when playing a recording repeatedly or switching back and forth between parameter sets for comparison
+
+    Results are stored per (frame index, settings key). The frame index is the position of the frame in the recording, as image file names
+    are not necessarily timestamps. The settings key is a hash of everything the result depends on besides the image: the algorithm, its
+    parameters, the processing mode, ROIs, undistortion options and calibration (see PupilDetection::resultCacheKey()).
+    Changing any setting thus yields another key, and results of the old settings are never served for it, there is no explicit
+    invalidation. A key of 0 means "do not cache". When the capacity is reached, results of other settings are dropped first.
+
+    The cache can be saved to and loaded from a binary file, one file per recording (see fileNameForRecording()). As the file is
+    chosen by the path of the recording only, it also stores a recording identity (see recordingIdentity()): if images were added or
+    removed, which renumbers the frames, or another recording was put at the same path, the file is not loaded. Access is
+    synchronized, so the file can be handled from another thread than the pupil detection.
+
+    find(): fills the cached pupils of the frame, returns false if there are none for the settings key
+    insert(): stores the pupils of the frame for the settings key
+    clear(): removes all results
+    load(): replaces the results by the ones of the file, returns false if it is missing, invalid or of another recording
+    save(): writes the results to the file, if they changed since the last load() or save()
+    fileNameForRecording(): cache file of a recording in the application cache directory
+    recordingIdentity(): hash of the frame timestamps of a recording, which changes whenever a frame number refers to another image
+    hash(): stable 64-bit FNV-1a hash, as std::hash and qHash may differ between runs, of a string or raw bytes
+*/
+class PupilResultCache {
+
+public:
+
+    explicit PupilResultCache(size_t capacity=500000);
+
+    bool find(quint64 frameNumber, quint64 settingsKey, std::vector<Pupil> &Pupils);
+    void insert(quint64 frameNumber, quint64 settingsKey, const std::vector<Pupil> &Pupils);
+    void clear();
+    size_t size();
+
+    bool load(const QString &fileName, quint64 recording);
+    bool save(const QString &fileName, quint64 recording);
+
+    static QString fileNameForRecording(const QString &recordingPath);
+    static quint64 recordingIdentity(const std::vector<quint64> &timestamps);
+    static quint64 hash(const std::string &data, quint64 seed=14695981039346656037ull);
+    static quint64 hash(const void *data, size_t size, quint64 seed=14695981039346656037ull);
+
+private:
+
+    struct Key {
+        quint64 frameNumber;
+        quint64 settingsKey;
+
+        bool operator==(const Key &other) const {
+            return frameNumber == other.frameNumber && settingsKey == other.settingsKey;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            return static_cast<size_t>(key.frameNumber * 0x9E3779B97F4A7C15ull ^ key.settingsKey);
+        }
+    };
+
+    QMutex mutex;
+    size_t capacity;
+    bool modified;
+    std::unordered_map<Key, PupilFrameResult, KeyHash> results;
+
+    void makeRoom(quint64 settingsKey);
+};
@@ -0,0 +1,324 @@
+
+#include "recordingIndex.h"
+
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <unordered_set>
+
+namespace {
+    const quint32 indexMagic = 0x50584958; // "PXIX"
+    const quint32 indexVersion = 1;
+}
+
+const char *RecordingIndex::indexFileName = "recording_index.bin";
+
+RecordingIndex::RecordingIndex(bool stereo) :
+    stereo(stereo),
+    imageWidth(0),
+    imageHeight(0) {
+}
+
+std::vector<QString> RecordingIndex::imageDirectories(const QString &recordingDirectory, bool stereo) {
+    const QDir dir(recordingDirectory);
+    if(stereo)
+        return {dir.filePath("0"), dir.filePath("1")};
+    return {dir.path()};
+}
+
+bool RecordingIndex::load(const QString &recordingDirectory) {
+
+    QFile file(QDir(recordingDirectory).filePath(indexFileName));
+    if(!file.exists())
+        return false;
+
+    // Adding or removing images changes the modification time of their directory
+    const QDateTime written = QFileInfo(file).lastModified();
+    for(const QString &imageDirectory : imageDirectories(recordingDirectory, stereo)) {
+        if(QFileInfo(imageDirectory).lastModified() > written) {
+            std::cout << "RecordingIndex: index of " << recordingDirectory.toStdString() << " is outdated" << std::endl;
+            return false;
+        }
+    }
+
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    bool fileStereo;
+    qint32 width, height;
+    quint64 count;
+    in >> magic >> version >> fileStereo >> width >> height >> count;
+    // Each entry takes at least 12 bytes, a larger count means the file is broken
+    if(in.status() != QDataStream::Ok || magic != indexMagic || version != indexVersion || fileStereo != stereo ||
+       count > static_cast<quint64>(file.size()) / 12) {
+        std::cerr << "RecordingIndex: index of " << recordingDirectory.toStdString() << " is invalid" << std::endl;
+        return false;
+    }
+
+    timestamps.clear();
+    filenames.clear();
+    filenamesSecondary.clear();
+    timestamps.reserve(count);
+    filenames.reserve(count);
+    if(stereo)
+        filenamesSecondary.reserve(count);
+
+    quint64 timestamp;
+    QByteArray name, nameSecondary;
+    for(quint64 i=0; i<count; i++) {
+        in >> timestamp >> name;
+        if(stereo)
+            in >> nameSecondary;
+        if(in.status() != QDataStream::Ok)
+            break;
+        addImage(timestamp, name.toStdString(), nameSecondary.toStdString());
+    }
+    if(in.status() != QDataStream::Ok || timestamps.empty() || !std::is_sorted(timestamps.begin(), timestamps.end())) {
+        std::cerr << "RecordingIndex: index of " << recordingDirectory.toStdString() << " is invalid" << std::endl;
+        return false;
+    }
+    imageWidth = width;
+    imageHeight = height;
+
+    // Spot check that the indexed images are still there
+    const std::vector<std::string> paths = getFilePaths(recordingDirectory);
+    if(!QFile::exists(QString::fromStdString(paths.front())) || !QFile::exists(QString::fromStdString(paths.back()))) {
+        std::cout << "RecordingIndex: index of " << recordingDirectory.toStdString() << " is outdated" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// The file is written in place instead of being renamed from a temporary file: renaming would change the modification time
+// of the recording directory after the index was written, so the index of a single camera recording would always look outdated
+bool RecordingIndex::save(const QString &recordingDirectory) const {
+
+    QFile file(QDir(recordingDirectory).filePath(indexFileName));
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cerr << "RecordingIndex: could not write index file: " << file.fileName().toStdString() << std::endl;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << indexMagic << indexVersion << stereo << static_cast<qint32>(imageWidth) << static_cast<qint32>(imageHeight)
+        << static_cast<quint64>(timestamps.size());
+    for(size_t i=0; i<timestamps.size(); i++) {
+        out << timestamps[i] << QByteArray::fromStdString(filenames[i]);
+        if(stereo)
+            out << QByteArray::fromStdString(filenamesSecondary[i]);
+    }
+    file.close();
+
+    if(out.status() != QDataStream::Ok || file.error() != QFileDevice::NoError) {
+        std::cerr << "RecordingIndex: could not write index file: " << file.fileName().toStdString() << std::endl;
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+// Lists the image files of the directory by their filename, alphabetically ordered
+std::vector<std::string> RecordingIndex::listImages(const QString &imageDirectory) {
+
+    // glob sorts the names alphabetically, so filenames without zeros like _19 come after _189
+    std::vector<cv::String> paths;
+    cv::glob(imageDirectory.toStdString(), paths, false);
+    purgeFilenamesVector(paths);
+
+    std::vector<std::string> names;
+    names.reserve(paths.size());
+    for(const cv::String &path : paths) {
+        const size_t separator = path.find_last_of("/\\");
+        names.push_back(separator == cv::String::npos ? path : path.substr(separator + 1));
+    }
+    return names;
+}
+
+bool RecordingIndex::scan(const QString &recordingDirectory) {
+
+    timestamps.clear();
+    filenames.clear();
+    filenamesSecondary.clear();
+    imageWidth = 0;
+    imageHeight = 0;
+
+    const std::vector<QString> directories = imageDirectories(recordingDirectory, stereo);
+    const std::vector<std::string> names = listImages(directories[0]);
+
+    if(stereo) {
+        // Both cameras images of a stereo image have the same filename
+        const std::vector<std::string> namesSecondary = listImages(directories[1]);
+        const std::unordered_set<std::string> secondary(namesSecondary.begin(), namesSecondary.end());
+        for(const std::string &name : names) {
+            if(secondary.count(name))
+                addImage(timestampFromFilename(name), name, name);
+        }
+        if(timestamps.size() != names.size() || timestamps.size() != namesSecondary.size()) {
+            std::cerr << "RecordingIndex: skipping " << names.size() - timestamps.size() << " main and "
+                      << namesSecondary.size() - timestamps.size() << " secondary camera images without counterpart" << std::endl;
+        }
+    } else {
+        for(const std::string &name : names)
+            addImage(timestampFromFilename(name), name);
+    }
+
+    if(timestamps.empty())
+        return false;
+
+    sortByTimestamp();
+
+    // Image size, for documenting in meta-snapshot, taken from the first images that can be read
+    const std::vector<std::string> paths = getFilePaths(recordingDirectory);
+    for(size_t i=0; i<paths.size() && i<10 && (imageWidth<=0 || imageHeight<=0); i++) {
+        const cv::Mat checkImg = cv::imread(paths[i], cv::IMREAD_GRAYSCALE);
+        imageWidth = checkImg.cols;
+        imageHeight = checkImg.rows;
+    }
+
+    std::cout << "RecordingIndex: indexed " << timestamps.size() << " images of " << recordingDirectory.toStdString() << std::endl;
+    return true;
+}
+
+void RecordingIndex::addImage(quint64 timestamp, const std::string &filename, const std::string &filenameSecondary) {
+    timestamps.push_back(timestamp);
+    filenames.push_back(filename);
+    if(stereo)
+        filenamesSecondary.push_back(filenameSecondary);
+}
+
+void RecordingIndex::setImageSize(int width, int height) {
+    imageWidth = width;
+    imageHeight = height;
+}
+
+void RecordingIndex::sortByTimestamp(bool removeDuplicates, const std::vector<quint64> &excluded) {
+
+    std::vector<size_t> order(timestamps.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return timestamps[a] < timestamps[b]; });
+    if(removeDuplicates) {
+        order.erase(std::unique(order.begin(), order.end(), [this](size_t a, size_t b) { return timestamps[a] == timestamps[b]; }),
+                    order.end());
+    }
+    // excluded is sorted, e.g. the images the ImageWriter failed to write
+    if(!excluded.empty()) {
+        order.erase(std::remove_if(order.begin(), order.end(), [this, &excluded](size_t i) {
+            return std::binary_search(excluded.begin(), excluded.end(), timestamps[i]); }), order.end());
+    }
+
+    std::vector<quint64> sortedTimestamps;
+    std::vector<std::string> sortedFilenames, sortedFilenamesSecondary;
+    sortedTimestamps.reserve(order.size());
+    sortedFilenames.reserve(order.size());
+    for(size_t i : order) {
+        sortedTimestamps.push_back(timestamps[i]);
+        sortedFilenames.push_back(std::move(filenames[i]));
+        if(stereo)
+            sortedFilenamesSecondary.push_back(std::move(filenamesSecondary[i]));
+    }
+    timestamps.swap(sortedTimestamps);
+    filenames.swap(sortedFilenames);
+    filenamesSecondary.swap(sortedFilenamesSecondary);
+}
+
+std::vector<std::string> RecordingIndex::getFilePaths(const QString &recordingDirectory, bool secondary) const {
+
+    const std::vector<QString> directories = imageDirectories(recordingDirectory, stereo);
+    const std::string prefix = directories[secondary && stereo ? 1 : 0].toStdString() + "/";
+    const std::vector<std::string> &names = secondary && stereo ? filenamesSecondary : filenames;
+
+    std::vector<std::string> paths;
+    paths.reserve(names.size());
+    for(const std::string &name : names)
+        paths.push_back(prefix + name);
+    return paths;
+}
+
+int RecordingIndex::findTimestamp(quint64 timestamp) const {
+    return findTimestamp(timestamps, timestamp);
+}
+
+int RecordingIndex::findTimestamp(const std::vector<quint64> &timestamps, quint64 timestamp) {
+    auto it = std::lower_bound(timestamps.begin(), timestamps.end(), timestamp);
+    if(it == timestamps.end() || *it != timestamp)
+        return -1;
+    return static_cast<int>(it - timestamps.begin());
+}
+
+// Parses the part of the filename before the first dot, like QFileInfo::baseName(), without creating a QFileInfo per image
+quint64 RecordingIndex::timestampFromFilename(const std::string &filename) {
+    const size_t separator = filename.find_last_of("/\\");
+    const size_t begin = separator == std::string::npos ? 0 : separator + 1;
+    const size_t end = std::min(filename.find('.', begin), filename.size());
+    if(begin == end)
+        return 0;
+
+    quint64 timestamp = 0;
+    for(size_t i=begin; i<end; i++) {
+        const char c = filename[i];
+        if(c < '0' || c > '9')
+            return 0;
+        timestamp = timestamp * 10 + static_cast<quint64>(c - '0');
+    }
+    return timestamp;
+}
+
+void RecordingIndex::purgeFilenamesVector(std::vector<cv::String> &filenames) {
+
+    if(filenames.empty())
+        return;
+
+    // we find the most frequent extension in the folder (which must be the image extension we use)
+    std::vector<cv::String> fileExtensions;
+    std::vector<int> fileExtensionFreqencies;
+    size_t dotPos = cv::String::npos;
+    cv::String currExt;
+    //
+    for(int c=0; c<filenames.size(); c++) {
+        dotPos = filenames[c].find_last_of('.');
+        if(dotPos != cv::String::npos) {
+            currExt = filenames[c].substr(dotPos, filenames[c].length()-(dotPos));
+
+            auto whereInVector = std::find(fileExtensions.begin(), fileExtensions.end(), currExt);
+            if(whereInVector == fileExtensions.end()) { // if the extension can NOT be found in the vector, add it
+                fileExtensions.push_back(currExt);
+                fileExtensionFreqencies.push_back(1);
+                //std::cout << "Found files in the folder with the following extension = " << currExt ;
+            } else {
+                fileExtensionFreqencies[(int)(whereInVector-fileExtensions.begin())]++;
+            }
+        }
+    }
+    if(fileExtensions.empty()) {
+        filenames.clear();
+        return;
+    }
+    int mostFreqIndex = std::max_element(fileExtensionFreqencies.begin(), fileExtensionFreqencies.end())-fileExtensionFreqencies.begin();
+
+    // Erasing one by one from a vector of hundreds of thousands of names is quadratic, the kept names are compacted instead
+    const cv::String &imageExt = fileExtensions[mostFreqIndex];
+    auto kept = std::remove_if(filenames.begin(), filenames.end(), [&imageExt](const cv::String &filename) {
+        const size_t dot = filename.find_last_of('.');
+        //also handles if the filename ends with dot but there are no characters afterwards
+        const bool unusual = dot == cv::String::npos || filename.compare(dot, cv::String::npos, imageExt) != 0;
+        if(unusual)
+            std::cout << "Deleting unusual filename from detected filenames vector = " << filename << std::endl;
+        return unusual;
+    });
+    filenames.erase(kept, filenames.end());
+}
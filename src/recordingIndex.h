@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QString>
+#include <opencv2/core.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+    Index of an image recording, i.e. a directory of images, or a stereo recording directory with the subdirectories 0 and 1
+
+    Listing and parsing a directory of hundreds of thousands of images takes long, so the index is persisted as binary file
+    (indexFileName) in the recording directory: image timestamps in ascending order, the filenames (relative to the image directory)
+    and the image size. For stereo recordings, only images present in both directories are indexed. The index is written by the
+    ImageWriter when a recording finishes, or by the ImageReader when a recording without (valid) index is opened.
+
+    The index file is considered outdated if any image directory was modified after it was written (images added or removed),
+    the recording is then scanned again.
+
+    load(): reads the index file of the recording directory, returns false if it is missing, invalid or outdated
+    save(): writes the index file into the recording directory
+    scan(): builds the index by listing the image directories, returns false if no images are found
+    addImage(): appends an image, e.g. while recording, sortByTimestamp() must be called before saving
+    sortByTimestamp(): sorts the images by timestamp (keeping the filename order for equal timestamps), removes duplicates if requested
+        and the images with one of the given (sorted) excluded timestamps
+    getFilePaths(): absolute paths of the main or secondary camera images
+    findTimestamp(): index of the image with the given timestamp using binary search, -1 if there is none
+    timestampFromFilename(): timestamp contained in the filename as in the format written by the ImageWriter, 0 if it contains none
+*/
+class RecordingIndex {
+
+public:
+
+    static const char *indexFileName;
+
+    explicit RecordingIndex(bool stereo=false);
+
+    bool load(const QString &recordingDirectory);
+    bool save(const QString &recordingDirectory) const;
+    bool scan(const QString &recordingDirectory);
+
+    void addImage(quint64 timestamp, const std::string &filename, const std::string &filenameSecondary=std::string());
+    void sortByTimestamp(bool removeDuplicates=false, const std::vector<quint64> &excluded=std::vector<quint64>());
+    void setImageSize(int width, int height);
+
+    bool isStereo() const {
+        return stereo;
+    }
+    int size() const {
+        return static_cast<int>(timestamps.size());
+    }
+    int getImageWidth() const {
+        return imageWidth;
+    }
+    int getImageHeight() const {
+        return imageHeight;
+    }
+    const std::vector<quint64> &getTimestamps() const {
+        return timestamps;
+    }
+    std::vector<std::string> getFilePaths(const QString &recordingDirectory, bool secondary=false) const;
+
+    int findTimestamp(quint64 timestamp) const;
+
+    static int findTimestamp(const std::vector<quint64> &timestamps, quint64 timestamp);
+    static quint64 timestampFromFilename(const std::string &filename);
+
+private:
+
+    bool stereo;
+    int imageWidth;
+    int imageHeight;
+
+    std::vector<quint64> timestamps;
+    std::vector<std::string> filenames, filenamesSecondary;
+
+    static std::vector<QString> imageDirectories(const QString &recordingDirectory, bool stereo);
+    static std::vector<std::string> listImages(const QString &imageDirectory);
+    static void purgeFilenamesVector(std::vector<cv::String> &filenames);
+};
@@ -0,0 +1,79 @@
+
+#include "roiRemapper.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+ROIRemapper::ROIRemapper() : useCounter(0) {
+}
+
+void ROIRemapper::setMaps(const cv::Mat &map1, const cv::Mat &map2) {
+    cv::Mat m1, m2;
+    cv::convertMaps(map1, map2, m1, m2, CV_16SC2);
+
+    const QMutexLocker locker(&mutex);
+    fixedMap1 = m1;
+    fixedMap2 = m2;
+    roiMaps.clear();
+}
+
+void ROIRemapper::clear() {
+    const QMutexLocker locker(&mutex);
+    fixedMap1.release();
+    fixedMap2.release();
+    roiMaps.clear();
+}
+
+bool ROIRemapper::isValid() {
+    const QMutexLocker locker(&mutex);
+    return !fixedMap1.empty();
+}
+
+cv::Mat ROIRemapper::remap(const cv::Mat &img) {
+    cv::Mat map1, map2;
+    {
+        const QMutexLocker locker(&mutex);
+        map1 = fixedMap1;
+        map2 = fixedMap2;
+    }
+    if(map1.empty() || map1.size() != img.size())
+        return img;
+
+    cv::Mat mapped;
+    cv::remap(img, mapped, map1, map2, cv::INTER_LINEAR);
+    return mapped;
+}
+
+// The map headers are copied under the lock, the remapping itself runs unlocked, so concurrent callers
+// (e.g. the two pupils of the two-pupil mode) do not serialize on each other
+cv::Mat ROIRemapper::remap(const cv::Mat &img, const cv::Rect &roi) {
+    cv::Mat map1, map2;
+    cv::Rect region;
+    {
+        const QMutexLocker locker(&mutex);
+        if(fixedMap1.empty() || fixedMap1.size() != img.size())
+            return img(roi & cv::Rect(0, 0, img.cols, img.rows));
+
+        region = roi & cv::Rect(0, 0, fixedMap1.cols, fixedMap1.rows);
+        if(region.area() == 0 || region.size() == fixedMap1.size()) {
+            map1 = fixedMap1;
+            map2 = fixedMap2;
+        } else {
+            auto it = std::find_if(roiMaps.begin(), roiMaps.end(), [&region](const ROIMaps &m) { return m.roi == region; });
+            if(it == roiMaps.end()) {
+                if(roiMaps.size() >= maxCachedROIs)
+                    roiMaps.erase(std::min_element(roiMaps.begin(), roiMaps.end(), [](const ROIMaps &a, const ROIMaps &b) { return a.lastUse < b.lastUse; }));
+                roiMaps.push_back(ROIMaps{region, fixedMap1(region).clone(), fixedMap2(region).clone(), 0});
+                it = roiMaps.end() - 1;
+            }
+            it->lastUse = ++useCounter;
+            map1 = it->map1;
+            map2 = it->map2;
+        }
+    }
+
+    cv::Mat mapped;
+    cv::remap(img, mapped, map1, map2, cv::INTER_LINEAR);
+    return mapped;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QMutex>
+#include <opencv2/core/mat.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+    Applies an undistortion/rectification mapping to whole images or to image regions only
+
+    The float maps from cv::initUndistortRectifyMap are converted once into the fixed-point CV_16SC2/CV_16UC1 format,
+    which cv::remap processes considerably faster and with half the memory traffic. For regions of interest, contiguous
+    copies of the map regions are kept for the most recently used ROIs, so only the ROI pixels are remapped per frame
+    (the source image is still the whole image, as ROI pixels may map to positions outside of the ROI).
+
+    setMaps(): sets new float maps, invalidating all cached ROI maps
+    clear(): removes the mapping
+    isValid(): whether a mapping is set
+    remap(img): remaps the whole image
+    remap(img, roi): remaps only the region roi of the mapped image, the result has the (clipped) size of roi
+*/
+class ROIRemapper {
+
+public:
+
+    ROIRemapper();
+
+    void setMaps(const cv::Mat &map1, const cv::Mat &map2);
+    void clear();
+    bool isValid();
+
+    cv::Mat remap(const cv::Mat &img);
+    cv::Mat remap(const cv::Mat &img, const cv::Rect &roi);
+
+private:
+
+    struct ROIMaps {
+        cv::Rect roi;
+        cv::Mat map1;
+        cv::Mat map2;
+        uint64_t lastUse;
+    };
+
+    // Enough for two pupils per view, older entries are replaced once the ROIs change
+    static const size_t maxCachedROIs = 4;
+
+    QMutex mutex;
+    cv::Mat fixedMap1, fixedMap2;
+    std::vector<ROIMaps> roiMaps;
+    uint64_t useCounter;
+
+};
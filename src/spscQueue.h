@@ -0,0 +1,68 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+    Bounded lock-free queue for exactly one producer thread and one consumer thread
+
+    Neither side ever blocks or takes a lock, so a time-critical producer (e.g. a socket reader) is never delayed by a
+    consumer that is busy, e.g. the GUI thread. The capacity is rounded up to a power of two.
+
+    push(): called by the producer only, returns false if the queue is full (the item is not added)
+    pop(): called by the consumer only, returns false if the queue is empty
+    empty(): approximate, exact only when called by the consumer
+*/
+template<typename T>
+class SPSCQueue {
+
+public:
+
+    explicit SPSCQueue(size_t capacity) : buffer(roundUpToPowerOfTwo(capacity)), mask(buffer.size() - 1), head(0), tail(0) {
+    }
+
+    bool push(T &&item) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == buffer.size())
+            return false;
+        buffer[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire))
+            return false;
+        item = std::move(buffer[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t p = 2;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    std::vector<T> buffer;
+    const size_t mask;
+
+    // On separate cache lines, so producer and consumer do not invalidate each others cache on every operation
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+
+};
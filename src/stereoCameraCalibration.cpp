@@ -78,6 +78,13 @@ void StereoCameraCalibration::reset() {
     distCoeffs = cv::Mat::zeros(8, 1, CV_64F);
     distCoeffsSecondary = cv::Mat::zeros(8, 1, CV_64F);
 
+    rectifyRemapper.clear();
+    rectifyRemapperSecondary.clear();
+    undistLUT.clear();
+    undistLUTSecondary.clear();
+    rectifyLUT.clear();
+    rectifyLUTSecondary.clear();
+
     emit unavailableCalibration();
 }
 
@@ -260,6 +267,12 @@ void StereoCameraCalibration::onNewImage(const CameraImage &cimg) {
 
             cv::initUndistortRectifyMap(cameraMatrix, distCoeffs, rectificationTransform, projectionMatrix, imageSize, CV_32F, lmapx, lmapy);
             cv::initUndistortRectifyMap(cameraMatrixSecondary, distCoeffsSecondary, rectificationTransformSecondary, projectionMatrixSecondary, imageSize, CV_32F, rmapx, rmapy);
+            rectifyRemapper.setMaps(lmapx, lmapy);
+            rectifyRemapperSecondary.setMaps(rmapx, rmapy);
+            undistLUT.build(cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix, imageSize);
+            undistLUTSecondary.build(cameraMatrixSecondary, distCoeffsSecondary, cv::Mat(), newCameraMatrixSecondary, imageSize);
+            rectifyLUT.build(cameraMatrix, distCoeffs, rectificationTransform, projectionMatrix, imageSize);
+            rectifyLUTSecondary.build(cameraMatrixSecondary, distCoeffsSecondary, rectificationTransformSecondary, projectionMatrixSecondary, imageSize);
 
             emit finishedCalibration();
         } else if(calibrationSuccess.isFinished() && !calibrationSuccess.result()) {
@@ -273,10 +286,8 @@ void StereoCameraCalibration::onNewImage(const CameraImage &cimg) {
         if(timer.elapsed() > updateDelay && !img.empty()) {
             timer.restart();
 
-            cv::Mat undist, undistSec;
-
-            cv::remap(img, undist, lmapx, lmapy, cv::INTER_LINEAR);
-            cv::remap(imgSecondary, undistSec, rmapx, rmapy, cv::INTER_LINEAR);
+            cv::Mat undist = rectifyRemapper.remap(img);
+            cv::Mat undistSec = rectifyRemapperSecondary.remap(imgSecondary);
 
             cv::putText(undist, "RECTIFIED", cv::Point(0.1*undist.cols, 0.1*undist.rows), cv::FONT_HERSHEY_PLAIN, 4, cv::Scalar(255,0,0), 3);
             cv::putText(undist, "MAIN RMSE: " + std::to_string(intrinsicRMSE) + "px", cv::Point(0.1 * undist.cols, 0.2 * undist.rows), cv::FONT_HERSHEY_PLAIN, 4, cv::Scalar(0, 0, 255), 3);
@@ -520,20 +531,8 @@ std::vector<cv::Point3f> StereoCameraCalibration::convertPointsTo3D(const std::v
                         distCoeffsSecondary, rectificationTransformSecondary,
                         projectionMatrixSecondary);
 
-    cv::Mat homogenPoints(4, static_cast<int>(distortedPoints.size()), CV_32F);
-
-    cv::triangulatePoints(projectionMatrix, projectionMatrixSecondary, undistCornerPointsBuf,
-                          undistCornerPointsBufSecondary, homogenPoints);
-
-    std::vector<cv::Point3f> worldPoints(distortedPoints.size());
-
-    // Output of triangulate points are in homogenous coordinates, convert to cartesian
-    for (int i = 0; i < homogenPoints.cols; i++) {
-        float scale = homogenPoints.at<float>(3, i) != 0.f ? homogenPoints.at<float>(3, i) : 1.f;
-        worldPoints.at(i).x = homogenPoints.at<float>(0, i) / scale;
-        worldPoints.at(i).y = homogenPoints.at<float>(1, i) / scale;
-        worldPoints.at(i).z = homogenPoints.at<float>(2, i) / scale;
-    }
+    std::vector<cv::Point3f> worldPoints;
+    PupilGeometry::triangulate(projectionMatrix, projectionMatrixSecondary, undistCornerPointsBuf, undistCornerPointsBufSecondary, worldPoints);
 
     return worldPoints;
 }
@@ -541,34 +540,173 @@ std::vector<cv::Point3f> StereoCameraCalibration::convertPointsTo3D(const std::v
 // Undistort pupil detections sizes based on the undistortion of pupil contour points
 // This only undistorts pixel values, not physical measures which are already undistorted by design
 std::pair<double, double> StereoCameraCalibration::undistortPupilDiameters(const Pupil &pupil, const Pupil &pupilSecondary) {
-    // Undistorting using remap should be faster than using the undistort function
+    return undistortPupilDiameters(std::vector<Pupil>{pupil}, std::vector<Pupil>{pupilSecondary}).front();
+}
+
+// Batched version for several pupil pairs (e.g. both eyes), pupils[i] in the main and pupilsSecondary[i] in the secondary view
+// Points of the whole fitted pupil ellipses are undistorted through the cached lookup tables, one call per camera
+std::vector<std::pair<double, double>> StereoCameraCalibration::undistortPupilDiameters(const std::vector<Pupil> &pupils, const std::vector<Pupil> &pupilsSecondary) {
+
+    const size_t count = std::min(pupils.size(), pupilsSecondary.size());
+    std::vector<std::pair<double, double>> diameters(count);
+    for(size_t i=0; i<count; i++)
+        diameters[i] = std::make_pair(pupils[i].diameter(), pupilsSecondary[i].diameter());
+
     if(mode!=CALIBRATED)
-        return std::make_pair(pupil.diameter(), pupilSecondary.diameter());
+        return diameters;
+
+    std::vector<size_t> measured, measuredSecondary;
+    std::vector<cv::Point2f> contours, contoursSecondary;
+    for(size_t i=0; i<count; i++) {
+        if(pupils[i].valid(-2) && pupils[i].size.area() > 0) {
+            PupilGeometry::sampleContour(pupils[i], PupilGeometry::contourSamples, contours);
+            measured.push_back(i);
+        }
+        if(pupilsSecondary[i].valid(-2) && pupilsSecondary[i].size.area() > 0) {
+            PupilGeometry::sampleContour(pupilsSecondary[i], PupilGeometry::contourSamples, contoursSecondary);
+            measuredSecondary.push_back(i);
+        }
+    }
 
-    Pupil rotPupil(pupil);
-    rotPupil.angle += 360-rotPupil.angle;
-    Pupil rotPupilSecondary(pupilSecondary);
-    rotPupilSecondary.angle += 360-rotPupilSecondary.angle;
+    std::vector<cv::Point2f> undistContours, undistContoursSecondary;
+    if(!contours.empty() && !undistLUT.undistortPoints(contours, undistContours))
+        cv::undistortPoints(contours, undistContours, cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix);
+    if(!contoursSecondary.empty() && !undistLUTSecondary.undistortPoints(contoursSecondary, undistContoursSecondary))
+        cv::undistortPoints(contoursSecondary, undistContoursSecondary, cameraMatrixSecondary, distCoeffsSecondary, cv::Mat(), newCameraMatrixSecondary);
 
-    // convert pupil detection from pixel into mm through stereocalibration
-    // Select the top left and top right corner of the bounding rects of the pupils as the points we triangulate
-    cv::Point2f mainPointsArr[4]; // rotatedRect points in order: bottomLeft, topLeft, topRight, bottomRight
-    rotPupil.points(mainPointsArr);
-    int secondPoint = rotPupil.size.width > rotPupil.size.height ? 2 : 0; // if the pupil major axis is horizontal use topLeft and topRight, else topLeft and bottomLeft
-    //cv::line(mimg.img,mainPointsArr[1], mainPointsArr[secondPoint], cv::Scalar(255, 0, 0));
+    for(size_t k=0; k<measured.size(); k++)
+        diameters[measured[k]].first = PupilGeometry::majorAxis(&undistContours[k * PupilGeometry::contourSamples], PupilGeometry::contourSamples);
+    for(size_t k=0; k<measuredSecondary.size(); k++)
+        diameters[measuredSecondary[k]].second = PupilGeometry::majorAxis(&undistContoursSecondary[k * PupilGeometry::contourSamples], PupilGeometry::contourSamples);
 
-    cv::Point2f secondaryPointsArr[4];
-    rotPupilSecondary.points(secondaryPointsArr);
-    //cv::line(mimg.imgSecondary,secondaryPointsArr[1], secondaryPointsArr[secondPoint], cv::Scalar(255, 0, 0));
+    return diameters;
+}
 
-    std::vector<cv::Point2f> mainPoints{mainPointsArr[1], mainPointsArr[secondPoint]}, secondaryPoints{secondaryPointsArr[1], secondaryPointsArr[secondPoint]};
+// Physical pupil diameters of several pupil pairs, pupils[i] in the main and pupilsSecondary[i] in the secondary view, -1 if not measurable
+// The contours and centers of all pupils are rectified in one batch per camera, and all centers are triangulated at once.
+// In the rectified views both cameras share the focal length f and the depth Z of a point, so the major axis of the
+// rectified pupil contour (a pixels) corresponds to a * Z / f in world units. Using the whole contour of both views
+// instead of two bounding box corners makes the measure less sensitive to the ellipse orientation and to single points.
+std::vector<double> StereoCameraCalibration::physicalPupilDiameters(const std::vector<Pupil> &pupils, const std::vector<Pupil> &pupilsSecondary) {
+
+    const size_t count = std::min(pupils.size(), pupilsSecondary.size());
+    std::vector<double> diameters(count, -1.0);
+
+    if(mode!=CALIBRATED || projectionMatrix.empty() || projectionMatrixSecondary.empty())
+        return diameters;
+
+    std::vector<size_t> measured;
+    std::vector<cv::Point2f> contours, contoursSecondary;
+    std::vector<cv::Point2f> centers, centersSecondary;
+    for(size_t i=0; i<count; i++) {
+        if(!pupils[i].valid(-2) || !pupilsSecondary[i].valid(-2) || pupils[i].size.area() <= 0 || pupilsSecondary[i].size.area() <= 0)
+            continue;
+        PupilGeometry::sampleContour(pupils[i], PupilGeometry::contourSamples, contours);
+        PupilGeometry::sampleContour(pupilsSecondary[i], PupilGeometry::contourSamples, contoursSecondary);
+        centers.push_back(pupils[i].center);
+        centersSecondary.push_back(pupilsSecondary[i].center);
+        measured.push_back(i);
+    }
+    if(measured.empty())
+        return diameters;
+
+    // Centers are appended to the contours, so each camera needs a single lookup
+    const size_t contourPoints = contours.size();
+    contours.insert(contours.end(), centers.begin(), centers.end());
+    contoursSecondary.insert(contoursSecondary.end(), centersSecondary.begin(), centersSecondary.end());
+
+    std::vector<cv::Point2f> rectified, rectifiedSecondary;
+    if(!rectifyLUT.undistortPoints(contours, rectified))
+        cv::undistortPoints(contours, rectified, cameraMatrix, distCoeffs, rectificationTransform, projectionMatrix);
+    if(!rectifyLUTSecondary.undistortPoints(contoursSecondary, rectifiedSecondary))
+        cv::undistortPoints(contoursSecondary, rectifiedSecondary, cameraMatrixSecondary, distCoeffsSecondary, rectificationTransformSecondary, projectionMatrixSecondary);
+
+    std::vector<cv::Point3f> worldCenters;
+    PupilGeometry::triangulate(projectionMatrix, projectionMatrixSecondary,
+                               std::vector<cv::Point2f>(rectified.begin() + contourPoints, rectified.end()),
+                               std::vector<cv::Point2f>(rectifiedSecondary.begin() + contourPoints, rectifiedSecondary.end()),
+                               worldCenters);
+
+    cv::Mat_<double> P;
+    projectionMatrix.convertTo(P, CV_64F);
+    const double f = P(0,0);
+    if(f <= 0)
+        return diameters;
+
+    for(size_t k=0; k<measured.size(); k++) {
+        const double z = worldCenters[k].z;
+        if(z <= 0)
+            continue;
+        const double a = PupilGeometry::majorAxis(&rectified[k * PupilGeometry::contourSamples], PupilGeometry::contourSamples);
+        const double aSecondary = PupilGeometry::majorAxis(&rectifiedSecondary[k * PupilGeometry::contourSamples], PupilGeometry::contourSamples);
+        diameters[measured[k]] = 0.5 * (a + aSecondary) * z / f;
+    }
+    return diameters;
+}
 
-    std::vector<cv::Point2f> undistCornerPointsBuf, undistCornerPointsBufSecondary;
+// Depths of the pupil centers of several pupil pairs along the optical axis of the main camera (calibration units), -1 if not measurable
+// The centers are triangulated in the rectified main camera frame, which is rotated back into the main camera frame
+std::vector<double> StereoCameraCalibration::pupilDepths(const std::vector<Pupil> &pupils, const std::vector<Pupil> &pupilsSecondary) {
 
-    cv::undistortPoints(cv::Mat(mainPoints), undistCornerPointsBuf, cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix);
-    cv::undistortPoints(cv::Mat(secondaryPoints), undistCornerPointsBufSecondary, cameraMatrixSecondary, distCoeffsSecondary, cv::Mat(), newCameraMatrixSecondary);
+    const size_t count = std::min(pupils.size(), pupilsSecondary.size());
+    std::vector<double> depths(count, -1.0);
 
-    return std::make_pair(cv::norm(undistCornerPointsBuf[0] - undistCornerPointsBuf[1]), cv::norm(undistCornerPointsBufSecondary[0] - undistCornerPointsBufSecondary[1]));
+    if(mode!=CALIBRATED || projectionMatrix.empty() || projectionMatrixSecondary.empty())
+        return depths;
+
+    std::vector<size_t> measured;
+    std::vector<cv::Point2f> centers, centersSecondary;
+    for(size_t i=0; i<count; i++) {
+        if(!pupils[i].valid(-2) || !pupilsSecondary[i].valid(-2))
+            continue;
+        centers.push_back(pupils[i].center);
+        centersSecondary.push_back(pupilsSecondary[i].center);
+        measured.push_back(i);
+    }
+    if(measured.empty())
+        return depths;
+
+    const std::vector<cv::Point3f> worldCenters = convertPointsTo3D(centers, centersSecondary);
+
+    cv::Mat_<double> R;
+    rectificationTransform.convertTo(R, CV_64F);
+    for(size_t k=0; k<measured.size(); k++) {
+        const cv::Point3f &p = worldCenters[k];
+        const double z = R(0,2) * p.x + R(1,2) * p.y + R(2,2) * p.z;
+        if(z > 0)
+            depths[measured[k]] = z;
+    }
+    return depths;
+}
+
+// Region of the secondary image where a point of the main image can appear if its depth is within [minDepth, maxDepth] (calibration units)
+// This is the bounding box of the corresponding segment of the epipolar line, sampled as it is curved by the lens distortion
+// Points along the viewing ray are sampled uniformly in inverse depth, which is uniform along the projected line
+// Returns an empty rectangle if the camera is not calibrated
+cv::Rect StereoCameraCalibration::epipolarSearchWindow(const cv::Point2f &point, double minDepth, double maxDepth) {
+
+    if(mode!=CALIBRATED || rotationMatrix.empty() || translationMatrix.empty() || minDepth <= 0 || maxDepth < minDepth)
+        return cv::Rect();
+
+    const int samples = 16;
+
+    // Viewing ray of the point in normalized main camera coordinates
+    std::vector<cv::Point2f> normalized;
+    cv::undistortPoints(std::vector<cv::Point2f>{point}, normalized, cameraMatrix, distCoeffs);
+
+    std::vector<cv::Point3f> ray(samples);
+    for(int i=0; i<samples; i++) {
+        const double z = 1.0 / (1.0/maxDepth + (1.0/minDepth - 1.0/maxDepth) * i / (samples - 1));
+        ray[i] = cv::Point3f(static_cast<float>(normalized[0].x * z), static_cast<float>(normalized[0].y * z), static_cast<float>(z));
+    }
+
+    // The stereo calibration's rotation and translation map main camera into secondary camera coordinates
+    cv::Mat rotationVector;
+    cv::Rodrigues(rotationMatrix, rotationVector);
+    std::vector<cv::Point2f> projected;
+    cv::projectPoints(ray, rotationVector, translationMatrix, cameraMatrixSecondary, distCoeffsSecondary, projected);
+
+    return cv::boundingRect(projected);
 }
 
 // Reprojection error of the calibration
@@ -786,12 +924,32 @@ void StereoCameraCalibration::loadFromFile(QString filename) {
 
         cv::initUndistortRectifyMap(cameraMatrix, distCoeffs, rectificationTransform, projectionMatrix, imageSize, CV_32F, lmapx, lmapy);
         cv::initUndistortRectifyMap(cameraMatrixSecondary, distCoeffsSecondary, rectificationTransformSecondary, projectionMatrixSecondary, imageSize, CV_32F, rmapx, rmapy);
+        rectifyRemapper.setMaps(lmapx, lmapy);
+        rectifyRemapperSecondary.setMaps(rmapx, rmapy);
+        undistLUT.build(cameraMatrix, distCoeffs, cv::Mat(), newCameraMatrix, imageSize);
+        undistLUTSecondary.build(cameraMatrixSecondary, distCoeffsSecondary, cv::Mat(), newCameraMatrixSecondary, imageSize);
+        rectifyLUT.build(cameraMatrix, distCoeffs, rectificationTransform, projectionMatrix, imageSize);
+        rectifyLUTSecondary.build(cameraMatrixSecondary, distCoeffsSecondary, rectificationTransformSecondary, projectionMatrixSecondary, imageSize);
 
         mode = CALIBRATED;
         emit finishedCalibration();
     }
 }
 
+// Rectifies a given main/secondary camera image using the calibration
+// If no calibration is load, the unchanged image is returned
+cv::Mat StereoCameraCalibration::rectifyImage(const cv::Mat &img) {
+    if(mode!=CALIBRATED)
+        return img;
+    return rectifyRemapper.remap(img);
+}
+
+cv::Mat StereoCameraCalibration::rectifyImageSecondary(const cv::Mat &imgSecondary) {
+    if(mode!=CALIBRATED)
+        return imgSecondary;
+    return rectifyRemapperSecondary.remap(imgSecondary);
+}
+
 template <typename T> void StereoCameraCalibration::writeVectorCSV(std::vector<std::tuple<int, uint64_t , T>> data, const std::string &header, const std::string &filename) {
 
     std::ofstream file(filename);
@@ -9,6 +9,8 @@
 #include <QtCore/QElapsedTimer>
 #include "devices/camera.h"
 #include "cameraCalibration.h"
+#include "roiRemapper.h"
+#include "pupilGeometry.h"
 #include <QtConcurrent/QtConcurrent>
 
 /**
@@ -115,6 +117,22 @@ public:
         return distCoeffs;
     }
 
+    cv::Mat getCameraMatrixSecondary() {
+        return cameraMatrixSecondary;
+    }
+
+    cv::Mat getDistCoefficientsSecondary() {
+        return distCoeffsSecondary;
+    }
+
+    cv::Mat getRotationMatrix() {
+        return rotationMatrix;
+    }
+
+    cv::Mat getTranslationMatrix() {
+        return translationMatrix;
+    }
+
     double getMainRMSE() {
         return intrinsicRMSE;
     }
@@ -167,6 +185,14 @@ public:
                                                const std::vector<cv::Point2f> &distortedPointsSecondary);
 
     std::pair<double, double> undistortPupilDiameters(const Pupil &pupil, const Pupil &pupilSecondary);
+    std::vector<std::pair<double, double>> undistortPupilDiameters(const std::vector<Pupil> &pupils, const std::vector<Pupil> &pupilsSecondary);
+    std::vector<double> physicalPupilDiameters(const std::vector<Pupil> &pupils, const std::vector<Pupil> &pupilsSecondary);
+    std::vector<double> pupilDepths(const std::vector<Pupil> &pupils, const std::vector<Pupil> &pupilsSecondary);
+
+    cv::Rect epipolarSearchWindow(const cv::Point2f &point, double minDepth, double maxDepth);
+
+    cv::Mat rectifyImage(const cv::Mat &img);
+    cv::Mat rectifyImageSecondary(const cv::Mat &imgSecondary);
 
 private:
 
@@ -188,6 +214,9 @@ private:
     cv::Mat newCameraMatrix, newCameraMatrixSecondary;
 
     cv::Mat lmapx, lmapy, rmapx, rmapy;
+    ROIRemapper rectifyRemapper, rectifyRemapperSecondary;
+    UndistortionLUT undistLUT, undistLUTSecondary;
+    UndistortionLUT rectifyLUT, rectifyLUTSecondary;
 
     std::vector<std::vector<cv::Point3f>> referenceObjectPoints;
 
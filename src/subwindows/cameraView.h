@@ -118,6 +118,7 @@ public slots:
     void saveROI2Selection(QRectF roiR);
 
     virtual void displayFileCameraFrame(int frameNumber) = 0;
+    virtual void displayFileCameraPreview(int frameNumber) = 0;
 
     virtual void updateForPupilDetectionProcMode() = 0;
     void updateView(const CameraImage &cimg, const int &procMode, const std::vector<cv::Rect> &ROIs, const std::vector<Pupil> &Pupils);
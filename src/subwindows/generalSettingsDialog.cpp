@@ -7,6 +7,7 @@
 #include <iostream>
 #include "generalSettingsDialog.h"
 #include "../supportFunctions.h"
+#include "../threadBudget.h"
 
 // Create a settings dialog for the general software settings
 // Settings are read upon creation from the QT application settings if existing
@@ -20,7 +21,7 @@ GeneralSettingsDialog::GeneralSettingsDialog(QWidget *parent) :
         applicationSettings(new QSettings(QSettings::IniFormat, QSettings::UserScope, QCoreApplication::organizationName(), QCoreApplication::applicationName(), parent)) {
 
     //this->setMinimumSize(200, 330); 
-    this->setMinimumSize(380, 580);
+    this->setMinimumSize(380, 700);
     this->setWindowTitle("Settings");
 
     readSettings();
@@ -44,6 +45,14 @@ GeneralSettingsDialog::GeneralSettingsDialog(QWidget *parent) :
     connect(saveOfflineEventLogBox, SIGNAL(stateChanged(int)), this, SLOT(setSaveOfflineEventLog(int)));
     connect(alwaysOnTopBox, SIGNAL(stateChanged(int)), this, SLOT(setAlwaysOnTop(int)));
 
+    connect(threadBudgetDetectionBox, SIGNAL(valueChanged(int)), this, SLOT(onThreadBudgetDetectionChange(int)));
+    connect(threadBudgetRecordingBox, SIGNAL(valueChanged(int)), this, SLOT(onThreadBudgetRecordingChange(int)));
+    connect(threadBudgetPlaybackBox, SIGNAL(valueChanged(int)), this, SLOT(onThreadBudgetPlaybackChange(int)));
+    connect(pinDetectionThreadBox, SIGNAL(stateChanged(int)), this, SLOT(setPinDetectionThread(int)));
+
+    connect(framePairingWindowBox, SIGNAL(valueChanged(int)), this, SLOT(onFramePairingWindowChange(int)));
+    connect(framePairingTimeoutBox, SIGNAL(valueChanged(int)), this, SLOT(onFramePairingTimeoutChange(int)));
+
     connect(applyButton, &QPushButton::clicked, this, &GeneralSettingsDialog::apply);
     connect(cancelButton, &QPushButton::clicked, this, &GeneralSettingsDialog::cancel);
 }
@@ -86,6 +95,14 @@ void GeneralSettingsDialog::readSettings() {
     darkAdaptMode = applicationSettings->value("GUIDarkAdaptMode", "2").toInt();
     // GUIDarkAdaptMode: 0 = no, 1 = yes, 2 = let PupilEXT guess
 
+    // 0 = derived from the number of cores
+    threadBudgetDetection = applicationSettings->value("threadBudget.detection", 0).toInt();
+    threadBudgetRecording = applicationSettings->value("threadBudget.recording", 0).toInt();
+    threadBudgetPlayback = applicationSettings->value("threadBudget.playback", 0).toInt();
+    pinDetectionThread = SupportFunctions::readBoolFromQSettings("threadBudget.pinDetectionThread", false, applicationSettings);
+    framePairingWindow = applicationSettings->value("StereoCamera.framePairingWindow", 16).toInt();
+    framePairingTimeoutMs = applicationSettings->value("StereoCamera.framePairingTimeoutMs", 0).toInt();
+
 }
 
 void GeneralSettingsDialog::updateForm() {
@@ -118,6 +135,8 @@ void GeneralSettingsDialog::updateForm() {
 
     if(dataWriterDataStyle == "PupilEXT-0-1-1")
         dataWriterDataStyleBox->setCurrentIndex(0);
+    else if(dataWriterDataStyle == "PupilEXT-0-1-3")
+        dataWriterDataStyleBox->setCurrentIndex(2);
     else // if(dataWriterDataStyle == "PupilEXT-0-1-2")
         dataWriterDataStyleBox->setCurrentIndex(1);
 
@@ -133,6 +152,15 @@ void GeneralSettingsDialog::updateForm() {
     metaSnapshotBox->setChecked(metaSnapshotsEnabled);
     saveOfflineEventLogBox->setChecked(saveOfflineEventLog);
     alwaysOnTopBox->setChecked(alwaysOnTop);
+
+    threadBudgetDetectionBox->setValue(threadBudgetDetection);
+    threadBudgetRecordingBox->setValue(threadBudgetRecording);
+    threadBudgetPlaybackBox->setValue(threadBudgetPlayback);
+    pinDetectionThreadBox->setChecked(pinDetectionThread);
+    threadBudgetLabel->setText(ThreadBudget::describe());
+
+    framePairingWindowBox->setValue(framePairingWindow);
+    framePairingTimeoutBox->setValue(framePairingTimeoutMs);
 }
 
 // Saved the settings selected in the dialog to the QT application settings
@@ -149,6 +177,12 @@ void GeneralSettingsDialog::saveSettings() {
     applicationSettings->setValue("metaSnapshotsEnabled", metaSnapshotsEnabled );
     applicationSettings->setValue("saveOfflineEventLog", saveOfflineEventLog );
     applicationSettings->setValue("alwaysOnTop", alwaysOnTop );
+    applicationSettings->setValue("threadBudget.detection", threadBudgetDetection);
+    applicationSettings->setValue("threadBudget.recording", threadBudgetRecording);
+    applicationSettings->setValue("threadBudget.playback", threadBudgetPlayback);
+    applicationSettings->setValue("threadBudget.pinDetectionThread", pinDetectionThread);
+    applicationSettings->setValue("StereoCamera.framePairingWindow", framePairingWindow);
+    applicationSettings->setValue("StereoCamera.framePairingTimeoutMs", framePairingTimeoutMs);
 }
 
 void GeneralSettingsDialog::createForm() {
@@ -171,6 +205,7 @@ void GeneralSettingsDialog::createForm() {
     dataWriterDataStyleBox = new QComboBox();
     dataWriterDataStyleBox->addItem(QString("PupilEXT v0.1.1"), QString("PupilEXT-0-1-1"));
     dataWriterDataStyleBox->addItem(QString("PupilEXT v0.1.2"), QString("PupilEXT-0-1-2"));
+    dataWriterDataStyleBox->addItem(QString("PupilEXT v0.1.3 (with blink flags)"), QString("PupilEXT-0-1-3"));
     dataWriterDataStyleBox->setCurrentText(dataWriterDataStyle);
     dataOutLayout->addRow(dataWriterDataStyleLabel, dataWriterDataStyleBox);
     QLabel *dataWriterDataStyleWarnLabel = new QLabel(tr("*Older version will not save trial numbering."));
@@ -304,6 +339,52 @@ void GeneralSettingsDialog::createForm() {
     appearanceGroup->setLayout(appearanceLayout);
     mainLayout->addWidget(appearanceGroup);
 
+    QGroupBox *threadBudgetGroup = new QGroupBox("Processing Threads");
+    QFormLayout *threadBudgetLayout = new QFormLayout();
+
+    const int numCores = ThreadBudget::getNumCores();
+    threadBudgetDetectionBox = new QSpinBox();
+    threadBudgetRecordingBox = new QSpinBox();
+    threadBudgetPlaybackBox = new QSpinBox();
+    for(QSpinBox *box : {threadBudgetDetectionBox, threadBudgetRecordingBox, threadBudgetPlaybackBox}) {
+        box->setRange(0, numCores);
+        box->setSpecialValueText(tr("Auto"));
+    }
+    threadBudgetLayout->addRow(new QLabel(tr("Pupil detection threads:")), threadBudgetDetectionBox);
+    threadBudgetLayout->addRow(new QLabel(tr("Image recording threads:")), threadBudgetRecordingBox);
+    threadBudgetLayout->addRow(new QLabel(tr("Image playback threads:")), threadBudgetPlaybackBox);
+
+    pinDetectionThreadBox = new QCheckBox("Pin pupil detection thread to a core (needs restart)");
+    threadBudgetLayout->addRow(pinDetectionThreadBox);
+
+    threadBudgetLabel = new QLabel();
+    threadBudgetLabel->setWordWrap(true);
+    threadBudgetLayout->addRow(threadBudgetLabel);
+
+    threadBudgetGroup->setLayout(threadBudgetLayout);
+    mainLayout->addWidget(threadBudgetGroup);
+
+    QGroupBox *framePairingGroup = new QGroupBox("Stereo Camera Frame Pairing");
+    QFormLayout *framePairingLayout = new QFormLayout();
+
+    framePairingWindowBox = new QSpinBox();
+    framePairingWindowBox->setRange(2, 1024);
+    framePairingWindowBox->setSuffix(tr(" frames"));
+    framePairingTimeoutBox = new QSpinBox();
+    framePairingTimeoutBox->setRange(0, 60000);
+    framePairingTimeoutBox->setSuffix(tr(" ms"));
+    framePairingTimeoutBox->setSpecialValueText(tr("Never"));
+    framePairingLayout->addRow(new QLabel(tr("Pairing window:")), framePairingWindowBox);
+    framePairingLayout->addRow(new QLabel(tr("Drop unpaired images after:")), framePairingTimeoutBox);
+
+    QLabel *framePairingWarnLabel = new QLabel(tr("Applies to the next opened stereo camera."));
+    SupportFunctions::setSmallerLabelFontSize(framePairingWarnLabel);
+    framePairingWarnLabel->setAlignment(Qt::AlignRight);
+    framePairingLayout->addRow(framePairingWarnLabel);
+
+    framePairingGroup->setLayout(framePairingLayout);
+    mainLayout->addWidget(framePairingGroup);
+
 
 
     QHBoxLayout *buttonsLayout = new QHBoxLayout();
@@ -347,6 +428,7 @@ void GeneralSettingsDialog::onSettingsChangedElsewhere() {
 void GeneralSettingsDialog::apply() {
 
     bool alwaysOnTopBeforeSave = SupportFunctions::readBoolFromQSettings("alwaysOnTop", false, applicationSettings);
+    bool pinDetectionThreadBeforeSave = SupportFunctions::readBoolFromQSettings("threadBudget.pinDetectionThread", false, applicationSettings);
     int darkAdaptModeBeforeSave = applicationSettings->value("GUIDarkAdaptMode", "2").toInt();
 
     saveSettings();
@@ -356,7 +438,7 @@ void GeneralSettingsDialog::apply() {
 
     // If there is any settings change that may need application restart to take effect,
     // tell MainWindow to offer the user a restart in a dialog
-    if((alwaysOnTopBeforeSave != alwaysOnTop) || (darkAdaptModeBeforeSave != darkAdaptMode)) {
+    if((alwaysOnTopBeforeSave != alwaysOnTop) || (darkAdaptModeBeforeSave != darkAdaptMode) || (pinDetectionThreadBeforeSave != pinDetectionThread)) {
         emit onSettingsChangeNeedingRestart();
     }
 
@@ -407,6 +489,27 @@ void GeneralSettingsDialog::setSaveOfflineEventLog(int m_state) {
 void GeneralSettingsDialog::setAlwaysOnTop(int m_state) {
     alwaysOnTop = (bool) m_state;
 }
+void GeneralSettingsDialog::setPinDetectionThread(int m_state) {
+    pinDetectionThread = (bool) m_state;
+}
+
+// Thread budgets take effect on apply, when the main window reconfigures the ThreadBudget
+void GeneralSettingsDialog::onThreadBudgetDetectionChange(int value) {
+    threadBudgetDetection = value;
+}
+void GeneralSettingsDialog::onThreadBudgetRecordingChange(int value) {
+    threadBudgetRecording = value;
+}
+void GeneralSettingsDialog::onThreadBudgetPlaybackChange(int value) {
+    threadBudgetPlayback = value;
+}
+
+void GeneralSettingsDialog::onFramePairingWindowChange(int value) {
+    framePairingWindow = value;
+}
+void GeneralSettingsDialog::onFramePairingTimeoutChange(int value) {
+    framePairingTimeoutMs = value;
+}
 
 //// Set the image writer format, all formats supported by OpenCV's imwrite can be specified
 //// Choices in the settings window are tiff, jpeg, and bmp
@@ -76,6 +76,21 @@ private:
     QCheckBox *saveOfflineEventLogBox;
     QCheckBox *alwaysOnTopBox;
 
+    int threadBudgetDetection;
+    int threadBudgetRecording;
+    int threadBudgetPlayback;
+    bool pinDetectionThread;
+    QSpinBox *threadBudgetDetectionBox;
+    QSpinBox *threadBudgetRecordingBox;
+    QSpinBox *threadBudgetPlaybackBox;
+    QCheckBox *pinDetectionThreadBox;
+    QLabel *threadBudgetLabel;
+
+    int framePairingWindow;
+    int framePairingTimeoutMs;
+    QSpinBox *framePairingWindowBox;
+    QSpinBox *framePairingTimeoutBox;
+
     void createForm();
     void saveSettings();
     void updateForm();
@@ -100,6 +115,12 @@ public slots:
     void setMetaSnapshotEnabled(int m_state);
     void setSaveOfflineEventLog(int m_state);
     void setAlwaysOnTop(int m_state);
+    void onThreadBudgetDetectionChange(int value);
+    void onThreadBudgetRecordingChange(int value);
+    void onThreadBudgetPlaybackChange(int value);
+    void setPinDetectionThread(int m_state);
+    void onFramePairingWindowChange(int value);
+    void onFramePairingTimeoutChange(int value);
 
     void onImageWriterFormatPngCompressionChange(int index);
     void onImageWriterFormatJpegQualityChange(int value);
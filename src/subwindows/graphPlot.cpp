@@ -83,6 +83,7 @@ GraphPlot::GraphPlot(DataTypes::DataType _plotDataKey, ProcMode procMode, bool l
             numGraphs=4;
             break;
     }
+    buffers = std::vector<PlotDataBuffer>(numGraphs, PlotDataBuffer(bufferCapacity));
 
 //    enableInteractions();
 //    enableYAxisInteraction();
@@ -137,6 +138,8 @@ GraphPlot::GraphPlot(DataTypes::DataType _plotDataKey, ProcMode procMode, bool l
     // Make left and bottom axes transfer their ranges to right and top axes:
     connect(customPlot->xAxis, SIGNAL(rangeChanged(QCPRange)), customPlot->xAxis2, SLOT(setRange(QCPRange)));
     connect(customPlot->yAxis, SIGNAL(rangeChanged(QCPRange)), customPlot->yAxis2, SLOT(setRange(QCPRange)));
+    // Dragging or zooming the key axis needs the data decimated anew for the new range
+    connect(customPlot->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(onKeyRangeChanged(QCPRange)));
 
     customPlot->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(customPlot, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(contextMenuRequest(QPoint)));
@@ -145,6 +148,10 @@ GraphPlot::GraphPlot(DataTypes::DataType _plotDataKey, ProcMode procMode, bool l
     //setRenderHint(QPainter::Antialiasing);
 
     customPlot->show();
+
+    replotTimer = new QTimer(this);
+    connect(replotTimer, SIGNAL(timeout()), this, SLOT(refreshPlot()));
+    replotTimer->start(1000 / replotFPS);
 }
 
 GraphPlot::~GraphPlot() {
@@ -162,6 +169,9 @@ void GraphPlot::reset() {
     lastTimestamp = 0;
 
     incrementedTimestamp = 0;
+    latestKey = 0.0;
+    for(PlotDataBuffer &buffer : buffers)
+        buffer.clear();
 //    customPlot->graph(0)->data()->clear();
     switch(currentProcMode) {
         case ProcMode::SINGLE_IMAGE_ONE_PUPIL:
@@ -381,28 +391,8 @@ void GraphPlot::appendData(const double &fps) {
 
     // Note: we currently only plot it for the main camera main view, as all their FPS's are equal
     if(plotDataKey == DataTypes::DataType::CAMERA_FPS || plotDataKey == DataTypes::DataType::PUPIL_FPS) {
-        customPlot->graph(0)->addData(m_timestamp/1000.0, fps);
-    }
-
-    if(currentInteractionMode != InteractionMode::MANUAL_SCALE_SCROLL_X_Y) {
-        if ((currentInteractionMode != InteractionMode::AUTO_SCROLL_X_MANUAL_SCALE_Y) &&
-            (currentInteractionMode != InteractionMode::AUTO_SCROLL_X_FIXED_SCALE_Y) &&
-            plotDataKey != DataTypes::DataType::PUPIL_CONFIDENCE &&
-            plotDataKey != DataTypes::DataType::PUPIL_OUTLINE_CONFIDENCE) {
-
-            // rescale value (vertical) axis to fit the current data:
-            customPlot->graph(0)->rescaleValueAxis(false, true);
-        }
-        // make key axis range scroll with the data (at a constant range size of 8):
-        customPlot->xAxis->setRange(m_timestamp / 1000.0, 15, Qt::AlignRight);
-    }
-
-    // if the first data is older than 4 minutes, remove 2 minutes of worth
-    if((m_timestamp/1000.0) - customPlot->graph()->dataMainKey (0) > 240) {
-        customPlot->graph(0)->data()->removeBefore((m_timestamp/1000.0)-120);
+        appendSample(0, m_timestamp/1000.0, fps);
     }
-
-    customPlot->replot();
 }
 
 // Slot that is called upon receiving framecount signals
@@ -420,28 +410,8 @@ void GraphPlot::appendData(const int &framecount) {
 
     // add data
     if(plotDataKey == DataTypes::DataType::FRAME_NUMBER) {
-        customPlot->graph(0)->addData(m_timestamp/1000.0, framecount);
+        appendSample(0, m_timestamp/1000.0, framecount);
     }
-
-    if(currentInteractionMode != InteractionMode::MANUAL_SCALE_SCROLL_X_Y) {
-        if ((currentInteractionMode != InteractionMode::AUTO_SCROLL_X_MANUAL_SCALE_Y) &&
-            (currentInteractionMode != InteractionMode::AUTO_SCROLL_X_FIXED_SCALE_Y) &&
-            plotDataKey != DataTypes::DataType::PUPIL_CONFIDENCE &&
-            plotDataKey != DataTypes::DataType::PUPIL_OUTLINE_CONFIDENCE) {
-
-            // rescale value (vertical) axis to fit the current data:
-            customPlot->graph(0)->rescaleValueAxis(false, true);
-        }
-        // make key axis range scroll with the data (at a constant range size of 8):
-        customPlot->xAxis->setRange(m_timestamp / 1000.0, 15, Qt::AlignRight);
-    }
-
-    // if the first data is older than 4 minutes, remove 2 minutes of worth
-    if((m_timestamp/1000.0) - customPlot->graph()->dataMainKey (0) > 240) {
-        customPlot->graph(0)->data()->removeBefore((m_timestamp/1000.0)-120);
-    }
-
-    customPlot->replot();
 }
 
 void GraphPlot::setPupilData(const Pupil &pupil, int graphID, quint64 timestamp) {
@@ -476,7 +446,13 @@ void GraphPlot::setPupilData(const Pupil &pupil, int graphID, quint64 timestamp)
     if(dataPointToAdd == -1.0)
         dataPointToAdd = std::numeric_limits<double>::quiet_NaN();
 
-    customPlot->graph(graphID)->addData(timestamp/1000.0, dataPointToAdd);
+    appendSample(graphID, timestamp/1000.0, dataPointToAdd);
+}
+
+void GraphPlot::appendSample(int graphID, double key, double value) {
+    buffers[graphID].append(key, value);
+    latestKey = key;
+    dataChanged = true;
 }
 
 // Slot that is called upon receiving a new stereo pupil detection
@@ -490,8 +466,6 @@ void GraphPlot::appendData(quint64 timestamp, int procMode, const std::vector<Pu
         return;
     }
 
-    qDebug() << timestamp << " " << Pupils[0].diameter();
-
     if(sharedTimestamp==0)
         sharedTimestamp = timestamp;
     uint64 m_timestamp = timestamp - sharedTimestamp;
@@ -520,64 +494,61 @@ void GraphPlot::appendData(quint64 timestamp, int procMode, const std::vector<Pu
             setPupilData(Pupils[STEREO_IMAGE_TWO_PUPIL_B_SEC], 3, m_timestamp);
             break;
     }
-//    // add data
-//    // GB: TODO: physical diameter is the same for two views, but is added as two different curves now..
-//    for(int i=0; i < numGraphs; i++) {
-//        ppppp
-//    }
-
-    if(currentInteractionMode != InteractionMode::MANUAL_SCALE_SCROLL_X_Y) {
-
-        if ((currentInteractionMode != InteractionMode::AUTO_SCROLL_X_MANUAL_SCALE_Y) &&
-            (currentInteractionMode != InteractionMode::AUTO_SCROLL_X_FIXED_SCALE_Y) &&
-            plotDataKey != DataTypes::DataType::PUPIL_CONFIDENCE &&
-            plotDataKey != DataTypes::DataType::PUPIL_OUTLINE_CONFIDENCE) {
-
-            // rescale value (vertical) axis to fit the current data:
-            //    customPlot->graph(0)->rescaleValueAxis(false, true);
-            //    customPlot->graph(1)->rescaleValueAxis(false, true);
-            std::set<double> possibleMinima;
-            std::set<double> possibleMaxima;
-            bool ok;
-            QCPRange possibleRange;
-            for (int i = 0; i < numGraphs; i++) {
-                ok = false;
-                possibleRange = customPlot->graph(i)->data()->valueRange(ok);
-                if (ok) {
-                    possibleMinima.insert(possibleRange.lower);
-                    possibleMaxima.insert(possibleRange.upper);
-                }
-            }
-            QCPRange commonRange(yAxisLimitLowT, yAxisLimitHighT);
-            if (!possibleMinima.empty())
-                commonRange.lower = *possibleMinima.begin();
-            if (!possibleMaxima.empty())
-                commonRange.upper = *possibleMaxima.rbegin();
+}
 
-            customPlot->yAxis->setRange(commonRange);
+// Called by the replot timer, pushes the visible part of the buffered data to the plot if anything changed since the last call
+// The samples are decimated to min/max pairs per pixel column of the plot, which looks the same as plotting all samples
+void GraphPlot::refreshPlot() {
 
-//                for(int i=0; i<numGraphs; i++) {
-//                    customPlot->graph(i)->rescaleValueAxis(false, true);
-//                }
-        }
+    if(!dataChanged)
+        return;
+    dataChanged = false;
+    refreshing = true;
 
+    if(currentInteractionMode != InteractionMode::MANUAL_SCALE_SCROLL_X_Y) {
         // make key axis range scroll with the data (at a constant range size of 15secs):
-        customPlot->xAxis->setRange(m_timestamp / 1000.0, 15, Qt::AlignRight);
+        customPlot->xAxis->setRange(latestKey, 15, Qt::AlignRight);
+    }
+
+    const QCPRange keyRange = customPlot->xAxis->range();
+    const int bins = customPlot->axisRect()->width();
+    for(int i=0; i<numGraphs; i++) {
+        buffers[i].decimate(keyRange.lower, keyRange.upper, bins, decimatedPoints);
+        customPlot->graph(i)->data()->set(decimatedPoints, true);
     }
 
+    if(currentInteractionMode != InteractionMode::MANUAL_SCALE_SCROLL_X_Y &&
+        currentInteractionMode != InteractionMode::AUTO_SCROLL_X_MANUAL_SCALE_Y &&
+        currentInteractionMode != InteractionMode::AUTO_SCROLL_X_FIXED_SCALE_Y &&
+        plotDataKey != DataTypes::DataType::PUPIL_CONFIDENCE &&
+        plotDataKey != DataTypes::DataType::PUPIL_OUTLINE_CONFIDENCE) {
 
-    // if the first data is older than 4 minutes, remove 2 minutes of worth
-    if((m_timestamp/1000.0) - customPlot->graph(0)->dataMainKey (0) > 240) {
-//            customPlot->graph(0)->data()->removeBefore((m_timestamp/1000.0)-120);
-//            customPlot->graph(1)->data()->removeBefore((m_timestamp/1000.0)-120);
-        for (int i = 0; i < numGraphs; i++) {
-            customPlot->graph(i)->data()->removeBefore((m_timestamp / 1000.0) - 120);
+        // rescale value (vertical) axis to fit the visible data of all graphs
+        bool found = false;
+        QCPRange commonRange(yAxisLimitLowT, yAxisLimitHighT);
+        for(int i=0; i<numGraphs; i++) {
+            QCPRange possibleRange;
+            if(!buffers[i].valueRange(keyRange.lower, keyRange.upper, possibleRange))
+                continue;
+            if(!found) {
+                commonRange = possibleRange;
+                found = true;
+            } else {
+                commonRange.expand(possibleRange);
+            }
         }
+        customPlot->yAxis->setRange(commonRange);
     }
 
+    refreshing = false;
     customPlot->replot();
 }
 
+void GraphPlot::onKeyRangeChanged(const QCPRange &range) {
+    if(!refreshing)
+        dataChanged = true;
+}
+
 void GraphPlot::updateYaxisRange() {
     customPlot->yAxis->setRange(yAxisLimitLow,yAxisLimitHigh);
 }
@@ -593,7 +564,7 @@ void GraphPlot::setKnownTimeZero(uint64_t timestamp) {
 
 void GraphPlot::clearClick() {
     reset(); // clear data
-    customPlot->replot(); // and redraw to make the plot actually empty on screen
+    dataChanged = true; // and redraw to make the plot actually empty on screen
 }
 
 
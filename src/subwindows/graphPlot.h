@@ -7,6 +7,7 @@
 #include <QtWidgets/QWidget>
 #include <QtCore/qobjectdefs.h>
 #include "qcustomplot/qcustomplot.h"
+#include "plotDataBuffer.h"
 #include "../pupil-detection-methods/Pupil.h"
 #include "../pupilDetection.h"
 #include "../dataTypes.h"
@@ -16,6 +17,9 @@
 
     GraphPlot(): create graph window and define window title
 
+    Incoming samples are only stored in a fixed-capacity PlotDataBuffer per graph. A timer refreshes the plot at most
+    replotFPS times per second, handing QCustomPlot the visible samples decimated to the pixel width of the plot.
+
 slots:
     appendData(): Slot for receiving respective data, depends on which data value is selected
 */
@@ -82,11 +86,23 @@ private:
     QCustomPlot *customPlot;
     QCPGraph *graph;
 
+    // Full-resolution samples per graph: about 65 s at 1000 fps, 36 min at 30 fps. Older samples are overwritten
+    static const int bufferCapacity = 65536;
+    static const int replotFPS = 30;
+
+    std::vector<PlotDataBuffer> buffers;
+    QVector<QCPGraphData> decimatedPoints;
+    QTimer *replotTimer;
+    bool dataChanged = false;
+    bool refreshing = false;
+    double latestKey = 0.0;
+
     uint64 incrementedTimestamp;
 
     bool resetScheduled = false;
 
     void setPupilData(const Pupil &pupil, int graphID, quint64 timestamp);
+    void appendSample(int graphID, double key, double value);
 
 //    bool interaction;
 //    bool yinteraction;
@@ -95,6 +111,8 @@ private:
     void saveYaxisSettings();
 
 private slots:
+    void refreshPlot();
+    void onKeyRangeChanged(const QCPRange &range);
     void setInteractionMode(InteractionMode m);
     void updateYaxisRange();
     void clearClick();
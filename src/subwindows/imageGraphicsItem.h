@@ -5,24 +5,31 @@
 */
 
 #include <QGraphicsItem>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
 
 /**
     Custom QGraphicsItem that handles the rendering of camera images on a QGraphicsView
 
     This should be faster than rendering it as a QLabel, we paint the QImage directly to the QGraphicsView canvas
 
-    // TODO could be speed up using opengl painting methods?
+    The item is meant to persist in the scene for the whole live-view: buffer() hands out its own image for writing
+    the next frame in place, so no image or item is allocated per frame as long as frame size and format stay the same.
+    Only the exposed part of the image is painted, e.g. when zoomed in or when only an overlay changed.
+
+    buffer(): returns the image to write into, (re)allocated only if size or format differ; call update() after writing
+    setImage(): replaces the displayed image
 */
 class ImageGraphicsItem : public QGraphicsItem {
 
 public:
 
     explicit ImageGraphicsItem() : image() {
-
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
     }
 
     explicit ImageGraphicsItem(const QImage &img) : image(img) {
-
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
     }
 
     ~ImageGraphicsItem() = default;
@@ -32,7 +39,24 @@ public:
     }
 
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override {
-        painter->drawImage(image.rect(), image);
+        const QRectF exposed = option->exposedRect.intersected(image.rect());
+        painter->drawImage(exposed, image, exposed);
+    }
+
+    QImage &buffer(const QSize &size, QImage::Format format) {
+        if(image.size() != size || image.format() != format) {
+            if(image.size() != size)
+                prepareGeometryChange();
+            image = QImage(size, format);
+        }
+        return image;
+    }
+
+    void setImage(const QImage &img) {
+        if(img.size() != image.size())
+            prepareGeometryChange();
+        image = img;
+        update();
     }
 
 private:
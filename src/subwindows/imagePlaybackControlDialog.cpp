@@ -148,6 +148,11 @@ void ImagePlaybackControlDialog::createForm() {
     connect(dial, SIGNAL(decremented()), this, SLOT(onDialBackward()));
     connect(slider, SIGNAL(valueChanged(int)), this, SLOT(onSliderValueChanged(int)));
 
+    stillImageTimer = new QTimer(this);
+    stillImageTimer->setSingleShot(true);
+    stillImageTimer->setInterval(stillImageDelay);
+    connect(stillImageTimer, SIGNAL(timeout()), this, SLOT(onSliderRested()));
+
     connect(dial, SIGNAL(incremented()), this, SIGNAL(cameraPlaybackPositionChanged()));
     connect(dial, SIGNAL(decremented()), this, SIGNAL(cameraPlaybackPositionChanged()));
     connect(slider, SIGNAL(valueChanged(int)), this, SIGNAL(cameraPlaybackPositionChanged()));
@@ -392,13 +397,24 @@ void ImagePlaybackControlDialog::onSliderValueChanged(int val) {
     int frameNumber = floor((float)(val)/(float)slider->maximum()*(float)(numImagesTotal-1));
     //qDebug() << "Seek to frame number (INDEX, starting from 0): " << frameNumber;
     fileCamera->seekToFrame(frameNumber);
-    selectedFrameBox->setValue(frameNumber + 1);
+    // Not through onFrameSelected(), which would load the full resolution image at every slider position
+    selectedFrameVal = frameNumber + 1;
+    selectedFrameBox->blockSignals(true);
+    selectedFrameBox->setValue(selectedFrameVal);
+    selectedFrameBox->blockSignals(false);
     if(!playImagesOn) {
         updateInfoInternal(frameNumber);
-        emit stillImageChange(frameNumber);
+        emit stillImagePreview(frameNumber);
+        stillImageFrame = frameNumber;
+        stillImageTimer->start();
     }
 }
 
+void ImagePlaybackControlDialog::onSliderRested() {
+    if(!playImagesOn)
+        emit stillImageChange(stillImageFrame);
+}
+
 
 void ImagePlaybackControlDialog::readSettings() {
 
@@ -12,6 +12,7 @@
 #include <QtWidgets/QComboBox>
 #include <QtWidgets/QPushButton>
 #include <QtCore/QSettings>
+#include <QtCore/QTimer>
 
 #include "playbackDial.h"
 #include "playbackSlider.h"
@@ -30,6 +31,8 @@
     interesting frames more closely. On the slider a green tick shows the position of file read, 
     (that last went into pupilDetection) and the slider handle marks the actually displayed image position
     (that just arrived from pupilDetection).
+    While the slider is dragged, downscaled previews are shown (stillImagePreview), the full resolution image is only
+    loaded (stillImageChange) once the slider rested for stillImageDelay ms.
 
     This dialog is designed to be only visible and interactable while an image directory is opened.
 */
@@ -96,6 +99,9 @@ private:
 
     
     PlaybackSlider *slider;
+    QTimer *stillImageTimer;
+    int stillImageFrame = 0;
+    static const int stillImageDelay = 150; // ms
     PlaybackDial *dial;
 
     QPushButton *startPauseButton;
@@ -147,6 +153,7 @@ private slots:
     void onDialForward();
     void onDialBackward();
     void onSliderValueChanged(int val);
+    void onSliderRested();
     void updateSliderColorTick(const CameraImage &cimg);
 
     
@@ -159,6 +166,7 @@ private slots:
 
 signals:
     void stillImageChange(int frameNumber);
+    void stillImagePreview(int frameNumber);
 
     void onPlaybackStartInitiated();
     void onPlaybackPauseInitiated();
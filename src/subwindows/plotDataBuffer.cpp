@@ -0,0 +1,166 @@
+
+#include "plotDataBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+PlotDataBuffer::PlotDataBuffer(int capacity) :
+    keys(std::max(capacity, 2)),
+    values(std::max(capacity, 2)),
+    head(0),
+    count(0) {
+}
+
+void PlotDataBuffer::append(double key, double value) {
+    const int cap = capacity();
+    if(count < cap) {
+        const int idx = physicalIndex(count);
+        keys[idx] = key;
+        values[idx] = value;
+        count++;
+    } else {
+        keys[head] = key;
+        values[head] = value;
+        head = (head + 1) % cap;
+    }
+}
+
+void PlotDataBuffer::clear() {
+    head = 0;
+    count = 0;
+}
+
+int PlotDataBuffer::size() const {
+    return count;
+}
+
+int PlotDataBuffer::capacity() const {
+    return static_cast<int>(keys.size());
+}
+
+double PlotDataBuffer::firstKey() const {
+    return keys[head];
+}
+
+double PlotDataBuffer::lastKey() const {
+    return keys[physicalIndex(count - 1)];
+}
+
+int PlotDataBuffer::physicalIndex(int i) const {
+    const int idx = head + i;
+    return idx < capacity() ? idx : idx - capacity();
+}
+
+// Logical index of the first sample with a key not less than key, binary search as keys are sorted
+int PlotDataBuffer::lowerBound(double key) const {
+    int lo = 0, hi = count;
+    while(lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if(keys[physicalIndex(mid)] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+bool PlotDataBuffer::valueRange(double keyLower, double keyUpper, QCPRange &range) const {
+    const int begin = lowerBound(keyLower);
+    bool found = false;
+    double lower = std::numeric_limits<double>::max();
+    double upper = std::numeric_limits<double>::lowest();
+    for(int i=begin; i<count; i++) {
+        const int idx = physicalIndex(i);
+        if(keys[idx] > keyUpper)
+            break;
+        const double v = values[idx];
+        if(std::isnan(v))
+            continue;
+        lower = std::min(lower, v);
+        upper = std::max(upper, v);
+        found = true;
+    }
+    if(found) {
+        range.lower = lower;
+        range.upper = upper;
+    }
+    return found;
+}
+
+// One sample left and right of the range is included, so the curve continues to the axis borders
+void PlotDataBuffer::decimate(double keyLower, double keyUpper, int bins, QVector<QCPGraphData> &points) const {
+
+    points.clear();
+    if(count == 0 || keyUpper < keyLower)
+        return;
+
+    const int begin = std::max(lowerBound(keyLower) - 1, 0);
+    int end = lowerBound(keyUpper);
+    while(end < count && keys[physicalIndex(end)] <= keyUpper)
+        end++;
+    end = std::min(end + 1, count);
+
+    bins = std::max(bins, 1);
+    if(end - begin <= 2 * bins) {
+        points.reserve(end - begin);
+        for(int i=begin; i<end; i++) {
+            const int idx = physicalIndex(i);
+            points.append(QCPGraphData(keys[idx], values[idx]));
+        }
+        return;
+    }
+
+    points.reserve(3 * bins + 2);
+    const double binWidth = (keyUpper - keyLower) / bins;
+
+    int i = begin;
+    // The sample left of the range is passed through as is
+    if(keys[physicalIndex(i)] < keyLower) {
+        points.append(QCPGraphData(keys[physicalIndex(i)], values[physicalIndex(i)]));
+        i++;
+    }
+
+    while(i < end) {
+        const int idx = physicalIndex(i);
+        if(keys[idx] > keyUpper) {
+            points.append(QCPGraphData(keys[idx], values[idx]));
+            i++;
+            continue;
+        }
+
+        const int bin = std::min(static_cast<int>((keys[idx] - keyLower) / binWidth), bins - 1);
+        const double binEnd = (bin == bins - 1) ? keyUpper : keyLower + (bin + 1) * binWidth;
+
+        int minIdx = -1, maxIdx = -1, nanIdx = -1;
+        // The first sample always belongs to the bin, which guards against rounding in the bin computation
+        for(const int first = i; i < end; i++) {
+            const int j = physicalIndex(i);
+            if(i > first && keys[j] >= binEnd && !(bin == bins - 1 && keys[j] <= keyUpper))
+                break;
+            const double v = values[j];
+            if(std::isnan(v)) {
+                if(nanIdx < 0)
+                    nanIdx = j;
+                continue;
+            }
+            if(minIdx < 0 || v < values[minIdx])
+                minIdx = j;
+            if(maxIdx < 0 || v > values[maxIdx])
+                maxIdx = j;
+        }
+
+        // Emit the extremes (and a gap marker) of the bin in key order
+        QCPGraphData binPoints[3];
+        int n = 0;
+        if(minIdx >= 0)
+            binPoints[n++] = QCPGraphData(keys[minIdx], values[minIdx]);
+        if(maxIdx >= 0 && maxIdx != minIdx)
+            binPoints[n++] = QCPGraphData(keys[maxIdx], values[maxIdx]);
+        if(nanIdx >= 0)
+            binPoints[n++] = QCPGraphData(keys[nanIdx], values[nanIdx]);
+        std::sort(binPoints, binPoints + n, [](const QCPGraphData &a, const QCPGraphData &b) { return a.key < b.key; });
+        for(int k=0; k<n; k++)
+            points.append(binPoints[k]);
+    }
+}
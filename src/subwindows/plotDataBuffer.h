@@ -0,0 +1,55 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QVector>
+#include "qcustomplot/qcustomplot.h"
+
+#include <vector>
+
+/**
+    Fixed-capacity ring buffer holding the full-resolution samples of one live plot graph
+
+    Keys (time) are expected to increase monotonically, the buffer is cleared by the graph plot when they do not.
+    Once full, the oldest samples are overwritten, so memory stays constant however long the session runs.
+    For display, decimate() reduces the samples in a key range to at most one min/max pair per output bin (i.e. per
+    on-screen pixel column), which keeps the drawn curve visually identical while QCustomPlot only gets a few thousand points.
+    If the range holds fewer samples than that (e.g. when zoomed in), the samples are returned at full resolution.
+    Samples without a value (NaN) are kept, so gaps in the data (e.g. no pupil found) stay visible.
+
+    append(): adds a sample, overwriting the oldest one if the buffer is full
+    clear(): removes all samples
+    size(), capacity(), firstKey(), lastKey(): buffer state, keys are only valid if size() > 0
+    valueRange(): range of the non-NaN values with key in [keyLower, keyUpper], returns false if there are none
+    decimate(): writes the (decimated) samples with key in [keyLower, keyUpper] into points, sorted by key
+*/
+class PlotDataBuffer {
+
+public:
+
+    explicit PlotDataBuffer(int capacity=65536);
+
+    void append(double key, double value);
+    void clear();
+
+    int size() const;
+    int capacity() const;
+    double firstKey() const;
+    double lastKey() const;
+
+    bool valueRange(double keyLower, double keyUpper, QCPRange &range) const;
+    void decimate(double keyLower, double keyUpper, int bins, QVector<QCPGraphData> &points) const;
+
+private:
+
+    std::vector<double> keys;
+    std::vector<double> values;
+    int head; // index of the oldest sample
+    int count;
+
+    int physicalIndex(int i) const;
+    int lowerBound(double key) const;
+
+};
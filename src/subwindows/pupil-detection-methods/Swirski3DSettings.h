@@ -0,0 +1,365 @@
+#pragma once
+
+/**
+    @authors Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include "PupilMethodSetting.h"
+#include "../../pupil-detection-methods/Swirski3D.h"
+#include <QtWidgets/QWidget>
+#include <QtWidgets/QtWidgets>
+#include <QtWidgets/QLabel>
+#include "../../SVGIconColorAdjuster.h"
+
+#include "json.h"
+#include <fstream>
+// for convenience
+using json = nlohmann::json;
+
+/**
+    Pupil Detection Algorithm setting for the Swirski3D algorithm, displayed in the pupil detection setting dialog
+
+    Only the radius range of the wrapped Swirski2D detection is exposed here, its other parameters keep their defaults.
+    Applying the settings discards the eye model, which is then fitted again to new observations.
+*/
+class Swirski3DSettings : public PupilMethodSetting {
+    Q_OBJECT
+
+public:
+
+    explicit Swirski3DSettings(PupilDetection * pupilDetection, Swirski3D *m_swirski, QWidget *parent=0) :
+        PupilMethodSetting("Swirski3DSettings.configParameters","Swirski3DSettings.configIndex", parent),
+        p_swirski(m_swirski),
+        pupilDetection(pupilDetection){
+
+        PupilMethodSetting::setDefaultParameters(defaultParameters);
+        createForm();
+        configsBox->setCurrentText(settingsMap.key(configIndex));
+
+        if(isAutoParamEnabled()) {
+            minRadiusBox->setEnabled(false);
+            maxRadiusBox->setEnabled(false);
+        } else {
+            minRadiusBox->setEnabled(true);
+            maxRadiusBox->setEnabled(true);
+        }
+
+        QVBoxLayout *infoLayout = new QVBoxLayout(infoBox);
+        QHBoxLayout *infoLayoutRow1 = new QHBoxLayout();
+        QPushButton *iLabelFakeButton = new QPushButton();
+        iLabelFakeButton->setFlat(true);
+        iLabelFakeButton->setAttribute(Qt::WA_NoSystemBackground, true);
+        iLabelFakeButton->setAttribute(Qt::WA_TranslucentBackground, true);
+        iLabelFakeButton->setStyleSheet("QPushButton { background-color: transparent; border: 0px }");
+        iLabelFakeButton->setIcon(SVGIconColorAdjuster::loadAndAdjustColors(QString(":/icons/Breeze/status/22/dialog-information.svg"), applicationSettings));
+        iLabelFakeButton->setFixedSize(QSize(32,32));
+        iLabelFakeButton->setIconSize(QSize(32,32));
+        infoLayoutRow1->addWidget(iLabelFakeButton);
+
+        QLabel *pLabel = new QLabel();
+        pLabel->setWordWrap(true);
+        pLabel->setTextInteractionFlags(Qt::LinksAccessibleByMouse);
+        pLabel->setOpenExternalLinks(true);
+        SupportFunctions::setSmallerLabelFontSize(pLabel);
+        pLabel->setText("Lech Swirski, Neil A. Dodgson, \"A fully-automatic, temporal approach to single camera, glint-free 3D eye model fitting\", 2013 <a href=\"http://www.cl.cam.ac.uk/research/rainbow/projects/eyemodelfit\">Website</a><br/>License: <a href=\"https://opensource.org/licenses/MIT\">MIT</a>");
+        infoLayoutRow1->addWidget(pLabel);
+
+        infoLayout->addLayout(infoLayoutRow1);
+
+        QLabel *confLabel;
+        if(p_swirski->hasConfidence())
+            confLabel = new QLabel("Info: This method does provide its own confidence.");
+        else
+            confLabel = new QLabel("Info: This method does not provide its own confidence, use the outline confidence.");
+        SupportFunctions::setSmallerLabelFontSize(confLabel);
+        confLabel->setWordWrap(true);
+        infoLayout->addWidget(confLabel);
+
+        QLabel *modelLabel = new QLabel("Info: The eye model is fitted in the background to spatially spread observations and kept up to date with newer ones, the physical pupil diameter is available once it is built. Keep the camera and the head still.");
+        SupportFunctions::setSmallerLabelFontSize(modelLabel);
+        modelLabel->setWordWrap(true);
+        infoLayout->addWidget(modelLabel);
+#if _DEBUG
+        QLabel *warnLabel = new QLabel("CAUTION: Debug build may perform very slow. Use release build or adjust processing speed to not risk memory overflow.");
+        SupportFunctions::setSmallerLabelFontSize(warnLabel);
+        warnLabel->setWordWrap(true);
+        warnLabel->setStyleSheet(QStringLiteral("QLabel{color: red;}"));
+        infoLayout->addWidget(warnLabel);
+#endif
+
+        infoBox->setLayout(infoLayout);
+    }
+
+    ~Swirski3DSettings() override = default;
+
+    void add2(Swirski3D *s_swirski) {
+        swirski2 = s_swirski;
+    }
+    void add3(Swirski3D *s_swirski) {
+        swirski3 = s_swirski;
+    }
+    void add4(Swirski3D *s_swirski) {
+        swirski4 = s_swirski;
+    }
+public slots:
+
+    void loadSettings() override {
+        PupilMethodSetting::loadSettings();
+
+        if(isAutoParamEnabled()) {
+            float autoParamPupSizePercent = applicationSettings->value("autoParamPupSizePercent", pupilDetection->getAutoParamPupSizePercent()).toFloat();
+            pupilDetection->setAutoParamEnabled(true);
+            pupilDetection->setAutoParamPupSizePercent(autoParamPupSizePercent);
+            pupilDetection->setAutoParamScheduled(true);
+
+            minRadiusBox->setEnabled(false);
+            maxRadiusBox->setEnabled(false);
+        } else {
+            pupilDetection->setAutoParamEnabled(false);
+            minRadiusBox->setEnabled(true);
+            maxRadiusBox->setEnabled(true);
+        }
+
+        applySpecificSettings();
+    }
+
+    void applySpecificSettings() override {
+
+        // First come the parameters roughly independent from ROI size and relative pupil size
+        QList<float>& currentParameters = getCurrentParameters();
+        currentParameters[2] = focalLengthBox->value();
+        currentParameters[3] = observationCountBox->value();
+        currentParameters[4] = refineBox->isChecked();
+        currentParameters[5] = reliabilityBox->value();
+
+        for(Swirski3D *swirski : {p_swirski, swirski2, swirski3, swirski4}) {
+            if(!swirski)
+                continue;
+            swirski->params.FocalLength = focalLengthBox->value();
+            swirski->params.ObservationCount = observationCountBox->value();
+            swirski->params.RefineWithRegionContrast = refineBox->isChecked();
+            swirski->params.ReliabilityThreshold = reliabilityBox->value();
+        }
+
+        // Then the specific ones that are set by autoParam
+        if(isAutoParamEnabled()) {
+            float autoParamPupSizePercent = applicationSettings->value("autoParamPupSizePercent", pupilDetection->getAutoParamPupSizePercent()).toFloat();
+            pupilDetection->setAutoParamPupSizePercent(autoParamPupSizePercent);
+            pupilDetection->setAutoParamScheduled(true);
+
+        } else {
+
+            currentParameters[0] = minRadiusBox->value();
+            currentParameters[1] = maxRadiusBox->value();
+
+            for(Swirski3D *swirski : {p_swirski, swirski2, swirski3, swirski4}) {
+                if(!swirski)
+                    continue;
+                if(Swirski2D *detector = dynamic_cast<Swirski2D*>(swirski->pupilDetector)) {
+                    detector->params.Radius_Min = minRadiusBox->value();
+                    detector->params.Radius_Max = maxRadiusBox->value();
+                }
+            }
+        }
+
+        // The model was fitted with the previous parameters
+        for(Swirski3D *swirski : {p_swirski, swirski2, swirski3, swirski4}) {
+            if(swirski)
+                swirski->resetModel();
+        }
+
+        emit onConfigChange(configsBox->currentText());
+    }
+
+    void applyAndSaveSpecificSettings() override {
+        applySpecificSettings();
+        PupilMethodSetting::saveSpecificSettings();
+    }
+
+private:
+
+    Swirski3D *p_swirski;
+    Swirski3D *swirski2 = nullptr;
+    Swirski3D *swirski3 = nullptr;
+    Swirski3D *swirski4 = nullptr;
+
+    PupilDetection *pupilDetection;
+
+    QSpinBox *minRadiusBox;
+    QSpinBox *maxRadiusBox;
+
+    QDoubleSpinBox *focalLengthBox;
+    QSpinBox *observationCountBox;
+    QCheckBox *refineBox;
+    QDoubleSpinBox *reliabilityBox;
+
+    void createForm() {
+        PupilMethodSetting::loadSettings();
+        QList<float>& selectedParameter = getCurrentParameters();
+
+        int Radius_Min = selectedParameter[0];
+        int Radius_Max = selectedParameter[1];
+
+        double FocalLength = selectedParameter[2];
+        int ObservationCount = selectedParameter[3];
+        bool RefineWithRegionContrast = selectedParameter[4];
+        double ReliabilityThreshold = selectedParameter[5];
+
+        QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+        QHBoxLayout *configsLayout = new QHBoxLayout();
+
+        configsBox = new QComboBox();
+        QLabel *parameterConfigsLabel = new QLabel(tr("Parameter configuration:"));
+        configsBox->setFixedWidth(250);
+        configsLayout->addWidget(parameterConfigsLabel);
+        configsLayout->addWidget(configsBox);
+
+        for (QMap<QString, Settings>::const_iterator cit = settingsMap.cbegin(); cit != settingsMap.cend(); cit++)
+        {
+            configsBox->addItem(cit.key());
+        }
+
+        connect(configsBox, SIGNAL(currentTextChanged(QString)), this, SLOT(onParameterConfigSelection(QString)));
+
+        mainLayout->addLayout(configsLayout);
+
+        mainLayout->addSpacerItem(new QSpacerItem(40, 5, QSizePolicy::Fixed));
+
+
+        QGroupBox *ellipseGroup = new QGroupBox("Algorithm specific: Ellipse Detection (Swirski2D)");
+        QGroupBox *modelGroup = new QGroupBox("Algorithm specific: Eye Model");
+
+        QFormLayout *ellipseLayout = new QFormLayout();
+        QFormLayout *modelLayout = new QFormLayout();
+
+        QLabel *minRadiusLabel = new QLabel(tr("Min. Radius [px]:"));
+        minRadiusBox = new QSpinBox();
+        minRadiusBox->setMaximum(5000);
+        minRadiusBox->setValue(Radius_Min);
+        minRadiusBox->setFixedWidth(80);
+
+        QLabel *maxRadiusLabel = new QLabel(tr("Max. Radius [px]:"));
+        maxRadiusBox = new QSpinBox();
+        maxRadiusBox->setMaximum(5000);
+        maxRadiusBox->setValue(Radius_Max);
+        maxRadiusBox->setFixedWidth(80);
+
+        QHBoxLayout *layoutRow1 = new QHBoxLayout;
+        layoutRow1->addWidget(minRadiusBox);
+        QSpacerItem *sp1 = new QSpacerItem(20, 20, QSizePolicy::Expanding, QSizePolicy::Minimum);
+        layoutRow1->addSpacerItem(sp1);
+        layoutRow1->addWidget(maxRadiusLabel);
+        layoutRow1->addWidget(maxRadiusBox);
+        ellipseLayout->addRow(minRadiusLabel, layoutRow1);
+
+        ellipseGroup->setLayout(ellipseLayout);
+        mainLayout->addWidget(ellipseGroup);
+
+
+        QLabel *focalLengthLabel = new QLabel(tr("Focal Length [px]:"));
+        focalLengthBox = new QDoubleSpinBox();
+        focalLengthBox->setMaximum(100000);
+        focalLengthBox->setValue(FocalLength);
+        focalLengthBox->setFixedWidth(80);
+        focalLengthBox->setToolTip(tr("Focal length of the camera in pixels, 0 uses the image width."));
+        modelLayout->addRow(focalLengthLabel, focalLengthBox);
+
+        QLabel *observationCountLabel = new QLabel(tr("Observations:"));
+        observationCountBox = new QSpinBox();
+        observationCountBox->setMinimum(2);
+        observationCountBox->setMaximum(1000);
+        observationCountBox->setValue(ObservationCount);
+        observationCountBox->setFixedWidth(80);
+        observationCountBox->setToolTip(tr("Number of spatially spread pupil observations the eye model is fitted to. Older ones are replaced by newer ones during the session."));
+        modelLayout->addRow(observationCountLabel, observationCountBox);
+
+        QLabel *refineLabel = new QLabel(tr("Refine with Region Contrast:"));
+        refineBox = new QCheckBox();
+        refineBox->setChecked(RefineWithRegionContrast);
+        modelLayout->addRow(refineLabel, refineBox);
+
+        QLabel *reliabilityLabel = new QLabel(tr("Min. Reliability:"));
+        reliabilityBox = new QDoubleSpinBox();
+        reliabilityBox->setMaximum(1.0);
+        reliabilityBox->setSingleStep(0.05);
+        reliabilityBox->setValue(ReliabilityThreshold);
+        reliabilityBox->setFixedWidth(80);
+        reliabilityBox->setToolTip(tr("Minimal agreement of the detected ellipse with the projected model pupil to report a physical diameter."));
+        modelLayout->addRow(reliabilityLabel, reliabilityBox);
+
+        modelGroup->setLayout(modelLayout);
+        mainLayout->addWidget(modelGroup);
+
+
+        QHBoxLayout *buttonsLayout = new QHBoxLayout();
+
+        resetButton = new QPushButton("Reset algorithm parameters");
+        fileButton = new QPushButton("Load config file");
+
+        buttonsLayout->addWidget(resetButton);
+        connect(resetButton, SIGNAL(clicked()), this, SLOT(onResetClick()));
+        buttonsLayout->addSpacerItem(new QSpacerItem(40, 20, QSizePolicy::Expanding));
+
+        buttonsLayout->addWidget(fileButton);
+        connect(fileButton, SIGNAL(clicked()), this, SLOT(onLoadFileClick()));
+
+        mainLayout->addLayout(buttonsLayout);
+
+        setLayout(mainLayout);
+    }
+
+    void loadSettingsFromFile(QString filename) {
+
+        std::ifstream file(filename.toStdString());
+        json j;
+        file>> j;
+
+        QList<float> customs = defaultParameters[Settings::DEFAULT];
+
+        customs[0] = j["Parameter Set"]["Radius_Min"];
+        customs[1] = j["Parameter Set"]["Radius_Max"];
+        customs[2] = j["Parameter Set"]["FocalLength"];
+        customs[3] = j["Parameter Set"]["ObservationCount"];
+        customs[4] = j["Parameter Set"]["RefineWithRegionContrast"];
+        customs[5] = j["Parameter Set"]["ReliabilityThreshold"];
+
+        insertCustomEntry(customs);
+    }
+
+    QMap<Settings, QList<float>> defaultParameters = {
+            { Settings::DEFAULT, {40.0f, 80.0f, 0.0f, 30.0f, 1.0f, 0.8f} },
+            { Settings::ROI_0_3_OPTIMIZED, {10.0f, 112.0f, 0.0f, 30.0f, 1.0f, 0.8f} },
+            { Settings::ROI_0_6_OPTIMIZED, {21.0f, 108.0f, 0.0f, 30.0f, 1.0f, 0.8f} },
+            { Settings::FULL_IMAGE_OPTIMIZED, {19.0f, 115.0f, 0.0f, 30.0f, 1.0f, 0.8f} },
+            { Settings::AUTOMATIC_PARAMETRIZATION, {-1.0f, -1.0f, 0.0f, 30.0f, 1.0f, 0.8f} },
+            { Settings::CUSTOM, {-1.0f, -1.0f, 0.0f, 30.0f, 1.0f, 0.8f} }
+    };
+
+
+private slots:
+
+    void onParameterConfigSelection(QString configKey) {
+        setConfigIndex(configKey);
+        QList<float>& selectedParameter = getCurrentParameters();
+
+        // First come the parameters roughly independent from ROI size and relative pupil size
+        focalLengthBox->setValue(selectedParameter[2]);
+        observationCountBox->setValue(selectedParameter[3]);
+        refineBox->setChecked(selectedParameter[4]);
+        reliabilityBox->setValue(selectedParameter[5]);
+
+        // Then the specific ones that are set by autoParam
+        if(isAutoParamEnabled()) {
+            minRadiusBox->setEnabled(false);
+            maxRadiusBox->setEnabled(false);
+        } else {
+            minRadiusBox->setEnabled(true);
+            maxRadiusBox->setEnabled(true);
+
+            minRadiusBox->setValue(selectedParameter[0]);
+            maxRadiusBox->setValue(selectedParameter[1]);
+        }
+    }
+
+};
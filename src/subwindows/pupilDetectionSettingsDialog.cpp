@@ -11,6 +11,7 @@
 #include "pupil-detection-methods/ExCuSeSettings.h"
 #include "pupil-detection-methods/StarburstSettings.h"
 #include "pupil-detection-methods/Swirski2DSettings.h"
+#include "pupil-detection-methods/Swirski3DSettings.h"
 #include "pupil-detection-methods/PuReSTSettings.h"
 #include "../SVGIconColorAdjuster.h"
 
@@ -148,6 +149,32 @@ void PupilDetectionSettingsDialog::createForm() {
     outlineConfidenceBox->setChecked(pupilDetection->isOutlineConfidenceEnabled());
     optionsLayout->addRow(outlineConfidenceLabel, outlineConfidenceBox);
 
+    QLabel *blinkRejectionLabel = new QLabel(tr("Skip Blinks / Frames Without Pupil:"));
+    blinkRejectionLabel->setToolTip(tr("Frames without a dark pupil-like blob are not passed to the detection algorithm, they are reported as invalid pupil with the blink flag set."));
+    blinkRejectionBox = new QCheckBox();
+    blinkRejectionBox->setChecked(pupilDetection->isBlinkRejectionEnabled());
+    optionsLayout->addRow(blinkRejectionLabel, blinkRejectionBox);
+
+    QLabel *blinkDarkContrastLabel = new QLabel(tr("Blink Rejection Min. Dark Contrast:"));
+    blinkDarkContrastLabel->setToolTip(tr("Grey levels between the median and the darkest half percent of the image, below which the frame is skipped as blink."));
+    blinkDarkContrastBox = new QSpinBox();
+    blinkDarkContrastBox->setRange(0, 255);
+    blinkDarkContrastBox->setValue(pupilDetection->getBlinkDarkContrast());
+    optionsLayout->addRow(blinkDarkContrastLabel, blinkDarkContrastBox);
+
+    QLabel *blinkBlobContrastLabel = new QLabel(tr("Blink Rejection Min. Pupil Contrast:"));
+    blinkBlobContrastLabel->setToolTip(tr("Grey levels the darkest pupil sized blob must be darker than its surround, otherwise the frame is skipped as blink."));
+    blinkBlobContrastBox = new QSpinBox();
+    blinkBlobContrastBox->setRange(0, 255);
+    blinkBlobContrastBox->setValue(pupilDetection->getBlinkBlobContrast());
+    optionsLayout->addRow(blinkBlobContrastLabel, blinkBlobContrastBox);
+
+    QLabel *resultCacheLabel = new QLabel(tr("Cache Detection Results of Image Playback:"));
+    resultCacheLabel->setToolTip(tr("Frames of a recording already processed with the same settings are not detected again, e.g. when replaying it or comparing parameters."));
+    resultCacheBox = new QCheckBox();
+    resultCacheBox->setChecked(pupilDetection->isResultCacheEnabled());
+    optionsLayout->addRow(resultCacheLabel, resultCacheBox);
+
 
     QLabel *pupilSizeUndistortionLabel = new QLabel(tr("Undistort individual pupil size (fast) [<a href=\"http://mock.link\">?</a>]:"));
     connect(pupilSizeUndistortionLabel, SIGNAL(linkActivated(QString)), this, SLOT(onShowHelpDialog()));
@@ -171,6 +198,12 @@ void PupilDetectionSettingsDialog::createForm() {
     optionsLayout->addRow(imageUndistortionLabel, imageUndistortionBox);
     connect(imageUndistortionBox, SIGNAL(stateChanged(int)), this, SLOT(onImageUndistortionClick(int)));
 
+    QLabel *epipolarSearchLabel = new QLabel(tr("Search Secondary View Along Epipolar Line (calibrated stereo only):"));
+    epipolarSearchLabel->setToolTip(tr("The secondary view is only searched near the epipolar line of the pupil found in the main view. Falls back to searching its whole ROI if no pupil is found there."));
+    epipolarSearchBox = new QCheckBox();
+    epipolarSearchBox->setChecked(pupilDetection->isEpipolarSearchEnabled());
+    optionsLayout->addRow(epipolarSearchLabel, epipolarSearchBox);
+
     optionsGroup->setLayout(optionsLayout);
     mainLayoutInnerCol1->addWidget(optionsGroup);
 
@@ -181,35 +214,18 @@ void PupilDetectionSettingsDialog::createForm() {
         PupilMethodSetting *settings;
         if(pm->title() == "PuRe") {
             settings = new PuReSettings(pupilDetection, dynamic_cast<PuRe*>(pm));
-            // If the current pupil detection is stereo, two algorithm instances exist, which should be confiured the same way
-            dynamic_cast<PuReSettings*>(settings)->add2(dynamic_cast<PuRe*>(pupilDetection->getMethod2("PuRe")));
-            dynamic_cast<PuReSettings*>(settings)->add3(dynamic_cast<PuRe*>(pupilDetection->getMethod3("PuRe")));
-            dynamic_cast<PuReSettings*>(settings)->add4(dynamic_cast<PuRe*>(pupilDetection->getMethod4("PuRe")));
         } else if(pm->title() == "PuReST") {
             settings = new PuReSTSettings(pupilDetection, dynamic_cast<PuReST*>(pm));
-            dynamic_cast<PuReSTSettings*>(settings)->add2(dynamic_cast<PuReST*>(pupilDetection->getMethod2("PuReST")));
-            dynamic_cast<PuReSTSettings*>(settings)->add3(dynamic_cast<PuReST*>(pupilDetection->getMethod3("PuReST")));
-            dynamic_cast<PuReSTSettings*>(settings)->add4(dynamic_cast<PuReST*>(pupilDetection->getMethod4("PuReST")));
         } else if(pm->title() == "ElSe") {
             settings = new ElSeSettings(pupilDetection, dynamic_cast<ElSe*>(pm));
-            dynamic_cast<ElSeSettings*>(settings)->add2(dynamic_cast<ElSe*>(pupilDetection->getMethod2("ElSe")));
-            dynamic_cast<ElSeSettings*>(settings)->add3(dynamic_cast<ElSe*>(pupilDetection->getMethod3("ElSe")));
-            dynamic_cast<ElSeSettings*>(settings)->add4(dynamic_cast<ElSe*>(pupilDetection->getMethod4("ElSe")));
         } else if(pm->title() == "ExCuSe") {
             settings = new ExCuSeSettings(pupilDetection, dynamic_cast<ExCuSe*>(pm));
-            dynamic_cast<ExCuSeSettings*>(settings)->add2(dynamic_cast<ExCuSe*>(pupilDetection->getMethod2("ExCuSe")));
-            dynamic_cast<ExCuSeSettings*>(settings)->add3(dynamic_cast<ExCuSe*>(pupilDetection->getMethod3("ExCuSe")));
-            dynamic_cast<ExCuSeSettings*>(settings)->add4(dynamic_cast<ExCuSe*>(pupilDetection->getMethod4("ExCuSe")));
         } else if(pm->title() == "Starburst") {
             settings = new StarburstSettings(pupilDetection, dynamic_cast<Starburst*>(pm));
-            dynamic_cast<StarburstSettings*>(settings)->add2(dynamic_cast<Starburst*>(pupilDetection->getMethod2("Starburst")));
-            dynamic_cast<StarburstSettings*>(settings)->add3(dynamic_cast<Starburst*>(pupilDetection->getMethod3("Starburst")));
-            dynamic_cast<StarburstSettings*>(settings)->add4(dynamic_cast<Starburst*>(pupilDetection->getMethod4("Starburst")));
         } else if(pm->title() == "Swirski2D") {
             settings = new Swirski2DSettings(pupilDetection, dynamic_cast<Swirski2D*>(pm));
-            dynamic_cast<Swirski2DSettings*>(settings)->add2(dynamic_cast<Swirski2D*>(pupilDetection->getMethod2("Swirski2D")));
-            dynamic_cast<Swirski2DSettings*>(settings)->add3(dynamic_cast<Swirski2D*>(pupilDetection->getMethod3("Swirski2D")));
-            dynamic_cast<Swirski2DSettings*>(settings)->add4(dynamic_cast<Swirski2D*>(pupilDetection->getMethod4("Swirski2D")));
+        } else if(pm->title() == "Swirski3D") {
+            settings = new Swirski3DSettings(pupilDetection, dynamic_cast<Swirski3D*>(pm));
         } else {
             // TODO: why is this here anyway?
             settings = new PupilMethodSetting();
@@ -233,6 +249,12 @@ void PupilDetectionSettingsDialog::createForm() {
         
     }
 
+    // If the current pupil detection uses multiple views, more algorithm instances exist, which should be configured the same way
+    // These are created and released by the pupil detection on demand, so the binding is renewed whenever they change
+    bindMethodInstances();
+    connect(pupilDetection, SIGNAL(methodInstancesChanged()), this, SLOT(bindMethodInstances()));
+    connect(pupilDetection, SIGNAL(methodInstancesReleasing()), this, SLOT(unbindMethodInstances()), Qt::DirectConnection);
+
     QHBoxLayout *buttonsLayout = new QHBoxLayout();
 
     applyButton = new QPushButton(tr("Apply"));
@@ -260,6 +282,11 @@ void PupilDetectionSettingsDialog::updateForm() {
     algorithmBox->setCurrentText(QString::fromStdString(pupilDetection->getCurrentMethod1()->title()));
     roiPreprocessingBox->setChecked(pupilDetection->isROIPreProcessingEnabled());
     outlineConfidenceBox->setChecked(pupilDetection->isOutlineConfidenceEnabled());
+    blinkRejectionBox->setChecked(pupilDetection->isBlinkRejectionEnabled());
+    blinkDarkContrastBox->setValue(pupilDetection->getBlinkDarkContrast());
+    blinkBlobContrastBox->setValue(pupilDetection->getBlinkBlobContrast());
+    epipolarSearchBox->setChecked(pupilDetection->isEpipolarSearchEnabled());
+    resultCacheBox->setChecked(pupilDetection->isResultCacheEnabled());
 
     pupilUndistortionBox->setChecked(pupilDetection->isPupilUndistortionEnabled());
     imageUndistortionBox->setChecked(pupilDetection->isImageUndistortionEnabled());
@@ -304,7 +331,13 @@ void PupilDetectionSettingsDialog::loadSettings() {
 //    pupilDetection->enableOutlineConfidence(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.outlineConfidence", outlineConfidenceBox->isChecked(), applicationSettings));
 //    pupilDetection->enableROIPreProcessing(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.processROI", roiPreprocessingBox->isChecked(), applicationSettings));
     pupilDetection->enableOutlineConfidence(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.outlineConfidence", true, applicationSettings));
+    pupilDetection->enableBlinkRejection(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.rejectBlinks", false, applicationSettings));
+    pupilDetection->setBlinkRejectionContrasts(
+            applicationSettings->value("PupilDetectionSettingsDialog.blinkDarkContrast", pupilDetection->getBlinkDarkContrast()).toInt(),
+            applicationSettings->value("PupilDetectionSettingsDialog.blinkBlobContrast", pupilDetection->getBlinkBlobContrast()).toInt());
+    pupilDetection->enableEpipolarSearch(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.epipolarSearch", false, applicationSettings));
     pupilDetection->enableROIPreProcessing(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.processROI", true, applicationSettings));
+    pupilDetection->enableResultCache(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.cacheResults", false, applicationSettings));
     pupilDetection->enablePupilUndistortion(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.undistortPupilSize", pupilUndistortionBox->isChecked(), applicationSettings));
     pupilDetection->enableImageUndistortion(SupportFunctions::readBoolFromQSettings("PupilDetectionSettingsDialog.undistortImage", imageUndistortionBox->isChecked(), applicationSettings));
 
@@ -327,7 +360,12 @@ void PupilDetectionSettingsDialog::saveUniversalSettings() {
 
     applicationSettings->setValue("PupilDetectionSettingsDialog.algorithm", algorithmBox->currentText());
     applicationSettings->setValue("PupilDetectionSettingsDialog.outlineConfidence", outlineConfidenceBox->isChecked());
+    applicationSettings->setValue("PupilDetectionSettingsDialog.rejectBlinks", blinkRejectionBox->isChecked());
+    applicationSettings->setValue("PupilDetectionSettingsDialog.blinkDarkContrast", blinkDarkContrastBox->value());
+    applicationSettings->setValue("PupilDetectionSettingsDialog.blinkBlobContrast", blinkBlobContrastBox->value());
+    applicationSettings->setValue("PupilDetectionSettingsDialog.epipolarSearch", epipolarSearchBox->isChecked());
     applicationSettings->setValue("PupilDetectionSettingsDialog.processROI", roiPreprocessingBox->isChecked());
+    applicationSettings->setValue("PupilDetectionSettingsDialog.cacheResults", resultCacheBox->isChecked());
     applicationSettings->setValue("PupilDetectionSettingsDialog.undistortPupilSize", pupilUndistortionBox->isChecked());
     applicationSettings->setValue("PupilDetectionSettingsDialog.undistortImage", imageUndistortionBox->isChecked());
 }
@@ -357,6 +395,59 @@ void PupilDetectionSettingsDialog::onProcModeSelection(int idx) {
     // } //else {}
 }
 
+// Passes the algorithm instances of the pupil detection slots 2-4 to the settings widgets, nullptr for instances that do not exist currently
+void PupilDetectionSettingsDialog::bindMethodInstances() {
+    setMethodInstances(false);
+}
+
+// Called directly by the thread releasing the instances, before they are deleted
+void PupilDetectionSettingsDialog::unbindMethodInstances() {
+    setMethodInstances(true);
+}
+
+// The widgets are in the same order as the slot 1 instances they were created for
+// While releasing, only the instances of the current algorithm are kept, as the release deletes all others
+void PupilDetectionSettingsDialog::setMethodInstances(bool releasing) {
+    std::vector<PupilDetectionMethod*> methods = pupilDetection->getMethods();
+    for(size_t i=0; i<methods.size() && i<pupilMethodSettings.size(); i++) {
+        const std::string title = methods[i]->title();
+        PupilMethodSetting *settings = pupilMethodSettings[i];
+        const bool bound = !releasing || methods[i] == pupilDetection->getCurrentMethod1();
+        PupilDetectionMethod *method2 = bound ? pupilDetection->getMethod2(title) : nullptr;
+        PupilDetectionMethod *method3 = bound ? pupilDetection->getMethod3(title) : nullptr;
+        PupilDetectionMethod *method4 = bound ? pupilDetection->getMethod4(title) : nullptr;
+        if(title == "PuRe") {
+            dynamic_cast<PuReSettings*>(settings)->add2(dynamic_cast<PuRe*>(method2));
+            dynamic_cast<PuReSettings*>(settings)->add3(dynamic_cast<PuRe*>(method3));
+            dynamic_cast<PuReSettings*>(settings)->add4(dynamic_cast<PuRe*>(method4));
+        } else if(title == "PuReST") {
+            dynamic_cast<PuReSTSettings*>(settings)->add2(dynamic_cast<PuReST*>(method2));
+            dynamic_cast<PuReSTSettings*>(settings)->add3(dynamic_cast<PuReST*>(method3));
+            dynamic_cast<PuReSTSettings*>(settings)->add4(dynamic_cast<PuReST*>(method4));
+        } else if(title == "ElSe") {
+            dynamic_cast<ElSeSettings*>(settings)->add2(dynamic_cast<ElSe*>(method2));
+            dynamic_cast<ElSeSettings*>(settings)->add3(dynamic_cast<ElSe*>(method3));
+            dynamic_cast<ElSeSettings*>(settings)->add4(dynamic_cast<ElSe*>(method4));
+        } else if(title == "ExCuSe") {
+            dynamic_cast<ExCuSeSettings*>(settings)->add2(dynamic_cast<ExCuSe*>(method2));
+            dynamic_cast<ExCuSeSettings*>(settings)->add3(dynamic_cast<ExCuSe*>(method3));
+            dynamic_cast<ExCuSeSettings*>(settings)->add4(dynamic_cast<ExCuSe*>(method4));
+        } else if(title == "Starburst") {
+            dynamic_cast<StarburstSettings*>(settings)->add2(dynamic_cast<Starburst*>(method2));
+            dynamic_cast<StarburstSettings*>(settings)->add3(dynamic_cast<Starburst*>(method3));
+            dynamic_cast<StarburstSettings*>(settings)->add4(dynamic_cast<Starburst*>(method4));
+        } else if(title == "Swirski2D") {
+            dynamic_cast<Swirski2DSettings*>(settings)->add2(dynamic_cast<Swirski2D*>(method2));
+            dynamic_cast<Swirski2DSettings*>(settings)->add3(dynamic_cast<Swirski2D*>(method3));
+            dynamic_cast<Swirski2DSettings*>(settings)->add4(dynamic_cast<Swirski2D*>(method4));
+        } else if(title == "Swirski3D") {
+            dynamic_cast<Swirski3DSettings*>(settings)->add2(dynamic_cast<Swirski3D*>(method2));
+            dynamic_cast<Swirski3DSettings*>(settings)->add3(dynamic_cast<Swirski3D*>(method3));
+            dynamic_cast<Swirski3DSettings*>(settings)->add4(dynamic_cast<Swirski3D*>(method4));
+        }
+    }
+}
+
 // Show and hide the algorithm specific settings depending on the current algorithm selection
 void PupilDetectionSettingsDialog::onAlgorithmSelection(int idx) {
 
@@ -389,7 +480,11 @@ void PupilDetectionSettingsDialog::applyButtonClick() {
 
     pupilDetection->setAlgorithm(algorithmBox->currentText());
     pupilDetection->enableOutlineConfidence(outlineConfidenceBox->isChecked());
+    pupilDetection->enableBlinkRejection(blinkRejectionBox->isChecked());
+    pupilDetection->setBlinkRejectionContrasts(blinkDarkContrastBox->value(), blinkBlobContrastBox->value());
+    pupilDetection->enableEpipolarSearch(epipolarSearchBox->isChecked());
     pupilDetection->enableROIPreProcessing(roiPreprocessingBox->isChecked());
+    pupilDetection->enableResultCache(resultCacheBox->isChecked());
     pupilDetection->enablePupilUndistortion(pupilUndistortionBox->isChecked());
     pupilDetection->enableImageUndistortion(imageUndistortionBox->isChecked());
 
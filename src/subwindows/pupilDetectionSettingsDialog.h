@@ -8,6 +8,7 @@
 #include <QtWidgets/QComboBox>
 #include <QtCore/qdir.h>
 #include <QtWidgets/QPushButton>
+#include <QtWidgets/QSpinBox>
 #include "../pupilDetection.h"
 #include "pupil-detection-methods/PupilMethodSetting.h"
 
@@ -49,7 +50,12 @@ private:
     
     QComboBox *algorithmBox;
     QCheckBox *outlineConfidenceBox;
+    QCheckBox *blinkRejectionBox;
+    QSpinBox *blinkDarkContrastBox;
+    QSpinBox *blinkBlobContrastBox;
+    QCheckBox *epipolarSearchBox;
     QCheckBox *roiPreprocessingBox;
+    QCheckBox *resultCacheBox;
     QCheckBox *pupilUndistortionBox;
     QCheckBox *imageUndistortionBox;
 
@@ -71,6 +77,7 @@ private:
     void updateForm();
     void loadSettings();
     void saveUniversalSettings();
+    void setMethodInstances(bool releasing);
 
 private slots:
 
@@ -84,6 +91,8 @@ private slots:
     void onImageUndistortionClick(int state);
 
     void onProcModeSelection(int idx);
+    void bindMethodInstances();
+    void unbindMethodInstances();
     void updateProcModeEnabled();
     void updateProcModeCompatibility();
 
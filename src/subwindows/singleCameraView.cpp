@@ -866,6 +866,16 @@ void SingleCameraView::displayFileCameraFrame(int frameNumber) {
     videoView->updateView(temp1);
 }
 
+// Keeps the current image if there is no preview yet, the full image follows when scrubbing stops
+void SingleCameraView::displayFileCameraPreview(int frameNumber) {
+    if(camera->getType() != CameraImageType::SINGLE_IMAGE_FILE)
+        return;
+
+    cv::Mat temp1 = dynamic_cast<FileCamera*>(camera)->getPreviewImageSingle(frameNumber);
+    if(!temp1.empty())
+        videoView->updateView(temp1);
+}
+
 void SingleCameraView::onDiscardROISelectionClick(){
     videoView->setROI1SelectionR(tempROIRect1);
     if(videoView->getDoubleROI())
@@ -139,6 +139,7 @@ public slots:
     void saveROI2Selection(QRectF roiR);
 
     void displayFileCameraFrame(int frameNumber);
+    void displayFileCameraPreview(int frameNumber);
 
     void updateForPupilDetectionProcMode();
     void updateView(const CameraImage &cimg, const int &procMode, const std::vector<cv::Rect> &ROIs, const std::vector<Pupil> &Pupils);
@@ -1008,6 +1008,18 @@ void StereoCameraView::displayFileCameraFrame(int frameNumber) {
     secondaryVideoView->updateView(temp2[1]);
 }
 
+// Keeps the current images if there is no preview yet, the full images follow when scrubbing stops
+void StereoCameraView::displayFileCameraPreview(int frameNumber) {
+    if(camera->getType() != CameraImageType::STEREO_IMAGE_FILE)
+        return;
+
+    std::vector<cv::Mat> temp2 = dynamic_cast<FileCamera*>(camera)->getPreviewImageStereo(frameNumber);
+    if(temp2[0].empty() || temp2[1].empty())
+        return;
+    mainVideoView->updateView(temp2[0]);
+    secondaryVideoView->updateView(temp2[1]);
+}
+
 void StereoCameraView::onDiscardROISelectionClick(){
     mainVideoView->setROI1SelectionR(tempROIs[0]);
     secondaryVideoView->setROI1SelectionR(tempROIs[1]);
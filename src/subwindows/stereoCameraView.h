@@ -151,6 +151,7 @@ public slots:
     void saveSecondaryROI2Selection(QRectF roi);
 
     void displayFileCameraFrame(int frameNumber);
+    void displayFileCameraPreview(int frameNumber);
 
     void updateForPupilDetectionProcMode();
     //void updateView(const CameraImage &cimg, const int &procMode, const std::vector<cv::Rect> &ROIs, const std::vector<Pupil> &Pupils);
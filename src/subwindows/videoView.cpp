@@ -211,10 +211,7 @@ void VideoView::updateViewProcessed(const cv::Mat &img, const std::vector<cv::Re
         tPupils.push_back(Pupils[z]);
     }
 
-    drawOverlay();
-    //drawProcessedOverlay();
-    
-    updateViewInternal(img);
+    scheduleFrame(img);
 }
 
 void VideoView::setImageROI(const QRect& ROI) {
@@ -530,9 +527,26 @@ void VideoView::updateView(const cv::Mat &img) {
 
     tROIs.clear();
     tPupils.clear();
-    drawOverlay();
-    //drawUnprocessedOverlay();
 
+    scheduleFrame(img);
+}
+
+// Keeps only the latest frame, and queues its repaint behind the events already waiting in the GUI thread
+// Frames arriving before the queued repaint runs replace the pending one, thus are dropped when the GUI is busy
+void VideoView::scheduleFrame(const cv::Mat &img) {
+    pendingFrame = img;
+    if(framePending)
+        return;
+    framePending = true;
+    QMetaObject::invokeMethod(this, "presentPendingFrame", Qt::QueuedConnection);
+}
+
+void VideoView::presentPendingFrame() {
+    framePending = false;
+    cv::Mat img = pendingFrame;
+    pendingFrame.release();
+
+    drawOverlay();
     updateViewInternal(img);
 }
 
@@ -546,20 +560,22 @@ void VideoView::updateViewInternal(const cv::Mat &img) {
     if(img.empty())
         return;
 
-    // For some reason, qt crashes when trying to paint a grayscale image over qpainter
-    cv::Mat bgrFrame = img; 
-    if (img.channels() == 1)
-        cv::cvtColor(img, bgrFrame, cv::COLOR_GRAY2BGR);
-    QImage qImg = SupportFunctions::cvMatToQImage(bgrFrame);
-
-    if(currentImage->boundingRect() != qImg.rect()) {
+    if(currentImage->boundingRect() != QRectF(0, 0, img.cols, img.rows)) {
         initialFit = false;
     }
 
-    graphicsScene->removeItem(currentImage);
-    delete currentImage;
-    currentImage = new ImageGraphicsItem(qImg);
-    graphicsScene->addItem(currentImage);
+    // The frame is copied into the image owned by the persistent item, as a QImage only wrapping the cv::Mat data
+    // would dangle once the camera reuses the buffer (this was the reason grayscale frames crashed the painter before)
+    if(img.type() == CV_8UC1) {
+        QImage &buffer = currentImage->buffer(QSize(img.cols, img.rows), QImage::Format_Grayscale8);
+        img.copyTo(cv::Mat(img.rows, img.cols, CV_8UC1, buffer.bits(), buffer.bytesPerLine()));
+    } else if(img.type() == CV_8UC3) {
+        QImage &buffer = currentImage->buffer(QSize(img.cols, img.rows), QImage::Format_RGB888);
+        cv::cvtColor(img, cv::Mat(img.rows, img.cols, CV_8UC3, buffer.bits(), buffer.bytesPerLine()), cv::COLOR_BGR2RGB);
+    } else {
+        currentImage->setImage(SupportFunctions::cvMatToQImage(img).copy());
+    }
+    currentImage->update();
 
     if(!initialFit) {
 
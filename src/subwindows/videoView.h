@@ -31,6 +31,10 @@ enum ColorFill {NO_FILL = 0, CONFIDENCE = 1, OUTLINE_CONFIDENCE = 2};
 
     Also renders and handles the ROI selection by the user, rendered over the camera image, returns ROI results through a signal
 
+    Frames are not painted when they arrive: only the latest frame is kept and a single repaint is queued behind the pending GUI events,
+    so when the GUI thread falls behind, intermediate frames are dropped instead of piling up in the event queue.
+    Mono frames are copied as 8-bit grayscale into the persistent image item, overlays (ROI, pupil outline and center) stay vector items.
+
 signals:
     void onROISelection(QRectF roi): Signalling a ROI selection by the user, transporting the ROI rect
 
@@ -90,6 +94,10 @@ private:
     QRectF roi1SelectionRectLastR; // the last saved position. necessary in cases when there is no pupil detection going on, and we are setting a custom ROI, which is not yet committed, but moved on the scene. when image play is on, this variable is needed
     QRectF roi2SelectionRectLastR; 
     void updateViewInternal(const cv::Mat &img);
+    void scheduleFrame(const cv::Mat &img);
+
+    cv::Mat pendingFrame;
+    bool framePending = false;
 
     std::vector<QGraphicsItem*> geBufferPG;
     QRect imageROI = QRect(0,0,0,0);
@@ -131,6 +139,10 @@ private:
     bool showPositioningGuide;
     bool pupilDetectionUsingROI;
 
+private slots:
+
+    void presentPendingFrame();
+
 protected:
 
     void resizeEvent(QResizeEvent *event) override;
@@ -0,0 +1,149 @@
+
+#include "threadBudget.h"
+#include "supportFunctions.h"
+
+#include <QtCore/QThread>
+#include <opencv2/core/utility.hpp>
+#include <tbb/tbb.h>
+#if TBB_INTERFACE_VERSION >= 11000
+#include <tbb/global_control.h>
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+int ThreadBudget::budgets[ThreadBudget::numRoles] = {0, 0, 0, 1};
+int ThreadBudget::requestedDetection = 0;
+bool ThreadBudget::active[ThreadBudget::numRoles] = {true, false, false, true};
+bool ThreadBudget::pinDetectionThread = false;
+
+namespace {
+    const char *roleNames[] = {"Pupil detection", "Image recording", "Image playback", "GUI"};
+    const char *roleSettings[] = {"threadBudget.detection", "threadBudget.recording", "threadBudget.playback"};
+}
+
+// The pools are created on first use and live until the application exits, waiting for their remaining tasks then
+QThreadPool *ThreadBudget::pool(Role role) {
+    static QThreadPool pools[numRoles - 1];
+    if(role == GUI)
+        return QThreadPool::globalInstance();
+    return &pools[role];
+}
+
+int ThreadBudget::getNumCores() {
+    return std::max(1, QThread::idealThreadCount());
+}
+
+int ThreadBudget::getBudget(Role role) {
+    return budgets[role];
+}
+
+bool ThreadBudget::isDetectionThreadPinned() {
+    return pinDetectionThread;
+}
+
+// The last core, as the first one is often busy with interrupt handling of the OS
+int ThreadBudget::getDetectionCore() {
+    return getNumCores() - 1;
+}
+
+// Default allocation: one core for the GUI, a quarter of the cores (at most 4) for recording, two cores for the playback of
+// stereo recordings on machines with at least 8 cores, the rest for the pupil detection
+void ThreadBudget::configure(QSettings *applicationSettings) {
+
+    const int cores = getNumCores();
+    int requested[numRoles - 1] = {0, 0, 0};
+    if(applicationSettings) {
+        for(int i=0; i<numRoles-1; i++)
+            requested[i] = std::max(0, applicationSettings->value(roleSettings[i], 0).toInt());
+        pinDetectionThread = SupportFunctions::readBoolFromQSettings("threadBudget.pinDetectionThread", false, applicationSettings);
+    }
+
+    budgets[GUI] = 1;
+    budgets[RECORDING] = requested[RECORDING] > 0 ? requested[RECORDING] : std::min(4, std::max(1, cores / 4));
+    budgets[PLAYBACK] = requested[PLAYBACK] > 0 ? requested[PLAYBACK] : (cores >= 8 ? 2 : 1);
+    requestedDetection = requested[DETECTION];
+
+    // The pools keep the full budget of their role, so that the tasks still queued when a role goes idle do not stall
+    for(Role role : {RECORDING, PLAYBACK})
+        pool(role)->setMaxThreadCount(budgets[role]);
+
+    distribute();
+
+    std::cout << describe().toStdString() << std::endl;
+}
+
+void ThreadBudget::setActive(Role role, bool isActive) {
+    if(role != RECORDING && role != PLAYBACK)
+        return;
+    if(active[role] == isActive)
+        return;
+    active[role] = isActive;
+    distribute();
+}
+
+// Idle roles do not reserve cores, so the detection gets them unless its budget is set explicitly
+void ThreadBudget::distribute() {
+    if(requestedDetection > 0) {
+        budgets[DETECTION] = requestedDetection;
+    } else {
+        int reserved = budgets[GUI];
+        for(Role role : {RECORDING, PLAYBACK})
+            if(active[role])
+                reserved += budgets[role];
+        budgets[DETECTION] = std::max(detectionFanOut, getNumCores() - reserved);
+    }
+
+    pool(DETECTION)->setMaxThreadCount(budgets[DETECTION]);
+    applyAlgorithmLimits(budgets[DETECTION]);
+}
+
+void ThreadBudget::applyAlgorithmLimits(int threads) {
+    cv::setNumThreads(threads);
+
+#if TBB_INTERFACE_VERSION >= 11000
+    // The limit holds as long as the global_control object exists, a new one replaces the previous limit
+    static std::unique_ptr<tbb::global_control> tbbLimit;
+    tbbLimit.reset();
+    tbbLimit.reset(new tbb::global_control(tbb::global_control::max_allowed_parallelism, static_cast<size_t>(threads)));
+#endif
+}
+
+bool ThreadBudget::pinCurrentThread(int core) {
+    if(core < 0 || core >= getNumCores())
+        return false;
+#ifdef _WIN32
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) == 0;
+#else
+    // Thread affinity is not supported by macOS
+    return false;
+#endif
+}
+
+QString ThreadBudget::describe() {
+    QString text = QString("Thread budget on %1 cores: ").arg(getNumCores());
+    int total = 0;
+    for(int i=0; i<numRoles; i++) {
+        text += QString("%1 %2%3%4").arg(roleNames[i]).arg(budgets[i]).arg(active[i] ? "" : " (idle)").arg(i < numRoles-1 ? ", " : "");
+        if(active[i])
+            total += budgets[i];
+    }
+    if(total > getNumCores())
+        text += " (oversubscribed)";
+    if(pinDetectionThread)
+        text += QString(", detection thread pinned to core %1").arg(getDetectionCore());
+    return text;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QSettings>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+
+/**
+    Process wide allocation of the CPU cores to the roles competing for them, to avoid oversubscription and the resulting latency spikes
+
+    Each role gets a budget of threads: the pupil detection fans out the detection of multiple pupils/views over its own thread pool, the
+    image writer encodes and writes images over its own pool, and the image playback reads stereo images over its own pool. One core is left
+    for the GUI. The parallelism inside the algorithms, i.e. OpenCV's parallel_for_ (resize, filter2D, remap, ...) and TBB (Swirski2D), is
+    limited to the detection budget, as it runs within the detection. The pupil detection thread itself can optionally be pinned to one core.
+
+    Budgets of 0 in the settings (the default) are derived from the number of cores. The derived detection budget only subtracts the roles
+    which are active, i.e. recording while the image writer runs and playback while stereo images are played back, and is at least the
+    fan-out width of the pupil detection (4 views in the stereo two pupil mode). configure() can be called again to apply changed settings,
+    only the pinning of the detection thread needs a restart.
+
+    configure(): reads the budgets from the application settings and applies them to the pools, OpenCV and TBB
+    setActive(): marks the recording or playback role as working or idle, redistributing the cores
+    pool(): thread pool of a role (not for the GUI role)
+    getBudget(): number of threads of a role
+    getNumCores(): number of cores (logical processors)
+    isDetectionThreadPinned(): whether the detection thread should be pinned to a core
+    pinCurrentThread(): pins the calling thread to the given core, returns false if not supported or failed
+    describe(): human readable summary of the active allocation
+*/
+class ThreadBudget {
+
+public:
+
+    enum Role {
+        DETECTION = 0,
+        RECORDING = 1,
+        PLAYBACK = 2,
+        GUI = 3
+    };
+
+    static void configure(QSettings *applicationSettings);
+    static void setActive(Role role, bool active);
+
+    static QThreadPool *pool(Role role);
+    static int getBudget(Role role);
+    static int getNumCores();
+    static bool isDetectionThreadPinned();
+    static int getDetectionCore();
+
+    static bool pinCurrentThread(int core);
+
+    static QString describe();
+
+private:
+
+    static const int numRoles = 4;
+
+    static const int detectionFanOut = 4;
+
+    static int budgets[numRoles];
+    static int requestedDetection;
+    static bool active[numRoles];
+    static bool pinDetectionThread;
+
+    static void distribute();
+    static void applyAlgorithmLimits(int threads);
+};
@@ -0,0 +1,216 @@
+
+#include "udpReceiverThread.h"
+
+#include <QtNetwork/QUdpSocket>
+#include <QtNetwork/QHostAddress>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#else
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <poll.h>
+#include <time.h>
+#endif
+
+static qint64 systemTimeUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+UDPReceiverThread::UDPReceiverThread(qintptr socketDescriptor, QObject *parent) :
+    QThread(parent),
+    descriptor(socketDescriptor),
+    kernelTimestamps(false),
+    stopRequested(false),
+    notificationPending(false),
+    dropped(0),
+    queue(queueCapacity),
+    receiveBuffer(65536) {
+
+#if defined(SO_TIMESTAMPNS)
+    int enable = 1;
+    kernelTimestamps = setsockopt(static_cast<int>(descriptor), SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0;
+#endif
+}
+
+UDPReceiverThread::~UDPReceiverThread() {
+    stop();
+    wait();
+}
+
+bool UDPReceiverThread::usesKernelTimestamps() const {
+    return kernelTimestamps;
+}
+
+void UDPReceiverThread::stop() {
+    stopRequested = true;
+}
+
+quint64 UDPReceiverThread::droppedDatagrams() const {
+    return dropped;
+}
+
+// The notification flag is reset before draining: a datagram pushed after that point either is drained here,
+// or its producer sees the reset flag and emits a new notification
+void UDPReceiverThread::takeDatagrams(std::vector<ReceivedDatagram> &datagrams) {
+    notificationPending.exchange(false, std::memory_order_acq_rel);
+    ReceivedDatagram datagram;
+    while(queue.pop(datagram))
+        datagrams.push_back(std::move(datagram));
+}
+
+void UDPReceiverThread::run() {
+    while(!stopRequested) {
+        if(!waitForDatagram())
+            continue;
+
+        ReceivedDatagram datagram;
+        if(!receiveDatagram(datagram))
+            continue;
+
+        if(!queue.push(std::move(datagram))) {
+            dropped++;
+            continue;
+        }
+        if(!notificationPending.exchange(true, std::memory_order_acq_rel))
+            emit datagramsAvailable();
+    }
+}
+
+bool UDPReceiverThread::waitForDatagram() {
+#ifdef Q_OS_WIN
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(static_cast<SOCKET>(descriptor), &readSet);
+    timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = pollTimeoutMs * 1000;
+    return select(0, &readSet, nullptr, nullptr, &timeout) > 0;
+#else
+    pollfd p;
+    p.fd = static_cast<int>(descriptor);
+    p.events = POLLIN;
+    p.revents = 0;
+    if(poll(&p, 1, pollTimeoutMs) <= 0)
+        return false;
+    if(p.revents & POLLNVAL) {
+        std::cerr << "UDPReceiverThread: socket was closed while listening" << std::endl;
+        stopRequested = true;
+        return false;
+    }
+    return (p.revents & POLLIN) != 0;
+#endif
+}
+
+bool UDPReceiverThread::receiveDatagram(ReceivedDatagram &datagram) {
+#ifdef Q_OS_WIN
+    const int size = recv(static_cast<SOCKET>(descriptor), receiveBuffer.data(), static_cast<int>(receiveBuffer.size()), 0);
+    datagram.timestampUs = systemTimeUs();
+    if(size < 0)
+        return false;
+#else
+    iovec iov;
+    iov.iov_base = receiveBuffer.data();
+    iov.iov_len = receiveBuffer.size();
+
+    char control[256];
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    const ssize_t size = recvmsg(static_cast<int>(descriptor), &msg, MSG_DONTWAIT);
+    datagram.timestampUs = systemTimeUs();
+    if(size < 0)
+        return false;
+
+#if defined(SO_TIMESTAMPNS)
+    for(cmsghdr *c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c)) {
+        if(c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+            const timespec *ts = reinterpret_cast<const timespec*>(CMSG_DATA(c));
+            datagram.timestampUs = static_cast<qint64>(ts->tv_sec) * 1000000 + ts->tv_nsec / 1000;
+            break;
+        }
+    }
+#endif
+#endif
+
+    datagram.data = QByteArray(receiveBuffer.data(), static_cast<int>(size));
+    return true;
+}
+
+// Datagrams "T <sequence number>" are sent at about 1 kHz, the latency of each is its receive timestamp minus the system time
+// right before sending. As both are taken on the same clock, the spread of the latency is the jitter of remote trial markers.
+int UDPReceiverThread::measureLoopbackLatency(int count) {
+
+    if(count <= 0) {
+        std::cerr << "Number of datagrams must be positive" << std::endl;
+        return -1;
+    }
+
+    QUdpSocket receiverSocket;
+    if(!receiverSocket.bind(QHostAddress::LocalHost, 0)) {
+        std::cerr << "Could not bind loopback UDP socket: " << receiverSocket.errorString().toStdString() << std::endl;
+        return -1;
+    }
+    QUdpSocket senderSocket;
+
+    UDPReceiverThread receiver(receiverSocket.socketDescriptor());
+    receiver.start(QThread::TimeCriticalPriority);
+
+    std::vector<qint64> sendTimes(count);
+    for(int i=0; i<count; i++) {
+        const QByteArray payload = "T " + QByteArray::number(i);
+        sendTimes[i] = systemTimeUs();
+        senderSocket.writeDatagram(payload, QHostAddress::LocalHost, receiverSocket.localPort());
+        QThread::usleep(1000);
+    }
+
+    std::vector<ReceivedDatagram> datagrams;
+    const qint64 deadline = systemTimeUs() + 1000000;
+    while(static_cast<int>(datagrams.size()) < count && systemTimeUs() < deadline) {
+        receiver.takeDatagrams(datagrams);
+        QThread::msleep(10);
+    }
+    receiver.stop();
+    receiver.wait();
+    receiver.takeDatagrams(datagrams);
+
+    std::vector<double> latencies;
+    for(const ReceivedDatagram &d : datagrams) {
+        bool ok = false;
+        const int i = d.data.mid(2).toInt(&ok);
+        if(ok && i >= 0 && i < count)
+            latencies.push_back(static_cast<double>(d.timestampUs - sendTimes[i]));
+    }
+
+    std::cout << "Receive timestamps: " << (receiver.usesKernelTimestamps() ? "kernel (SO_TIMESTAMPNS)" : "system clock after receive") << std::endl;
+    std::cout << "Received " << latencies.size() << " of " << count << " datagrams" << std::endl;
+    if(latencies.empty())
+        return 1;
+
+    double mean = 0.0;
+    for(double l : latencies)
+        mean += l;
+    mean /= latencies.size();
+    double variance = 0.0;
+    for(double l : latencies)
+        variance += (l - mean) * (l - mean);
+    const double stdDev = std::sqrt(variance / latencies.size());
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) { return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))]; };
+
+    std::cout << "Latency [us]: mean " << mean << ", std (jitter) " << stdDev
+              << ", min " << latencies.front() << ", median " << percentile(0.5)
+              << ", p99 " << percentile(0.99) << ", max " << latencies.back() << std::endl;
+
+    return static_cast<int>(latencies.size()) == count ? 0 : 1;
+}
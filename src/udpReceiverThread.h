@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QThread>
+#include <QtCore/QByteArray>
+
+#include <atomic>
+#include <vector>
+
+#include "spscQueue.h"
+
+/**
+    A datagram as received by UDPReceiverThread, timestamp in microseconds since epoch (system clock)
+*/
+struct ReceivedDatagram {
+    qint64 timestampUs = 0;
+    QByteArray data;
+};
+
+/**
+    Reads datagrams from a bound UDP socket in a dedicated thread, so their receive time does not depend on the load of the GUI thread
+
+    The thread blocks on the native socket descriptor (with a short timeout to be able to stop) and timestamps each datagram as
+    early as possible: on Linux, the kernel receive timestamp (SO_TIMESTAMPNS, taken when the packet arrived at the network stack)
+    is used, on other platforms the system clock right after the receive call. Datagrams are handed over through a lock-free queue,
+    and the consumer is notified with datagramsAvailable(), which is emitted once until the queue was drained by takeDatagrams().
+
+    The socket must stay open while the thread runs, the QUdpSocket owning it must not read from it in the meantime.
+
+    usesKernelTimestamps(): whether kernel receive timestamps are available for the socket
+    stop(): requests the thread to finish, returns immediately, use wait() afterwards
+    takeDatagrams(): moves all queued datagrams into datagrams (appended), to be called from the consumer thread only
+    droppedDatagrams(): number of datagrams discarded as the queue was full
+    measureLoopbackLatency(): sends count datagrams over the loopback interface to a receiver thread and prints the latency
+                              statistics (i.e. the jitter of remote markers), returns 0 if all were received
+
+signals:
+    datagramsAvailable(): new datagrams are in the queue
+*/
+class UDPReceiverThread : public QThread {
+    Q_OBJECT
+
+public:
+
+    explicit UDPReceiverThread(qintptr socketDescriptor, QObject *parent=nullptr);
+    ~UDPReceiverThread() override;
+
+    bool usesKernelTimestamps() const;
+    void stop();
+    void takeDatagrams(std::vector<ReceivedDatagram> &datagrams);
+    quint64 droppedDatagrams() const;
+
+    static int measureLoopbackLatency(int count);
+
+protected:
+
+    void run() override;
+
+private:
+
+    static const size_t queueCapacity = 1024;
+    static const int pollTimeoutMs = 100;
+
+    qintptr descriptor;
+    bool kernelTimestamps;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> notificationPending;
+    std::atomic<quint64> dropped;
+
+    SPSCQueue<ReceivedDatagram> queue;
+    std::vector<char> receiveBuffer;
+
+    bool waitForDatagram();
+    bool receiveDatagram(ReceivedDatagram &datagram);
+
+signals:
+
+    void datagramsAvailable();
+
+};
@@ -0,0 +1,267 @@
+
+#include "videoReader.h"
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/core/version.hpp>
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+VideoReader::VideoReader(const std::string &fileName, size_t queueCapacity) :
+    fileName(fileName),
+    width(0),
+    height(0),
+    queueCapacity(std::max<size_t>(1, queueCapacity)),
+    nextDecode(0),
+    seekTarget(-1),
+    generation(0),
+    stopRequested(false),
+    stillPosition(-1) {
+
+    buildIndex();
+    if(pts.empty())
+        return;
+
+    if(!capture.open(fileName, cv::CAP_FFMPEG)) {
+        pts.clear();
+        timestamps.clear();
+        return;
+    }
+    decodingThread = std::thread(&VideoReader::decode, this);
+}
+
+VideoReader::~VideoReader() {
+    mutex.lock();
+    stopRequested = true;
+    frameTaken.wakeAll();
+    frameDecoded.wakeAll();
+    mutex.unlock();
+    if(decodingThread.joinable())
+        decodingThread.join();
+}
+
+bool VideoReader::isOpen() const {
+    return !pts.empty();
+}
+
+int VideoReader::getNumFrames() const {
+    return static_cast<int>(pts.size());
+}
+
+int VideoReader::getNumKeyFrames() const {
+    return static_cast<int>(keyFrames.size());
+}
+
+int VideoReader::getWidth() const {
+    return width;
+}
+
+int VideoReader::getHeight() const {
+    return height;
+}
+
+const std::vector<quint64> &VideoReader::getTimestamps() const {
+    return timestamps;
+}
+
+bool VideoReader::isVideoFileName(const QString &fileName) {
+    static const QStringList extensions = {"mp4", "m4v", "mov", "avi", "mkv", "webm", "mpg", "mpeg", "wmv", "h264", "h265"};
+    return extensions.contains(QFileInfo(fileName).suffix().toLower());
+}
+
+// The PTS index comes from a decoding pass: grab() decodes, so the frames come in presentation order and POS_MSEC is the PTS of the
+// decoded picture. In raw stream mode, the FFmpeg backend does not reliably report the PTS, so it is only used for the key frame flags,
+// which OpenCV exposes from version 4.7 on.
+void VideoReader::buildIndex() {
+
+    cv::VideoCapture scan;
+    if(!scan.open(fileName, cv::CAP_FFMPEG)) {
+        std::cerr << "VideoReader: could not open video file: " << fileName << std::endl;
+        return;
+    }
+    width = static_cast<int>(scan.get(cv::CAP_PROP_FRAME_WIDTH));
+    height = static_cast<int>(scan.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+    while(scan.grab())
+        pts.push_back(scan.get(cv::CAP_PROP_POS_MSEC));
+    scan.release();
+
+    timestamps.reserve(pts.size());
+    for(double ms : pts)
+        timestamps.push_back(static_cast<quint64>(std::llround(std::max(0.0, ms))));
+
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 7)
+    // Packets come in decoding order, each key frame is located by its packet PTS. The flags are only used if every packet matches
+    // a decoded frame, otherwise positionAt() lets OpenCV find the key frames
+    cv::VideoCapture packets;
+    if(!pts.empty() && packets.open(fileName, cv::CAP_FFMPEG) && packets.set(cv::CAP_PROP_FORMAT, -1)) {
+        size_t count = 0;
+        bool matching = true;
+        while(matching && packets.grab()) {
+            count++;
+            if(packets.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) == 0)
+                continue;
+            const double ms = packets.get(cv::CAP_PROP_POS_MSEC);
+            const int frameNumber = frameNumberForPts(ms);
+            matching = std::abs(pts[frameNumber] - ms) < 0.5;
+            keyFrames.push_back(frameNumber);
+        }
+        std::sort(keyFrames.begin(), keyFrames.end());
+        keyFrames.erase(std::unique(keyFrames.begin(), keyFrames.end()), keyFrames.end());
+        if(!matching || count != pts.size() || keyFrames.empty() || keyFrames.front() != 0)
+            keyFrames.clear();
+    }
+#endif
+
+    std::cout << "VideoReader: indexed " << pts.size() << " frames (" << keyFrames.size() << " key frames) of " << fileName << std::endl;
+}
+
+int VideoReader::frameNumberForPts(double ms) const {
+    auto it = std::lower_bound(pts.begin(), pts.end(), ms);
+    if(it == pts.end())
+        return static_cast<int>(pts.size()) - 1;
+    if(it != pts.begin() && ms - *(it - 1) < *it - ms)
+        --it;
+    return static_cast<int>(it - pts.begin());
+}
+
+// Seeks to the closest key frame at or before the frame (OpenCV seeks to the key frame before its target itself, if the key frames
+// are not known) and grabs forward until the frame is reached, according to the PTS index. If the seek landed after the frame,
+// grabbing starts again from the beginning of the file. On success, the frame is grabbed and can be retrieved.
+bool VideoReader::positionAt(cv::VideoCapture &cap, int frameNumber) {
+
+    int start = frameNumber;
+    if(!keyFrames.empty()) {
+        auto it = std::upper_bound(keyFrames.begin(), keyFrames.end(), frameNumber);
+        start = it == keyFrames.begin() ? 0 : *(it - 1);
+    }
+
+    for(int attempt=0; attempt<2; attempt++) {
+        if(attempt == 1) {
+            if(start == 0)
+                break;
+            start = 0;
+        }
+        cap.set(cv::CAP_PROP_POS_FRAMES, start);
+        while(cap.grab()) {
+            const int current = frameNumberForPts(cap.get(cv::CAP_PROP_POS_MSEC));
+            if(current == frameNumber)
+                return true;
+            if(current > frameNumber)
+                break;
+        }
+    }
+    std::cerr << "VideoReader: could not seek to frame " << frameNumber << std::endl;
+    return false;
+}
+
+cv::Mat VideoReader::retrieveGray(cv::VideoCapture &cap) {
+    cv::Mat decoded;
+    if(!cap.retrieve(decoded) || decoded.empty())
+        return cv::Mat();
+
+    cv::Mat img;
+    if(decoded.channels() == 3)
+        cv::cvtColor(decoded, img, cv::COLOR_BGR2GRAY);
+    else if(decoded.channels() == 4)
+        cv::cvtColor(decoded, img, cv::COLOR_BGRA2GRAY);
+    else
+        img = decoded.clone();
+    return img;
+}
+
+// Decodes the frames in order into the queue, waiting while it is full. A frame that could not be decoded is queued as empty image,
+// so a waiting frame() call always returns. Frames decoded while a seek was requested are discarded.
+void VideoReader::decode() {
+
+    int position = -1; // frame grabbed last by the capture
+
+    mutex.lock();
+    while(!stopRequested) {
+        if(seekTarget >= 0) {
+            nextDecode = seekTarget;
+            seekTarget = -1;
+            queue.clear();
+        }
+        if(nextDecode >= getNumFrames() || queue.size() >= queueCapacity) {
+            frameTaken.wait(&mutex);
+            continue;
+        }
+        const int frameNumber = nextDecode;
+        const quint64 currentGeneration = generation;
+        mutex.unlock();
+
+        bool grabbed;
+        if(position == frameNumber - 1)
+            grabbed = capture.grab();
+        else
+            grabbed = positionAt(capture, frameNumber);
+        cv::Mat img;
+        if(grabbed)
+            img = retrieveGray(capture);
+        position = grabbed ? frameNumber : -1;
+
+        mutex.lock();
+        if(currentGeneration != generation)
+            continue;
+        queue.push_back({frameNumber, img});
+        nextDecode = frameNumber + 1;
+        frameDecoded.wakeAll();
+    }
+    mutex.unlock();
+}
+
+// Frames skipped by the playback are dropped from the queue, a frame far ahead or behind the decoding position makes it seek
+cv::Mat VideoReader::frame(int frameNumber) {
+
+    if(frameNumber < 0 || frameNumber >= getNumFrames())
+        return cv::Mat();
+
+    const QMutexLocker locker(&mutex);
+    while(!stopRequested) {
+        while(!queue.empty() && queue.front().frameNumber < frameNumber) {
+            queue.pop_front();
+            frameTaken.wakeAll();
+        }
+        if(!queue.empty() && queue.front().frameNumber == frameNumber) {
+            cv::Mat img = std::move(queue.front().img);
+            queue.pop_front();
+            frameTaken.wakeAll();
+            return img;
+        }
+
+        const int decodingAt = seekTarget >= 0 ? seekTarget : (queue.empty() ? nextDecode : queue.front().frameNumber);
+        if(decodingAt > frameNumber || frameNumber - decodingAt > static_cast<int>(2 * queueCapacity)) {
+            seekTarget = frameNumber;
+            generation++;
+            queue.clear();
+            frameTaken.wakeAll();
+        }
+        frameDecoded.wait(&mutex);
+    }
+    return cv::Mat();
+}
+
+cv::Mat VideoReader::stillFrame(int frameNumber) {
+
+    if(frameNumber < 0 || frameNumber >= getNumFrames())
+        return cv::Mat();
+
+    const QMutexLocker locker(&stillMutex);
+    if(!stillCapture.isOpened() && !stillCapture.open(fileName, cv::CAP_FFMPEG))
+        return cv::Mat();
+
+    bool grabbed;
+    if(stillPosition == frameNumber - 1)
+        grabbed = stillCapture.grab();
+    else
+        grabbed = positionAt(stillCapture, frameNumber);
+    stillPosition = grabbed ? frameNumber : -1;
+
+    return grabbed ? retrieveGray(stillCapture) : cv::Mat();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+/**
+    @author Moritz Lode, Gabor Benyei, Attila Boncser
+*/
+
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+#include <opencv2/core/mat.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+    Reads the frames of a video file (e.g. MP4, AVI, MKV) through cv::VideoCapture (FFmpeg backend) as grayscale images, for the ImageReader
+
+    On opening, an index of the whole file is built by decoding it once: the presentation timestamp (PTS) of every frame. The frames
+    are numbered in presentation order and get their PTS in milliseconds as timestamp. From OpenCV 4.7 on, a second pass reads the
+    packets without decoding them (raw stream mode) to find the key frames. Otherwise, or if the packets do not match the decoded
+    frames, the key frames stay unknown.
+
+    A decoding thread decodes the frames in order ahead of the playback into a bounded queue, so decoding runs concurrently with
+    the pupil detection (FFmpeg additionally decodes with multiple threads). Requesting a frame that is not next in order
+    makes the decoding thread seek: it jumps to the closest key frame before it and decodes forward, checking the position of
+    every decoded frame against the PTS index, so seeking is frame-accurate also for variable frame rate videos.
+
+    isOpen(): whether the file could be opened and contains frames
+    getNumFrames(): number of frames in the index
+    getTimestamps(): PTS of each frame in milliseconds
+    frame(): returns the given frame, taken from the queue if it was decoded ahead, empty if it could not be decoded
+    stillFrame(): returns the given frame using a separate decoder, without disturbing the decoding ahead (e.g. for previews)
+    isVideoFileName(): whether the file name has one of the supported video file extensions
+*/
+class VideoReader {
+
+public:
+
+    explicit VideoReader(const std::string &fileName, size_t queueCapacity=16);
+    ~VideoReader();
+
+    bool isOpen() const;
+    int getNumFrames() const;
+    int getNumKeyFrames() const;
+    int getWidth() const;
+    int getHeight() const;
+    const std::vector<quint64> &getTimestamps() const;
+
+    cv::Mat frame(int frameNumber);
+    cv::Mat stillFrame(int frameNumber);
+
+    static bool isVideoFileName(const QString &fileName);
+
+private:
+
+    struct DecodedFrame {
+        int frameNumber;
+        cv::Mat img;
+    };
+
+    std::string fileName;
+    int width;
+    int height;
+
+    std::vector<double> pts; // ms, in presentation order
+    std::vector<quint64> timestamps;
+    std::vector<int> keyFrames; // frame numbers, ascending
+
+    // Decoding ahead, the capture is only used by the decoding thread
+    cv::VideoCapture capture;
+    QMutex mutex;
+    QWaitCondition frameDecoded;
+    QWaitCondition frameTaken;
+    std::deque<DecodedFrame> queue;
+    const size_t queueCapacity;
+    int nextDecode;
+    int seekTarget;
+    quint64 generation;
+    bool stopRequested;
+    std::thread decodingThread;
+
+    QMutex stillMutex;
+    cv::VideoCapture stillCapture;
+    int stillPosition;
+
+    void buildIndex();
+    void decode();
+    int frameNumberForPts(double ms) const;
+    bool positionAt(cv::VideoCapture &cap, int frameNumber);
+    static cv::Mat retrieveGray(cv::VideoCapture &cap);
+};